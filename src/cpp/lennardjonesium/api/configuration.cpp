@@ -26,15 +26,69 @@
 #include <string>
 #include <filesystem>
 #include <memory>
+#include <stdexcept>
 
 #include <lennardjonesium/tools/system_parameters.hpp>
 #include <lennardjonesium/tools/cubic_lattice.hpp>
 #include <lennardjonesium/physics/lennard_jones_force.hpp>
 #include <lennardjonesium/engine/initial_condition.hpp>
+#include <lennardjonesium/output/sinks.hpp>
+#include <lennardjonesium/output/logger.hpp>
+#include <lennardjonesium/output/compression.hpp>
 #include <lennardjonesium/control/simulation_phase.hpp>
 #include <lennardjonesium/api/simulation.hpp>
 #include <lennardjonesium/api/configuration.hpp>
 
+namespace
+{
+    // A misspelled option must not quietly turn into the default
+    [[noreturn]] void unknown_option(const std::string& option, const std::string& name)
+    {
+        throw std::invalid_argument("Unknown " + option + ": \"" + name + "\"");
+    }
+
+    output::LogQueue::Policy log_queue_policy(const std::string& name)
+    {
+        if (name == "block") {return output::LogQueue::Policy::block;}
+        if (name == "drop") {return output::LogQueue::Policy::drop;}
+        if (name == "decimate") {return output::LogQueue::Policy::decimate;}
+        if (name == "coalesce") {return output::LogQueue::Policy::coalesce;}
+        unknown_option("log_queue_policy", name);
+    }
+
+    output::ThermodynamicReduction::Mode thermodynamic_reduction(const std::string& name)
+    {
+        if (name == "none") {return output::ThermodynamicReduction::Mode::none;}
+        if (name == "decimate") {return output::ThermodynamicReduction::Mode::decimate;}
+        if (name == "aggregate") {return output::ThermodynamicReduction::Mode::aggregate;}
+        unknown_option("thermodynamic_log_reduction", name);
+    }
+
+    output::ThermodynamicSink::Format thermodynamic_log_format(const std::string& name)
+    {
+        if (name == "csv") {return output::ThermodynamicSink::Format::csv;}
+        if (name == "binary") {return output::ThermodynamicSink::Format::binary;}
+        unknown_option("thermodynamic_log_format", name);
+    }
+
+    // Whether the logs are written asynchronously (with io_uring)
+    bool asynchronous_output(const std::string& name)
+    {
+        if (name == "stream") {return false;}
+        if (name == "uring") {return true;}
+        unknown_option("output_backend", name);
+    }
+
+    output::Compression compression(const std::string& name)
+    {
+        if (name == "none") {return output::Compression::none;}
+        if (name == "gzip") {return output::Compression::gzip;}
+        if (name == "zstd") {return output::Compression::zstd;}
+        unknown_option("compression", name);
+    }
+} // namespace
+
+
 namespace api
 {
     std::unique_ptr<Simulation> make_simulation(const Configuration& configuration)
@@ -50,6 +104,10 @@ namespace api
 
             .unit_cell = tools::CubicLattice::FaceCentered(),
 
+            .initial_snapshot_path = configuration.system.initial_snapshot,
+            .initial_snapshot_density = configuration.system.initial_snapshot_density,
+            .initial_snapshot_run = configuration.system.initial_snapshot_run,
+
             .random_seed = configuration.system.random_seed,
 
             .force_parameters = physics::LennardJonesForce::Parameters{
@@ -66,7 +124,10 @@ namespace api
                         .sample_size =  configuration.equilibration.sample_size,
                         .adjustment_interval = configuration.equilibration.adjustment_interval,
                         .steady_state_time = configuration.equilibration.steady_state_time,
-                        .timeout = configuration.equilibration.timeout
+                        .timeout = configuration.equilibration.timeout,
+                        .drift_threshold = configuration.equilibration.drift_threshold,
+                        .drift_block_count = configuration.equilibration.drift_block_count,
+                        .drift_pass_count = configuration.equilibration.drift_pass_count
                     }
                 },
 
@@ -76,15 +137,72 @@ namespace api
                         .tolerance = configuration.observation.tolerance,
                         .sample_size = configuration.observation.sample_size,
                         .observation_interval = configuration.observation.observation_interval,
-                        .observation_count = configuration.observation.observation_count
+                        .observation_count = configuration.observation.observation_count,
+                        .correlation_levels = configuration.observation.correlation_levels,
+                        .pair_distribution_interval =
+                            configuration.observation.pair_distribution_interval,
+                        .structure_factor_interval =
+                            configuration.observation.structure_factor_interval,
+                        .energy_error_tolerance =
+                            configuration.observation.energy_error_tolerance,
+                        .pressure_error_tolerance =
+                            configuration.observation.pressure_error_tolerance,
+                        .specific_heat_error_tolerance =
+                            configuration.observation.specific_heat_error_tolerance,
+                        .minimum_observation_count =
+                            configuration.observation.minimum_observation_count,
+                        .energy_histogram_bin_width =
+                            configuration.observation.energy_histogram_bin_width
                     }
                 }
             },
 
+            .pair_distribution_bins = configuration.observation.pair_distribution_bins,
+
+            .checkpoint_interval = configuration.system.checkpoint_interval,
+
             .event_log_path = configuration.filepaths.event_log,
             .thermodynamic_log_path = configuration.filepaths.thermodynamic_log,
             .observation_log_path = configuration.filepaths.observation_log,
-            .snapshot_log_path = configuration.filepaths.snapshot_log
+            .pair_distribution_log_path = configuration.filepaths.pair_distribution_log,
+            .energy_histogram_log_path = configuration.filepaths.energy_histogram_log,
+            .snapshot_log_path = configuration.filepaths.snapshot_log,
+            .trajectory_log_path = configuration.filepaths.trajectory_log,
+            .checkpoint_path = configuration.filepaths.checkpoint,
+            .store_path = configuration.filepaths.store,
+            .store_run = configuration.filepaths.store_run,
+            .thermodynamic_log_format =
+                thermodynamic_log_format(configuration.filepaths.thermodynamic_log_format),
+            .thermodynamic_log_reduction = {
+                .mode =
+                    thermodynamic_reduction(configuration.filepaths.thermodynamic_log_reduction),
+                .interval = configuration.filepaths.thermodynamic_log_interval
+            },
+            .thermodynamic_log_pressure_tensor =
+                configuration.filepaths.thermodynamic_log_pressure_tensor,
+            .trajectory_interval = configuration.system.trajectory_interval,
+            .trajectory_velocities = configuration.system.trajectory_velocities,
+            .log_queue = {
+                .capacity = static_cast<size_t>(configuration.filepaths.log_queue_capacity),
+                .policy = log_queue_policy(configuration.filepaths.log_queue_policy),
+                .decimation_interval = configuration.filepaths.log_queue_decimation_interval
+            },
+            .log_compression = {
+                .thermodynamic_log =
+                    compression(configuration.filepaths.thermodynamic_log_compression),
+                .observation_log =
+                    compression(configuration.filepaths.observation_log_compression),
+                .pair_distribution_log =
+                    compression(configuration.filepaths.pair_distribution_log_compression),
+                .energy_histogram_log =
+                    compression(configuration.filepaths.energy_histogram_log_compression),
+                .snapshot_log =
+                    compression(configuration.filepaths.snapshot_log_compression),
+                .trajectory_log =
+                    compression(configuration.filepaths.trajectory_log_compression)
+            },
+            .asynchronous_output = asynchronous_output(configuration.filepaths.output_backend),
+            .direct_trajectory_output = configuration.filepaths.trajectory_direct_io
         };
 
         // Now create the Simulation object
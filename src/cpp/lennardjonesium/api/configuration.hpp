@@ -58,6 +58,22 @@ namespace api
 
             // Time step size
             double time_delta = 0.005;
+
+            // Time steps between checkpoints (0 disables checkpointing)
+            int checkpoint_interval = 0;
+
+            // Snapshot file to warm start from, and the density at which it was taken (if the
+            // snapshot is empty or cannot be used, start from the lattice; the events log says
+            // why a snapshot could not be used)
+            std::string initial_snapshot = "";
+            double initial_snapshot_density = 0.0;
+
+            // Alternatively, the run in the output store whose snapshot to warm start from
+            std::string initial_snapshot_run = "";
+
+            // Time steps between frames of the trajectory (0 disables the trajectory log)
+            int trajectory_interval = 0;
+            bool trajectory_velocities = true;
         };
 
         struct Equilibration
@@ -69,6 +85,9 @@ namespace api
             int adjustment_interval = 200;
             int steady_state_time = 1000;
             int timeout = 5000;
+            double drift_threshold = 0.0;
+            int drift_block_count = 10;
+            int drift_pass_count = 3;
         };
 
         struct Observation
@@ -79,6 +98,15 @@ namespace api
             int sample_size = 50;
             int observation_interval = 200;
             int observation_count = 20;
+            int correlation_levels = 0;
+            int pair_distribution_interval = 0;
+            int pair_distribution_bins = 100;
+            int structure_factor_interval = 10;
+            double energy_error_tolerance = 0.0;
+            double pressure_error_tolerance = 0.0;
+            double specific_heat_error_tolerance = 0.0;
+            int minimum_observation_count = 5;
+            double energy_histogram_bin_width = 0.0;
         };
 
         struct Filepaths
@@ -87,7 +115,49 @@ namespace api
             std::string event_log = "events.log";
             std::string thermodynamic_log = "thermodynamics.csv";
             std::string observation_log = "observations.csv";
+            std::string pair_distribution_log = "pair_distribution.csv";
+            std::string energy_histogram_log = "energy_histogram.csv";
             std::string snapshot_log = "snapshots.csv";
+            std::string trajectory_log = "trajectory.bin";
+            std::string checkpoint = "checkpoint.bin";
+
+            // Format of the thermodynamic log, either "csv" or "binary"
+            std::string thermodynamic_log_format = "csv";
+
+            // Rows of the thermodynamic log: "none" (every time step), "decimate", or "aggregate",
+            // the latter two with the given interval (see output::ThermodynamicReduction)
+            std::string thermodynamic_log_reduction = "none";
+            int thermodynamic_log_interval = 10;
+
+            // Whether the thermodynamic log includes the virial and kinetic tensors
+            bool thermodynamic_log_pressure_tensor = false;
+
+            // Logger queue:  the policy when it is full is one of "block", "drop", "decimate",
+            // or "coalesce" (see output::LogQueue)
+            int log_queue_capacity = 4096;
+            std::string log_queue_policy = "block";
+            int log_queue_decimation_interval = 10;
+
+            // Output backend, either "stream" or "uring" (see output::UringFileSink); with
+            // "uring", the trajectory may also be written with O_DIRECT.  Logs written to the
+            // store are appended by the store itself, so with a store, "uring" only affects the
+            // trajectory.
+            std::string output_backend = "stream";
+            bool trajectory_direct_io = false;
+
+            // Output store shared by the runs of a sweep (see output::SweepStore); if empty, each
+            // log is written to its own file
+            std::string store = "";
+            std::string store_run = "";
+
+            // Compression of each log: "none", "gzip", or "zstd" (see output::LogCompression).
+            // The event log is never compressed.
+            std::string thermodynamic_log_compression = "none";
+            std::string observation_log_compression = "none";
+            std::string pair_distribution_log_compression = "none";
+            std::string energy_histogram_log_compression = "none";
+            std::string snapshot_log_compression = "none";
+            std::string trajectory_log_compression = "none";
         };
 
         /**
@@ -102,7 +172,9 @@ namespace api
     };
 
     /**
-     * We also provide a factory function which creates a simulation from these parameters.
+     * We also provide a factory function which creates a simulation from these parameters.  It
+     * throws std::invalid_argument if one of the named options (formats, policies, compressions,
+     * etc.) is not one of the names given above.
      */
     std::unique_ptr<Simulation> make_simulation(const Configuration&);
 } // namespace api
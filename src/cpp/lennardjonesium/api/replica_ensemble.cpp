@@ -0,0 +1,152 @@
+/**
+ * replica_ensemble.cpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <lennardjonesium/control/simulation_phase.hpp>
+#include <lennardjonesium/api/simulation.hpp>
+#include <lennardjonesium/api/simulation_pool.hpp>
+#include <lennardjonesium/api/replica_ensemble.hpp>
+
+namespace
+{
+    // Split the parameters into those of the equilibration and those of the replicas
+    std::pair<api::Simulation::Parameters, api::Simulation::Parameters>
+    split_schedule(const api::Simulation::Parameters& parameters)
+    {
+        const auto& schedule = parameters.schedule_parameters;
+
+        auto last_equilibration = schedule.end();
+        for (auto it = schedule.begin(); it != schedule.end(); ++it)
+        {
+            if (std::holds_alternative<control::EquilibrationPhase::Parameters>(it->second))
+            {
+                last_equilibration = it;
+            }
+        }
+
+        assert(last_equilibration != schedule.end()
+            && "ReplicaEnsemble schedule needs an EquilibrationPhase");
+        assert(last_equilibration + 1 != schedule.end()
+            && "ReplicaEnsemble schedule needs phases after the last EquilibrationPhase");
+
+        auto equilibration_parameters = parameters;
+        equilibration_parameters.schedule_parameters.assign(
+            schedule.begin(), last_equilibration + 1
+        );
+
+        auto replica_parameters = parameters;
+        replica_parameters.schedule_parameters.assign(last_equilibration + 1, schedule.end());
+
+        return {equilibration_parameters, replica_parameters};
+    }
+} // namespace
+
+
+namespace api
+{
+    ReplicaEnsemble::ReplicaEnsemble(ReplicaEnsemble::Parameters parameters)
+        : equilibration_{split_schedule(parameters.simulation_parameters).first}
+    {
+        assert(parameters.replica_count > 0 && "ReplicaEnsemble needs at least one replica");
+
+        auto base_parameters = split_schedule(parameters.simulation_parameters).second;
+
+        // Derive a distinct seed for each replica from the one given
+        std::seed_seq seed_sequence{base_parameters.random_seed};
+        std::vector<std::random_device::result_type> seeds(parameters.replica_count);
+        seed_sequence.generate(seeds.begin(), seeds.end());
+
+        replicas_.reserve(parameters.replica_count);
+
+        for (int i = 0; i < parameters.replica_count; ++i)
+        {
+            auto replica_parameters = base_parameters;
+
+            replica_parameters.initial_snapshot_path = base_parameters.snapshot_log_path;
+            replica_parameters.initial_snapshot_density =
+                base_parameters.system_parameters.density;
+            replica_parameters.redraw_initial_velocities = true;
+            replica_parameters.random_seed = seeds[i];
+
+            for (auto path : {
+                &Simulation::Parameters::event_log_path,
+                &Simulation::Parameters::thermodynamic_log_path,
+                &Simulation::Parameters::observation_log_path,
+                &Simulation::Parameters::pair_distribution_log_path,
+                &Simulation::Parameters::energy_histogram_log_path,
+                &Simulation::Parameters::snapshot_log_path,
+                &Simulation::Parameters::trajectory_log_path,
+                &Simulation::Parameters::checkpoint_path
+            })
+            {
+                replica_parameters.*path = replica_path(base_parameters.*path, i);
+            }
+
+            replicas_.emplace_back(replica_parameters);
+        }
+    }
+
+    std::filesystem::path ReplicaEnsemble::replica_path(const std::filesystem::path& path, int i)
+    {
+        return path.parent_path() / ("replica_" + std::to_string(i)) / path.filename();
+    }
+
+    bool ReplicaEnsemble::run(SimulationPool& pool, Simulation::echo_chain_type echo_chain)
+    {
+        equilibration_.run(echo_chain);
+
+        if (!equilibration_.completed()) {return false;}
+
+        for (auto& replica : replicas_)
+        {
+            // Make sure the replica subdirectories exist before the replica opens its files
+            auto parameters = replica.parameters();
+
+            for (const auto& path : {
+                parameters.event_log_path,
+                parameters.thermodynamic_log_path,
+                parameters.observation_log_path,
+                parameters.pair_distribution_log_path,
+                parameters.energy_histogram_log_path,
+                parameters.snapshot_log_path,
+                parameters.trajectory_log_path,
+                parameters.checkpoint_path
+            })
+            {
+                std::error_code error;
+                std::filesystem::create_directories(path.parent_path(), error);
+            }
+
+            pool.push(replica);
+        }
+
+        return true;
+    }
+} // namespace api
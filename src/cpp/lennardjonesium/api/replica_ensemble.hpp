@@ -0,0 +1,83 @@
+/**
+ * replica_ensemble.hpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LJ_REPLICA_ENSEMBLE_HPP
+#define LJ_REPLICA_ENSEMBLE_HPP
+
+#include <filesystem>
+#include <vector>
+
+#include <lennardjonesium/api/simulation.hpp>
+#include <lennardjonesium/api/simulation_pool.hpp>
+
+namespace api
+{
+    class ReplicaEnsemble
+    {
+        /**
+         * ReplicaEnsemble gives several independent samples of a single state point, while paying
+         * for the equilibration only once.  The schedule of the given Simulation::Parameters is
+         * split after its last EquilibrationPhase.  The first part runs as a single Simulation,
+         * whose final snapshot is then forked into replica_count replicas, each of which runs the
+         * remaining phases as a Simulation of its own.  The replicas start from the equilibrated
+         * positions, but with velocities drawn afresh from the Maxwell-Boltzmann distribution
+         * (each with its own seed), which decorrelates them from each other.
+         * 
+         * The equilibration writes to the files given in the Parameters.  Replica i writes to the
+         * same file names, in a subdirectory "replica_<i>" next to each of them.
+         */
+
+        public:
+            struct Parameters
+            {
+                Simulation::Parameters simulation_parameters = {};
+                int replica_count = 4;
+            };
+
+            explicit ReplicaEnsemble(Parameters parameters);
+
+            /**
+             * Run the equilibration synchronously, in this thread, then push the replicas onto
+             * the pool (the caller should wait on the pool).  Returns false without pushing
+             * anything if the equilibration was aborted.
+             */
+            bool run(
+                SimulationPool& pool,
+                Simulation::echo_chain_type echo_chain = Simulation::Echo::Silent()
+            );
+
+            Simulation& equilibration() {return equilibration_;}
+            std::vector<Simulation>& replicas() {return replicas_;}
+
+            // The path to which replica i writes, in place of the given one
+            static std::filesystem::path replica_path(const std::filesystem::path& path, int i);
+        
+        private:
+            Simulation equilibration_;
+
+            // The SimulationPool holds references to these, so they must never be reallocated
+            std::vector<Simulation> replicas_;
+    };
+} // namespace api
+
+
+#endif
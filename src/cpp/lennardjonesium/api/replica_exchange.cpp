@@ -0,0 +1,306 @@
+/**
+ * replica_exchange.cpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <filesystem>
+#include <istream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <lennardjonesium/tools/binary_stream.hpp>
+#include <lennardjonesium/physics/system_state.hpp>
+#include <lennardjonesium/output/log_message.hpp>
+#include <lennardjonesium/api/simulation.hpp>
+#include <lennardjonesium/api/simulation_pool.hpp>
+#include <lennardjonesium/api/replica_exchange.hpp>
+
+namespace api
+{
+    ReplicaExchange::ReplicaExchange(ReplicaExchange::Parameters parameters)
+        : temperatures_{parameters.temperatures},
+          barrier_{static_cast<std::ptrdiff_t>(parameters.temperatures.size()), Completion{this}},
+          random_number_engine_{parameters.simulation_parameters.random_seed},
+          states_(parameters.temperatures.size(), nullptr),
+          events_(parameters.temperatures.size())
+    {
+        assert(temperatures_.size() > 1 && "ReplicaExchange needs at least two temperatures");
+        assert(std::is_sorted(temperatures_.begin(), temperatures_.end())
+            && "ReplicaExchange temperatures must be in increasing order");
+        assert(parameters.exchange_interval > 0 && "Exchange interval must be positive");
+
+        int rung_count = static_cast<int>(temperatures_.size());
+        rungs_.reserve(rung_count);
+
+        for (int i = 0; i < rung_count; ++i)
+        {
+            auto rung_parameters = parameters.simulation_parameters;
+            rung_parameters.system_parameters.temperature = temperatures_[i];
+
+            for (auto path : {
+                &Simulation::Parameters::event_log_path,
+                &Simulation::Parameters::thermodynamic_log_path,
+                &Simulation::Parameters::observation_log_path,
+                &Simulation::Parameters::pair_distribution_log_path,
+                &Simulation::Parameters::energy_histogram_log_path,
+                &Simulation::Parameters::snapshot_log_path,
+                &Simulation::Parameters::trajectory_log_path,
+                &Simulation::Parameters::checkpoint_path
+            })
+            {
+                rung_parameters.*path = rung_path(rung_parameters.*path, i);
+            }
+
+            rung_parameters.exchange = control::SimulationController::Exchange{
+                .exchange = [this, i](physics::SystemState& state) {return exchange_(i, state);},
+                .leave = [this, i]() {leave_(i);},
+                .save = [this](std::ostream& out) {save_(out);},
+                .restore = [this](std::istream& in) {return restore_(in);},
+                .interval = parameters.exchange_interval
+            };
+
+            rungs_.emplace_back(rung_parameters);
+        }
+    }
+
+    std::filesystem::path ReplicaExchange::rung_path(const std::filesystem::path& path, int i)
+    {
+        return path.parent_path() / ("rung_" + std::to_string(i)) / path.filename();
+    }
+
+    void ReplicaExchange::run(SimulationPool& pool)
+    {
+        // The rungs wait for each other at the barrier, so a rung left waiting for a thread
+        // would deadlock the whole ladder.  Threads taken by jobs already on the pool (running or
+        // queued ahead of us) are not available to the rungs.
+        int rung_count = static_cast<int>(rungs_.size());
+
+        if (pool.thread_count() < rung_count)
+        {
+            throw std::invalid_argument(
+                "SimulationPool has too few threads to run every rung at once"
+            );
+        }
+
+        auto status = pool.status();
+
+        if (pool.thread_count() - status.running - status.waiting < rung_count)
+        {
+            throw std::invalid_argument(
+                "SimulationPool has too few idle threads to run every rung at once"
+            );
+        }
+
+        // Each rung writes its own checkpoint, so if the ladder was killed part way through a
+        // round of checkpoints, the rungs may have saved different rounds.  The exchanges only
+        // make sense if every rung resumes from the same round, so unless they all can, we throw
+        // every checkpoint away and start the whole ladder over.
+        std::vector<std::optional<int>> time_steps;
+
+        for (const auto& rung : rungs_)
+        {
+            time_steps.push_back(rung.resumable_time_step());
+        }
+
+        if (std::adjacent_find(time_steps.begin(), time_steps.end(), std::not_equal_to{})
+            != time_steps.end())
+        {
+            for (auto& rung : rungs_)
+            {
+                std::error_code error;
+                std::filesystem::remove(rung.parameters().checkpoint_path, error);
+            }
+        }
+
+        for (auto& rung : rungs_)
+        {
+            // Make sure the rung subdirectories exist before the rung opens its files
+            auto parameters = rung.parameters();
+
+            for (const auto& path : {
+                parameters.event_log_path,
+                parameters.thermodynamic_log_path,
+                parameters.observation_log_path,
+                parameters.pair_distribution_log_path,
+                parameters.energy_histogram_log_path,
+                parameters.snapshot_log_path,
+                parameters.trajectory_log_path,
+                parameters.checkpoint_path
+            })
+            {
+                std::error_code error;
+                std::filesystem::create_directories(path.parent_path(), error);
+            }
+
+            pool.push(rung);
+        }
+    }
+
+    std::optional<output::ReplicaExchangeEvent>
+    ReplicaExchange::exchange_(int rung, physics::SystemState& state)
+    {
+        states_[rung] = &state;
+        barrier_.arrive_and_wait();
+
+        // The completion has filled in our event (if we were paired this round)
+        states_[rung] = nullptr;
+        return std::exchange(events_[rung], std::nullopt);
+    }
+
+    void ReplicaExchange::leave_(int rung)
+    {
+        states_[rung] = nullptr;
+        barrier_.arrive_and_drop();
+    }
+
+    void ReplicaExchange::save_(std::ostream& out) const
+    {
+        // Every rung is between barriers while checkpointing, so nothing changes under us
+        std::ostringstream engine;
+        engine << random_number_engine_;
+
+        tools::write_binary(out, round_);
+        tools::write_binary(out, engine.str());
+        tools::write_binary(out, static_cast<std::uint64_t>(swap_counts_.size()));
+
+        for (const auto& [pair, count] : swap_counts_)
+        {
+            tools::write_binary(out, pair.first);
+            tools::write_binary(out, pair.second);
+            tools::write_binary(out, count.attempted);
+            tools::write_binary(out, count.accepted);
+        }
+    }
+
+    bool ReplicaExchange::restore_(std::istream& in)
+    {
+        int round{0};
+        std::string engine_state;
+        std::uint64_t size{0};
+
+        tools::read_binary(in, round);
+        tools::read_binary(in, engine_state);
+        tools::read_binary(in, size);
+
+        std::map<std::pair<int, int>, SwapCount> swap_counts;
+
+        for (std::uint64_t k = 0; k < size && in; ++k)
+        {
+            std::pair<int, int> pair;
+            SwapCount count;
+
+            tools::read_binary(in, pair.first);
+            tools::read_binary(in, pair.second);
+            tools::read_binary(in, count.attempted);
+            tools::read_binary(in, count.accepted);
+
+            swap_counts[pair] = count;
+        }
+
+        std::mt19937 random_number_engine;
+        std::istringstream engine{engine_state};
+        engine >> random_number_engine;
+
+        if (!in || !engine) {return false;}
+
+        // run() only lets the rungs resume from the same round, so a mismatch means that the
+        // checkpoints changed under us; refuse to resume rather than run the ladder out of step
+        std::lock_guard lock{restore_mutex_};
+
+        if (restored_) {return round == round_;}
+
+        round_ = round;
+        random_number_engine_ = random_number_engine;
+        swap_counts_ = std::move(swap_counts);
+        restored_ = true;
+
+        return true;
+    }
+
+    void ReplicaExchange::attempt_exchanges_()
+    {
+        /**
+         * Only the rungs which are waiting at the barrier have a state to offer.  We pair them
+         * up in order of temperature, alternating which one starts the pairs from round to round,
+         * so that every neighbor gets a chance to swap with both of its neighbors.
+         */
+        std::vector<int> waiting;
+        for (int i = 0; i < static_cast<int>(states_.size()); ++i)
+        {
+            if (states_[i] != nullptr) {waiting.push_back(i);}
+        }
+
+        std::uniform_real_distribution<> uniform{0.0, 1.0};
+
+        for (size_t k = round_ % 2; k + 1 < waiting.size(); k += 2)
+        {
+            int i = waiting[k];
+            int j = waiting[k + 1];
+
+            physics::SystemState& state_i = *states_[i];
+            physics::SystemState& state_j = *states_[j];
+
+            double exponent = (1.0 / temperatures_[i] - 1.0 / temperatures_[j])
+                * (state_i.potential_energy - state_j.potential_energy);
+
+            double probability = std::min(1.0, std::exp(exponent));
+            bool accepted = uniform(random_number_engine_) < probability;
+
+            if (accepted)
+            {
+                // Swap the configurations, keeping each rung at its own temperature
+                std::swap(state_i, state_j);
+                state_i.velocities *= std::sqrt(temperatures_[i] / temperatures_[j]);
+                state_j.velocities *= std::sqrt(temperatures_[j] / temperatures_[i]);
+            }
+
+            SwapCount& count = swap_counts_[{i, j}];
+            ++count.attempted;
+            if (accepted) {++count.accepted;}
+
+            events_[i] = output::ReplicaExchangeEvent{
+                .partner_temperature = temperatures_[j],
+                .acceptance_probability = probability,
+                .accepted = accepted,
+                .accepted_count = count.accepted,
+                .attempted_count = count.attempted
+            };
+
+            events_[j] = events_[i];
+            events_[j]->partner_temperature = temperatures_[i];
+        }
+
+        ++round_;
+    }
+} // namespace api
@@ -0,0 +1,157 @@
+/**
+ * replica_exchange.hpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LJ_REPLICA_EXCHANGE_HPP
+#define LJ_REPLICA_EXCHANGE_HPP
+
+#include <barrier>
+#include <filesystem>
+#include <istream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <lennardjonesium/physics/system_state.hpp>
+#include <lennardjonesium/output/log_message.hpp>
+#include <lennardjonesium/api/simulation.hpp>
+#include <lennardjonesium/api/simulation_pool.hpp>
+
+namespace api
+{
+    class ReplicaExchange
+    {
+        /**
+         * ReplicaExchange runs a ladder of Simulations at the same density and at different
+         * temperatures (parallel tempering), and periodically attempts to swap the configurations
+         * of neighboring rungs.  A configuration stuck in a local minimum at a low temperature can
+         * then escape by climbing the ladder, which greatly shortens the decorrelation time of
+         * the dense, cold states near the phase boundary.
+         * 
+         * Every exchange_interval time steps, each rung offers its state for exchange and waits
+         * (on a std::barrier) until every other rung has done the same.  Then the neighboring
+         * pairs (0, 1), (2, 3), ... are considered at even rounds, and (1, 2), (3, 4), ... at odd
+         * rounds.  A swap between temperatures T_i and T_j is accepted with the Metropolis
+         * probability
+         * 
+         *      min(1, exp[(1/T_i - 1/T_j) (U_i - U_j)])
+         * 
+         * where U is the potential energy.  Since this is molecular dynamics, the kinetic part
+         * is handled by rescaling the velocities of the swapped configurations by sqrt(T_i / T_j)
+         * (and its inverse), so that each rung stays at its own temperature.  The outcome of each
+         * attempt is written to the events log of both rungs involved.
+         * 
+         * A rung whose schedule ends (or aborts) leaves the ladder, and its neighbors then pair
+         * with the next rung which is still running.  Since the rungs wait for each other, they
+         * must all run at once: the SimulationPool needs at least as many idle threads as there
+         * are temperatures, and nothing else should be pushed onto it until the ladder is done.
+         * The rung with temperature index i writes its files to the subdirectory "rung_<i>" next
+         * to those given in the Parameters.
+         * 
+         * With checkpointing, each rung saves the round, the random number generator and the swap
+         * statistics of the ladder in its checkpoint.  The rungs checkpoint at the same time
+         * steps, but each writes its own file, so if they were killed part way through a round of
+         * checkpoints, they may have saved different states.  The ladder resumes only if every
+         * rung saved the same time step; otherwise all of the checkpoints are removed and the
+         * ladder starts over.
+         */
+
+        public:
+            struct Parameters
+            {
+                // All rungs share these parameters, except for the temperature
+                Simulation::Parameters simulation_parameters = {};
+
+                // The ladder of temperatures, in increasing order
+                std::vector<double> temperatures = {};
+
+                // Time steps between exchange attempts
+                int exchange_interval = 100;
+            };
+
+            // Number of exchanges attempted and accepted between a pair of rungs
+            struct SwapCount
+            {
+                int attempted{0};
+                int accepted{0};
+            };
+
+            explicit ReplicaExchange(Parameters parameters);
+
+            // The rungs refer back to this object, so it must stay where it is
+            ReplicaExchange(const ReplicaExchange&) = delete;
+            ReplicaExchange& operator=(const ReplicaExchange&) = delete;
+
+            // Push every rung onto the pool (the caller should wait on the pool).  Throws
+            // std::invalid_argument if the pool has fewer idle threads than there are rungs.  Jobs
+            // pushed onto the pool afterwards may take threads that a rung is still waiting for.
+            void run(SimulationPool& pool);
+
+            std::vector<Simulation>& rungs() {return rungs_;}
+
+            // Keyed by the pair of rungs (i, j), i < j, which were paired.  These are neighbors,
+            // unless the rungs between them had left the ladder.  Read after waiting.
+            const std::map<std::pair<int, int>, SwapCount>& swap_counts() const
+                {return swap_counts_;}
+
+            // The path to which rung i writes, in place of the given one
+            static std::filesystem::path rung_path(const std::filesystem::path& path, int i);
+        
+        private:
+            // The barrier completion runs on one thread while the others wait
+            struct Completion
+            {
+                ReplicaExchange* replica_exchange;
+                void operator() () noexcept {replica_exchange->attempt_exchanges_();}
+            };
+
+            std::vector<double> temperatures_;
+            std::vector<Simulation> rungs_;
+
+            std::barrier<Completion> barrier_;
+            std::mt19937 random_number_engine_;
+            int round_{0};
+
+            // One slot per rung, each written only by its own rung before arriving at the barrier
+            std::vector<physics::SystemState*> states_;
+            std::vector<std::optional<output::ReplicaExchangeEvent>> events_;
+
+            // Swap statistics between pairs, updated only by the barrier completion
+            std::map<std::pair<int, int>, SwapCount> swap_counts_;
+
+            // Guards restoring, which every rung does on its own thread before the first exchange
+            std::mutex restore_mutex_;
+            bool restored_{false};
+
+            std::optional<output::ReplicaExchangeEvent> exchange_(int rung, physics::SystemState&);
+            void leave_(int rung);
+            void save_(std::ostream& out) const;
+            bool restore_(std::istream& in);
+            void attempt_exchanges_();
+    };
+} // namespace api
+
+
+#endif
@@ -20,29 +20,124 @@
  * <https://www.gnu.org/licenses/>.
  */
 
+#include <array>
 #include <cassert>
+#include <functional>
+#include <ios>
+#include <ostream>
 #include <memory>
+#include <optional>
 #include <variant>
 #include <vector>
 #include <utility>
+#include <cstdint>
 #include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
 
-#include <boost/iostreams/stream.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/chain.hpp>
 #include <boost/iostreams/device/file.hpp>
+#include <boost/iostreams/device/null.hpp>
+#include <boost/iostreams/categories.hpp>
+#include <boost/iostreams/write.hpp>
 
 #include <lennardjonesium/tools/overloaded_visitor.hpp>
+#include <lennardjonesium/tools/binary_stream.hpp>
 #include <lennardjonesium/tools/system_parameters.hpp>
+#include <lennardjonesium/tools/cubic_lattice.hpp>
 #include <lennardjonesium/physics/forces.hpp>
 #include <lennardjonesium/physics/lennard_jones_force.hpp>
+#include <lennardjonesium/physics/pair_distribution.hpp>
 #include <lennardjonesium/engine/initial_condition.hpp>
 #include <lennardjonesium/engine/integrator_builder.hpp>
+#include <lennardjonesium/output/output_service.hpp>
 #include <lennardjonesium/output/logger.hpp>
+#include <lennardjonesium/output/snapshot_reader.hpp>
+#include <lennardjonesium/output/uring_file_sink.hpp>
+#include <lennardjonesium/output/sweep_store.hpp>
+#include <lennardjonesium/output/compression.hpp>
 #include <lennardjonesium/control/simulation_phase.hpp>
 #include <lennardjonesium/control/simulation_controller.hpp>
 #include <lennardjonesium/api/simulation.hpp>
 
+namespace
+{
+    void write_phase_parameters(
+        std::ostream& out, const control::EquilibrationPhase::Parameters& parameters
+    )
+    {
+        tools::write_binary(out, parameters.tolerance);
+        tools::write_binary(out, parameters.sample_size);
+        tools::write_binary(out, parameters.adjustment_interval);
+        tools::write_binary(out, parameters.steady_state_time);
+        tools::write_binary(out, parameters.timeout);
+        tools::write_binary(out, parameters.drift_threshold);
+        tools::write_binary(out, parameters.drift_block_count);
+        tools::write_binary(out, parameters.drift_pass_count);
+    }
+
+    void write_phase_parameters(
+        std::ostream& out, const control::ObservationPhase::Parameters& parameters
+    )
+    {
+        tools::write_binary(out, parameters.tolerance);
+        tools::write_binary(out, parameters.sample_size);
+        tools::write_binary(out, parameters.observation_interval);
+        tools::write_binary(out, parameters.observation_count);
+        tools::write_binary(out, parameters.correlation_levels);
+        tools::write_binary(out, parameters.pair_distribution_interval);
+        tools::write_binary(out, parameters.structure_factor_interval);
+        tools::write_binary(out, parameters.structure_factor_wavenumbers);
+        tools::write_binary(out, parameters.energy_error_tolerance);
+        tools::write_binary(out, parameters.pressure_error_tolerance);
+        tools::write_binary(out, parameters.specific_heat_error_tolerance);
+        tools::write_binary(out, parameters.minimum_observation_count);
+        tools::write_binary(out, parameters.energy_histogram_bin_width);
+    }
+
+    // An output filter which counts the bytes passing through it (the count is shared by the
+    // copies, since the chain keeps a copy of its own)
+    class ByteCounter
+    {
+        public:
+            using char_type = char;
+            using category = boost::iostreams::multichar_output_filter_tag;
+
+            template<class Sink>
+            std::streamsize write(Sink& sink, const char* s, std::streamsize n)
+            {
+                auto written = boost::iostreams::write(sink, s, n);
+                *count_ += static_cast<std::uint64_t>(written);
+                return written;
+            }
+
+            void set(std::uint64_t count) {*count_ = count;}
+            std::uint64_t count() const {return *count_;}
+
+        private:
+            std::shared_ptr<std::uint64_t> count_ = std::make_shared<std::uint64_t>(0);
+    };
+
+    // 64-bit FNV-1a, which is good enough to tell apart the parameters of different runs
+    std::uint64_t fnv1a(std::string_view bytes)
+    {
+        std::uint64_t hash = 0xcbf29ce484222325;
+
+        for (unsigned char byte : bytes)
+        {
+            hash ^= byte;
+            hash *= 0x100000001b3;
+        }
+
+        return hash;
+    }
+} // namespace
+
+
 namespace api
 {
     Simulation::Simulation(Simulation::Parameters parameters)
@@ -69,59 +164,468 @@ namespace api
         assert(short_range_force_ != nullptr && "Failed to construct ShortRangeForce");
     }
 
-    void Simulation::run(echo_chain_type echo_chain)
+    void Simulation::run(echo_chain_type echo_chain, output::OutputService* output_service)
     {
-        using event_stream_type = boost::iostreams::filtering_ostream;
+        using log_stream_type = boost::iostreams::filtering_ostream;
         using file_sink_type = boost::iostreams::file_sink;
-        using file_stream_type = boost::iostreams::stream<file_sink_type>;
 
-        // Set up streams
-        echo_chain.push(file_sink_type{parameters_.event_log_path});
-        event_stream_type event_stream{echo_chain};
+        // With a store, every log but the events and the trajectory goes to a segment of the store
+        std::shared_ptr<output::SweepStore> store;
+        if (!parameters_.store_path.empty())
+        {
+            store = output::SweepStore::open(parameters_.store_path);
+        }
 
-        file_stream_type thermodynamic_stream{
-            file_sink_type{parameters_.thermodynamic_log_path}
-        };
+        auto segment = [&](const char* log) {return store->segment(parameters_.store_run, log);};
+
+        const auto logs = log_files_();
+
+        // Resume from the last checkpoint if there is one, and if every log can be continued
+        // from where the checkpoint left it.  Otherwise we start over.
+        bool checkpointing = parameters_.checkpoint_interval > 0;
+        auto positions = checkpointing ? resumable_log_positions_(logs, store != nullptr)
+            : std::nullopt;
+        bool resuming = positions.has_value();
+
+        // Count the bytes written to each log, so that the checkpoints can record them
+        std::array<ByteCounter, log_count> counters{};
 
-        file_stream_type observation_stream{
-            file_sink_type{parameters_.observation_log_path}
+        if (resuming)
+        {
+            for (size_t i = 0; i < log_count; ++i)
+            {
+                if (!logs[i].used) {continue;}
+
+                counters[i].set((*positions)[i]);
+                std::filesystem::resize_file(logs[i].path, (*positions)[i]);
+            }
+        }
+
+        auto file_mode = [resuming](bool binary)
+        {
+            auto mode = binary ? (std::ios::out | std::ios::binary) : std::ios::out;
+            return resuming ? (mode | std::ios::app) : mode;
         };
 
-        file_stream_type snapshot_stream{
-            file_sink_type{parameters_.snapshot_log_path}
+        // Set up streams.  The events always go to an uncompressed file of their own, which the
+        // EventSink flushes after every event, so that the progress of a run survives a crash.
+        // (A compressor would hold the events back until the end of the run, since neither of
+        // Boost's compressors can flush part of a stream.)
+        echo_chain.push(counters[0]);
+        echo_chain.push(file_sink_type{parameters_.event_log_path, file_mode(false)});
+
+        // We write straight into the chain, since a filtering_ostream would treat the chain as a
+        // single device, which cannot be flushed
+        std::ostream event_stream{&echo_chain.front()};
+
+        // Every other log is a chain of an optional compressor (which therefore runs on the
+        // Logger thread) and a device: a segment of the store, a file written through io_uring,
+        // or an ordinary file.  A store takes precedence over io_uring, since its chunks are
+        // appended by the SweepStore itself.
+        auto open_log = [&](size_t index, bool binary, bool direct = false)
+        {
+            const auto& log = logs[index];
+
+            auto stream = std::make_unique<log_stream_type>();
+            output::push_compressor(*stream, log.compression);
+            stream->push(counters[index]);
+
+            if (store && log.store_name != nullptr) {stream->push(segment(log.store_name));}
+            else if (parameters_.asynchronous_output)
+            {
+                stream->push(output::UringFileSink{
+                    log.path, {.direct = direct, .append = resuming}
+                });
+            }
+            else
+            {
+                binary = binary || (log.compression != output::Compression::none);
+                stream->push(file_sink_type{log.path, file_mode(binary)});
+            }
+
+            return stream;
         };
 
+        bool binary_thermodynamics =
+            (parameters_.thermodynamic_log_format == output::ThermodynamicSink::Format::binary);
+
+        auto thermodynamic_stream = open_log(1, binary_thermodynamics);
+        auto observation_stream = open_log(2, false);
+        auto pair_distribution_stream = logs[3].used ? open_log(3, false)
+            : std::make_unique<log_stream_type>(boost::iostreams::null_sink{});
+        auto energy_histogram_stream = logs[4].used ? open_log(4, false)
+            : std::make_unique<log_stream_type>(boost::iostreams::null_sink{});
+        auto snapshot_stream = open_log(5, false);
+
+        // The trajectory is only written if requested, since it can be very large (and it stays
+        // in a file of its own even with a store)
+        std::unique_ptr<log_stream_type> trajectory_stream;
+
+        if (logs[6].used)
+        {
+            trajectory_stream = open_log(6, true, parameters_.direct_trajectory_output);
+        }
+        else
+        {
+            trajectory_stream = std::make_unique<log_stream_type>(boost::iostreams::null_sink{});
+        }
+
         // Set up logger
         output::Logger logger{output::Logger::Streams{
             .event_log = event_stream,
-            .thermodynamic_log = thermodynamic_stream,
-            .observation_log = observation_stream,
-            .snapshot_log = snapshot_stream
-        }};
+            .thermodynamic_log = *thermodynamic_stream,
+            .observation_log = *observation_stream,
+            .pair_distribution_log = *pair_distribution_stream,
+            .energy_histogram_log = *energy_histogram_stream,
+            .snapshot_log = *snapshot_stream,
+            .trajectory_log = *trajectory_stream
+        },
+            parameters_.thermodynamic_log_format,
+            parameters_.log_queue,
+            output_service,
+            parameters_.thermodynamic_log_reduction,
+            resuming,
+            parameters_.thermodynamic_log_pressure_tensor
+        };
+
+        // The Logger is synced before the counters are read
+        auto log_positions = [&counters]()
+        {
+            std::vector<std::uint64_t> positions;
+            for (const auto& counter : counters) {positions.push_back(counter.count());}
+            return positions;
+        };
         
-        // Create initial state and SimulationController
-        auto initial_state = initial_condition_.system_state();
-        auto simulation_controller = make_simulation_controller_(logger);
+        // Create initial state and SimulationController.  When resuming, the state is restored
+        // from the checkpoint, and any failed warm start was logged by the earlier run.
+        auto initial_state =
+            resuming ? initial_condition_.system_state() : make_initial_state_(logger);
+        auto simulation_controller = make_simulation_controller_(logger, log_positions);
+
+        simulation_controller.set_exchange(parameters_.exchange);
+        simulation_controller.set_trajectory({
+            .box = initial_condition_.bounding_box().array(),
+            .velocities = parameters_.trajectory_velocities,
+            .interval = parameters_.trajectory_interval
+        });
+
+        if (resuming)
+        {
+            std::ifstream checkpoint{parameters_.checkpoint_path, std::ios::binary};
+
+            // The logs were already cut back to the checkpoint, so there is no going back now.
+            // This can only happen if the checkpoint was corrupted after it was written.
+            if (!simulation_controller.restore(checkpoint, initial_state))
+            {
+                std::error_code error;
+                std::filesystem::remove(parameters_.checkpoint_path, error);
+
+                throw std::ios_base::failure(
+                    "Cannot resume from checkpoint " + parameters_.checkpoint_path.string()
+                );
+            }
+        }
 
         // Run the actual simulation
         initial_state | simulation_controller;
+        completed_ = simulation_controller.completed();
+
+        // The run is over, so there is nothing left to resume
+        if (checkpointing)
+        {
+            std::error_code error;
+            std::filesystem::remove(parameters_.checkpoint_path, error);
+        }
 
         // Close the logger
         logger.close();
 
-        // Close the streams (note that event_stream is a different type)
-        event_stream.reset();
-        thermodynamic_stream.close();
-        observation_stream.close();
-        snapshot_stream.close();
+        // Close the streams (resetting a chain closes its compressor and device)
+        echo_chain.reset();
+        thermodynamic_stream->reset();
+        observation_stream->reset();
+        pair_distribution_stream->reset();
+        energy_histogram_stream->reset();
+        snapshot_stream->reset();
+        trajectory_stream->reset();
     }
 
-    control::SimulationController Simulation::make_simulation_controller_(output::Logger& logger)
+    std::array<Simulation::LogFile, Simulation::log_count> Simulation::log_files_() const
     {
+        const auto& compression = parameters_.log_compression;
+
+        // The optional logs are only used if something is written to them
+        bool trajectory = parameters_.trajectory_interval > 0;
+        using ob_parameters_type = control::ObservationPhase::Parameters;
+
+        bool pair_distribution =
+            any_observation_phase_(&ob_parameters_type::pair_distribution_interval);
+        bool energy_histogram =
+            any_observation_phase_(&ob_parameters_type::energy_histogram_bin_width);
+
+        return {{
+            {nullptr, parameters_.event_log_path, output::Compression::none, true},
+            {
+                "thermodynamic_log",
+                parameters_.thermodynamic_log_path,
+                compression.thermodynamic_log,
+                true
+            },
+            {
+                "observation_log",
+                parameters_.observation_log_path,
+                compression.observation_log,
+                true
+            },
+            {
+                "pair_distribution_log",
+                parameters_.pair_distribution_log_path,
+                compression.pair_distribution_log,
+                pair_distribution
+            },
+            {
+                "energy_histogram_log",
+                parameters_.energy_histogram_log_path,
+                compression.energy_histogram_log,
+                energy_histogram
+            },
+            {"snapshot_log", parameters_.snapshot_log_path, compression.snapshot_log, true},
+            {nullptr, parameters_.trajectory_log_path, compression.trajectory_log, trajectory}
+        }};
+    }
+
+    std::optional<int> Simulation::resumable_time_step() const
+    {
+        if (parameters_.checkpoint_interval <= 0
+            || !resumable_log_positions_(log_files_(), !parameters_.store_path.empty()))
+        {
+            return {};
+        }
+
+        std::ifstream checkpoint{parameters_.checkpoint_path, std::ios::binary};
+        return control::SimulationController::checkpoint_time_step(checkpoint, parameter_hash_());
+    }
+
+    std::optional<std::vector<std::uint64_t>> Simulation::resumable_log_positions_(
+        const std::array<LogFile, log_count>& logs, bool store
+    ) const
+    {
+        if (!std::filesystem::exists(parameters_.checkpoint_path)) {return {};}
+
+        std::ifstream checkpoint{parameters_.checkpoint_path, std::ios::binary};
+        auto positions = control::SimulationController::log_positions(
+            checkpoint, parameter_hash_()
+        );
+
+        if (!positions || positions->size() != log_count) {return {};}
+
+        for (size_t i = 0; i < log_count; ++i)
+        {
+            const auto& log = logs[i];
+            if (!log.used) {continue;}
+
+            // A compressed log cannot be cut off at an arbitrary point and continued, nor can a
+            // segment of the store which was never closed.  A file may also be shorter than the
+            // checkpoint says if it was not all written out before the crash.  The trajectory
+            // has no header until its first frame, and a continued log never gets one.
+            std::error_code error;
+            auto size = std::filesystem::file_size(log.path, error);
+
+            if (log.compression != output::Compression::none
+                || (store && log.store_name != nullptr)
+                || error
+                || size < (*positions)[i]
+                || (log.path == parameters_.trajectory_log_path && (*positions)[i] == 0))
+            {
+                return {};
+            }
+        }
+
+        return positions;
+    }
+
+    physics::SystemState Simulation::make_initial_state_(output::Logger& logger)
+    {
+        bool from_store =
+            !parameters_.initial_snapshot_run.empty() && !parameters_.store_path.empty();
+
+        if ((parameters_.initial_snapshot_path.empty() && !from_store)
+            || parameters_.initial_snapshot_density <= 0)
+        {
+            return initial_condition_.system_state();
+        }
+
+        // A snapshot which cannot be used is not an error, since e.g. the neighbouring run of a
+        // sweep may have been aborted before it wrote one, but it is recorded in the events log
+        auto fall_back = [this, &logger](std::string reason)
+        {
+            logger.log(0, output::WarmStartFailedEvent{std::move(reason)});
+            return initial_condition_.system_state();
+        };
+
+        std::optional<output::SystemSnapshot> snapshot;
+        std::string snapshot_name;
+
+        if (from_store)
+        {
+            snapshot_name = "the snapshot log of run " + parameters_.initial_snapshot_run;
+
+            auto contents = output::SweepStore::open(parameters_.store_path)->read(
+                parameters_.initial_snapshot_run, "snapshot_log"
+            );
+
+            if (!contents) {return fall_back("Cannot find " + snapshot_name + " in the store");}
+
+            std::istringstream source{output::decompress(std::move(*contents))};
+            snapshot = output::read_snapshot(source);
+        }
+        else
+        {
+            snapshot_name = parameters_.initial_snapshot_path.string();
+
+            auto source = output::open_input(parameters_.initial_snapshot_path);
+
+            if (!*source) {return fall_back("Cannot open " + snapshot_name);}
+
+            snapshot = output::read_snapshot(*source);
+        }
+
+        if (!snapshot) {return fall_back("No snapshot in " + snapshot_name);}
+
+        int particle_count = parameters_.system_parameters.particle_count;
+        auto snapshot_count = snapshot->data->positions.cols();
+
+        if (snapshot_count != particle_count)
+        {
+            return fall_back(
+                "The snapshot in " + snapshot_name + " has " + std::to_string(snapshot_count)
+                    + " particles rather than " + std::to_string(particle_count)
+            );
+        }
+
+        physics::SystemState reference_state{particle_count};
+        reference_state.positions = snapshot->data->positions;
+        reference_state.velocities = snapshot->data->velocities;
+
+        return engine::InitialCondition{
+            parameters_.system_parameters,
+            reference_state,
+            parameters_.initial_snapshot_density,
+            parameters_.random_seed,
+            parameters_.redraw_initial_velocities
+        }.system_state();
+    }
+
+    std::uint64_t Simulation::parameter_hash_() const
+    {
+        // Everything which affects the evolution of the system or the contents of the logs, but
+        // not where the logs are written, nor how (the queue, backend, or store)
+        std::ostringstream out;
+
+        tools::write_binary(out, parameters_.system_parameters.temperature);
+        tools::write_binary(out, parameters_.system_parameters.density);
+        tools::write_binary(out, parameters_.system_parameters.particle_count);
+        tools::write_binary(out, Eigen::Matrix4Xd{parameters_.unit_cell});
+
+        tools::write_binary(out, parameters_.initial_snapshot_path.string());
+        tools::write_binary(out, parameters_.initial_snapshot_density);
+        tools::write_binary(out, parameters_.initial_snapshot_run);
+        tools::write_binary(out, parameters_.redraw_initial_velocities);
+        tools::write_binary(out, parameters_.random_seed);
+
+        std::visit(
+            tools::OverloadedVisitor{
+                [&out](physics::LennardJonesForce::Parameters lj_parameters)
+                {tools::write_binary(out, lj_parameters.cutoff_distance);}
+            },
+            parameters_.force_parameters
+        );
+
+        tools::write_binary(out, parameters_.time_delta);
+
+        for (const auto& [name, phase_parameters] : parameters_.schedule_parameters)
+        {
+            tools::write_binary(out, name);
+            tools::write_binary(out, static_cast<std::uint64_t>(phase_parameters.index()));
+            std::visit(
+                [&out](const auto& parameters) {write_phase_parameters(out, parameters);},
+                phase_parameters
+            );
+        }
+
+        tools::write_binary(out, parameters_.pair_distribution_bins);
+
+        tools::write_binary(out, static_cast<int>(parameters_.thermodynamic_log_format));
+        tools::write_binary(out, static_cast<int>(parameters_.thermodynamic_log_reduction.mode));
+        tools::write_binary(out, parameters_.thermodynamic_log_reduction.interval);
+        tools::write_binary(out, parameters_.thermodynamic_log_pressure_tensor);
+        tools::write_binary(out, parameters_.trajectory_interval);
+        tools::write_binary(out, parameters_.trajectory_velocities);
+
+        for (auto compression : {
+            parameters_.log_compression.thermodynamic_log,
+            parameters_.log_compression.observation_log,
+            parameters_.log_compression.pair_distribution_log,
+            parameters_.log_compression.energy_histogram_log,
+            parameters_.log_compression.snapshot_log,
+            parameters_.log_compression.trajectory_log
+        })
+        {
+            tools::write_binary(out, static_cast<int>(compression));
+        }
+
+        return fnv1a(out.view());
+    }
+
+    template<class T>
+    bool Simulation::any_observation_phase_(
+        T control::ObservationPhase::Parameters::* parameter
+    ) const
+    {
+        for (const auto& [name, phase_parameters] : parameters_.schedule_parameters)
+        {
+            if (auto ob_phase_parameters =
+                std::get_if<control::ObservationPhase::Parameters>(&phase_parameters))
+            {
+                if (ob_phase_parameters->*parameter > 0) {return true;}
+            }
+        }
+
+        return false;
+    }
+
+    control::SimulationController Simulation::make_simulation_controller_(
+        output::Logger& logger, std::function<std::vector<std::uint64_t> ()> log_positions
+    )
+    {
+        // The pair distribution histogram is filled by the integrator and read by the phases
+        using ob_parameters_type = control::ObservationPhase::Parameters;
+
+        auto pair_distribution =
+            any_observation_phase_(&ob_parameters_type::pair_distribution_interval)
+            ? std::make_shared<physics::PairDistributionHistogram>(
+                parameters_.system_parameters,
+                short_range_force_->cutoff_distance(),
+                parameters_.pair_distribution_bins
+            )
+            : nullptr;
+
+        // The virial tensor is needed for the log, or for the shear viscosity
+        bool virial_tensor = parameters_.thermodynamic_log_pressure_tensor;
+
+        for (const auto& [name, phase_parameters] : parameters_.schedule_parameters)
+        {
+            if (auto ob_phase_parameters =
+                std::get_if<control::ObservationPhase::Parameters>(&phase_parameters))
+            {
+                virial_tensor = virial_tensor || ob_phase_parameters->correlation_levels > 0;
+            }
+        }
+
         // First build the integrator
         auto integrator = engine::Integrator::Builder(parameters_.time_delta)
             .bounding_box(initial_condition_.bounding_box())
-            .short_range_force(*short_range_force_)
+            .short_range_force(*short_range_force_, pair_distribution, virial_tensor)
             .build();
         
         // Next assemble the scheduler
@@ -142,15 +646,34 @@ namespace api
             if (auto ob_phase_parameters =
                 std::get_if<control::ObservationPhase::Parameters>(&phase_parameters))
             {
+                // Measure the order parameter at the Bragg peak of our own initial lattice
+                if (ob_phase_parameters->structure_factor_wavenumbers.empty())
+                {
+                    ob_phase_parameters->structure_factor_wavenumbers = tools::CubicLattice{
+                        parameters_.system_parameters, parameters_.unit_cell
+                    }.bragg_wavenumbers();
+                }
+
                 schedule.push(
                     std::make_unique<control::ObservationPhase>(
-                        name, parameters_.system_parameters, *ob_phase_parameters
+                        name, parameters_.system_parameters, *ob_phase_parameters,
+                        pair_distribution
                     )
                 );
             }
         }
 
         // Finally return the SimulationController
-        return {std::move(integrator), std::move(schedule), logger};
+        return {
+            std::move(integrator),
+            std::move(schedule),
+            logger,
+            control::SimulationController::Checkpointing{
+                .path = parameters_.checkpoint_path,
+                .interval = parameters_.checkpoint_interval,
+                .parameter_hash = parameter_hash_(),
+                .log_positions = std::move(log_positions)
+            }
+        };
     }
 } // namespace api
@@ -23,9 +23,13 @@
 #ifndef LJ_SIMULATION_HPP
 #define LJ_SIMULATION_HPP
 
+#include <array>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <variant>
 #include <random>
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <utility>
@@ -40,7 +44,9 @@
 #include <lennardjonesium/physics/forces.hpp>
 #include <lennardjonesium/physics/lennard_jones_force.hpp>
 #include <lennardjonesium/engine/initial_condition.hpp>
+#include <lennardjonesium/output/output_service.hpp>
 #include <lennardjonesium/output/logger.hpp>
+#include <lennardjonesium/output/compression.hpp>
 #include <lennardjonesium/control/simulation_phase.hpp>
 #include <lennardjonesium/control/simulation_controller.hpp>
 
@@ -59,6 +65,8 @@ namespace api
          * 
          *  Information:
          *      parameters():   Get the parameters used to define the simulation
+         *      completed():    Whether the last run completed its schedule without aborting
+         *      resumable_time_step():  The time step at which run() would resume, if it would
          * 
          *  Used for making plots:
          *      potential():    Evaluate the potential for a given separation distance
@@ -66,6 +74,17 @@ namespace api
          *      force():        Evaluate the force for a given separation distance
          * 
          * NOTE: Whenever the simulation is re-run, the files it generated will be overwritten.
+         * 
+         * If checkpointing is enabled, run() first looks for a checkpoint left behind by an
+         * interrupted run with the same parameters, and if it finds one, resumes from there.
+         * Each checkpoint records how far each log had been written, so the logs are cut back
+         * to that point and continued, and end up the same as if the run had not been
+         * interrupted.  (Only the events log shows that the phase was started again.)  Since a
+         * compressed log, or a log in the store, cannot be continued, such runs start over
+         * instead.  The checkpoint is removed once the run finishes.
+         * 
+         * The initial snapshot (for warm starts) is only read when run() is called, so that
+         * the snapshot may be produced by another simulation which runs first.
          */
 
         using force_parameter_type = std::variant<
@@ -93,6 +112,19 @@ namespace api
                 // Unit cell type for the initial lattice
                 tools::CubicLattice::UnitCell unit_cell = tools::CubicLattice::FaceCentered();
 
+                // Optionally, a snapshot file from another simulation to warm start from (if
+                // empty, we start from the lattice instead, as we do if the file cannot be used,
+                // in which case a WarmStartFailedEvent gives the reason)
+                std::filesystem::path initial_snapshot_path = {};
+                double initial_snapshot_density = 0.0;
+
+                // Alternatively, a run in the output store (see store_path) whose snapshot log to
+                // warm start from
+                std::string initial_snapshot_run = {};
+
+                // Whether to keep the velocities of the initial snapshot, or to draw new ones
+                bool redraw_initial_velocities = false;
+
                 // The random seed to use for initial state construction
                 std::random_device::result_type random_seed =
                     engine::InitialCondition::random_number_engine_type::default_seed;
@@ -110,11 +142,63 @@ namespace api
                         {"Observation Phase", control::ObservationPhase::Parameters{}}
                     };
                 
+                // Number of bins in the pair distribution histogram (which extends to the cutoff).
+                // The pair distribution and energy histogram logs are only written if some
+                // ObservationPhase samples them.
+                int pair_distribution_bins = 100;
+
+                // Time steps between checkpoints (0 disables checkpointing)
+                int checkpoint_interval = 0;
+
+                // Hooks for replica exchange (see ReplicaExchange); disabled by default
+                control::SimulationController::Exchange exchange = {};
+
                 // Filesystem defaults simply place files at top level in the working directory
                 std::filesystem::path event_log_path = "events.log";
                 std::filesystem::path thermodynamic_log_path = "thermodynamics.csv";
                 std::filesystem::path observation_log_path = "observations.csv";
+                std::filesystem::path pair_distribution_log_path = "pair_distribution.csv";
+                std::filesystem::path energy_histogram_log_path = "energy_histogram.csv";
                 std::filesystem::path snapshot_log_path = "snapshots.csv";
+                std::filesystem::path trajectory_log_path = "trajectory.bin";
+                std::filesystem::path checkpoint_path = "checkpoint.bin";
+
+                // If store_path is given, the logs (other than the events, the trajectory, and the
+                // checkpoint) are written to that output::SweepStore under the name store_run,
+                // instead of to the paths above
+                std::filesystem::path store_path = {};
+                std::string store_run = {};
+
+                // The thermodynamic log may be written in a compact binary format instead of CSV
+                output::ThermodynamicSink::Format thermodynamic_log_format =
+                    output::ThermodynamicSink::Format::csv;
+
+                // Whether to write every measurement, or only every k-th measurement, or
+                // statistics of blocks of k measurements (see output::ThermodynamicReduction)
+                output::ThermodynamicReduction thermodynamic_log_reduction = {};
+
+                // Whether the thermodynamic log includes the virial and kinetic tensors.  The
+                // virial tensor is only computed if this is set, or if an ObservationPhase uses
+                // the Green-Kubo correlators.
+                bool thermodynamic_log_pressure_tensor = false;
+
+                // Time steps between frames of the trajectory log; 0 disables it (and the file
+                // is not created)
+                int trajectory_interval = 0;
+                bool trajectory_velocities = true;
+
+                // Capacity of the queue to the Logger thread, and what to do when it is full
+                output::LogQueue log_queue = {};
+
+                // Compression of each log (see output::LogCompression)
+                output::LogCompression log_compression = {};
+
+                // Write the logs (other than the event log) asynchronously through io_uring, and
+                // optionally bypass the page cache for the trajectory (see UringFileSink).  This
+                // only applies to logs written to files, so with a store_path, it only affects
+                // the trajectory.
+                bool asynchronous_output = false;
+                bool direct_trajectory_output = false;
             };
 
             explicit Simulation(Parameters parameters);
@@ -140,10 +224,21 @@ namespace api
                 Echo() = delete;
             };
 
-            void run(echo_chain_type = Echo::Silent());
+            // If an OutputService is given, the output is written by its threads, rather than by
+            // a thread started for this run
+            void run(
+                echo_chain_type = Echo::Silent(),
+                output::OutputService* output_service = nullptr
+            );
 
             Parameters parameters() {return parameters_;}
 
+            // Whether the last run() completed its schedule (false if it was aborted)
+            bool completed() const {return completed_;}
+
+            // If run() would resume from a checkpoint, the time step at which it was taken
+            std::optional<int> resumable_time_step() const;
+
             // Evaluate the basic functions that describe the force.  Useful for plotting.
             double potential(double distance) {return short_range_force_->potential(distance);}
             double virial(double distance) {return short_range_force_->virial(distance);}
@@ -157,8 +252,46 @@ namespace api
             // other ShortRangeForces in the future
             std::unique_ptr<const physics::ShortRangeForce> short_range_force_;
 
-            // Construct the SimulationController from the local parameters and a Logger
-            control::SimulationController make_simulation_controller_(output::Logger&);
+            bool completed_{false};
+
+            // Get the initial state, from the initial snapshot if there is one
+            physics::SystemState make_initial_state_(output::Logger& logger);
+
+            // The files of the logs, in the order of output::Logger::Streams
+            static constexpr size_t log_count = 7;
+
+            struct LogFile
+            {
+                const char* store_name;         // Name in the store, if it can go there
+                std::filesystem::path path;
+                output::Compression compression;
+                bool used;
+            };
+
+            // The logs, in the order of output::Logger::Streams (and of the log positions which
+            // the checkpoints record)
+            std::array<LogFile, log_count> log_files_() const;
+
+            // If the checkpoint can be resumed, and every log can be continued from where the
+            // checkpoint left it, get the positions of the logs
+            std::optional<std::vector<std::uint64_t>> resumable_log_positions_(
+                const std::array<LogFile, log_count>& logs, bool store
+            ) const;
+
+            // Identifies the parameters in the checkpoints, so that a checkpoint is only resumed
+            // by the same simulation
+            std::uint64_t parameter_hash_() const;
+
+            // Whether any ObservationPhase of the schedule has a positive value of the given
+            // parameter (e.g. whether any phase samples the pair distribution)
+            template<class T>
+            bool any_observation_phase_(T control::ObservationPhase::Parameters::* parameter) const;
+
+            // Construct the SimulationController from the local parameters and a Logger (and a
+            // function to report the positions of the logs for the checkpoints)
+            control::SimulationController make_simulation_controller_(
+                output::Logger&, std::function<std::vector<std::uint64_t> ()> log_positions
+            );
     };
 } // namespace api
 
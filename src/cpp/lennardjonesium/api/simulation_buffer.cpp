@@ -27,6 +27,7 @@
 #include <boost/iostreams/chain.hpp>
 
 #include <lennardjonesium/tools/text_buffer.hpp>
+#include <lennardjonesium/output/output_service.hpp>
 #include <lennardjonesium/api/simulation.hpp>
 #include <lennardjonesium/api/simulation_buffer.hpp>
 
@@ -48,8 +49,8 @@ namespace api
                 Simulation::echo_chain_type echo_chain{};
                 echo_chain.push(tools::TextBufferFilter(*buffer));
 
-                // Run the simulation
-                simulation.run(echo_chain);
+                // Run the simulation (sharing the output threads with any other simulations)
+                simulation.run(echo_chain, &output::OutputService::shared());
 
                 // Free our copy of the shared buffer (should happen automatically)
                 buffer.reset();
@@ -25,14 +25,21 @@
 #include <thread>
 #include <algorithm>
 #include <ranges>
+#include <utility>
 
 #include <lennardjonesium/tools/message_buffer.hpp>
+#include <lennardjonesium/output/output_service.hpp>
 #include <lennardjonesium/api/simulation.hpp>
 #include <lennardjonesium/api/simulation_pool.hpp>
 
 namespace api
 {
-    SimulationPool::SimulationPool(int thread_count)
+    SimulationPool::SimulationPool(
+        int thread_count,
+        bool record_completed,
+        output::OutputService& output_service
+    )
+        : output_service_{output_service}, record_completed_{record_completed}
     {
         // Populate the thread pool
         for (auto i [[maybe_unused]] : std::views::iota(0, thread_count))
@@ -66,10 +73,17 @@ namespace api
         ++started_;
     }
 
-    void SimulationPool::increment_completed_()
+    void SimulationPool::increment_completed_(Simulation& simulation)
     {
         std::lock_guard<std::mutex> lock(mutex_);
         ++completed_;
+        if (record_completed_) {completed_jobs_.push_back(&simulation);}
+    }
+
+    std::vector<Simulation*> SimulationPool::take_completed()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return std::exchange(completed_jobs_, {});
     }
 
     void SimulationPool::wait()
@@ -95,8 +109,8 @@ namespace api
         while (auto job = pool_.jobs_.get())
         {
             pool_.increment_started_();
-            job.value().get().run();
-            pool_.increment_completed_();
+            job.value().get().run(Simulation::Echo::Silent(), &pool_.output_service_);
+            pool_.increment_completed_(job.value().get());
         }
     }
 } // namespace api
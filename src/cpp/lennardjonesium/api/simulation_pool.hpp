@@ -29,6 +29,7 @@
 #include <functional>
 
 #include <lennardjonesium/tools/message_buffer.hpp>
+#include <lennardjonesium/output/output_service.hpp>
 #include <lennardjonesium/api/simulation.hpp>
 
 namespace api
@@ -39,6 +40,9 @@ namespace api
          * SimulationPool is a thread pool for running batches of simulations in parallel.  The
          * simulation jobs themselves are run without printing anything to stdout.  One should also
          * take care that the simulation jobs are given different filepaths for the output files.
+         * 
+         * The output of every job is written by the threads of one OutputService (by default the
+         * process-wide one), so the workers do not each start an output thread of their own.
          */
 
         public:
@@ -71,8 +75,22 @@ namespace api
             // Get the current Status
             Status status();
 
-            // We initialize the SimulationPool with the number of threads to use
-            explicit SimulationPool(int thread_count = 4);
+            // Take the jobs which have completed since the last call, in order of completion.
+            // This allows the caller to react to results (e.g. by pushing more jobs) while the
+            // pool is still running.  The completed jobs are only recorded if the pool was
+            // constructed with record_completed, otherwise this is always empty.
+            std::vector<Simulation*> take_completed();
+
+            // The number of worker threads, i.e. the number of jobs which can run at once
+            int thread_count() const {return static_cast<int>(threads_.size());}
+
+            // We initialize the SimulationPool with the number of threads to use, and whether to
+            // record the completed jobs for take_completed()
+            explicit SimulationPool(
+                int thread_count = 4,
+                bool record_completed = false,
+                output::OutputService& output_service = output::OutputService::shared()
+            );
 
             // Waits for any remaining jobs to finish before destruction
             ~SimulationPool() noexcept;
@@ -96,16 +114,20 @@ namespace api
             // The job queue
             tools::MessageBuffer<std::reference_wrapper<Simulation>> jobs_;
 
+            output::OutputService& output_service_;
+            bool record_completed_;
+
             // These track the state of the queue
             std::mutex mutex_;
             int queued_{};
             int started_{};
             int completed_{};
+            std::vector<Simulation*> completed_jobs_;
 
             // These wrap mutex accesses for changing the state
             void increment_queued_();
             void increment_started_();
-            void increment_completed_();
+            void increment_completed_(Simulation& simulation);
     };
 } // namespace api
 
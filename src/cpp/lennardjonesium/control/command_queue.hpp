@@ -28,6 +28,8 @@
 #include <variant>
 
 #include <lennardjonesium/physics/observation.hpp>
+#include <lennardjonesium/physics/energy_histogram.hpp>
+#include <lennardjonesium/physics/pair_distribution.hpp>
 
 namespace control
 {
@@ -53,6 +55,18 @@ namespace control
         physics::Observation observation;
     };
 
+    // Record the pair distribution function accumulated over a phase
+    struct RecordPairDistribution
+    {
+        physics::PairDistributionHistogram::Result pair_distribution;
+    };
+
+    // Record the potential energy histogram accumulated over a phase
+    struct RecordEnergyHistogram
+    {
+        physics::EnergyHistogram energy_histogram;
+    };
+
     // Adjust the temperature of the system
     struct AdjustTemperature
     {
@@ -73,6 +87,8 @@ namespace control
     using Command = std::variant<
         AdvanceTime,
         RecordObservation,
+        RecordPairDistribution,
+        RecordEnergyHistogram,
         AdjustTemperature,
         PhaseComplete,
         AbortSimulation
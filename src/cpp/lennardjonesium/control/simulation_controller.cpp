@@ -22,8 +22,25 @@
 
 #include <variant>
 #include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <lennardjonesium/tools/overloaded_visitor.hpp>
+#include <lennardjonesium/tools/binary_stream.hpp>
+#include <lennardjonesium/tools/frame_pool.hpp>
 #include <lennardjonesium/physics/system_state.hpp>
 #include <lennardjonesium/physics/transformations.hpp>
 #include <lennardjonesium/physics/measurements.hpp>
@@ -34,18 +51,290 @@
 #include <lennardjonesium/control/simulation_phase.hpp>
 #include <lennardjonesium/control/simulation_controller.hpp>
 
+namespace
+{
+    void write_state(std::ostream& out, const physics::SystemState& state)
+    {
+        tools::write_binary(out, state.time);
+        tools::write_binary(out, state.potential_energy);
+        tools::write_binary(out, state.virial);
+        tools::write_binary(out, state.virial_tensor);
+        tools::write_binary(out, state.positions);
+        tools::write_binary(out, state.velocities);
+        tools::write_binary(out, state.displacements);
+        tools::write_binary(out, state.forces);
+    }
+
+    void read_state(std::istream& in, physics::SystemState& state)
+    {
+        tools::read_binary(in, state.time);
+        tools::read_binary(in, state.potential_energy);
+        tools::read_binary(in, state.virial);
+        tools::read_binary(in, state.virial_tensor);
+        tools::read_binary(in, state.positions);
+        tools::read_binary(in, state.velocities);
+        tools::read_binary(in, state.displacements);
+        tools::read_binary(in, state.forces);
+    }
+
+    // Write the contents to a new file and wait until they are on disk
+    std::error_code write_durably(const std::filesystem::path& path, std::string_view contents)
+    {
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {return {errno, std::system_category()};}
+
+        std::error_code error;
+
+        while (!contents.empty())
+        {
+            ssize_t written = ::write(fd, contents.data(), contents.size());
+
+            if (written < 0)
+            {
+                if (errno == EINTR) {continue;}
+                error = {errno, std::system_category()};
+                break;
+            }
+
+            contents.remove_prefix(written);
+        }
+
+        if (!error && ::fsync(fd) < 0) {error = {errno, std::system_category()};}
+        if (::close(fd) < 0 && !error) {error = {errno, std::system_category()};}
+
+        return error;
+    }
+
+    // Persist the entries of a directory (the checkpoint is still complete if this fails; it
+    // is merely the rename which might be lost in a crash)
+    void sync_directory(const std::filesystem::path& directory)
+    {
+        auto path = directory.empty() ? std::filesystem::path{"."} : directory;
+
+        int fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) {return;}
+
+        ::fsync(fd);
+        ::close(fd);
+    }
+} // namespace
+
+
 namespace control
 {
+    void SimulationController::save(
+        std::ostream& out, int time_step, const physics::SystemState& state
+    ) const
+    {
+        out.write(checkpoint_signature, sizeof(checkpoint_signature));
+        tools::write_binary(out, checkpoint_version);
+        tools::write_binary(out, checkpointing_.parameter_hash);
+        tools::write_binary(
+            out,
+            checkpointing_.log_positions
+                ? checkpointing_.log_positions() : std::vector<std::uint64_t>{}
+        );
+
+        tools::write_binary(out, time_step);
+        tools::write_binary(out, completed_phases_);
+        write_state(out, state);
+
+        simulation_phases_.front()->save(out);
+
+        std::ostringstream exchange;
+        if (exchange_.save) {exchange_.save(exchange);}
+        tools::write_binary(out, exchange.str());
+    }
+
+    std::optional<std::vector<std::uint64_t>> SimulationController::log_positions(
+        std::istream& in, std::uint64_t parameter_hash
+    )
+    {
+        std::array<char, sizeof(checkpoint_signature)> signature{};
+        std::uint32_t version{0};
+        std::uint64_t saved_parameter_hash{0};
+        std::vector<std::uint64_t> positions;
+
+        in.read(signature.data(), signature.size());
+        tools::read_binary(in, version);
+
+        // Do not read any further if the layout might be different
+        if (!in || !std::equal(signature.begin(), signature.end(), checkpoint_signature)
+            || version != checkpoint_version)
+        {
+            return {};
+        }
+
+        tools::read_binary(in, saved_parameter_hash);
+        tools::read_binary(in, positions);
+
+        if (!in || saved_parameter_hash != parameter_hash) {return {};}
+
+        return positions;
+    }
+
+    std::optional<int> SimulationController::checkpoint_time_step(
+        std::istream& in, std::uint64_t parameter_hash
+    )
+    {
+        if (!log_positions(in, parameter_hash)) {return {};}
+
+        int time_step{0};
+        tools::read_binary(in, time_step);
+
+        if (!in) {return {};}
+
+        return time_step;
+    }
+
+    bool SimulationController::restore(std::istream& in, physics::SystemState& state)
+    {
+        if (!log_positions(in, checkpointing_.parameter_hash)) {return false;}
+
+        int time_step{0};
+        int completed_phases{0};
+        physics::SystemState restored_state;
+
+        tools::read_binary(in, time_step);
+        tools::read_binary(in, completed_phases);
+        read_state(in, restored_state);
+
+        if (!in
+            || completed_phases < completed_phases_
+            || completed_phases - completed_phases_
+                >= static_cast<int>(simulation_phases_.size())
+            || restored_state.particle_count() != state.particle_count())
+        {
+            return false;
+        }
+
+        // Skip the phases which were already complete, and restore the current one
+        for (; completed_phases_ < completed_phases; ++completed_phases_)
+        {
+            simulation_phases_.pop();
+        }
+
+        simulation_phases_.front()->restore(in);
+
+        std::string exchange;
+        tools::read_binary(in, exchange);
+
+        if (!in) {return false;}
+
+        if (exchange_.restore)
+        {
+            std::istringstream exchange_in{exchange};
+            if (!exchange_.restore(exchange_in)) {return false;}
+        }
+
+        state = std::move(restored_state);
+        resume_time_step_ = time_step;
+
+        return true;
+    }
+
+    void SimulationController::write_checkpoint_(
+        int time_step, const physics::SystemState& state
+    ) const
+    {
+        auto temporary_path = checkpointing_.path;
+        temporary_path += ".tmp";
+
+        // The positions of the logs are only meaningful once everything before the checkpoint
+        // has been written
+        if (checkpointing_.log_positions) {logger_.sync();}
+
+        std::ostringstream out;
+        save(out, time_step, state);
+
+        // The contents must be on disk before the rename, otherwise a crash could leave the
+        // renamed checkpoint empty.  Never replace a good checkpoint with a bad one.
+        if (auto error = write_durably(temporary_path, out.view()))
+        {
+            std::error_code ignored;
+            std::filesystem::remove(temporary_path, ignored);
+
+            logger_.log(time_step, output::CheckpointFailedEvent{
+                "cannot write " + temporary_path.string() + ": " + error.message()
+            });
+
+            return;
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temporary_path, checkpointing_.path, error);
+
+        if (error)
+        {
+            logger_.log(time_step, output::CheckpointFailedEvent{
+                "cannot replace " + checkpointing_.path.string() + ": " + error.message()
+            });
+
+            return;
+        }
+
+        // Make the rename itself durable
+        sync_directory(checkpointing_.path.parent_path());
+    }
+
     physics::SystemState& SimulationController::operator() (physics::SystemState& state)
     {
         // Clock for counting the global time
-        int time_step = 0;
+        int time_step = resume_time_step_.value_or(0);
+        int last_checkpoint_time = time_step;
+
+        // Exchanges and frames fall on multiples of their intervals.  A resumed simulation picks
+        // up the same clocks, including an exchange which was due just after the checkpoint.
+        auto last_time = [time_step](int interval, bool due)
+        {
+            if (interval <= 0) {return time_step;}
+            int remainder = time_step % interval;
+            return time_step - ((remainder == 0 && due) ? interval : remainder);
+        };
+
+        int last_exchange_time = last_time(exchange_.interval, resume_time_step_.has_value());
+        int last_trajectory_time = last_time(trajectory_.interval, false);
 
         // Measuring device to get the instantaneous thermodynamic information
         physics::ThermodynamicMeasurement measurement;
 
-        // Initialize the first SimulationPhase
-        simulation_phases_.front()->set_start_time(time_step);
+        // The trajectory frames are copied into frames which are allocated here and reused once
+        // the Logger has written them, so that logging them never allocates
+        tools::FramePool<output::TrajectoryFrame::Data> trajectory_frames{
+            4,
+            output::TrajectoryFrame::Data{
+                .time = state.time,
+                .box = trajectory_.box,
+                .positions = (trajectory_.interval > 0) ? state.positions : Eigen::Matrix4Xd{},
+                .velocities = (trajectory_.interval > 0 && trajectory_.velocities)
+                    ? state.velocities : Eigen::Matrix4Xd{}
+            }
+        };
+
+        // A measurement is logged at every time step, so there must be a frame for every message
+        // which can wait in the Logger's queue, besides the one held back by the coalesce policy,
+        // the one being written, and the one being filled.  With fewer, acquire() would stall the
+        // simulation before the queue policy has a say.
+        tools::FramePool<physics::ThermodynamicMeasurement::Result> thermodynamic_frames{
+            logger_.capacity() + 3
+        };
+
+        // A snapshot is only taken at the end of the run, so its one frame is not preallocated
+        // (which would only allocate the same matrices sooner, in every run), but allocated when
+        // it is first filled
+        tools::FramePool<output::SystemSnapshot::Data> snapshot_frames{1};
+
+        auto snapshot = [&snapshot_frames, &state]()
+        {
+            auto frame = snapshot_frames.acquire();
+            frame->positions = state.positions;
+            frame->velocities = state.velocities;
+            frame->forces = state.forces;
+            return output::SystemSnapshot{std::move(frame)};
+        };
+
+        // Initialize the first SimulationPhase (unless it was resumed from a checkpoint)
+        if (!resume_time_step_) {simulation_phases_.front()->set_start_time(time_step);}
 
         // Log phase start event
         logger_.log(time_step, output::PhaseStartEvent{simulation_phases_.front()->name()});
@@ -59,12 +348,58 @@ namespace control
         {
             [&](const AdvanceTime& command)
             {
+                // Nothing else is waiting in the CommandQueue, so now is a safe time to checkpoint
+                if (this->checkpointing_.interval > 0
+                    && time_step - last_checkpoint_time >= this->checkpointing_.interval)
+                {
+                    this->write_checkpoint_(time_step, state);
+                    last_checkpoint_time = time_step;
+                }
+
+                // Likewise, this is a safe time to swap the state with another replica
+                if (this->exchange_.interval > 0
+                    && time_step - last_exchange_time >= this->exchange_.interval)
+                {
+                    if (auto event = this->exchange_.exchange(state))
+                    {
+                        this->logger_.log(time_step, *event);
+
+                        // The state now continues the trajectory of another replica
+                        if (event->accepted)
+                        {
+                            this->simulation_phases_.front()->restart_trajectory();
+                        }
+                    }
+
+                    last_exchange_time = time_step;
+                }
+
                 state | (*this->integrator_)(command.time_steps) | measurement;
 
                 // Log the measurement
-                this->logger_.log(time_step, output::ThermodynamicData{measurement.result()});
+                auto thermodynamic_frame = thermodynamic_frames.acquire();
+                *thermodynamic_frame = measurement.result();
+                this->logger_.log(
+                    time_step, output::ThermodynamicData{std::move(thermodynamic_frame)}
+                );
 
                 time_step += command.time_steps;
+
+                if (this->trajectory_.interval > 0
+                    && time_step - last_trajectory_time >= this->trajectory_.interval)
+                {
+                    auto frame = trajectory_frames.acquire();
+                    frame->time = state.time;
+                    frame->box = this->trajectory_.box;
+                    frame->positions = state.positions;
+                    if (this->trajectory_.velocities) {frame->velocities = state.velocities;}
+
+                    this->logger_.log(time_step, output::TrajectoryFrame{std::move(frame)});
+
+                    last_trajectory_time = time_step;
+                }
+
+                this->simulation_phases_.front()->observe(state);
                 this->simulation_phases_.front()->evaluate(command_queue, time_step, measurement);
             },
 
@@ -77,6 +412,22 @@ namespace control
                 this->logger_.log(time_step, output::RecordObservationEvent{});
             },
 
+            [&](const RecordPairDistribution& command)
+            {
+                // Send pair distribution function to file
+                this->logger_.log(time_step, output::PairDistributionData{
+                    command.pair_distribution
+                });
+            },
+
+            [&](const RecordEnergyHistogram& command)
+            {
+                // Send potential energy histogram to file
+                this->logger_.log(time_step, output::EnergyHistogramData{
+                    command.energy_histogram
+                });
+            },
+
             [&](const AdjustTemperature& command)
             {
                 state | physics::set_temperature(command.target_temperature);
@@ -96,15 +447,12 @@ namespace control
                 });
                 
                 this->simulation_phases_.pop();
+                ++this->completed_phases_;
 
                 if (this->simulation_phases_.empty())
                 {
                     // If we are finished, then record a snapshot
-                    this->logger_.log(time_step, output::SystemSnapshot{
-                        .positions = state.positions,
-                        .velocities = state.velocities,
-                        .forces = state.forces
-                    });
+                    this->logger_.log(time_step, snapshot());
                 }
                 else
                 {
@@ -127,11 +475,7 @@ namespace control
                 this->logger_.log(time_step, output::AbortSimulationEvent{command.reason});
 
                 // Log snapshot in case we would like it for diagnostic reasons
-                this->logger_.log(time_step, output::SystemSnapshot{
-                    .positions = state.positions,
-                    .velocities = state.velocities,
-                    .forces = state.forces
-                });
+                this->logger_.log(time_step, snapshot());
             }
         };
         
@@ -142,6 +486,9 @@ namespace control
             command_queue.pop();
         }
 
+        // Other replicas should not wait for this one any more
+        if (exchange_.leave) {exchange_.leave();}
+
         return state;
     }
 } // namespace control
@@ -24,12 +24,22 @@
 #define LJ_SIMULATION_CONTROLLER_HPP
 
 #include <cassert>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <istream>
+#include <optional>
+#include <ostream>
 #include <queue>
 #include <utility>
 #include <memory>
+#include <vector>
+
+#include <Eigen/Dense>
 
 #include <lennardjonesium/physics/system_state.hpp>
 #include <lennardjonesium/engine/integrator.hpp>
+#include <lennardjonesium/output/log_message.hpp>
 #include <lennardjonesium/output/logger.hpp>
 #include <lennardjonesium/control/simulation_phase.hpp>
 
@@ -44,33 +54,154 @@ namespace control
          * responsible for keeping track of the time step count, as well as pushing relevant data
          * to various message queues.
          * 
-         * TODO: We have implemented the main message queue, however one thing we'd like to add is
-         * some output of the full system trajectory.  This could be used to draw to the screen,
-         * or write to a file which could afterwards be used to make a movie.  The system trajectory
-         * should get its own buffer, as it will require some special handling.
+         * The SimulationController can also record frames of the trajectory at regular
+         * intervals (see output::TrajectorySink), which can afterwards be used to make a movie or
+         * for further analysis.
+         * 
+         * The SimulationController can also write checkpoints at regular intervals, from which an
+         * interrupted simulation can be resumed.  A checkpoint is a versioned binary file which
+         * contains a hash of the simulation parameters (see Checkpointing), the positions of the
+         * logs, the time step, the position in the schedule, the full SystemState, and whatever
+         * the current SimulationPhase saves of its clocks and collected data.  It is written to a
+         * temporary file, synced to disk, and then renamed over the previous checkpoint, so that
+         * a simulation killed while writing one still leaves the last complete checkpoint
+         * behind.  If a checkpoint cannot be written, the failure is reported in the events log,
+         * and the previous checkpoint is kept.
+         * 
+         * Checkpoints are only taken just before advancing time, when the CommandQueue holds
+         * nothing else, so that no pending Commands are lost.  The evolution itself needs no
+         * random number generator state, because it is deterministic once the initial state is
+         * created.  Replica exchange does draw random numbers, so its state is saved in the
+         * checkpoint as well (see Exchange).
+         * 
+         * For replica exchange, the SimulationController can also offer its state for exchange
+         * at regular intervals (at the same point as checkpoints).  The exchange function may
+         * replace the state by that of another replica, and returns an event to be logged if an
+         * exchange was attempted.  If the exchange was accepted, the current SimulationPhase
+         * restarts whatever it follows along the trajectory.  Once the schedule is over (or
+         * aborted), the leave function is called, so that the other replicas no longer wait for
+         * this one.  The save and restore functions add the state of the exchange to the
+         * checkpoints.
          */
 
         public:
             using Schedule = std::queue<std::unique_ptr<SimulationPhase>>;
 
+            struct Checkpointing
+            {
+                std::filesystem::path path{};
+                int interval{0};                // Time steps between checkpoints; 0 disables
+
+                // Identifies the parameters of the simulation, so that a checkpoint is never
+                // resumed by a simulation with different ones
+                std::uint64_t parameter_hash{0};
+
+                // If given, the Logger is synced before each checkpoint, and this reports how far
+                // each log got, so that a resumed simulation can continue the logs from there
+                std::function<std::vector<std::uint64_t> ()> log_positions{};
+            };
+
+            struct Exchange
+            {
+                using event_type = std::optional<output::ReplicaExchangeEvent>;
+
+                std::function<event_type (physics::SystemState&)> exchange{};
+                std::function<void ()> leave{};
+
+                // Save and restore the state of the exchange (e.g. its random number generator)
+                // with the checkpoints; restore returns false if the saved state is unusable
+                std::function<void (std::ostream&)> save{};
+                std::function<bool (std::istream&)> restore{};
+
+                int interval{0};                // Time steps between exchanges; 0 disables
+            };
+
+            struct Trajectory
+            {
+                Eigen::Array4d box{Eigen::Array4d::Ones()};
+                bool velocities{true};          // Whether to record velocities as well
+                int interval{0};                // Time steps between frames; 0 disables
+            };
+
+            // Identifies checkpoint files, and must be incremented whenever their layout changes
+            static constexpr char checkpoint_signature[8] = "LJCHKPT";
+            static constexpr std::uint32_t checkpoint_version = 7;
+
             physics::SystemState& operator() (physics::SystemState&);
 
             SimulationController(
                 std::unique_ptr<const engine::Integrator> integrator,
                 Schedule schedule,
-                output::Logger& logger
+                output::Logger& logger,
+                Checkpointing checkpointing
             )
                 : integrator_{std::move(integrator)},
                   simulation_phases_{std::move(schedule)},
-                  logger_{logger}
+                  logger_{logger},
+                  checkpointing_{checkpointing}
             {
                 assert(integrator_ != nullptr && "No Integrator instance given");
             }
+
+            // Without checkpointing
+            SimulationController(
+                std::unique_ptr<const engine::Integrator> integrator,
+                Schedule schedule,
+                output::Logger& logger
+            )
+                : SimulationController{
+                    std::move(integrator), std::move(schedule), logger, Checkpointing{}
+                }
+            {}
+
+            // Write a checkpoint of the given state (and of this controller) to a binary stream
+            void save(std::ostream& out, int time_step, const physics::SystemState& state) const;
+
+            /**
+             * Restore the state and schedule from a checkpoint, so that the next run continues
+             * from where the checkpoint was taken.  Returns false if the checkpoint cannot be
+             * used (wrong version, different parameter hash or particle count, or truncated).
+             * In that case, the state is left untouched, but the SimulationController may have
+             * been partially restored and should be discarded.
+             */
+            bool restore(std::istream& in, physics::SystemState& state);
+
+            // Read the log positions saved in a checkpoint, if it was written by a simulation
+            // with the given parameter hash
+            static std::optional<std::vector<std::uint64_t>> log_positions(
+                std::istream& in, std::uint64_t parameter_hash
+            );
+
+            // Likewise, read the time step at which a checkpoint was taken
+            static std::optional<int> checkpoint_time_step(
+                std::istream& in, std::uint64_t parameter_hash
+            );
+
+            // Whether every phase of the schedule ran to completion (i.e. nothing aborted)
+            bool completed() const {return simulation_phases_.empty();}
+
+            // Take part in replica exchange (must be set before restoring or running)
+            void set_exchange(Exchange exchange) {exchange_ = std::move(exchange);}
+
+            // Record the trajectory (must be set before running)
+            void set_trajectory(Trajectory trajectory) {trajectory_ = trajectory;}
         
         private:
             std::unique_ptr<const engine::Integrator> integrator_;
             Schedule simulation_phases_;
             output::Logger& logger_;
+            Checkpointing checkpointing_;
+            Exchange exchange_{};
+            Trajectory trajectory_{};
+
+            // Number of phases already popped from the schedule
+            int completed_phases_{0};
+
+            // If restored from a checkpoint, the time step at which to resume
+            std::optional<int> resume_time_step_{};
+
+            // Write a checkpoint file atomically
+            void write_checkpoint_(int time_step, const physics::SystemState& state) const;
     };
 } // namespace control
 
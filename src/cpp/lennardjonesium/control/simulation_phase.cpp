@@ -20,15 +20,36 @@
  * <https://www.gnu.org/licenses/>.
  */
 
+#include <cmath>
+#include <istream>
+#include <ostream>
+#include <utility>
+
 #include <lennardjonesium/tools/math.hpp>
+#include <lennardjonesium/tools/binary_stream.hpp>
+#include <lennardjonesium/tools/cubic_lattice.hpp>
 #include <lennardjonesium/tools/moving_sample.hpp>
+#include <lennardjonesium/physics/system_state.hpp>
 #include <lennardjonesium/physics/measurements.hpp>
 #include <lennardjonesium/physics/observation.hpp>
+#include <lennardjonesium/physics/correlators.hpp>
+#include <lennardjonesium/physics/pair_distribution.hpp>
+#include <lennardjonesium/physics/structure_factor.hpp>
 #include <lennardjonesium/control/command_queue.hpp>
 #include <lennardjonesium/control/simulation_phase.hpp>
 
 namespace control
 {
+    void SimulationPhase::save(std::ostream& out) const
+    {
+        tools::write_binary(out, start_time_);
+    }
+
+    void SimulationPhase::restore(std::istream& in)
+    {
+        tools::read_binary(in, start_time_);
+    }
+
     EquilibrationPhase::EquilibrationPhase(
         std::string name,
         tools::SystemParameters system_parameters,
@@ -46,6 +67,15 @@ namespace control
         // Collect temperature sample every time step
         temperature_analyzer_.collect(measurement);
 
+        // Both series have the same block length, so they complete their blocks together
+        bool new_block = false;
+
+        if (equilibration_parameters_.drift_threshold > 0)
+        {
+            new_block = temperature_drift_.push_back(measurement.result().temperature);
+            potential_energy_drift_.push_back(measurement.result().potential_energy);
+        }
+
         // Check whether adjustment is needed
         if (time_step - last_adjustment_check_time_
             >= equilibration_parameters_.adjustment_interval) [[unlikely]]
@@ -61,6 +91,35 @@ namespace control
                     .measured_temperature = last_temperature_,
                     .target_temperature = system_parameters_.temperature
                 });
+
+                // The rescaling is a step in both series, so test only what comes after it
+                temperature_drift_.clear();
+                potential_energy_drift_.clear();
+                drift_passes_ = 0;
+            }
+        }
+
+        // When a block is completed, check whether both series have stopped drifting, and
+        // return early if they have passed enough consecutive checks
+        if (new_block) [[unlikely]]
+        {
+            bool stationary =
+                temperature_drift_.stationary(
+                    equilibration_parameters_.drift_threshold,
+                    equilibration_parameters_.drift_block_count)
+                && potential_energy_drift_.stationary(
+                    equilibration_parameters_.drift_threshold,
+                    equilibration_parameters_.drift_block_count)
+                && tools::relative_error(
+                    temperature_analyzer_.result(), system_parameters_.temperature)
+                        < equilibration_parameters_.tolerance;
+
+            drift_passes_ = stationary ? drift_passes_ + 1 : 0;
+
+            if (drift_passes_ >= equilibration_parameters_.drift_pass_count)
+            {
+                command_queue.push(PhaseComplete{});
+                return;
             }
         }
 
@@ -83,12 +142,49 @@ namespace control
         command_queue.push(AdvanceTime{});
     }
 
+    void EquilibrationPhase::save(std::ostream& out) const
+    {
+        SimulationPhase::save(out);
+
+        tools::write_binary(out, last_adjustment_check_time_);
+        tools::write_binary(out, last_adjustment_time_);
+        tools::write_binary(out, last_temperature_);
+        temperature_analyzer_.save(out);
+        temperature_drift_.save(out);
+        potential_energy_drift_.save(out);
+        tools::write_binary(out, drift_passes_);
+    }
+
+    void EquilibrationPhase::restore(std::istream& in)
+    {
+        SimulationPhase::restore(in);
+
+        tools::read_binary(in, last_adjustment_check_time_);
+        tools::read_binary(in, last_adjustment_time_);
+        tools::read_binary(in, last_temperature_);
+        temperature_analyzer_.restore(in);
+        temperature_drift_.restore(in);
+        potential_energy_drift_.restore(in);
+        tools::read_binary(in, drift_passes_);
+    }
+
     ObservationPhase::ObservationPhase(
         std::string name,
         tools::SystemParameters system_parameters,
         int start_time
     )
-        : ObservationPhase::ObservationPhase(name, system_parameters, {}, start_time)
+        : ObservationPhase::ObservationPhase(name, system_parameters, Parameters{}, start_time)
+    {}
+
+    ObservationPhase::ObservationPhase(
+        std::string name,
+        tools::SystemParameters system_parameters,
+        Parameters observation_parameters,
+        int start_time
+    )
+        : ObservationPhase::ObservationPhase(
+            name, system_parameters, observation_parameters, nullptr, start_time
+        )
     {}
 
     void ObservationPhase::evaluate(
@@ -99,6 +195,18 @@ namespace control
     {
         // Collect relevant data every time step
         thermodynamic_analyzer_.collect(measurement);
+        block_averaging_analyzer_.collect(measurement);
+        if (energy_histogram_analyzer_) {energy_histogram_analyzer_->collect(measurement);}
+
+        // Set if the latest Observation is precise enough to stop early
+        bool converged = false;
+
+        // The sample will be taken during the next force calculation
+        if (pair_distribution_
+            && (time_step - start_time_) % observation_parameters_.pair_distribution_interval == 0)
+        {
+            pair_distribution_->request_sample();
+        }
 
         // Check whether we should compute an Observation
         if (time_step - last_observation_time_
@@ -107,12 +215,36 @@ namespace control
             last_observation_time_ = time_step;
 
             auto observation = thermodynamic_analyzer_.result();
+            auto standard_errors = block_averaging_analyzer_.result();
+
+            observation.temperature_error = standard_errors.temperature;
+            observation.total_energy_error = standard_errors.total_energy;
+            observation.pressure_error = standard_errors.pressure;
+            observation.specific_heat_error = standard_errors.specific_heat;
+
+            if (transport_correlator_ && transport_correlator_->sample_size() > 1)
+            {
+                auto transport = transport_correlator_->result();
+
+                observation.green_kubo_diffusion_coefficient = transport.diffusion_coefficient;
+                observation.shear_viscosity = transport.shear_viscosity;
+            }
+
+            if (structure_factor_measurement_ && structure_factor_measurement_->sample_count() > 0)
+            {
+                auto structure_factor = structure_factor_measurement_->result();
+
+                observation.order_parameter = structure_factor.order_parameter;
+                structure_factor_measurement_->clear();
+            }
 
             // Check whether the temperature has drifted too far from the nominal value
             if (tools::relative_error(observation.temperature, system_parameters_.temperature)
                 >= observation_parameters_.tolerance) [[unlikely]]
             {
-                // Issue abort command and return early
+                // Keep the pair distribution sampled so far, since it shows what the system
+                // turned into; then issue abort command and return early
+                record_pair_distribution_(command_queue);
                 command_queue.push(AbortSimulation{"Temperature drifted outside acceptable range"});
                 return;
             }
@@ -120,12 +252,22 @@ namespace control
             {
                 ++observation_count_;
                 command_queue.push(RecordObservation{observation});
+
+                converged = converged_(observation);
             }
         }
 
         // Check whether we have collected enough Observations and return early
-        if (observation_count_ >= observation_parameters_.observation_count) [[unlikely]]
+        if (converged || observation_count_ >= observation_parameters_.observation_count)
+            [[unlikely]]
         {
+            record_pair_distribution_(command_queue);
+
+            if (energy_histogram_analyzer_ && energy_histogram_analyzer_->sample_size() > 0)
+            {
+                command_queue.push(RecordEnergyHistogram{energy_histogram_analyzer_->result()});
+            }
+
             command_queue.push(PhaseComplete{});
             return;
         }
@@ -133,5 +275,122 @@ namespace control
         // If we reach here, add the default command to advance to next time step
         command_queue.push(AdvanceTime{});
     }
-} // namespace control
 
+    void ObservationPhase::record_pair_distribution_(CommandQueue& command_queue) const
+    {
+        if (pair_distribution_ && pair_distribution_->sample_count() > 0)
+        {
+            command_queue.push(RecordPairDistribution{pair_distribution_->result()});
+        }
+    }
+
+    void ObservationPhase::observe(const physics::SystemState& state)
+    {
+        if (transport_correlator_) {state | *transport_correlator_;}
+        if (structure_factor_measurement_) {state | *structure_factor_measurement_;}
+    }
+
+    void ObservationPhase::save(std::ostream& out) const
+    {
+        /**
+         * The multiple-tau correlators hold a history of the velocities of every particle at
+         * every level, which would make the checkpoints many times larger than the state itself.
+         * So after a restart, the Green-Kubo quantities are computed from the data collected
+         * since the restart only.  The structure factor is averaged only between consecutive
+         * Observations, so at most one such window is affected.
+         */
+        SimulationPhase::save(out);
+
+        tools::write_binary(out, last_observation_time_);
+        tools::write_binary(out, observation_count_);
+        thermodynamic_analyzer_.save(out);
+        block_averaging_analyzer_.save(out);
+
+        tools::write_binary(out, pair_distribution_ != nullptr);
+        if (pair_distribution_) {pair_distribution_->save(out);}
+
+        tools::write_binary(out, energy_histogram_analyzer_.has_value());
+        if (energy_histogram_analyzer_) {energy_histogram_analyzer_->save(out);}
+    }
+
+    void ObservationPhase::restore(std::istream& in)
+    {
+        SimulationPhase::restore(in);
+
+        tools::read_binary(in, last_observation_time_);
+        tools::read_binary(in, observation_count_);
+        thermodynamic_analyzer_.restore(in);
+        block_averaging_analyzer_.restore(in);
+
+        bool has_pair_distribution{false};
+        tools::read_binary(in, has_pair_distribution);
+
+        // Only restore the histogram if this phase is set up to sample one
+        if (has_pair_distribution)
+        {
+            if (pair_distribution_) {pair_distribution_->restore(in);}
+            else {in.setstate(std::ios::failbit);}
+        }
+
+        bool has_energy_histogram{false};
+        tools::read_binary(in, has_energy_histogram);
+
+        if (has_energy_histogram)
+        {
+            if (energy_histogram_analyzer_) {energy_histogram_analyzer_->restore(in);}
+            else {in.setstate(std::ios::failbit);}
+        }
+    }
+
+    bool ObservationPhase::converged_(const physics::Observation& observation) const
+    {
+        const auto& parameters = observation_parameters_;
+
+        if (observation_count_ < parameters.minimum_observation_count) {return false;}
+
+        // Each pair holds a standard error and the value it should be small relative to
+        std::pair<double, double> estimates[] = {
+            {observation.total_energy_error, observation.total_energy},
+            {observation.pressure_error, observation.pressure},
+            {observation.specific_heat_error, observation.specific_heat}
+        };
+
+        double tolerances[] = {
+            parameters.energy_error_tolerance,
+            parameters.pressure_error_tolerance,
+            parameters.specific_heat_error_tolerance
+        };
+
+        bool enabled = false;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            if (tolerances[i] <= 0) {continue;}
+            enabled = true;
+
+            auto [error, value] = estimates[i];
+            if (!(error <= tolerances[i] * std::abs(value))) {return false;}
+        }
+
+        return enabled;
+    }
+
+    void ObservationPhase::make_structure_factor_measurement_()
+    {
+        // The CubicLattice always fills a cube of volume N / density
+        tools::CubicLattice lattice{system_parameters_};
+
+        if (observation_parameters_.structure_factor_wavenumbers.empty())
+        {
+            observation_parameters_.structure_factor_wavenumbers = lattice.bragg_wavenumbers();
+        }
+
+        structure_factor_measurement_.emplace(
+            lattice.bounding_box(),
+            physics::StructureFactorMeasurement::Parameters{
+                .wavenumbers = observation_parameters_.structure_factor_wavenumbers,
+                .stride = observation_parameters_.structure_factor_interval
+            }
+        );
+    }
+} // namespace control
@@ -23,14 +23,25 @@
 #ifndef LJ_SIMULATION_PHASE_HPP
 #define LJ_SIMULATION_PHASE_HPP
 
+#include <istream>
 #include <memory>
 #include <limits>
+#include <optional>
+#include <ostream>
 #include <string>
+#include <vector>
+
+#include <Eigen/Dense>
 
 #include <lennardjonesium/tools/system_parameters.hpp>
 #include <lennardjonesium/tools/moving_sample.hpp>
+#include <lennardjonesium/tools/drift_test.hpp>
+#include <lennardjonesium/physics/system_state.hpp>
 #include <lennardjonesium/physics/measurements.hpp>
 #include <lennardjonesium/physics/analyzers.hpp>
+#include <lennardjonesium/physics/correlators.hpp>
+#include <lennardjonesium/physics/pair_distribution.hpp>
+#include <lennardjonesium/physics/structure_factor.hpp>
 #include <lennardjonesium/control/command_queue.hpp>
 
 namespace control
@@ -56,12 +67,37 @@ namespace control
                 const physics::ThermodynamicMeasurement& measurement
             ) = 0;
 
+            /**
+             * Some phases need more than the thermodynamic information (e.g. the velocities, in
+             * order to compute time correlation functions).  The SimulationController passes the
+             * full SystemState after every time step, before calling evaluate().  By default,
+             * it is ignored.
+             */
+            virtual void observe(const physics::SystemState& state [[maybe_unused]]) {}
+
             std::string name() {return name_;}
             int start_time() {return start_time_;}
             
             // Derived classes may have further work to do
             virtual void set_start_time(int start_time) {start_time_ = start_time;}
 
+            /**
+             * The SimulationController calls this when the state has been replaced by a different
+             * configuration (e.g. by replica exchange).  Quantities which follow the trajectory
+             * through time, such as time correlation functions, must then start over, since the
+             * trajectory is no longer continuous.  By default, there are none.
+             */
+            virtual void restart_trajectory() {}
+
+            /**
+             * For checkpoints, a SimulationPhase must be able to save its clocks and collected
+             * data to a binary stream, and restore them later so that it can continue as if it
+             * had never been interrupted.  restore() must not be confused with set_start_time():
+             * it resumes a phase that is already in progress.
+             */
+            virtual void save(std::ostream& out) const;
+            virtual void restore(std::istream& in);
+
             virtual ~SimulationPhase() = default;
         
         protected:
@@ -107,6 +143,20 @@ namespace control
          * 
          * timeout:  If we pass this number of time steps without reaching equilibrium, then we
          *      determine that the system cannot equilibrate and we abort the simulation.
+         * 
+         * drift_threshold:  If positive, the phase can also complete before steady_state_time,
+         *      once the temperature and potential energy series are both stationary and the
+         *      temperature is within tolerance.  Each series is tested for drift by fitting a line
+         *      to its block means (blocks of sample_size time steps) since the last adjustment;
+         *      it is stationary if the t-statistic of the slope is below this value.  The test is
+         *      made only when a new block has been completed.
+         * 
+         * drift_block_count:  The minimum number of complete blocks which must be fitted before
+         *      the stationarity test is trusted.
+         * 
+         * drift_pass_count:  The number of consecutive tests (i.e. blocks) which must pass before
+         *      the phase completes, since a single test of a noisy series passes by chance now
+         *      and then.
          */
 
         public:
@@ -117,6 +167,9 @@ namespace control
                 int adjustment_interval = 200;
                 int steady_state_time = 1000;
                 int timeout = 5000;
+                double drift_threshold = 0.0;
+                int drift_block_count = 10;
+                int drift_pass_count = 3;
             };
 
             // Set all clocks to match start time
@@ -136,6 +189,8 @@ namespace control
             )
                 : SimulationPhase{name},
                   temperature_analyzer_(system_parameters, equilibration_parameters.sample_size),
+                  temperature_drift_{equilibration_parameters.sample_size},
+                  potential_energy_drift_{equilibration_parameters.sample_size},
                   system_parameters_{system_parameters},
                   equilibration_parameters_{equilibration_parameters}
             {set_start_time(start_time);}
@@ -153,14 +208,20 @@ namespace control
                 int time_step,
                 const physics::ThermodynamicMeasurement& measurement
             ) override;
+
+            virtual void save(std::ostream& out) const override;
+            virtual void restore(std::istream& in) override;
         
         private:
             physics::TemperatureAnalyzer temperature_analyzer_;
+            tools::DriftTest temperature_drift_;
+            tools::DriftTest potential_energy_drift_;
             tools::SystemParameters system_parameters_;
             Parameters equilibration_parameters_;
             double last_temperature_{std::numeric_limits<double>::signaling_NaN()};
             int last_adjustment_check_time_;
             int last_adjustment_time_;
+            int drift_passes_{0};
     };
 
     class ObservationPhase : public SimulationPhase
@@ -191,6 +252,52 @@ namespace control
          *      given tolerance, then the experiment will be ended; however, observations made
          *      up to that point should be valid (since they were made at a temperature within
          *      the allowed tolerance.)
+         * 
+         * correlation_levels:  The number of levels in the multiple-tau correlators used to
+         *      compute the Green-Kubo diffusion coefficient and shear viscosity.  The longest
+         *      correlation time is 8 * 2^correlation_levels time steps (so 8 levels cover 2048
+         *      time steps).  The correlators keep a history of every velocity at every level, so
+         *      they are off by default (0), and the Green-Kubo quantities are then reported as
+         *      zero.
+         * 
+         * pair_distribution_interval:  The number of time steps between samples of the pair
+         *      distribution function g(r).  The samples are taken by the short-range force
+         *      calculation, from a PairDistributionHistogram shared with this phase; if no
+         *      histogram is given (or the interval is 0, the default), g(r) is not sampled.  The
+         *      histogram accumulates over the whole phase and is recorded once, when the phase
+         *      completes (or is aborted).  Without it, the pair distribution log is not written at
+         *      all.  An interval of about 10 resolves g(r) well.
+         * 
+         * structure_factor_interval:  The number of time steps between measurements of the
+         *      static structure factor S(k), from which the order parameter is computed.  Each
+         *      Observation reports the average over the measurements since the previous one.
+         *      A value of 0 disables the measurement, and the order parameter is reported as 0.
+         * 
+         * structure_factor_wavenumbers:  The wavevectors at which to measure S(k), as integer
+         *      multiples of 2 pi / L.  If empty, the first Bragg peak of the face-centered
+         *      CubicLattice for these SystemParameters is used.
+         * 
+         * energy_error_tolerance, pressure_error_tolerance, specific_heat_error_tolerance:
+         *      Relative tolerances for early stopping.  If any of them is positive, the phase
+         *      completes as soon as every positive one is met, i.e. the block-averaged standard
+         *      error of that quantity is at most the given fraction of its observed value.  The
+         *      observation_count is then a maximum, which bounds the running time for state
+         *      points that converge slowly (or whose observed value is close to zero).
+         * 
+         * minimum_observation_count:  The number of Observations to make before early stopping
+         *      is considered, so that the blocking analysis has enough data to be trusted.
+         * 
+         * energy_histogram_bin_width:  The width (per particle) of the bins of the potential
+         *      energy histogram, which is accumulated at every time step over the whole phase and
+         *      recorded once, when the phase completes.  The histogram can be used to reweight
+         *      the results to nearby temperatures (see physics::HistogramReweighting).  A value
+         *      of 0 (the default) disables the histogram, since it is only needed for
+         *      reweighting; a width of about 0.005 resolves it well.
+         * 
+         * The means reported in each Observation are taken over the most recent sample_size
+         * measurements.  The standard errors, on the other hand, are block-averaged over every
+         * measurement made since the start of the ObservationPhase, and hence estimate the
+         * uncertainty of the phase-long averages.
          */
 
         public:
@@ -200,6 +307,15 @@ namespace control
                 int sample_size = 50;
                 int observation_interval = 200;
                 int observation_count = 20;
+                int correlation_levels = 0;
+                int pair_distribution_interval = 0;
+                int structure_factor_interval = 10;
+                std::vector<Eigen::Vector4i> structure_factor_wavenumbers{};
+                double energy_error_tolerance = 0.0;
+                double pressure_error_tolerance = 0.0;
+                double specific_heat_error_tolerance = 0.0;
+                int minimum_observation_count = 5;
+                double energy_histogram_bin_width = 0.0;
             };
 
             // Set all clocks to match start time
@@ -207,6 +323,9 @@ namespace control
             {
                 start_time_ = start_time;
                 last_observation_time_ = start_time;
+
+                // Discard any samples collected before this phase started
+                if (pair_distribution_) {pair_distribution_->clear();}
             }
 
             // Main constructor requires all arguments
@@ -214,13 +333,52 @@ namespace control
                 std::string name,
                 tools::SystemParameters system_parameters,
                 Parameters observation_parameters,
+                std::shared_ptr<physics::PairDistributionHistogram> pair_distribution,
                 int start_time = 0
             )
                 : SimulationPhase{name},
                   thermodynamic_analyzer_{system_parameters, observation_parameters.sample_size},
+                  block_averaging_analyzer_{system_parameters},
                   system_parameters_{system_parameters},
                   observation_parameters_{observation_parameters}
-            {set_start_time(start_time);}
+            {
+                if (observation_parameters_.pair_distribution_interval > 0)
+                {
+                    pair_distribution_ = std::move(pair_distribution);
+                }
+
+                if (observation_parameters_.structure_factor_interval > 0)
+                {
+                    make_structure_factor_measurement_();
+                }
+
+                if (observation_parameters_.energy_histogram_bin_width > 0)
+                {
+                    energy_histogram_analyzer_.emplace(
+                        system_parameters, observation_parameters_.energy_histogram_bin_width
+                    );
+                }
+
+                if (observation_parameters_.correlation_levels > 0)
+                {
+                    transport_correlator_.emplace(
+                        system_parameters,
+                        physics::TransportCorrelator::Parameters{
+                            .level_count = observation_parameters_.correlation_levels
+                        }
+                    );
+                }
+
+                set_start_time(start_time);
+            }
+
+            // If no histogram is given, g(r) will not be sampled
+            ObservationPhase(
+                std::string name,
+                tools::SystemParameters system_parameters,
+                Parameters observation_parameters,
+                int start_time = 0
+            );
 
             // If no parameters given, use defaults
             ObservationPhase(
@@ -235,13 +393,40 @@ namespace control
                 int time_step,
                 const physics::ThermodynamicMeasurement& measurement
             ) override;
+
+            // Feed the velocities and stresses to the transport correlator
+            virtual void observe(const physics::SystemState& state) override;
+
+            // Discard the time correlations and mean square displacements collected so far
+            virtual void restart_trajectory() override
+            {
+                thermodynamic_analyzer_.clear_mean_square_displacement();
+                if (transport_correlator_) {transport_correlator_->clear();}
+            }
+
+            // The transport correlator and structure factor are not saved; see the .cpp file
+            virtual void save(std::ostream& out) const override;
+            virtual void restore(std::istream& in) override;
         
         private:
             physics::ThermodynamicAnalyzer thermodynamic_analyzer_;
+            physics::BlockAveragingAnalyzer block_averaging_analyzer_;
+            std::optional<physics::EnergyHistogramAnalyzer> energy_histogram_analyzer_;
+            std::optional<physics::TransportCorrelator> transport_correlator_;
+            std::shared_ptr<physics::PairDistributionHistogram> pair_distribution_;
+            std::optional<physics::StructureFactorMeasurement> structure_factor_measurement_;
             tools::SystemParameters system_parameters_;
             Parameters observation_parameters_;
             int last_observation_time_;
             int observation_count_{0};
+
+            void make_structure_factor_measurement_();
+
+            // Whether the standard errors in the Observation meet the early stopping tolerances
+            bool converged_(const physics::Observation& observation) const;
+
+            // Send the pair distribution to the log, if it has been sampled
+            void record_pair_distribution_(CommandQueue& command_queue) const;
     };
 
 } // namespace control
@@ -25,19 +25,75 @@
 #include <utility>
 #include <ranges>
 
+#include <Eigen/Dense>
+
 #include <lennardjonesium/physics/system_state.hpp>
 #include <lennardjonesium/physics/forces.hpp>
+#include <lennardjonesium/physics/pair_distribution.hpp>
 #include <lennardjonesium/engine/particle_pair_filter.hpp>
 #include <lennardjonesium/engine/force_calculation.hpp>
 
+namespace
+{
+    struct VirialTensorSum
+    {
+        /**
+         * The virial tensor is symmetric (for central pair forces, r F^T is symmetric because F
+         * is parallel to r), so we only accumulate its six independent components, and fill in
+         * the matrix once at the end.
+         */
+
+        double xx{0}, yy{0}, zz{0}, xy{0}, xz{0}, yz{0};
+
+        void add(const Eigen::Vector4d& r, const Eigen::Vector4d& f)
+        {
+            xx += r(0) * f(0);
+            yy += r(1) * f(1);
+            zz += r(2) * f(2);
+            xy += r(0) * f(1);
+            xz += r(0) * f(2);
+            yz += r(1) * f(2);
+        }
+
+        // A background force need not be parallel to the position, so we keep the symmetric part
+        void add_symmetrized(const Eigen::Vector4d& r, const Eigen::Vector4d& f)
+        {
+            xx += r(0) * f(0);
+            yy += r(1) * f(1);
+            zz += r(2) * f(2);
+            xy += 0.5 * (r(0) * f(1) + r(1) * f(0));
+            xz += 0.5 * (r(0) * f(2) + r(2) * f(0));
+            yz += 0.5 * (r(1) * f(2) + r(2) * f(1));
+        }
+
+        void add_to(Eigen::Matrix4d& tensor) const
+        {
+            tensor(0, 0) += xx;
+            tensor(1, 1) += yy;
+            tensor(2, 2) += zz;
+            tensor(0, 1) += xy;
+            tensor(1, 0) += xy;
+            tensor(0, 2) += xz;
+            tensor(2, 0) += xz;
+            tensor(1, 2) += yz;
+            tensor(2, 1) += yz;
+        }
+    };
+} // namespace
+
+
 namespace engine
 {
     ShortRangeForceCalculation::ShortRangeForceCalculation(
         const physics::ShortRangeForce& short_range_force,
-        std::unique_ptr<ParticlePairFilter> particle_pair_filter
+        std::unique_ptr<ParticlePairFilter> particle_pair_filter,
+        std::shared_ptr<physics::PairDistributionHistogram> pair_distribution,
+        bool virial_tensor
     )
         : short_range_force_{short_range_force},
-          particle_pair_filter_{std::move(particle_pair_filter)}
+          particle_pair_filter_{std::move(particle_pair_filter)},
+          pair_distribution_{std::move(pair_distribution)},
+          virial_tensor_{virial_tensor}
     {
         // assert(short_range_force_ != nullptr && "No ShortRangeForce given");
         assert(particle_pair_filter_ != nullptr && "No ParticlePairFilter given");
@@ -49,15 +105,24 @@ namespace engine
         /**
          * We need to get the ForceContribution from each pair of particles and add them to the
          * system state.  We use the particle pair filter to obtain pairs that are within the
-         * cutoff distance of each other.
+         * cutoff distance of each other.  If a pair distribution sample has been requested, we
+         * also bin each pair distance while we are here, and likewise accumulate the virial
+         * tensor if it was asked for.
          */
 
         // First clear the dynamical quantities
         state | physics::clear_dynamics;
 
+        bool sample_pair_distribution =
+            pair_distribution_ && pair_distribution_->sample_requested();
+
+        VirialTensorSum virial_tensor;
+
         // Now iterate over the pairs of particles
         for (const auto& pair : particle_pair_filter_->pairs(state))
         {
+            if (sample_pair_distribution) {pair_distribution_->add(pair.square_distance);}
+
             auto force_contribution = short_range_force_.compute(pair.separation);
 
             state.forces.col(pair.first) += force_contribution.force;
@@ -65,14 +130,20 @@ namespace engine
 
             state.potential_energy += force_contribution.potential;
             state.virial += force_contribution.virial;
+
+            if (virial_tensor_) {virial_tensor.add(pair.separation, force_contribution.force);}
         }
 
+        if (sample_pair_distribution) {pair_distribution_->complete_sample();}
+        if (virial_tensor_) {virial_tensor.add_to(state.virial_tensor);}
+
         return state;
     }
 
     BackgroundForceCalculation::BackgroundForceCalculation
-        (const physics::BackgroundForce& background_force)
-        : background_force_{background_force}
+        (const physics::BackgroundForce& background_force, bool virial_tensor)
+        : background_force_{background_force},
+          virial_tensor_{virial_tensor}
     {
         // assert(background_force_ != nullptr && "No BackgroundForce given");
     }
@@ -87,6 +158,8 @@ namespace engine
         // First clear the dynamical quantities
         state | physics::clear_dynamics;
 
+        VirialTensorSum virial_tensor;
+
         // Now iterate over the particles
         for (int i : std::views::iota(0, state.particle_count()))
         {
@@ -95,8 +168,15 @@ namespace engine
             state.forces.col(i) += force_contribution.force;
             state.potential_energy += force_contribution.potential;
             state.virial += force_contribution.virial;
+
+            if (virial_tensor_)
+            {
+                virial_tensor.add_symmetrized(state.positions.col(i), force_contribution.force);
+            }
         }
 
+        if (virial_tensor_) {virial_tensor.add_to(state.virial_tensor);}
+
         return state;
     }
 } // namespace engine
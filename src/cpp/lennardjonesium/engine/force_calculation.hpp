@@ -27,6 +27,7 @@
 
 #include <lennardjonesium/physics/system_state.hpp>
 #include <lennardjonesium/physics/forces.hpp>
+#include <lennardjonesium/physics/pair_distribution.hpp>
 #include <lennardjonesium/engine/particle_pair_filter.hpp>
 
 namespace engine
@@ -62,10 +63,22 @@ namespace engine
 
     class ShortRangeForceCalculation : public ForceCalculation
     {
+        /**
+         * ShortRangeForceCalculation visits every pair of particles within the cutoff distance.
+         * Since this is also what is needed to compute the pair distribution function, it can
+         * optionally be given a PairDistributionHistogram, which it will fill from the same pair
+         * loop whenever the histogram has requested a sample.
+         * 
+         * The virial tensor (needed for the pressure tensor and the shear viscosity) is only
+         * accumulated if asked for; otherwise it is left at zero.
+         */
+
         public:
             ShortRangeForceCalculation(
                 const physics::ShortRangeForce& short_range_force,
-                std::unique_ptr<ParticlePairFilter> particle_pair_filter
+                std::unique_ptr<ParticlePairFilter> particle_pair_filter,
+                std::shared_ptr<physics::PairDistributionHistogram> pair_distribution = nullptr,
+                bool virial_tensor = false
             );
 
             // Compute the forces resulting from this interaction
@@ -76,18 +89,24 @@ namespace engine
 
             // Can't be const, because some types use internal state
             std::unique_ptr<ParticlePairFilter> particle_pair_filter_;
+
+            // Shared with whoever wants to read the result
+            std::shared_ptr<physics::PairDistributionHistogram> pair_distribution_;
+
+            bool virial_tensor_;
     };
 
     class BackgroundForceCalculation : public ForceCalculation
     {
         public:
-            BackgroundForceCalculation(const physics::BackgroundForce&);
+            BackgroundForceCalculation(const physics::BackgroundForce&, bool virial_tensor = false);
 
             // Compute the forces resulting from this interaction
             virtual physics::SystemState& operator() (physics::SystemState&) const override;
         
         private:
             const physics::BackgroundForce& background_force_;
+            bool virial_tensor_;
     };
 } // namespace engine
 
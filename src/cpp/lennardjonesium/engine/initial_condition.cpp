@@ -20,6 +20,8 @@
  * <https://www.gnu.org/licenses/>.
  */
 
+#include <cassert>
+#include <cmath>
 #include <random>
 #include <ranges>
 
@@ -46,6 +48,46 @@ namespace engine
         )
     {}
 
+    InitialCondition::InitialCondition(
+        tools::SystemParameters system_parameters,
+        const physics::SystemState& reference_state,
+        double reference_density,
+        std::random_device::result_type seed,
+        bool redraw_velocities
+    )
+        : system_parameters_{system_parameters},
+          bounding_box_{tools::CubicLattice{system_parameters}.bounding_box()},
+          system_state_{system_parameters.particle_count},
+          seed_{seed}
+    {
+        assert(reference_state.particle_count() == system_parameters.particle_count
+            && "Reference state must have the same number of particles");
+        assert(reference_density > 0 && "Reference density must be positive");
+
+        /**
+         * Both boxes are cubes of volume N / density, so the positions scale by the cube root of
+         * the ratio of densities.  The positions of the reference state were already inside its
+         * BoundingBox, so the rescaled ones are inside the new one.
+         */
+        double scale_factor = std::cbrt(reference_density / system_parameters_.density);
+
+        system_state_.positions = scale_factor * reference_state.positions;
+
+        // Either keep the reference velocities, or decorrelate from them with a fresh draw
+        if (redraw_velocities) {draw_velocities_();}
+        else {system_state_.velocities = reference_state.velocities;}
+
+        /**
+         * The reference state should have no net momentum, but we make sure of it anyway.  Its
+         * angular momentum is not conserved (due to the periodic boundary conditions), and
+         * removing it would add a rigid rotation to an otherwise equilibrated state, so we leave
+         * it alone.
+         */
+        system_state_
+            | physics::zero_momentum()
+            | physics::set_temperature(system_parameters_.temperature);
+    }
+
     InitialCondition::InitialCondition(
         tools::SystemParameters system_parameters,
         std::random_device::result_type seed,
@@ -69,21 +111,8 @@ namespace engine
             ++index;
         }
 
-        /**
-         * Next, we choose the initial velocities from a Maxwell-Boltzmann distribution.  This is
-         * just a normal distribution with mean 0 and variance equal to the temperature.
-         */
-        random_number_engine_type gen{seed_};
-        std::normal_distribution<> maxwell_boltzmann_distribution{
-            0,
-            std::sqrt(system_parameters_.temperature)
-        };
-
-        // The individual velocity components are all independent, so we treat them as a 1d array
-        for (auto& velocity_component : system_state_.velocities.topRows<3>().reshaped())
-        {
-            velocity_component = maxwell_boltzmann_distribution(gen);
-        }
+        // Next, we choose the initial velocities
+        draw_velocities_();
 
         /**
          * We still need to zero the linear and angular momentum, which will in turn affect
@@ -102,5 +131,24 @@ namespace engine
         
         // Now the initial state is set up.
     }
+
+    void InitialCondition::draw_velocities_()
+    {
+        /**
+         * We choose the velocities from a Maxwell-Boltzmann distribution.  This is just a normal
+         * distribution with mean 0 and variance equal to the temperature.
+         */
+        random_number_engine_type gen{seed_};
+        std::normal_distribution<> maxwell_boltzmann_distribution{
+            0,
+            std::sqrt(system_parameters_.temperature)
+        };
+
+        // The individual velocity components are all independent, so we treat them as a 1d array
+        for (auto& velocity_component : system_state_.velocities.topRows<3>().reshaped())
+        {
+            velocity_component = maxwell_boltzmann_distribution(gen);
+        }
+    }
 } // namespace engine
 
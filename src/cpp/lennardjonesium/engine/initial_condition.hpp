@@ -44,6 +44,15 @@ namespace engine
          * We do not enforce any particular method of choosing the initial seed.  If not provided,
          * we use the default one.  The caller is responsible for determining their own method of
          * choosing a seed, either via the system time or std::random_device, etc.
+         * 
+         * Instead of the lattice, the InitialCondition can also be "warm started" from the final
+         * state of another simulation of the same number of particles (e.g. a neighboring point
+         * in a sweep over temperature and density).  The positions are rescaled affinely from the
+         * reference BoundingBox to the new one, and the velocities are rescaled to the new
+         * temperature.  A state that is already near equilibrium needs far less time in the
+         * EquilibrationPhase than the perfect lattice does.  Optionally, the velocities can be
+         * drawn afresh (using the seed) instead, which gives a statistically independent replica
+         * of an equilibrated state.
          */
 
         public:
@@ -59,6 +68,15 @@ namespace engine
                 std::random_device::result_type seed = random_number_engine_type::default_seed,
                 tools::CubicLattice::UnitCell unit_cell = tools::CubicLattice::FaceCentered()
             );
+
+            // Warm start from a reference state, which had the given density
+            InitialCondition(
+                tools::SystemParameters system_parameters,
+                const physics::SystemState& reference_state,
+                double reference_density,
+                std::random_device::result_type seed = random_number_engine_type::default_seed,
+                bool redraw_velocities = false
+            );
             
             // These return by value so that the original InitialCondition will not be modified
             tools::BoundingBox bounding_box() {return bounding_box_;}
@@ -78,6 +96,9 @@ namespace engine
                 tools::CubicLattice cubic_lattice
             );
 
+            // Draw the velocities from the Maxwell-Boltzmann distribution, using the seed
+            void draw_velocities_();
+
             // Data members
             tools::SystemParameters system_parameters_;
             tools::BoundingBox bounding_box_;
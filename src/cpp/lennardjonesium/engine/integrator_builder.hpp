@@ -28,6 +28,7 @@
 
 #include <lennardjonesium/tools/bounding_box.hpp>
 #include <lennardjonesium/physics/forces.hpp>
+#include <lennardjonesium/physics/pair_distribution.hpp>
 #include <lennardjonesium/engine/boundary_condition.hpp>
 #include <lennardjonesium/engine/particle_pair_filter.hpp>
 #include <lennardjonesium/engine/force_calculation.hpp>
@@ -114,8 +115,13 @@ namespace engine
                   bounding_box_{bounding_box}
             {}
 
+            // The virial tensor is only accumulated if asked for (see ShortRangeForceCalculation)
             template <class ParticlePairFilterType = CellListParticlePairFilter>
-            WithShortRangeForce short_range_force(const physics::ShortRangeForce&);
+            WithShortRangeForce short_range_force(
+                const physics::ShortRangeForce&,
+                std::shared_ptr<physics::PairDistributionHistogram> pair_distribution = nullptr,
+                bool virial_tensor = false
+            );
         
         private:
             // Need to store the bounding box because it might be passed on to the next stage
@@ -153,8 +159,11 @@ namespace engine
     // we can't assume that every type of particle pair filter is constructed the same way.
     template <class ParticlePairFilterType>
     inline Integrator::Builder::WithBoundingBox::WithShortRangeForce
-    Integrator::Builder::WithBoundingBox::short_range_force
-        (const physics::ShortRangeForce& short_range_force)
+    Integrator::Builder::WithBoundingBox::short_range_force(
+        const physics::ShortRangeForce& short_range_force,
+        std::shared_ptr<physics::PairDistributionHistogram> pair_distribution,
+        bool virial_tensor
+    )
     {
         double cutoff_distance = short_range_force.cutoff_distance();
 
@@ -163,7 +172,9 @@ namespace engine
             std::move(boundary_condition_),
             std::make_unique<const ShortRangeForceCalculation>(
                 short_range_force,
-                std::make_unique<ParticlePairFilterType>(bounding_box_, cutoff_distance)
+                std::make_unique<ParticlePairFilterType>(bounding_box_, cutoff_distance),
+                std::move(pair_distribution),
+                virial_tensor
             )
         );
     }
@@ -106,16 +106,19 @@ namespace engine
                     // This allows us to do Eigen arithmetic on the raw array
                     Eigen::Map<const Eigen::Array4d> image_array(image.data());
 
-                    // Find the separation vector to i from the image of j
-                    auto separation = (
+                    // Find the separation vector to i from the image of j (evaluated eagerly,
+                    // since bounding_box_.array() returns a temporary)
+                    Eigen::Vector4d separation = (
                         state.positions.col(i) - state.positions.col(j)
                         - (image_array * bounding_box_.array()).matrix()
                     );
 
+                    double square_distance = separation.squaredNorm();
+
                     // Return if it is shorter than the cutoff distance, otherwise skip
-                    if (separation.squaredNorm() < cutoff_distance_ * cutoff_distance_)
+                    if (square_distance < cutoff_distance_ * cutoff_distance_)
                     {
-                        co_yield ParticlePair{separation, i, j};
+                        co_yield ParticlePair{separation, i, j, square_distance};
                     }
                 }
             }
@@ -162,9 +165,11 @@ namespace engine
                 {
                     auto separation = state.positions.col(cell[i]) - state.positions.col(cell[j]);
 
-                    if (separation.squaredNorm() < cutoff_distance_ * cutoff_distance_)
+                    double square_distance = separation.squaredNorm();
+
+                    if (square_distance < cutoff_distance_ * cutoff_distance_)
                     {
-                        co_yield ParticlePair{separation, cell[i], cell[j]};
+                        co_yield ParticlePair{separation, cell[i], cell[j], square_distance};
                     }
                 }
             }
@@ -177,14 +182,19 @@ namespace engine
             {
                 for (int j : std::views::iota(0, static_cast<int>(pair.second.size())))
                 {
-                    auto separation = (
+                    // Evaluate eagerly, since bounding_box_.array() returns a temporary
+                    Eigen::Vector4d separation = (
                         state.positions.col(pair.first[i]) - state.positions.col(pair.second[j])
                         - (pair.lattice_image.cast<double>() * bounding_box_.array()).matrix()
                     );
 
-                    if (separation.squaredNorm() < cutoff_distance_ * cutoff_distance_)
+                    double square_distance = separation.squaredNorm();
+
+                    if (square_distance < cutoff_distance_ * cutoff_distance_)
                     {
-                        co_yield ParticlePair{separation, pair.first[i], pair.second[j]};
+                        co_yield ParticlePair{
+                            separation, pair.first[i], pair.second[j], square_distance
+                        };
                     }
                 }
             }
@@ -40,13 +40,16 @@ namespace engine
          * the separation vector between them (which had to be calculated already, in order to
          * filter the particle pairs by their separation distance).  The separation vector already
          * takes into account any corrections due to wrapping around the periodic boundary
-         * conditions.
+         * conditions.  The square distance is also kept, since it is needed both for the force
+         * and for sampling the pair distribution function.
          */
 
         Eigen::Vector4d separation;
 
         int first;
         int second;
+
+        double square_distance{};
     };
 
     // It is useful to be able to compare ParticlePairs
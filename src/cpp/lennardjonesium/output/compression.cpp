@@ -0,0 +1,151 @@
+/**
+ * compression.cpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <iterator>
+#include <memory>
+#include <string>
+
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/file.hpp>
+
+// GCC 12 reports a spurious -Wrestrict in the way gzip_compressor builds its header
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wrestrict"
+#include <boost/iostreams/filter/gzip.hpp>
+#pragma GCC diagnostic pop
+
+#include <boost/iostreams/filter/zstd.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include <lennardjonesium/output/compression.hpp>
+
+namespace
+{
+    constexpr std::array<unsigned char, 2> gzip_magic = {0x1f, 0x8b};
+    constexpr std::array<unsigned char, 4> zstd_magic = {0x28, 0xb5, 0x2f, 0xfd};
+
+    template<std::size_t Size>
+    bool starts_with(
+        const char* data, std::size_t size, const std::array<unsigned char, Size>& magic
+    )
+    {
+        return size >= Size && std::memcmp(data, magic.data(), Size) == 0;
+    }
+
+    template<class Chain>
+    void push_compressor_(Chain& chain, output::Compression compression)
+    {
+        switch (compression)
+        {
+            case output::Compression::gzip:
+                chain.push(boost::iostreams::gzip_compressor{});
+                break;
+
+            case output::Compression::zstd:
+                chain.push(boost::iostreams::zstd_compressor{});
+                break;
+
+            case output::Compression::none:
+                break;
+        }
+    }
+
+    void push_decompressor(
+        boost::iostreams::filtering_istream& stream, output::Compression compression
+    )
+    {
+        switch (compression)
+        {
+            case output::Compression::gzip:
+                stream.push(boost::iostreams::gzip_decompressor{});
+                break;
+
+            case output::Compression::zstd:
+                stream.push(boost::iostreams::zstd_decompressor{});
+                break;
+
+            case output::Compression::none:
+                break;
+        }
+    }
+} // namespace
+
+
+namespace output
+{
+    void push_compressor(boost::iostreams::filtering_ostream& stream, Compression compression)
+        {push_compressor_(stream, compression);}
+
+    void push_compressor(
+        boost::iostreams::chain<boost::iostreams::output>& chain, Compression compression
+    )
+        {push_compressor_(chain, compression);}
+
+    Compression detect_compression(const char* data, std::size_t size)
+    {
+        if (starts_with(data, size, gzip_magic)) {return Compression::gzip;}
+        if (starts_with(data, size, zstd_magic)) {return Compression::zstd;}
+        return Compression::none;
+    }
+
+    std::unique_ptr<std::istream> open_input(const std::filesystem::path& path)
+    {
+        std::array<char, 4> head{};
+        std::size_t head_size{0};
+
+        {
+            std::ifstream file{path, std::ios::binary};
+            file.read(head.data(), head.size());
+            head_size = static_cast<std::size_t>(file.gcount());
+        }
+
+        auto compression = detect_compression(head.data(), head_size);
+
+        if (compression == Compression::none)
+        {
+            return std::make_unique<std::ifstream>(path);
+        }
+
+        auto stream = std::make_unique<boost::iostreams::filtering_istream>();
+        push_decompressor(*stream, compression);
+        stream->push(boost::iostreams::file_source{path.string(), std::ios::binary});
+
+        return stream;
+    }
+
+    std::string decompress(std::string data)
+    {
+        auto compression = detect_compression(data.data(), data.size());
+        if (compression == Compression::none) {return data;}
+
+        boost::iostreams::filtering_istream source;
+        push_decompressor(source, compression);
+        source.push(boost::iostreams::array_source{data.data(), data.size()});
+
+        return std::string{std::istreambuf_iterator<char>{source}, {}};
+    }
+} // namespace output
@@ -0,0 +1,81 @@
+/**
+ * compression.hpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LJ_COMPRESSION_HPP
+#define LJ_COMPRESSION_HPP
+
+#include <filesystem>
+#include <istream>
+#include <memory>
+#include <string>
+
+#include <boost/iostreams/chain.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+namespace output
+{
+    /**
+     * Any of the logs may be compressed as it is written.  The compressor is the first filter
+     * of the log's stream, so the compression is done by whichever thread writes to the stream,
+     * i.e. the Logger thread, and it works the same whether the log goes to a file, through
+     * io_uring, or to a SweepStore.
+     * 
+     * The event log is the exception: it is flushed after every event so that it shows how far
+     * a run got if it crashes, and neither the gzip nor the zstd compressor of Boost.Iostreams
+     * can flush without ending the compressed stream.
+     * 
+     * Compressed logs keep their file names; readers recognize them by their first bytes (the
+     * gzip and zstd magic numbers), so that e.g. read_snapshot() can be given an input opened
+     * with open_input() without knowing how the file was written.
+     */
+
+    enum class Compression {none, gzip, zstd};
+
+    struct LogCompression
+    {
+        Compression thermodynamic_log = Compression::none;
+        Compression observation_log = Compression::none;
+        Compression pair_distribution_log = Compression::none;
+        Compression energy_histogram_log = Compression::none;
+        Compression snapshot_log = Compression::none;
+        Compression trajectory_log = Compression::none;
+    };
+
+    // Push the compressor for the given format (if any) onto a stream or chain, ahead of its
+    // device
+    void push_compressor(boost::iostreams::filtering_ostream& stream, Compression compression);
+    void push_compressor(
+        boost::iostreams::chain<boost::iostreams::output>& chain, Compression compression
+    );
+
+    // The format of compressed data, judging by its first bytes
+    Compression detect_compression(const char* data, std::size_t size);
+
+    // Open a file for reading, decompressing it if need be
+    std::unique_ptr<std::istream> open_input(const std::filesystem::path& path);
+
+    // Decompress data held in memory (e.g. a SweepStore segment), if it is compressed
+    std::string decompress(std::string data);
+} // namespace output
+
+
+#endif
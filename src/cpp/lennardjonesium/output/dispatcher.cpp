@@ -34,47 +34,89 @@ namespace output
         auto message_dispatcher = tools::OverloadedVisitor
         {
             // Events
-            [time_step, this](PhaseStartEvent message)
+            // A block of aggregated thermodynamic measurements should not straddle the start
+            // of a phase or a rescaling of the velocities, so these close the current block
+            [time_step, this](const PhaseStartEvent& message)
             {
+                this->thermodynamic_sink_.write_partial_block();
                 this->event_sink_.write(time_step, message);
             },
             
-            [time_step, this](AdjustTemperatureEvent message)
+            [time_step, this](const AdjustTemperatureEvent& message)
             {
+                this->thermodynamic_sink_.write_partial_block();
                 this->event_sink_.write(time_step, message);
             },
             
-            [time_step, this](RecordObservationEvent message)
+            [time_step, this](const RecordObservationEvent& message)
             {
                 this->event_sink_.write(time_step, message);
             },
             
-            [time_step, this](PhaseCompleteEvent message)
+            [time_step, this](const PhaseCompleteEvent& message)
             {
                 this->event_sink_.write(time_step, message);
             },
             
-            [time_step, this](AbortSimulationEvent message)
+            [time_step, this](const AbortSimulationEvent& message)
+            {
+                this->event_sink_.write(time_step, message);
+            },
+            
+            [time_step, this](const ReplicaExchangeEvent& message)
+            {
+                this->event_sink_.write(time_step, message);
+            },
+            
+            [time_step, this](const DroppedMessagesEvent& message)
+            {
+                this->event_sink_.write(time_step, message);
+            },
+            
+            [time_step, this](const CheckpointFailedEvent& message)
+            {
+                this->event_sink_.write(time_step, message);
+            },
+            
+            [time_step, this](const WarmStartFailedEvent& message)
             {
                 this->event_sink_.write(time_step, message);
             },
             
             // Thermodynamics
-            [time_step, this](ThermodynamicData message)
+            [time_step, this](const ThermodynamicData& message)
             {
                 this->thermodynamic_sink_.write(time_step, message);
             },
             
             // Observations
-            [time_step, this](ObservationData message)
+            [time_step, this](const ObservationData& message)
             {
                 this->observation_sink_.write(time_step, message);
             },
 
+            // Pair distribution function
+            [time_step, this](const PairDistributionData& message)
+            {
+                this->pair_distribution_sink_.write(time_step, message);
+            },
+
+            // Potential energy histogram
+            [time_step, this](const EnergyHistogramData& message)
+            {
+                this->energy_histogram_sink_.write(time_step, message);
+            },
+
             // Snapshots
-            [time_step, this](SystemSnapshot message)
+            [time_step, this](const SystemSnapshot& message)
             {
                 this->snapshot_sink_.write(time_step, message);
+            },
+
+            // Trajectory
+            [time_step, this](const TrajectoryFrame& message)
+            {
+                this->trajectory_sink_.write(time_step, message);
             }
         };
 
@@ -32,36 +32,55 @@ namespace output
     {
         /**
          * The Dispatcher takes a message from the message queue and sends it to the appropriate
-         * Sink, based on the type of message.
+         * Sink, based on the type of message.  The message is passed on by reference, so that the
+         * large messages (which refer to frames from a tools::FramePool) are released as soon as
+         * send() returns.
          */
 
         public:
             void send(int time_step, LogMessage message);
 
+            // Called once all messages have been sent, so any measurements held back by the
+            // ThermodynamicSink are written out as well
             void flush_all()
             {
+                thermodynamic_sink_.write_partial_block();
+
                 event_sink_.flush();
                 thermodynamic_sink_.flush();
                 observation_sink_.flush();
+                pair_distribution_sink_.flush();
+                energy_histogram_sink_.flush();
+                snapshot_sink_.flush();
+                trajectory_sink_.flush();
             }
 
             Dispatcher(
                 EventSink& event_sink,
                 ThermodynamicSink& thermodynamic_sink,
                 ObservationSink& observation_sink,
-                SystemSnapshotSink& snapshot_sink
+                PairDistributionSink& pair_distribution_sink,
+                EnergyHistogramSink& energy_histogram_sink,
+                SystemSnapshotSink& snapshot_sink,
+                TrajectorySink& trajectory_sink
             )
                 : event_sink_{event_sink},
                   thermodynamic_sink_{thermodynamic_sink},
                   observation_sink_{observation_sink},
-                  snapshot_sink_{snapshot_sink}
+                  pair_distribution_sink_{pair_distribution_sink},
+                  energy_histogram_sink_{energy_histogram_sink},
+                  snapshot_sink_{snapshot_sink},
+                  trajectory_sink_{trajectory_sink}
             {}
 
         private:
             EventSink& event_sink_;
             ThermodynamicSink& thermodynamic_sink_;
             ObservationSink& observation_sink_;
+            PairDistributionSink& pair_distribution_sink_;
+            EnergyHistogramSink& energy_histogram_sink_;
             SystemSnapshotSink& snapshot_sink_;
+            TrajectorySink& trajectory_sink_;
     };
 } // namespace output
 
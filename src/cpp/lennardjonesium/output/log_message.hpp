@@ -23,13 +23,17 @@
 #ifndef LJ_LOG_MESSAGE_HPP
 #define LJ_LOG_MESSAGE_HPP
 
+#include <memory>
 #include <string>
+#include <utility>
 #include <variant>
 
 #include <Eigen/Dense>
 
 #include <lennardjonesium/physics/measurements.hpp>
 #include <lennardjonesium/physics/observation.hpp>
+#include <lennardjonesium/physics/energy_histogram.hpp>
+#include <lennardjonesium/physics/pair_distribution.hpp>
 #include <lennardjonesium/physics/system_state.hpp>
 
 namespace output
@@ -63,27 +67,129 @@ namespace output
         std::string reason;
     };
 
+    struct ReplicaExchangeEvent
+    {
+        double partner_temperature;
+        double acceptance_probability;
+        bool accepted;
+        int accepted_count;         // Totals so far, between this replica and its partner
+        int attempted_count;
+    };
+
+    struct DroppedMessagesEvent
+    {
+        // ThermodynamicData which the Logger did not write because its queue was full
+        int count;
+        int first_time_step;
+    };
+
+    struct CheckpointFailedEvent
+    {
+        std::string reason;
+    };
+
+    struct WarmStartFailedEvent
+    {
+        // Why the initial snapshot could not be used (the run starts from the lattice instead)
+        std::string reason;
+    };
+
     struct ThermodynamicData
     {
-        physics::ThermodynamicMeasurement::Result data;
+        /**
+         * With the virial and kinetic tensors, the ThermodynamicMeasurement::Result no longer fits
+         * in the LogMessage variant, so like the Observation, we keep it on the heap.  But unlike
+         * the Observation, it is sent at every time step, so the SimulationController takes it
+         * from a tools::FramePool rather than allocating a new one each time.
+         */
+
+        ThermodynamicData(const physics::ThermodynamicMeasurement::Result& result)
+            : data{std::make_shared<const physics::ThermodynamicMeasurement::Result>(result)}
+        {}
+
+        ThermodynamicData(std::shared_ptr<const physics::ThermodynamicMeasurement::Result> result)
+            : data{std::move(result)}
+        {}
+
+        std::shared_ptr<const physics::ThermodynamicMeasurement::Result> data;
     };
 
     struct ObservationData
     {
-        physics::Observation data;
+        /**
+         * Observations are only recorded occasionally, so we keep the Observation on the heap.
+         * Otherwise it would be the largest alternative and push the LogMessage variant past 64B.
+         */
+
+        ObservationData(const physics::Observation& observation)
+            : data{std::make_shared<const physics::Observation>(observation)}
+        {}
+
+        std::shared_ptr<const physics::Observation> data;
+    };
+
+    struct PairDistributionData
+    {
+        physics::PairDistributionHistogram::Result data;
+    };
+
+    struct EnergyHistogramData
+    {
+        // Like the Observation, the histogram is kept on the heap, since it is rarely recorded
+
+        EnergyHistogramData(const physics::EnergyHistogram& histogram)
+            : data{std::make_shared<const physics::EnergyHistogram>(histogram)}
+        {}
+
+        std::shared_ptr<const physics::EnergyHistogram> data;
     };
 
     struct SystemSnapshot
     {
         /**
          * Rather than capture the entire SystemState, we capture only the parts that will be
-         * printed to the file.  This way the size of the LogMessage variant does not grow bigger
-         * than 64B (so it will fit in a single cache line, if that is important).
+         * printed to the file.  Like the TrajectoryFrame, the data is kept on the heap, and the
+         * SimulationController takes it from a tools::FramePool, so that sending a snapshot
+         * neither allocates nor copies the matrices more than once.
          */
 
-        Eigen::Matrix4Xd positions;
-        Eigen::Matrix4Xd velocities;
-        Eigen::Matrix4Xd forces;
+        struct Data
+        {
+            Eigen::Matrix4Xd positions;
+            Eigen::Matrix4Xd velocities;
+            Eigen::Matrix4Xd forces;
+        };
+
+        SystemSnapshot(Data snapshot)
+            : data{std::make_shared<const Data>(std::move(snapshot))}
+        {}
+
+        SystemSnapshot(std::shared_ptr<const Data> snapshot) : data{std::move(snapshot)} {}
+
+        std::shared_ptr<const Data> data;
+    };
+
+    struct TrajectoryFrame
+    {
+        /**
+         * A frame of the trajectory, which is recorded at regular intervals.  Like the other large
+         * messages, it is kept on the heap (in a frame from a tools::FramePool, when sent by the
+         * SimulationController).  The velocities are left empty if they are not to be recorded.
+         */
+
+        struct Data
+        {
+            double time;
+            Eigen::Array4d box;
+            Eigen::Matrix4Xd positions;
+            Eigen::Matrix4Xd velocities;
+        };
+
+        TrajectoryFrame(Data frame) : data{std::make_shared<const Data>(std::move(frame))} {}
+
+        TrajectoryFrame(std::shared_ptr<const Data> frame) : data{std::move(frame)} {}
+
+        std::shared_ptr<const Data> data;
     };
 
     using LogMessage = std::variant<
@@ -92,9 +198,16 @@ namespace output
         RecordObservationEvent,
         PhaseCompleteEvent,
         AbortSimulationEvent,
+        ReplicaExchangeEvent,
+        DroppedMessagesEvent,
+        CheckpointFailedEvent,
+        WarmStartFailedEvent,
         ThermodynamicData,
         ObservationData,
-        SystemSnapshot
+        PairDistributionData,
+        EnergyHistogramData,
+        SystemSnapshot,
+        TrajectoryFrame
     >;
 } // namespace output
 
@@ -20,60 +20,198 @@
  * <https://www.gnu.org/licenses/>.
  */
 
+#include <cassert>
 #include <iostream>
 #include <utility>
+#include <mutex>
 #include <thread>
+#include <variant>
 
-#include <lennardjonesium/tools/message_buffer.hpp>
+#include <lennardjonesium/tools/ring_buffer.hpp>
 #include <lennardjonesium/output/log_message.hpp>
 #include <lennardjonesium/output/sinks.hpp>
 #include <lennardjonesium/output/dispatcher.hpp>
+#include <lennardjonesium/output/output_service.hpp>
 #include <lennardjonesium/output/logger.hpp>
 
 namespace output
 {
-    Logger::Logger(Logger::Streams streams)
+    Logger::Logger(
+        Logger::Streams streams,
+        ThermodynamicSink::Format thermodynamic_format,
+        LogQueue queue,
+        OutputService* output_service,
+        ThermodynamicReduction thermodynamic_reduction,
+        bool append,
+        bool pressure_tensor
+    )
         : event_sink_{streams.event_log},
-          thermodynamic_sink_{streams.thermodynamic_log},
+          thermodynamic_sink_{
+              streams.thermodynamic_log,
+              thermodynamic_format,
+              thermodynamic_reduction,
+              pressure_tensor
+          },
           observation_sink_{streams.observation_log},
-          snapshot_sink_{streams.snapshot_log}
+          pair_distribution_sink_{streams.pair_distribution_log},
+          energy_histogram_sink_{streams.energy_histogram_log},
+          snapshot_sink_{streams.snapshot_log},
+          trajectory_sink_{streams.trajectory_log},
+          dispatcher_{
+              event_sink_,
+              thermodynamic_sink_,
+              observation_sink_,
+              pair_distribution_sink_,
+              energy_histogram_sink_,
+              snapshot_sink_,
+              trajectory_sink_
+          },
+          queue_{queue},
+          buffer_{queue.capacity}
     {
-        // Initialize the log files
-        event_sink_.write_header();
-        thermodynamic_sink_.write_header();
-        observation_sink_.write_header();
-        snapshot_sink_.write_header();
+        assert(queue_.decimation_interval > 0 && "Decimation interval must be positive");
+
+        // Initialize the log files, unless we continue the ones from an earlier run
+        if (!append)
+        {
+            event_sink_.write_header();
+            thermodynamic_sink_.write_header();
+            observation_sink_.write_header();
+            pair_distribution_sink_.write_header();
+            energy_histogram_sink_.write_header();
+            snapshot_sink_.write_header();
+            trajectory_sink_.write_header();
+        }
 
         event_sink_.flush();
         thermodynamic_sink_.flush();
         observation_sink_.flush();
+        pair_distribution_sink_.flush();
+        energy_histogram_sink_.flush();
         snapshot_sink_.flush();
+        trajectory_sink_.flush();
+
+        if (output_service)
+        {
+            served_ = true;
+            output_service->attach(*this);
+            return;
+        }
 
         // Start the consumer thread
         consumer_ = std::thread(
             [this]() {
-                Dispatcher dispatcher{
-                    this->event_sink_,
-                    this->thermodynamic_sink_,
-                    this->observation_sink_,
-                    this->snapshot_sink_
-                };
-
-                auto dispatch = [&dispatcher](message_type message)
-                {
-                    auto [time_step, log_message] = message;
-                    dispatcher.send(time_step, log_message);
-                };
+                auto dispatch = [this](message_type&& message) {dispatch_(std::move(message));};
 
-                // while (this->buffer_.get_and(dispatch));
+                // Each batch holds everything that arrived since the previous one
+                while (this->buffer_.get_batch(dispatch) > 0);
 
-                while (auto o = this->buffer_.get()) {dispatch(o.value());}
-
-                dispatcher.flush_all();
+                dispatcher_.flush_all();
             }
         );
     }
 
+    void Logger::dispatch_(message_type&& message)
+    {
+        auto& [time_step, log_message] = message;
+        dispatcher_.send(time_step, std::move(log_message));
+    }
+
+    size_t Logger::poll()
+    {
+        return buffer_.poll_batch([this](message_type&& message) {dispatch_(std::move(message));});
+    }
+
+    void Logger::finish()
+    {
+        dispatcher_.flush_all();
+
+        // Notify while holding the lock, since the Logger may be destroyed as soon as close()
+        // sees finished_
+        std::lock_guard<std::mutex> lock(finish_mutex_);
+        finished_ = true;
+        finish_signal_.notify_all();
+    }
+
+    void Logger::log(int time_step, LogMessage message)
+    {
+        message_type item{time_step, std::move(message)};
+
+        if (queue_.policy == LogQueue::Policy::block
+            || !std::holds_alternative<ThermodynamicData>(item.second))
+        {
+            // Everything before this message must be sent first, to keep the logs in order
+            catch_up_();
+            buffer_.put(std::move(item));
+            return;
+        }
+
+        switch (queue_.policy)
+        {
+            case LogQueue::Policy::decimate:
+                if (buffer_.size() >= buffer_.capacity() / 2
+                    && time_step % queue_.decimation_interval != 0)
+                {
+                    drop_(time_step);
+                }
+                else if (!buffer_.try_put(item)) {drop_(time_step);}
+                break;
+
+            case LogQueue::Policy::coalesce:
+                // The held measurement must go first, otherwise the newer one takes its place
+                if (pending_ && !buffer_.try_put(*pending_))
+                {
+                    drop_(pending_->first);
+                    pending_ = std::move(item);
+                    break;
+                }
+
+                pending_.reset();
+                if (!buffer_.try_put(item)) {pending_ = std::move(item);}
+                break;
+
+            case LogQueue::Policy::drop:
+            default:
+                if (!buffer_.try_put(item)) {drop_(time_step);}
+                break;
+        }
+    }
+
+    void Logger::sync()
+    {
+        catch_up_();
+
+        // Once the consumer has taken everything, it does not touch the Sinks again until we
+        // send another message, so we can flush them from this thread
+        buffer_.wait_until_empty();
+        dispatcher_.flush_all();
+    }
+
+    void Logger::drop_(int time_step)
+    {
+        if (dropped_count_ == 0) {first_dropped_ = time_step;}
+        last_dropped_ = time_step;
+        ++dropped_count_;
+    }
+
+    void Logger::catch_up_()
+    {
+        if (pending_)
+        {
+            buffer_.put(std::move(*pending_));
+            pending_.reset();
+        }
+
+        if (dropped_count_ > 0)
+        {
+            buffer_.put({
+                last_dropped_,
+                DroppedMessagesEvent{.count = dropped_count_, .first_time_step = first_dropped_}
+            });
+            dropped_count_ = 0;
+        }
+    }
+
     void Logger::close()
     {
         // If consumer thread is running, then close the buffer
@@ -81,9 +219,19 @@ namespace output
 
         if (consumer_.joinable())
         {
+            catch_up_();
             buffer_.close();
             consumer_.join();
         }
+
+        if (served_ && !buffer_.closed())
+        {
+            catch_up_();
+            buffer_.close();
+
+            std::unique_lock<std::mutex> lock(finish_mutex_);
+            finish_signal_.wait(lock, [this]() {return finished_;});
+        }
     }
 
     Logger::~Logger() noexcept
@@ -23,17 +23,47 @@
 #ifndef LJ_LOGGER_HPP
 #define LJ_LOGGER_HPP
 
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
+#include <optional>
 #include <utility>
 #include <thread>
 
-#include <lennardjonesium/tools/message_buffer.hpp>
+#include <lennardjonesium/tools/ring_buffer.hpp>
 #include <lennardjonesium/output/log_message.hpp>
 #include <lennardjonesium/output/sinks.hpp>
+#include <lennardjonesium/output/dispatcher.hpp>
+#include <lennardjonesium/output/output_service.hpp>
 
 namespace output
 {
-    class Logger
+    struct LogQueue
+    {
+        /**
+         * Configures the queue between the simulation thread and the Logger thread.  When the
+         * queue is full, the policy decides what happens to ThermodynamicData (every other
+         * message always waits for space, since they are infrequent and cannot be recovered):
+         * 
+         *  block:      Wait for space, so that nothing is lost
+         *  drop:       Discard the measurement
+         *  decimate:   Once the queue is half full, keep only the measurements on time steps
+         *              which are multiples of decimation_interval (and discard any others that
+         *              still do not fit)
+         *  coalesce:   Hold on to the most recent measurement, replacing any earlier one which
+         *              is still waiting, and send it as soon as there is space
+         * 
+         * The number of discarded measurements is reported in the events log.
+         */
+
+        enum class Policy {block, drop, decimate, coalesce};
+
+        size_t capacity = 4096;
+        Policy policy = Policy::block;
+        int decimation_interval = 10;
+    };
+
+    class Logger : private OutputService::Channel
     {
         /**
          * The Logger prints the relevant simulation data to output streams.  It is not a flexible
@@ -45,6 +75,18 @@ namespace output
          * The Logger accepts std::ostream& arguments to its constructor; the caller is responsible
          * for configuring these streams and making sure they point to opened files.  The caller
          * is also responsible for closing the streams afterward.
+         * 
+         * NOTE: Messages are passed to the consumer thread through a lock-free RingBuffer, which
+         * supports only a single producer.  So log() must only be called from one thread (in
+         * practice, the thread running the SimulationController).  If the consumer falls behind
+         * by more than the capacity of the buffer, then what log() does depends on the LogQueue
+         * policy.
+         * 
+         * If the Logger is given an OutputService, its messages are processed by one of the
+         * service's threads instead of a consumer thread of its own.
+         * 
+         * With append, the streams continue the logs of an earlier run (which is resumed from a
+         * checkpoint), so the headers are not written again.
          */
 
         public:
@@ -53,17 +95,36 @@ namespace output
                 std::ostream& event_log;
                 std::ostream& thermodynamic_log;
                 std::ostream& observation_log;
+                std::ostream& pair_distribution_log;
+                std::ostream& energy_histogram_log;
                 std::ostream& snapshot_log;
+                std::ostream& trajectory_log;
             };
 
-            Logger(Streams);
+            Logger(
+                Streams,
+                ThermodynamicSink::Format thermodynamic_format = ThermodynamicSink::Format::csv,
+                LogQueue queue = {},
+                OutputService* output_service = nullptr,
+                ThermodynamicReduction thermodynamic_reduction = {},
+                bool append = false,
+                bool pressure_tensor = false
+            );
 
             // Used by producer thread to send log messages, which will be dispatched to the
             // appropriate destination
-            void log(int time_step, LogMessage message) {buffer_.put({time_step, message});}
+            void log(int time_step, LogMessage message);
+
+            // The number of messages which can be waiting in the queue
+            size_t capacity() const {return buffer_.capacity();}
+
+            // Wait until every message logged so far has been written, and flush the streams, so
+            // that the logs are complete up to this point (e.g. for a checkpoint).  Like log(),
+            // this must only be called from the producer thread.
+            void sync();
 
             // Call close() after producer threads are finished, this clears the message buffer
-            // and terminates consumer thread (optional)
+            // and terminates consumer thread, or waits for the OutputService to finish (optional)
             // Note that there is no way to reopen logging
             void close();
 
@@ -74,11 +135,46 @@ namespace output
             EventSink event_sink_;
             ThermodynamicSink thermodynamic_sink_;
             ObservationSink observation_sink_;
+            PairDistributionSink pair_distribution_sink_;
+            EnergyHistogramSink energy_histogram_sink_;
             SystemSnapshotSink snapshot_sink_;
+            TrajectorySink trajectory_sink_;
+            Dispatcher dispatcher_;
 
             using message_type = std::pair<int, LogMessage>;
-            tools::MessageBuffer<message_type> buffer_;
+
+            // Count a ThermodynamicData message which was discarded
+            void drop_(int time_step);
+
+            // Send any measurement held back by the coalesce policy, and report any discarded
+            // measurements to the events log
+            void catch_up_();
+
+            // Send a message from the buffer to its Sink
+            void dispatch_(message_type&& message);
+
+            // OutputService::Channel interface
+            void connect(tools::Doorbell& doorbell) override {buffer_.connect(doorbell);}
+            size_t poll() override;
+            bool pending() const override {return buffer_.closed() || !buffer_.empty();}
+            bool drained() const override {return buffer_.closed() && buffer_.empty();}
+            void finish() override;
+
+            LogQueue queue_;
+            tools::RingBuffer<message_type> buffer_;
             std::thread consumer_;
+
+            // When served by an OutputService, close() waits for finish()
+            bool served_{false};
+            std::mutex finish_mutex_;
+            std::condition_variable finish_signal_;
+            bool finished_{false};
+
+            // Only accessed by the producer thread
+            std::optional<message_type> pending_;
+            int dropped_count_{0};
+            int first_dropped_{0};
+            int last_dropped_{0};
     };
 } // namespace output
 
@@ -0,0 +1,158 @@
+/**
+ * output_service.cpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <lennardjonesium/tools/ring_buffer.hpp>
+#include <lennardjonesium/output/output_service.hpp>
+
+namespace output
+{
+    OutputService::OutputService(int thread_count, std::chrono::microseconds batch_delay)
+        : batch_delay_{batch_delay}
+    {
+        assert(thread_count > 0 && "OutputService needs at least one thread");
+
+        for (int i = 0; i < thread_count; ++i)
+        {
+            workers_.push_back(std::make_unique<Worker>());
+        }
+
+        // Only start the threads once every Worker is in place
+        for (auto& worker : workers_)
+        {
+            worker->thread = std::jthread([this, &worker = *worker]() {serve_(worker);});
+        }
+    }
+
+    OutputService::~OutputService()
+    {
+        for (auto& worker : workers_)
+        {
+            {
+                std::lock_guard<std::mutex> lock(worker->mutex);
+                worker->stopping = true;
+            }
+
+            worker->doorbell.wake();
+        }
+
+        for (auto& worker : workers_)
+        {
+            if (worker->thread.joinable()) {worker->thread.join();}
+        }
+    }
+
+    void OutputService::attach(Channel& channel)
+    {
+        // Give the Channel to the least busy Worker
+        auto& worker = **std::ranges::min_element(
+            workers_,
+            {},
+            [](const auto& worker) {return worker->channel_count.load();}
+        );
+
+        ++worker.channel_count;
+        channel.connect(worker.doorbell);
+
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.incoming.push_back(&channel);
+        }
+
+        worker.doorbell.wake();
+    }
+
+    OutputService& OutputService::shared()
+    {
+        // Writing is mostly formatting, so a few threads can keep up with many simulations
+        static OutputService service{
+            std::max(1, static_cast<int>(std::thread::hardware_concurrency()) / 4)
+        };
+
+        return service;
+    }
+
+    void OutputService::serve_(Worker& worker)
+    {
+        std::vector<Channel*> channels;
+
+        while (true)
+        {
+            bool stopping;
+
+            {
+                std::lock_guard<std::mutex> lock(worker.mutex);
+                channels.insert(channels.end(), worker.incoming.begin(), worker.incoming.end());
+                worker.incoming.clear();
+                stopping = worker.stopping;
+            }
+
+            size_t processed = 0;
+
+            for (auto channel : channels) {processed += channel->poll();}
+
+            // Let go of the Channels which are finished
+            std::erase_if(
+                channels,
+                [&worker](Channel* channel)
+                {
+                    if (!channel->drained()) {return false;}
+
+                    channel->finish();
+                    --worker.channel_count;
+                    return true;
+                }
+            );
+
+            if (processed > 0) {continue;}
+            if (stopping && channels.empty()) {return;}
+
+            // Nothing to do, so sleep until a Channel has messages
+            auto token = worker.doorbell.prepare();
+
+            bool idle = std::ranges::none_of(
+                channels, [](Channel* channel) {return channel->pending();}
+            );
+
+            {
+                std::lock_guard<std::mutex> lock(worker.mutex);
+                idle = idle && worker.incoming.empty() && !worker.stopping;
+            }
+
+            if (idle)
+            {
+                worker.doorbell.wait(token);
+
+                // Give the messages a chance to accumulate
+                std::this_thread::sleep_for(batch_delay_);
+            }
+            else {worker.doorbell.cancel();}
+        }
+    }
+} // namespace output
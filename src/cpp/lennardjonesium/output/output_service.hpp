@@ -0,0 +1,126 @@
+/**
+ * output_service.hpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LJ_OUTPUT_SERVICE_HPP
+#define LJ_OUTPUT_SERVICE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <lennardjonesium/tools/ring_buffer.hpp>
+
+namespace output
+{
+    class OutputService
+    {
+        /**
+         * The OutputService is a small, fixed set of I/O threads which serve the message queues
+         * of any number of Loggers.  Without it, every Logger starts its own consumer thread, so
+         * a SimulationPool with N workers runs 2N threads.  With it, the number of threads doing
+         * output stays the same however many simulations are running.
+         * 
+         * Each Channel (i.e. Logger) is assigned to the I/O thread serving the fewest Channels
+         * when it is attached, and stays with that thread, so that its queue still has a single
+         * consumer.  An I/O thread goes over all of its Channels, processing whatever messages
+         * are waiting, and sleeps on a Doorbell shared by all of its Channels when there are
+         * none.  When it is woken, it first waits for batch_delay, so that it can process many
+         * messages in one go rather than being woken for every time step.
+         * 
+         * A Channel is served until it has been closed and all of its messages processed, after
+         * which finish() is called and the OutputService forgets about it.  The OutputService
+         * must outlive every Channel attached to it.
+         * 
+         * shared() gives a process-wide OutputService, which is used by default by the
+         * SimulationPool and the SimulationBuffer.
+         */
+
+        public:
+            class Channel
+            {
+                /**
+                 * The interface through which the OutputService serves a message queue.  All of
+                 * these are called from the I/O thread.
+                 */
+
+                public:
+                    // Ring the given Doorbell when messages arrive (called once, on attach)
+                    virtual void connect(tools::Doorbell& doorbell) = 0;
+
+                    // Process any waiting messages (without blocking), returning their number
+                    virtual size_t poll() = 0;
+
+                    // Whether there are messages waiting, or the queue has been closed
+                    virtual bool pending() const = 0;
+
+                    // Whether the queue has been closed and every message has been processed
+                    virtual bool drained() const = 0;
+
+                    // The last call made by the OutputService, after the Channel is drained
+                    virtual void finish() = 0;
+
+                protected:
+                    ~Channel() = default;
+            };
+
+            explicit OutputService(
+                int thread_count = 1,
+                std::chrono::microseconds batch_delay = std::chrono::milliseconds(1)
+            );
+
+            // Waits for the Channels still attached to be drained
+            ~OutputService() noexcept;
+
+            // Start serving a Channel
+            void attach(Channel& channel);
+
+            int thread_count() const {return static_cast<int>(workers_.size());}
+
+            // The process-wide OutputService
+            static OutputService& shared();
+
+        private:
+            struct Worker
+            {
+                tools::Doorbell doorbell;
+
+                // Channels attached but not yet picked up by the thread, protected by mutex
+                std::mutex mutex;
+                std::vector<Channel*> incoming;
+                bool stopping{false};
+
+                std::atomic<int> channel_count{0};
+                std::jthread thread;
+            };
+
+            void serve_(Worker& worker);
+
+            std::chrono::microseconds batch_delay_;
+            std::vector<std::unique_ptr<Worker>> workers_;
+    };
+} // namespace output
+
+
+#endif
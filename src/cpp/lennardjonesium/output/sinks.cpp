@@ -20,24 +20,78 @@
  * <https://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <vector>
 #include <ranges>
+#include <string>
+#include <string_view>
 
 // test
 #include <iostream>
 
 #include <fmt/core.h>
+#include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <lennardjonesium/tools/binary_stream.hpp>
 #include <lennardjonesium/physics/system_state.hpp>
 #include <lennardjonesium/output/log_message.hpp>
 #include <lennardjonesium/output/sinks.hpp>
 
+namespace
+{
+    // The columns of the thermodynamic log, in order.  The symmetric tensors are written as their
+    // 6 independent components.
+    constexpr std::array<std::string_view, 20> thermodynamic_columns{
+        "TimeStep",
+        "Time",
+        "KineticEnergy",
+        "PotentialEnergy",
+        "TotalEnergy",
+        "Virial",
+        "Temperature",
+        "MeanSquareDisplacement",
+        "VirialXX", "VirialYY", "VirialZZ", "VirialXY", "VirialXZ", "VirialYZ",
+        "KineticXX", "KineticYY", "KineticZZ", "KineticXY", "KineticXZ", "KineticYZ"
+    };
+
+    // The values of one row of the thermodynamic log, in the order of the columns
+    std::array<double, thermodynamic_columns.size()> thermodynamic_record(
+        int time_step, const output::ThermodynamicData& message
+    )
+    {
+        const auto& virial_tensor = message.data->virial_tensor;
+        const auto& kinetic_tensor = message.data->kinetic_tensor;
+
+        return {
+            static_cast<double>(time_step),
+            message.data->time,
+            message.data->kinetic_energy,
+            message.data->potential_energy,
+            message.data->total_energy,
+            message.data->virial,
+            message.data->temperature,
+            message.data->mean_square_displacement,
+            virial_tensor(0, 0), virial_tensor(1, 1), virial_tensor(2, 2),
+            virial_tensor(0, 1), virial_tensor(0, 2), virial_tensor(1, 2),
+            kinetic_tensor(0, 0), kinetic_tensor(1, 1), kinetic_tensor(2, 2),
+            kinetic_tensor(0, 1), kinetic_tensor(0, 2), kinetic_tensor(1, 2)
+        };
+    }
+} // namespace
+
+
 namespace output
 {
     // The EventSink flushes after every message.  This should not be a problem, as Events are
     // not very frequent.
 
-    void EventSink::write(int time_step, PhaseStartEvent message)
+    void EventSink::write(int time_step, const PhaseStartEvent& message)
     {
         fmt::print(
             destination_,
@@ -49,7 +103,7 @@ namespace output
         flush();
     }
 
-    void EventSink::write(int time_step, AdjustTemperatureEvent message)
+    void EventSink::write(int time_step, const AdjustTemperatureEvent& message)
     {
         fmt::print(
             destination_,
@@ -62,7 +116,7 @@ namespace output
         flush();
     }
     
-    void EventSink::write(int time_step, RecordObservationEvent message [[maybe_unused]])
+    void EventSink::write(int time_step, const RecordObservationEvent& message [[maybe_unused]])
     {
         fmt::print(
             destination_,
@@ -73,7 +127,7 @@ namespace output
         flush();
     }
     
-    void EventSink::write(int time_step, PhaseCompleteEvent message)
+    void EventSink::write(int time_step, const PhaseCompleteEvent& message)
     {
         fmt::print(
             destination_,
@@ -85,7 +139,7 @@ namespace output
         flush();
     }
     
-    void EventSink::write(int time_step, AbortSimulationEvent message)
+    void EventSink::write(int time_step, const AbortSimulationEvent& message)
     {
         fmt::print(
             destination_,
@@ -97,68 +151,382 @@ namespace output
         flush();
     }
 
-    void ThermodynamicSink::write_header()
+    void EventSink::write(int time_step, const ReplicaExchangeEvent& message)
     {
         fmt::print(
             destination_,
-            "{},{},{},{},{},{},{},{}\n",
-            "TimeStep",
-            "Time",
-            "KineticEnergy",
-            "PotentialEnergy",
-            "TotalEnergy",
-            "Virial",
-            "Temperature",
-            "MeanSquareDisplacement"
+            "{}: Replica exchange with temperature {:.4g} {} (probability {:.3f}), "
+            "{} of {} accepted\n",
+            time_step,
+            message.partner_temperature,
+            message.accepted ? "accepted" : "rejected",
+            message.acceptance_probability,
+            message.accepted_count,
+            message.attempted_count
+        );
+
+        flush();
+    }
+
+    void EventSink::write(int time_step, const DroppedMessagesEvent& message)
+    {
+        fmt::print(
+            destination_,
+            "{}: Logger dropped {} thermodynamic measurements since time step {}\n",
+            time_step,
+            message.count,
+            message.first_time_step
         );
+
+        flush();
+    }
+
+    void EventSink::write(int time_step, const CheckpointFailedEvent& message)
+    {
+        fmt::print(
+            destination_,
+            "{}: Checkpoint failed: {}\n",
+            time_step,
+            message.reason
+        );
+
+        flush();
     }
 
-    void ThermodynamicSink::write(int time_step, ThermodynamicData message)
+    void EventSink::write(int time_step, const WarmStartFailedEvent& message)
     {
         fmt::print(
             destination_,
-            "{},{},{},{},{},{},{},{}\n",
+            "{}: Warm start failed: {}; starting from the lattice\n",
+            time_step,
+            message.reason
+        );
+
+        flush();
+    }
+
+    ThermodynamicSink::ThermodynamicSink(
+        std::ostream& destination,
+        Format format,
+        ThermodynamicReduction reduction,
+        bool pressure_tensor
+    )
+        : detail::SinkCommon{destination},
+          format_{format},
+          reduction_{reduction},
+          pressure_tensor_{pressure_tensor}
+    {
+        static_assert(std::tuple_size_v<Record> == thermodynamic_columns.size());
+        assert(reduction_.interval > 0 && "Reduction interval must be positive");
+    }
+
+    std::vector<std::string> ThermodynamicSink::columns_() const
+    {
+        auto written_columns = thermodynamic_columns | std::views::take(2 + quantities_());
+
+        if (reduction_.mode != ThermodynamicReduction::Mode::aggregate)
+        {
+            return {written_columns.begin(), written_columns.end()};
+        }
+
+        std::vector<std::string> columns{"TimeStep", "Time", "SampleCount"};
+        for (auto column : written_columns | std::views::drop(2))
+        {
+            columns.emplace_back(column);
+            columns.push_back(std::string{column} + "Min");
+            columns.push_back(std::string{column} + "Max");
+            columns.push_back(std::string{column} + "Variance");
+        }
+
+        return columns;
+    }
+
+    void ThermodynamicSink::write_header()
+    {
+        auto columns = columns_();
+
+        if (format_ == Format::csv)
+        {
+            for (size_t i = 0; i < columns.size(); ++i)
+            {
+                destination_ << (i == 0 ? "" : ",") << columns[i];
+            }
+
+            destination_ << '\n';
+            return;
+        }
+
+        std::uint32_t data_offset = 8 + 4 * sizeof(std::uint32_t);
+        for (const auto& column : columns)
+        {
+            data_offset += sizeof(std::uint32_t) + column.size();
+        }
+        data_offset = (data_offset + 7) / 8 * 8;
+
+        std::uint32_t header_size = 0;
+        auto write_field = [this, &header_size](auto value)
+        {
+            tools::write_binary(destination_, value);
+            header_size += sizeof(value);
+        };
+
+        destination_.write("LJCOLUMN", 8);
+        header_size += 8;
+
+        write_field(std::uint32_t{1});
+        write_field(std::uint32_t{0x01020304});
+        write_field(static_cast<std::uint32_t>(columns.size()));
+        write_field(data_offset);
+
+        for (const auto& column : columns)
+        {
+            write_field(static_cast<std::uint32_t>(column.size()));
+            destination_.write(column.data(), static_cast<std::streamsize>(column.size()));
+            header_size += column.size();
+        }
+
+        for (; header_size < data_offset; ++header_size) {destination_.put('\0');}
+    }
+
+    void ThermodynamicSink::write(int time_step, const ThermodynamicData& message)
+    {
+        switch (reduction_.mode)
+        {
+            case ThermodynamicReduction::Mode::none:
+                break;
+
+            case ThermodynamicReduction::Mode::decimate:
+                if (time_step % reduction_.interval != 0) {return;}
+                break;
+
+            case ThermodynamicReduction::Mode::aggregate:
+                add_to_block_(thermodynamic_record(time_step, message));
+                if (block_.count == reduction_.interval) {write_partial_block();}
+                return;
+        }
+
+        if (format_ == Format::binary)
+        {
+            auto record = thermodynamic_record(time_step, message);
+            write_row_(record.data(), 2 + quantities_());
+            return;
+        }
+
+        if (!pressure_tensor_)
+        {
+            fmt::print(
+                destination_,
+                "{},{},{},{},{},{},{},{}\n",
+                time_step,
+                message.data->time,
+                message.data->kinetic_energy,
+                message.data->potential_energy,
+                message.data->total_energy,
+                message.data->virial,
+                message.data->temperature,
+                message.data->mean_square_displacement
+            );
+            return;
+        }
+
+        const auto& virial_tensor = message.data->virial_tensor;
+        const auto& kinetic_tensor = message.data->kinetic_tensor;
+
+        fmt::print(
+            destination_,
+            "{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{}\n",
             time_step,
-            message.data.time,
-            message.data.kinetic_energy,
-            message.data.potential_energy,
-            message.data.total_energy,
-            message.data.virial,
-            message.data.temperature,
-            message.data.mean_square_displacement
+            message.data->time,
+            message.data->kinetic_energy,
+            message.data->potential_energy,
+            message.data->total_energy,
+            message.data->virial,
+            message.data->temperature,
+            message.data->mean_square_displacement,
+            virial_tensor(0, 0), virial_tensor(1, 1), virial_tensor(2, 2),
+            virial_tensor(0, 1), virial_tensor(0, 2), virial_tensor(1, 2),
+            kinetic_tensor(0, 0), kinetic_tensor(1, 1), kinetic_tensor(2, 2),
+            kinetic_tensor(0, 1), kinetic_tensor(0, 2), kinetic_tensor(1, 2)
         );
     }
 
+    void ThermodynamicSink::add_to_block_(const Record& record)
+    {
+        ++block_.count;
+        block_.last_time_step = static_cast<int>(record[0]);
+        block_.last_time = record[1];
+
+        for (size_t i = 0; i < quantities_(); ++i)
+        {
+            double value = record[2 + i];
+
+            if (block_.count == 1)
+            {
+                block_.min[i] = value;
+                block_.max[i] = value;
+            }
+            else
+            {
+                block_.min[i] = std::min(block_.min[i], value);
+                block_.max[i] = std::max(block_.max[i], value);
+            }
+
+            double delta = value - block_.mean[i];
+            block_.mean[i] += delta / block_.count;
+            block_.sum_of_squares[i] += delta * (value - block_.mean[i]);
+        }
+    }
+
+    void ThermodynamicSink::write_partial_block()
+    {
+        if (block_.count == 0) {return;}
+
+        std::array<double, 3 + 4 * quantity_count> row;
+        row[0] = static_cast<double>(block_.last_time_step);
+        row[1] = block_.last_time;
+        row[2] = static_cast<double>(block_.count);
+
+        for (size_t i = 0; i < quantities_(); ++i)
+        {
+            // The sample variance within the block (using Bessel's correction)
+            row[3 + 4 * i] = block_.mean[i];
+            row[4 + 4 * i] = block_.min[i];
+            row[5 + 4 * i] = block_.max[i];
+            row[6 + 4 * i] = (block_.count > 1)
+                ? block_.sum_of_squares[i] / (block_.count - 1)
+                : 0.0;
+        }
+
+        write_row_(row.data(), 3 + 4 * quantities_());
+        block_ = {};
+    }
+
+    void ThermodynamicSink::write_row_(const double* values, size_t count)
+    {
+        if (format_ == Format::binary)
+        {
+            destination_.write(
+                reinterpret_cast<const char*>(values),
+                static_cast<std::streamsize>(count * sizeof(double))
+            );
+            return;
+        }
+
+        // Format the whole row before writing it, as fmt::print() does
+        fmt::memory_buffer buffer;
+        for (size_t i = 0; i < count; ++i)
+        {
+            fmt::format_to(std::back_inserter(buffer), "{}{}", (i == 0) ? "" : ",", values[i]);
+        }
+        buffer.push_back('\n');
+
+        destination_.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    }
+
     void ObservationSink::write_header()
     {
         fmt::print(
             destination_,
-            "{},{},{},{},{},{},{}\n",
+            "{},{},{},{},{},{},{},{},{},{},{},{},{},{}\n",
             "TimeStep",
             "Temperature",
             "Density",
             "TotalEnergy",
             "Pressure",
             "SpecificHeat",
-            "DiffusionCoefficient"
+            "DiffusionCoefficient",
+            "TemperatureError",
+            "TotalEnergyError",
+            "PressureError",
+            "SpecificHeatError",
+            "GreenKuboDiffusionCoefficient",
+            "ShearViscosity",
+            "OrderParameter"
         );
     }
 
-    void ObservationSink::write(int time_step, ObservationData message)
+    void ObservationSink::write(int time_step, const ObservationData& message)
     {
         fmt::print(
             destination_,
-            "{},{},{},{},{},{},{}\n",
+            "{},{},{},{},{},{},{},{},{},{},{},{},{},{}\n",
             time_step,
-            message.data.temperature,
-            message.data.density,
-            message.data.total_energy,
-            message.data.pressure,
-            message.data.specific_heat,
-            message.data.diffusion_coefficient
+            message.data->temperature,
+            message.data->density,
+            message.data->total_energy,
+            message.data->pressure,
+            message.data->specific_heat,
+            message.data->diffusion_coefficient,
+            message.data->temperature_error,
+            message.data->total_energy_error,
+            message.data->pressure_error,
+            message.data->specific_heat_error,
+            message.data->green_kubo_diffusion_coefficient,
+            message.data->shear_viscosity,
+            message.data->order_parameter
         );
     }
 
+    void PairDistributionSink::write_header()
+    {
+        fmt::print(
+            destination_,
+            "{},{},{}\n",
+            "TimeStep",
+            "Radius",
+            "PairDistribution"
+        );
+    }
+
+    void PairDistributionSink::write(int time_step, const PairDistributionData& message)
+    {
+        for (size_t bin = 0; bin < message.data.radii.size(); ++bin)
+        {
+            fmt::print(
+                destination_,
+                "{},{},{}\n",
+                time_step,
+                message.data.radii[bin],
+                message.data.pair_distribution[bin]
+            );
+        }
+    }
+
+    void EnergyHistogramSink::write_header()
+    {
+        fmt::print(
+            destination_,
+            "{},{},{},{},{},{},{}\n",
+            "TimeStep",
+            "Temperature",
+            "Density",
+            "ParticleCount",
+            "PotentialEnergy",
+            "Virial",
+            "Count"
+        );
+    }
+
+    void EnergyHistogramSink::write(int time_step, const EnergyHistogramData& message)
+    {
+        const auto& histogram = *message.data;
+
+        for (size_t bin = 0; bin < histogram.counts.size(); ++bin)
+        {
+            fmt::print(
+                destination_,
+                "{},{},{},{},{},{},{}\n",
+                time_step,
+                histogram.temperature,
+                histogram.density,
+                histogram.particle_count,
+                histogram.potential_energies[bin],
+                histogram.virials[bin],
+                histogram.counts[bin]
+            );
+        }
+    }
+
     void SystemSnapshotSink::write_header()
     {
         // We set up two header rows for a multi-index Pandas dataframe
@@ -181,26 +549,102 @@ namespace output
         );
     }
 
-    void SystemSnapshotSink::write(int time_step, SystemSnapshot message)
+    void SystemSnapshotSink::write(int time_step, const SystemSnapshot& message)
     {
-        for (int particle_id : std::views::iota(0, message.positions.cols()))
+        const auto& snapshot = *message.data;
+
+        for (int particle_id : std::views::iota(0, snapshot.positions.cols()))
         {
             fmt::print(
                 destination_,
                 "{},{},{},{},{},{},{},{},{},{},{}\n",
                 time_step,
                 particle_id,
-                message.positions.col(particle_id).x(),
-                message.positions.col(particle_id).y(),
-                message.positions.col(particle_id).z(),
-                message.velocities.col(particle_id).x(),
-                message.velocities.col(particle_id).y(),
-                message.velocities.col(particle_id).z(),
-                message.forces.col(particle_id).x(),
-                message.forces.col(particle_id).y(),
-                message.forces.col(particle_id).z()
+                snapshot.positions.col(particle_id).x(),
+                snapshot.positions.col(particle_id).y(),
+                snapshot.positions.col(particle_id).z(),
+                snapshot.velocities.col(particle_id).x(),
+                snapshot.velocities.col(particle_id).y(),
+                snapshot.velocities.col(particle_id).z(),
+                snapshot.forces.col(particle_id).x(),
+                snapshot.forces.col(particle_id).y(),
+                snapshot.forces.col(particle_id).z()
             );
         }
     }
+
+    void TrajectorySink::write(int time_step, const TrajectoryFrame& message)
+    {
+        const auto& frame = *message.data;
+        auto particle_count = static_cast<std::uint32_t>(frame.positions.cols());
+        bool write_velocities = (frame.velocities.cols() == frame.positions.cols());
+
+        if (header_pending_)
+        {
+            destination_.write("LJTRAJEC", 8);
+            tools::write_binary(destination_, std::uint32_t{2});
+            tools::write_binary(destination_, std::uint32_t{0x01020304});
+            tools::write_binary(destination_, particle_count);
+            tools::write_binary(destination_, static_cast<std::uint32_t>(write_velocities));
+            header_pending_ = false;
+        }
+
+        // The velocities start on a multiple of 4 bytes, and the frame ends on a multiple of 8
+        auto pad = [](std::uint32_t size, std::uint32_t alignment)
+            {return (size + alignment - 1) / alignment * alignment;};
+
+        std::uint32_t positions_end = static_cast<std::uint32_t>(
+            sizeof(std::uint32_t) + sizeof(std::int32_t) + 4 * sizeof(double)
+            + particle_count * 3 * sizeof(std::uint16_t)
+        );
+        std::uint32_t velocities_start = write_velocities ? pad(positions_end, 4) : positions_end;
+        std::uint32_t velocities_end = velocities_start
+            + (write_velocities ? particle_count * 3 * std::uint32_t{sizeof(float)} : 0);
+        std::uint32_t frame_size = pad(velocities_end, 8);
+
+        static constexpr char padding[8] = {};
+
+        tools::write_binary(destination_, frame_size);
+        tools::write_binary(destination_, static_cast<std::int32_t>(time_step));
+        tools::write_binary(destination_, frame.time);
+        for (int i = 0; i < 3; ++i) {tools::write_binary(destination_, frame.box(i));}
+
+        // Quantize each coordinate to a 16-bit fraction of the box side; it is decoded as
+        // (q + 0.5) / 65536 * box
+        std::vector<std::uint16_t> positions(particle_count * 3);
+        for (std::uint32_t j = 0; j < particle_count; ++j)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                double q = std::floor(frame.positions(i, j) / frame.box(i) * 65536.0);
+                positions[3 * j + i] = static_cast<std::uint16_t>(std::clamp(q, 0.0, 65535.0));
+            }
+        }
+
+        destination_.write(
+            reinterpret_cast<const char*>(positions.data()),
+            static_cast<std::streamsize>(positions.size() * sizeof(std::uint16_t))
+        );
+        destination_.write(padding, velocities_start - positions_end);
+
+        if (write_velocities)
+        {
+            std::vector<float> velocities(particle_count * 3);
+            for (std::uint32_t j = 0; j < particle_count; ++j)
+            {
+                for (int i = 0; i < 3; ++i)
+                {
+                    velocities[3 * j + i] = static_cast<float>(frame.velocities(i, j));
+                }
+            }
+
+            destination_.write(
+                reinterpret_cast<const char*>(velocities.data()),
+                static_cast<std::streamsize>(velocities.size() * sizeof(float))
+            );
+        }
+
+        destination_.write(padding, frame_size - velocities_end);
+    }
 } // namespace output
 
@@ -23,8 +23,11 @@
 #ifndef LJ_SINKS_HPP
 #define LJ_SINKS_HPP
 
+#include <array>
 #include <concepts>
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include <lennardjonesium/physics/system_state.hpp>
 #include <lennardjonesium/output/log_message.hpp>
@@ -55,7 +58,7 @@ namespace detail
     class MessageSink
     {
         public:
-            virtual void write(int time_step, MessageType message) = 0;
+            virtual void write(int time_step, const MessageType& message) = 0;
     };
 } // namespace detail
 
@@ -74,6 +77,10 @@ namespace output
      *  EventSink
      *  ThermodynamicSink
      *  ObservationSink
+     *  PairDistributionSink
+     *  EnergyHistogramSink
+     *  SystemSnapshotSink
+     *  TrajectorySink
      */
 
     /**
@@ -99,39 +106,133 @@ namespace output
           public detail::MessageSink<AdjustTemperatureEvent>,
           public detail::MessageSink<RecordObservationEvent>,
           public detail::MessageSink<PhaseCompleteEvent>,
-          public detail::MessageSink<AbortSimulationEvent>
+          public detail::MessageSink<AbortSimulationEvent>,
+          public detail::MessageSink<ReplicaExchangeEvent>,
+          public detail::MessageSink<DroppedMessagesEvent>,
+          public detail::MessageSink<CheckpointFailedEvent>,
+          public detail::MessageSink<WarmStartFailedEvent>
     {
         public:
             // For the moment, the Events file has no header information
             virtual void write_header() override {}
 
-            virtual void write(int time_step, PhaseStartEvent message) override;
-            virtual void write(int time_step, AdjustTemperatureEvent message) override;
-            virtual void write(int time_step, RecordObservationEvent message) override;
-            virtual void write(int time_step, PhaseCompleteEvent message) override;
-            virtual void write(int time_step, AbortSimulationEvent message) override;
+            virtual void write(int time_step, const PhaseStartEvent& message) override;
+            virtual void write(int time_step, const AdjustTemperatureEvent& message) override;
+            virtual void write(int time_step, const RecordObservationEvent& message) override;
+            virtual void write(int time_step, const PhaseCompleteEvent& message) override;
+            virtual void write(int time_step, const AbortSimulationEvent& message) override;
+            virtual void write(int time_step, const ReplicaExchangeEvent& message) override;
+            virtual void write(int time_step, const DroppedMessagesEvent& message) override;
+            virtual void write(int time_step, const CheckpointFailedEvent& message) override;
+            virtual void write(int time_step, const WarmStartFailedEvent& message) override;
 
             EventSink() = default;
             explicit EventSink(std::ostream& destination) : detail::SinkCommon{destination} {}
     };
 
+    struct ThermodynamicReduction
+    {
+        /**
+         * Configures how much of the thermodynamic data the ThermodynamicSink writes.  Long
+         * production runs measure at every time step, which makes this log by far the largest,
+         * and most of its rows are never looked at individually:
+         * 
+         *  none:       Write every measurement
+         *  decimate:   Write only the measurements on time steps which are multiples of interval
+         *  aggregate:  Write one row per block of interval measurements.  Each quantity has the
+         *              mean of the block under its usual column name (so that plots of the log
+         *              work unchanged), followed by the columns <name>Min, <name>Max, and
+         *              <name>Variance.  TimeStep and Time are those of the last measurement in
+         *              the block, and SampleCount is the number of measurements in it (which is
+         *              less than interval for a block cut short by the start of a phase, by a
+         *              temperature adjustment, or by the end of the run).
+         */
+
+        enum class Mode {none, decimate, aggregate};
+
+        Mode mode = Mode::none;
+        int interval = 10;
+    };
+
     /**
      * ThermodynamicSink will record the raw (instantaneous) thermodynamic measurements to a file,
      * which will allow us to re-analyze them later, if desired.
+     * 
+     * Since this is by far the largest output, it can be written either as CSV, or in a compact
+     * binary columnar format which costs nothing to format and can be memory-mapped directly
+     * (e.g. by numpy.memmap).  The binary file consists of a header:
+     * 
+     *  char[8]     magic "LJCOLUMN"
+     *  uint32      format version (1)
+     *  uint32      byte order mark 0x01020304 (values are in the native byte order)
+     *  uint32      number of columns
+     *  uint32      offset of the first record (a multiple of 8)
+     *  for each column: uint32 name length, followed by the name (the columns of the CSV header)
+     *  zero padding up to the first record
+     * 
+     * followed by one fixed-width record per time step, holding one float64 for each column.
+     * The destination stream should be opened in binary mode.
+     * 
+     * The ThermodynamicReduction decides which rows are written, and in the aggregate mode, the
+     * columns of both formats are those of the aggregated rows.
+     * 
+     * The components of the virial and kinetic tensors (the last twelve columns) are only
+     * written with pressure_tensor, since the virial tensor is only computed when asked for.
      */
     class ThermodynamicSink
         : public detail::SinkCommon, public detail::MessageSink<ThermodynamicData>
     {
         public:
+            enum class Format {csv, binary};
+
             virtual void write_header() override;
 
-            virtual void write(int time_step, ThermodynamicData message) override;
+            virtual void write(int time_step, const ThermodynamicData& message) override;
+
+            // Write out an incomplete block of aggregated measurements (at the end of the run,
+            // or at an event which should not fall inside a block)
+            void write_partial_block();
 
             ThermodynamicSink() = default;
 
-            explicit ThermodynamicSink(std::ostream& destination)
-                : detail::SinkCommon{destination}
-            {}
+            explicit ThermodynamicSink(
+                std::ostream& destination,
+                Format format = Format::csv,
+                ThermodynamicReduction reduction = {},
+                bool pressure_tensor = false
+            );
+        
+        private:
+            // TimeStep and Time, followed by the measured quantities (the last twelve of which
+            // are the tensor components)
+            static constexpr size_t quantity_count = 18;
+            static constexpr size_t scalar_quantity_count = 6;
+            using Record = std::array<double, 2 + quantity_count>;
+
+            struct Block
+            {
+                // Running statistics of each quantity (the variance by Welford's algorithm)
+                int count{0};
+                int last_time_step{0};
+                double last_time{0};
+                std::array<double, quantity_count> mean{};
+                std::array<double, quantity_count> sum_of_squares{};
+                std::array<double, quantity_count> min{};
+                std::array<double, quantity_count> max{};
+            };
+
+            // The number of quantities which are actually written
+            size_t quantities_() const
+                {return pressure_tensor_ ? quantity_count : scalar_quantity_count;}
+
+            std::vector<std::string> columns_() const;
+            void write_row_(const double* values, size_t count);
+            void add_to_block_(const Record& record);
+
+            Format format_ = Format::csv;
+            ThermodynamicReduction reduction_ = {};
+            bool pressure_tensor_ = false;
+            Block block_ = {};
     };
 
     /**
@@ -143,7 +244,7 @@ namespace output
         public:
             virtual void write_header() override;
 
-            virtual void write(int time_step, ObservationData message) override;
+            virtual void write(int time_step, const ObservationData& message) override;
 
             ObservationSink() = default;
             
@@ -152,6 +253,45 @@ namespace output
             {}
     };
 
+    /**
+     * PairDistributionSink will record the radial distribution function g(r) to a file, one row
+     * per histogram bin.  The time step identifies the phase at the end of which it was recorded.
+     */
+    class PairDistributionSink
+        : public detail::SinkCommon, public detail::MessageSink<PairDistributionData>
+    {
+        public:
+            virtual void write_header() override;
+
+            virtual void write(int time_step, const PairDistributionData& message) override;
+
+            PairDistributionSink() = default;
+            
+            explicit PairDistributionSink(std::ostream& destination)
+                : detail::SinkCommon{destination}
+            {}
+    };
+
+    /**
+     * EnergyHistogramSink will record the potential energy histogram to a file, one row per
+     * bin.  Each row repeats the state point at which the histogram was taken, so that the
+     * histograms of several runs can simply be concatenated before reweighting them.
+     */
+    class EnergyHistogramSink
+        : public detail::SinkCommon, public detail::MessageSink<EnergyHistogramData>
+    {
+        public:
+            virtual void write_header() override;
+
+            virtual void write(int time_step, const EnergyHistogramData& message) override;
+
+            EnergyHistogramSink() = default;
+            
+            explicit EnergyHistogramSink(std::ostream& destination)
+                : detail::SinkCommon{destination}
+            {}
+    };
+
     /**
      * SystemSnapshotSink will write the positions, velocities, and forces (accelerations) of all
      * particles to a file.  One use is for writing the final state at the end of the simulation.
@@ -164,7 +304,7 @@ namespace output
         public:
             virtual void write_header() override;
 
-            virtual void write(int time_step, SystemSnapshot message) override;
+            virtual void write(int time_step, const SystemSnapshot& message) override;
 
             SystemSnapshotSink() = default;
             
@@ -172,6 +312,57 @@ namespace output
                 : detail::SinkCommon{destination}
             {}
     };
+
+    /**
+     * TrajectorySink writes frames of the trajectory to a compact binary file, for making movies
+     * or for analysis after the run.  As in the XTC format, the positions are quantized relative
+     * to the box: each coordinate is stored as a uint16 fraction of the box side, which gives a
+     * resolution of about 1e-4 of the box side (for the boxes we simulate, better than 1e-3 in
+     * units of sigma).  The velocities, if recorded, are stored as float32.
+     * 
+     * The file starts with a header, which is written along with the first frame (since it
+     * depends on the particle count), and only if write_header() was called, so that a log which
+     * is continued does not get a second one:
+     * 
+     *  char[8]     magic "LJTRAJEC"
+     *  uint32      format version (2)
+     *  uint32      byte order mark 0x01020304 (values are in the native byte order)
+     *  uint32      number of particles N
+     *  uint32      1 if velocities are recorded, 0 otherwise
+     * 
+     * Each frame is then:
+     * 
+     *  uint32      size of the frame in bytes (including this field)
+     *  int32       time step
+     *  float64     time
+     *  float64[3]  box dimensions
+     *  uint16[N][3]    quantized positions
+     *  zero padding up to a multiple of 4 bytes (only if N is odd)
+     *  float32[N][3]   velocities (if recorded)
+     *  zero padding up to a multiple of 8 bytes
+     * 
+     * All frames have the same size, so frame k starts at byte 24 + k * (frame size), and the
+     * file can be seeked (or memory-mapped) without an index.  The padding keeps every field of
+     * every frame aligned, so that a memory-mapped file can be read in place.
+     */
+    class TrajectorySink
+        : public detail::SinkCommon, public detail::MessageSink<TrajectoryFrame>
+    {
+        public:
+            // The header is written with the first frame
+            virtual void write_header() override {header_pending_ = true;}
+
+            virtual void write(int time_step, const TrajectoryFrame& message) override;
+
+            TrajectorySink() = default;
+            
+            explicit TrajectorySink(std::ostream& destination)
+                : detail::SinkCommon{destination}
+            {}
+        
+        private:
+            bool header_pending_{false};
+    };
 } // namespace output
 
 
@@ -0,0 +1,180 @@
+/**
+ * snapshot_reader.cpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include <lennardjonesium/physics/energy_histogram.hpp>
+#include <lennardjonesium/output/log_message.hpp>
+#include <lennardjonesium/output/snapshot_reader.hpp>
+
+namespace
+{
+    // TimeStep, ParticleID, then position, velocity, and force components
+    constexpr int snapshot_column_count = 11;
+
+    // TimeStep, Temperature, Density, ParticleCount, PotentialEnergy, Virial, Count
+    constexpr int histogram_column_count = 7;
+
+    // Split a line on commas and parse every field, failing if any is malformed
+    template<int column_count>
+    std::optional<std::array<double, column_count>> parse_row(std::string_view line)
+    {
+        std::array<double, column_count> fields{};
+
+        for (int column = 0; column < column_count; ++column)
+        {
+            auto end = (column + 1 < column_count) ? line.find(',') : line.size();
+            if (end == std::string_view::npos) {return std::nullopt;}
+
+            auto field = line.substr(0, end);
+            auto [last, error] = std::from_chars(
+                field.data(), field.data() + field.size(), fields[column]
+            );
+
+            if (error != std::errc{} || last != field.data() + field.size()) {return std::nullopt;}
+
+            line.remove_prefix(std::min(end + 1, line.size()));
+        }
+
+        return fields;
+    }
+} // namespace
+
+
+namespace output
+{
+    std::optional<SystemSnapshot> read_snapshot(std::istream& source)
+    {
+        std::string line;
+
+        // Skip the two header rows
+        for (int header_row = 0; header_row < 2; ++header_row)
+        {
+            if (!std::getline(source, line) || !line.starts_with("TimeStep,ParticleID,"))
+            {
+                return std::nullopt;
+            }
+        }
+
+        // Collect the rows of the most recent time step
+        std::vector<std::array<double, snapshot_column_count>> rows;
+        double current_time_step{-1};
+
+        while (std::getline(source, line))
+        {
+            if (line.empty()) {continue;}
+
+            auto row = parse_row<snapshot_column_count>(line);
+            if (!row) {return std::nullopt;}
+
+            if ((*row)[0] != current_time_step)
+            {
+                current_time_step = (*row)[0];
+                rows.clear();
+            }
+
+            // Particles are written in order of their IDs
+            if ((*row)[1] != static_cast<double>(rows.size())) {return std::nullopt;}
+
+            rows.push_back(*row);
+        }
+
+        if (rows.empty()) {return std::nullopt;}
+
+        auto particle_count = static_cast<Eigen::Index>(rows.size());
+
+        SystemSnapshot::Data snapshot{
+            .positions = Eigen::Matrix4Xd::Zero(4, particle_count),
+            .velocities = Eigen::Matrix4Xd::Zero(4, particle_count),
+            .forces = Eigen::Matrix4Xd::Zero(4, particle_count)
+        };
+
+        for (Eigen::Index i = 0; i < particle_count; ++i)
+        {
+            const auto& row = rows[i];
+
+            snapshot.positions.col(i).head<3>() << row[2], row[3], row[4];
+            snapshot.velocities.col(i).head<3>() << row[5], row[6], row[7];
+            snapshot.forces.col(i).head<3>() << row[8], row[9], row[10];
+        }
+
+        return SystemSnapshot{std::move(snapshot)};
+    }
+
+    std::optional<physics::EnergyHistogram> read_energy_histogram(std::istream& source)
+    {
+        std::string line;
+
+        if (!std::getline(source, line) || !line.starts_with("TimeStep,Temperature,"))
+        {
+            return std::nullopt;
+        }
+
+        // Collect the rows of the most recent time step
+        std::vector<std::array<double, histogram_column_count>> rows;
+        double current_time_step{-1};
+
+        while (std::getline(source, line))
+        {
+            if (line.empty()) {continue;}
+
+            auto row = parse_row<histogram_column_count>(line);
+            if (!row) {return std::nullopt;}
+
+            if ((*row)[0] != current_time_step)
+            {
+                current_time_step = (*row)[0];
+                rows.clear();
+            }
+
+            rows.push_back(*row);
+        }
+
+        if (rows.empty()) {return std::nullopt;}
+
+        physics::EnergyHistogram histogram{
+            .temperature = rows.front()[1],
+            .density = rows.front()[2],
+            .particle_count = static_cast<int>(rows.front()[3])
+        };
+
+        for (const auto& row : rows)
+        {
+            histogram.potential_energies.push_back(row[4]);
+            histogram.virials.push_back(row[5]);
+            histogram.counts.push_back(static_cast<long>(row[6]));
+        }
+
+        return histogram;
+    }
+} // namespace output
@@ -0,0 +1,54 @@
+/**
+ * snapshot_reader.hpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LJ_SNAPSHOT_READER_HPP
+#define LJ_SNAPSHOT_READER_HPP
+
+#include <istream>
+#include <optional>
+
+#include <lennardjonesium/physics/energy_histogram.hpp>
+#include <lennardjonesium/output/log_message.hpp>
+
+namespace output
+{
+    /**
+     * read_snapshot() reads back a file written by the SystemSnapshotSink, so that the final
+     * state of one simulation can be used to start another (see engine::InitialCondition).  If
+     * the file holds several snapshots, the last one is returned.  Since the snapshot file does
+     * not record the 4th (unused) vector components, they are set to zero.
+     * 
+     * If the file is not a valid snapshot file, or contains no snapshot, std::nullopt is
+     * returned.
+     */
+    std::optional<SystemSnapshot> read_snapshot(std::istream& source);
+
+    /**
+     * read_energy_histogram() similarly reads back a file written by the EnergyHistogramSink, so
+     * that the histograms of several runs can be combined by physics::HistogramReweighting.  If
+     * the file holds several histograms (one per ObservationPhase), the last one is returned.
+     */
+    std::optional<physics::EnergyHistogram> read_energy_histogram(std::istream& source);
+} // namespace output
+
+
+#endif
@@ -0,0 +1,352 @@
+/**
+ * sweep_store.cpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <lennardjonesium/tools/binary_stream.hpp>
+#include <lennardjonesium/output/sweep_store.hpp>
+
+namespace
+{
+    constexpr std::uint32_t format_version = 2;
+    constexpr std::uint32_t byte_order_mark = 0x01020304;
+    constexpr std::uint64_t header_size = 16;
+
+    void write_header(std::ostream& out, const char* magic)
+    {
+        out.write(magic, 8);
+        tools::write_binary(out, format_version);
+        tools::write_binary(out, byte_order_mark);
+    }
+
+    bool read_header(std::istream& in, const char* magic)
+    {
+        char buffer[8];
+        std::uint32_t version{0};
+        std::uint32_t bom{0};
+
+        in.read(buffer, 8);
+        tools::read_binary(in, version);
+        tools::read_binary(in, bom);
+
+        if (!in || !std::equal(buffer, buffer + 8, magic)) {return false;}
+
+        // Never start afresh over a store which is merely in another format
+        if (version != format_version || bom != byte_order_mark)
+        {
+            throw std::ios_base::failure("SweepStore: unsupported store format");
+        }
+
+        return true;
+    }
+
+    std::filesystem::path index_path(const std::filesystem::path& path)
+    {
+        auto result = path;
+        result += ".index";
+        return result;
+    }
+} // namespace
+
+
+namespace output
+{
+    std::shared_ptr<SweepStore> SweepStore::open(const std::filesystem::path& path)
+    {
+        static std::mutex registry_mutex;
+        static std::map<std::filesystem::path, std::weak_ptr<SweepStore>> registry;
+
+        auto key = std::filesystem::weakly_canonical(std::filesystem::absolute(path));
+
+        std::scoped_lock lock{registry_mutex};
+
+        auto store = registry[key].lock();
+
+        if (!store)
+        {
+            store = std::make_shared<SweepStore>(key);
+            registry[key] = store;
+        }
+
+        return store;
+    }
+
+    SweepStore::SweepStore(const std::filesystem::path& path)
+        : path_{path}, index_path_{index_path(path)}
+    {
+        namespace fs = std::filesystem;
+
+        if (!path_.parent_path().empty()) {fs::create_directories(path_.parent_path());}
+
+        // Start afresh if either file is missing or is not a store
+        bool existing = fs::is_regular_file(path_) && fs::is_regular_file(index_path_);
+
+        if (existing)
+        {
+            std::ifstream data{path_, std::ios::binary};
+            existing = read_header(data, "LJSTORED");
+        }
+
+        if (existing) {load_index_();}
+
+        if (existing)
+        {
+            data_.open(path_, std::ios::binary | std::ios::app);
+            index_.open(index_path_, std::ios::binary | std::ios::app);
+            data_size_ = fs::file_size(path_);
+        }
+        else
+        {
+            data_.open(path_, std::ios::binary | std::ios::trunc);
+            index_.open(index_path_, std::ios::binary | std::ios::trunc);
+
+            write_header(data_, "LJSTORED");
+            write_header(index_, "LJSINDEX");
+            data_.flush();
+            index_.flush();
+
+            data_size_ = header_size;
+        }
+
+        if (!data_ || !index_)
+        {
+            throw std::ios_base::failure("SweepStore: cannot open " + path_.string());
+        }
+    }
+
+    SweepStore::Segment
+    SweepStore::segment(std::string run, std::string log, std::size_t chunk_size)
+    {
+        auto state = std::make_shared<Segment::State>(Segment::State{
+            .store = shared_from_this(),
+            .segment = new_segment_(),
+            .run = std::move(run),
+            .log = std::move(log),
+            .chunk_size = std::max<std::size_t>(chunk_size, 1),
+            .buffer = {}
+        });
+
+        state->buffer.reserve(state->chunk_size);
+
+        return Segment{std::move(state)};
+    }
+
+    void SweepStore::append(const std::string& run, const std::string& log, std::string_view data)
+    {
+        auto segment = new_segment_();
+
+        write_chunk_(segment, run, log, data);
+        close_segment_(segment, run, log);
+    }
+
+    std::optional<std::string> SweepStore::read(const std::string& run, const std::string& log)
+    {
+        std::vector<Chunk> chunks;
+
+        {
+            std::scoped_lock lock{mutex_};
+
+            auto entry = entries_.find({run, log});
+            if (entry == entries_.end()) {return std::nullopt;}
+
+            chunks = entry->second.chunks;
+        }
+
+        std::ifstream data{path_, std::ios::binary};
+        std::string result;
+
+        for (const auto& chunk : chunks)
+        {
+            auto size = result.size();
+            result.resize(size + chunk.length);
+
+            data.seekg(static_cast<std::streamoff>(chunk.offset));
+            data.read(result.data() + size, static_cast<std::streamsize>(chunk.length));
+        }
+
+        if (!data) {return std::nullopt;}
+
+        return result;
+    }
+
+    void SweepStore::write_chunk_(
+        std::uint64_t segment,
+        const std::string& run,
+        const std::string& log,
+        std::string_view data
+    )
+    {
+        std::scoped_lock lock{mutex_};
+
+        std::uint64_t offset = data_size_;
+
+        // Hand the data to the OS before the index refers to it, so that a reader in another
+        // process never finds a record whose data it cannot read.  Nothing is synced to disk:
+        // after a system crash, load_index_() ignores records which point past the end of the
+        // data file.
+        data_.write(data.data(), static_cast<std::streamsize>(data.size()));
+        data_.flush();
+        data_size_ += data.size();
+
+        write_record_(segment, run, log, {offset, data.size()});
+    }
+
+    void SweepStore::close_segment_(
+        std::uint64_t segment, const std::string& run, const std::string& log
+    )
+    {
+        std::scoped_lock lock{mutex_};
+        write_record_(segment, run, log, {closing_offset, 0});
+    }
+
+    void SweepStore::write_record_(
+        std::uint64_t segment,
+        const std::string& run,
+        const std::string& log,
+        Chunk chunk
+    )
+    {
+        tools::write_binary(index_, segment);
+        tools::write_binary(index_, chunk.offset);
+        tools::write_binary(index_, chunk.length);
+        tools::write_binary(index_, static_cast<std::uint32_t>(run.size()));
+        tools::write_binary(index_, static_cast<std::uint32_t>(log.size()));
+        index_.write(run.data(), static_cast<std::streamsize>(run.size()));
+        index_.write(log.data(), static_cast<std::streamsize>(log.size()));
+        index_.flush();
+
+        if (!data_ || !index_)
+        {
+            throw std::ios_base::failure("SweepStore: cannot write to " + path_.string());
+        }
+
+        record_(segment, run, log, chunk);
+    }
+
+    void SweepStore::load_index_()
+    {
+        std::ifstream index{index_path_, std::ios::binary};
+        if (!read_header(index, "LJSINDEX")) {return;}
+
+        auto data_size = std::filesystem::file_size(path_);
+
+        while (true)
+        {
+            std::uint64_t segment{0}, offset{0}, length{0};
+            std::uint32_t run_size{0}, log_size{0};
+
+            tools::read_binary(index, segment);
+            tools::read_binary(index, offset);
+            tools::read_binary(index, length);
+            tools::read_binary(index, run_size);
+            tools::read_binary(index, log_size);
+
+            std::string run(run_size, '\0');
+            std::string log(log_size, '\0');
+            index.read(run.data(), run_size);
+            index.read(log.data(), log_size);
+
+            // Ignore an incomplete record at the end, or one whose data never made it to disk
+            if (!index || (offset != closing_offset && offset + length > data_size)) {break;}
+
+            next_segment_ = std::max(next_segment_, segment + 1);
+            record_(segment, run, log, {offset, length});
+        }
+    }
+
+    void SweepStore::record_(
+        std::uint64_t segment, const std::string& run, const std::string& log, Chunk chunk
+    )
+    {
+        if (chunk.offset != closing_offset)
+        {
+            open_segments_[segment].push_back(chunk);
+            return;
+        }
+
+        auto chunks = std::move(open_segments_[segment]);
+        open_segments_.erase(segment);
+
+        // Only the newest closed segment of each log is kept
+        auto entry = entries_.find({run, log});
+        if (entry == entries_.end() || segment > entry->second.segment)
+        {
+            entries_[{run, log}] = Entry{.segment = segment, .chunks = std::move(chunks)};
+        }
+    }
+
+    std::uint64_t SweepStore::new_segment_()
+    {
+        std::scoped_lock lock{mutex_};
+        return next_segment_++;
+    }
+
+    std::streamsize SweepStore::Segment::write(const char* s, std::streamsize n)
+    {
+        State& state = *state_;
+        std::string_view data{s, static_cast<std::size_t>(n)};
+
+        while (!data.empty())
+        {
+            auto count = std::min(data.size(), state.chunk_size - state.buffer.size());
+            state.buffer.append(data.substr(0, count));
+            data.remove_prefix(count);
+
+            if (state.buffer.size() == state.chunk_size) {write_buffer_();}
+        }
+
+        return n;
+    }
+
+    void SweepStore::Segment::close()
+    {
+        State& state = *state_;
+        if (state.closed) {return;}
+
+        // An empty log is recorded as well, so that it replaces any older segment
+        if (!state.buffer.empty() || !state.written) {write_buffer_();}
+
+        state.store->close_segment_(state.segment, state.run, state.log);
+        state.closed = true;
+    }
+
+    void SweepStore::Segment::write_buffer_()
+    {
+        State& state = *state_;
+
+        state.store->write_chunk_(state.segment, state.run, state.log, state.buffer);
+        state.buffer.clear();
+        state.written = true;
+    }
+} // namespace output
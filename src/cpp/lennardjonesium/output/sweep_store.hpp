@@ -0,0 +1,206 @@
+/**
+ * sweep_store.hpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LJ_SWEEP_STORE_HPP
+#define LJ_SWEEP_STORE_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <boost/iostreams/categories.hpp>
+
+namespace output
+{
+    class SweepStore : public std::enable_shared_from_this<SweepStore>
+    {
+        /**
+         * SweepStore collects the logs of all the runs of a sweep into a single append-only data
+         * file, rather than a directory of small files per run.  Next to the data file (at the
+         * same path with ".index" appended) is an index, which says where each piece of each log
+         * is, so that a reader can load the logs of a few runs without scanning anything else.
+         * 
+         * Each log of a run is written as a "segment", identified by the run name, the log name,
+         * and a segment number.  A Segment device collects its data into chunks, and each full
+         * chunk is appended to the data file and then recorded in the index, so the logs of many
+         * runs can be written at the same time and their chunks interleave.  When the Segment is
+         * closed, a closing record is added to the index.  Writing the same run and log again
+         * (e.g. when a run is repeated) starts a new segment, and readers take the newest one
+         * which was closed; a segment which was never closed (e.g. because the run was killed)
+         * is ignored, so that it does not hide an earlier, complete one.
+         * 
+         * Every Simulation in a process which names the same store shares one SweepStore (see
+         * open()), so the files are only ever appended to by one writer, which holds a mutex
+         * only long enough to append one chunk.
+         * 
+         * The index consists of a header ("LJSINDEX", u32 version, u32 byte order mark) followed
+         * by records of the form
+         * 
+         *  u64 segment, u64 offset, u64 length, u32 run size, u32 log size, run, log
+         * 
+         * in the native byte order.  A closing record has offset 2^64 - 1 and length 0.  The data
+         * file has a similar header ("LJSTORED", version, byte order mark), and the offsets are
+         * relative to the start of the file.  The Python class lennardjonesium.tools.SweepStore
+         * reads both.
+         */
+
+        public:
+            // Sink device writing one log of one run (see segment())
+            class Segment;
+
+            // The store at the given path, shared with every other user in this process
+            static std::shared_ptr<SweepStore> open(const std::filesystem::path& path);
+
+            // Open (or create) a store; existing segments are kept.  Since a Segment keeps its
+            // store alive, segment() may only be used on a store owned by a shared_ptr.
+            explicit SweepStore(const std::filesystem::path& path);
+
+            SweepStore(const SweepStore&) = delete;
+            SweepStore& operator=(const SweepStore&) = delete;
+
+            // Start a new segment for the given run and log
+            Segment segment(std::string run, std::string log, std::size_t chunk_size = 1 << 20);
+
+            // Write a whole segment at once
+            void append(const std::string& run, const std::string& log, std::string_view data);
+
+            // The contents of the newest segment of the given run and log, if there is one
+            std::optional<std::string> read(const std::string& run, const std::string& log);
+
+            const std::filesystem::path& path() const {return path_;}
+
+        private:
+            struct Chunk
+            {
+                std::uint64_t offset;
+                std::uint64_t length;
+            };
+
+            struct Entry
+            {
+                std::uint64_t segment;
+                std::vector<Chunk> chunks;
+            };
+
+            // Marks the closing record of a segment in the index
+            static constexpr std::uint64_t closing_offset = ~std::uint64_t{0};
+
+            // Append a chunk of a segment to the data file, and record it in the index
+            void write_chunk_(
+                std::uint64_t segment,
+                const std::string& run,
+                const std::string& log,
+                std::string_view data
+            );
+
+            // Record in the index that a segment is complete
+            void close_segment_(
+                std::uint64_t segment, const std::string& run, const std::string& log
+            );
+
+            void write_record_(
+                std::uint64_t segment,
+                const std::string& run,
+                const std::string& log,
+                Chunk chunk
+            );
+
+            void load_index_();
+
+            // Add a chunk, or the closing record, of a segment to the in-memory index
+            void record_(
+                std::uint64_t segment, const std::string& run, const std::string& log, Chunk chunk
+            );
+
+            std::uint64_t new_segment_();
+
+            std::filesystem::path path_;
+            std::filesystem::path index_path_;
+
+            std::mutex mutex_;
+            std::ofstream data_;
+            std::ofstream index_;
+            std::uint64_t data_size_{0};
+            std::uint64_t next_segment_{0};
+
+            // The newest closed segment of each (run, log), and the chunks of the open segments
+            std::map<std::pair<std::string, std::string>, Entry> entries_;
+            std::map<std::uint64_t, std::vector<Chunk>> open_segments_;
+    };
+
+    class SweepStore::Segment
+    {
+        /**
+         * A Segment is a Boost.Iostreams Sink device for one log of one run.  Data is written to
+         * the store one chunk at a time, and the rest when the device is closed, along with the
+         * closing record.  A Segment to which nothing was written is still recorded (as empty)
+         * when it is closed.  It is not flushable, since flushing a line at a time would fill the
+         * index with tiny chunks.
+         * 
+         * As with file_sink, the device is a handle to shared state, so that it may be copied.
+         */
+
+        public:
+            using char_type = char;
+
+            struct category
+                : public boost::iostreams::sink_tag,
+                  public boost::iostreams::closable_tag
+            {};
+
+            std::streamsize write(const char* s, std::streamsize n);
+            void close();
+
+        private:
+            friend class SweepStore;
+
+            struct State
+            {
+                std::shared_ptr<SweepStore> store;
+                std::uint64_t segment;
+                std::string run;
+                std::string log;
+                std::size_t chunk_size;
+                std::string buffer;
+                bool written{false};
+                bool closed{false};
+            };
+
+            explicit Segment(std::shared_ptr<State> state) : state_{std::move(state)} {}
+
+            void write_buffer_();
+
+            std::shared_ptr<State> state_;
+    };
+} // namespace output
+
+
+#endif
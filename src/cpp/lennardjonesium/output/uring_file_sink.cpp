@@ -0,0 +1,499 @@
+/**
+ * uring_file_sink.cpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <ios>
+#include <memory>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define LJ_HAVE_IO_URING
+#endif
+
+#include <lennardjonesium/output/uring_file_sink.hpp>
+
+namespace
+{
+    // O_DIRECT writes must be aligned to the logical block size, which is at most a page
+    constexpr std::size_t page_size = 4096;
+
+    std::size_t round_up(std::size_t n, std::size_t multiple)
+        {return (n + multiple - 1) / multiple * multiple;}
+
+    [[noreturn]] void fail(const char* what, int error)
+    {
+        throw std::ios_base::failure(what, std::error_code(error, std::generic_category()));
+    }
+
+    // Write all of the data at the given offset, synchronously
+    void write_fully(int fd, const char* data, std::size_t length, off_t offset)
+    {
+        while (length > 0)
+        {
+            ssize_t written = ::pwrite(fd, data, length, offset);
+
+            if (written < 0)
+            {
+                if (errno == EINTR) {continue;}
+                fail("UringFileSink: write failed", errno);
+            }
+
+            data += written;
+            length -= written;
+            offset += written;
+        }
+    }
+
+    // The ring indices are shared with the kernel
+    unsigned int load_acquire(unsigned int* index)
+        {return std::atomic_ref<unsigned int>(*index).load(std::memory_order_acquire);}
+
+    void store_release(unsigned int* index, unsigned int value)
+        {std::atomic_ref<unsigned int>(*index).store(value, std::memory_order_release);}
+} // namespace
+
+
+namespace output
+{
+    class UringFileSink::Ring
+    {
+        public:
+            Ring(const std::filesystem::path& path, Options options);
+            ~Ring();
+
+            void write(const char* s, std::size_t n);
+            void flush();
+            void close();
+
+            bool is_open() const {return fd_ >= 0;}
+            bool asynchronous() const {return ring_fd_ >= 0;}
+
+        private:
+            struct Buffer
+            {
+                std::unique_ptr<char, decltype(&std::free)> data{nullptr, &std::free};
+                std::size_t length{0};      // Bytes of data in the buffer
+                std::size_t submitted{0};   // Bytes submitted (including any padding)
+                off_t offset{0};            // Offset of the buffer in the file
+                bool in_flight{false};
+            };
+
+            // Submit the current buffer (padded to whole blocks if pad is set and the file was
+            // opened with O_DIRECT), then move on to a free buffer
+            void submit_current_(bool pad);
+
+            void submit_(Buffer& buffer);
+
+            // Start writing at the end of the existing file
+            void seek_end_();
+
+            // Collect the writes which have completed, waiting for at least one if wait is set
+            void reap_(bool wait);
+
+            void setup_ring_(unsigned int entries);
+            void teardown_ring_();
+            int enter_(unsigned int to_submit, unsigned int min_complete, unsigned int flags);
+
+            int fd_{-1};
+            bool direct_{false};
+            std::size_t buffer_size_;
+            std::vector<Buffer> buffers_;
+            std::size_t current_{0};
+            off_t file_offset_{0};          // Offset of the current buffer in the file
+            std::size_t in_flight_{0};
+
+            int ring_fd_{-1};
+
+            #ifdef LJ_HAVE_IO_URING
+            void* sq_ring_{MAP_FAILED};
+            std::size_t sq_ring_size_{0};
+            void* cq_ring_{MAP_FAILED};
+            std::size_t cq_ring_size_{0};
+            io_uring_sqe* sqes_{nullptr};
+            std::size_t sqes_size_{0};
+
+            unsigned int* sq_tail_{nullptr};
+            unsigned int* sq_mask_{nullptr};
+            unsigned int* sq_array_{nullptr};
+            unsigned int* cq_head_{nullptr};
+            unsigned int* cq_tail_{nullptr};
+            unsigned int* cq_mask_{nullptr};
+            io_uring_cqe* cqes_{nullptr};
+            #endif
+    };
+
+    UringFileSink::Ring::Ring(const std::filesystem::path& path, Options options)
+        : buffer_size_{round_up(std::max<std::size_t>(options.buffer_size, 1), page_size)}
+    {
+        // Appending with O_DIRECT reads back the partial block at the end of the file
+        int flags = options.append ? (O_RDWR | O_CREAT | O_CLOEXEC)
+            : (O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC);
+
+        if (options.direct)
+        {
+            fd_ = ::open(path.c_str(), flags | O_DIRECT, 0644);
+            direct_ = (fd_ >= 0);
+        }
+
+        // Either O_DIRECT was not asked for, or the filesystem does not support it
+        if (fd_ < 0) {fd_ = ::open(path.c_str(), flags, 0644);}
+        if (fd_ < 0) {fail("UringFileSink: cannot open file", errno);}
+
+        unsigned int queue_depth = std::max(options.queue_depth, 1u);
+        buffers_.resize(queue_depth);
+
+        for (auto& buffer : buffers_)
+        {
+            buffer.data.reset(static_cast<char*>(std::aligned_alloc(page_size, buffer_size_)));
+            if (!buffer.data) {fail("UringFileSink: cannot allocate buffer", ENOMEM);}
+        }
+
+        if (options.append) {seek_end_();}
+
+        setup_ring_(queue_depth);
+    }
+
+    void UringFileSink::Ring::seek_end_()
+    {
+        struct stat status;
+        if (::fstat(fd_, &status) < 0) {fail("UringFileSink: cannot read file size", errno);}
+
+        file_offset_ = status.st_size;
+        if (!direct_) {return;}
+
+        // The first write must start on a block boundary, so it begins with the partial block
+        Buffer& buffer = buffers_[current_];
+        off_t block_start = file_offset_ - file_offset_ % static_cast<off_t>(page_size);
+        buffer.length = static_cast<std::size_t>(file_offset_ - block_start);
+
+        ssize_t count{0};
+        do {count = ::pread(fd_, buffer.data.get(), page_size, block_start);}
+        while (count < 0 && errno == EINTR);
+
+        if (count < 0) {fail("UringFileSink: cannot read file", errno);}
+        if (static_cast<std::size_t>(count) < buffer.length)
+        {
+            fail("UringFileSink: cannot read file", EIO);
+        }
+
+        file_offset_ = block_start;
+    }
+
+    UringFileSink::Ring::~Ring()
+    {
+        try {close();}
+        catch (...) {}
+
+        // If close() failed part way, at least release the resources
+        teardown_ring_();
+        if (fd_ >= 0) {::close(fd_);}
+    }
+
+    void UringFileSink::Ring::write(const char* s, std::size_t n)
+    {
+        while (n > 0)
+        {
+            Buffer& buffer = buffers_[current_];
+
+            std::size_t count = std::min(n, buffer_size_ - buffer.length);
+            std::memcpy(buffer.data.get() + buffer.length, s, count);
+
+            buffer.length += count;
+            s += count;
+            n -= count;
+
+            if (buffer.length == buffer_size_) {submit_current_(false);}
+        }
+    }
+
+    void UringFileSink::Ring::flush()
+    {
+        // With O_DIRECT, we can only write whole blocks
+        if (!direct_) {submit_current_(false);}
+        reap_(false);
+    }
+
+    void UringFileSink::Ring::close()
+    {
+        if (fd_ < 0) {return;}
+
+        submit_current_(true);
+        while (in_flight_ > 0) {reap_(true);}
+
+        // Remove the padding of the last block
+        if (direct_ && ::ftruncate(fd_, file_offset_) < 0)
+        {
+            fail("UringFileSink: cannot truncate file", errno);
+        }
+
+        teardown_ring_();
+
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+    void UringFileSink::Ring::submit_current_(bool pad)
+    {
+        Buffer& buffer = buffers_[current_];
+        if (buffer.length == 0) {return;}
+
+        buffer.submitted = buffer.length;
+
+        if (pad && direct_)
+        {
+            buffer.submitted = round_up(buffer.length, page_size);
+            std::memset(
+                buffer.data.get() + buffer.length, 0, buffer.submitted - buffer.length
+            );
+        }
+
+        buffer.offset = file_offset_;
+        file_offset_ += buffer.length;
+
+        submit_(buffer);
+
+        // Find a free buffer for the following data, waiting for one if need be
+        while (true)
+        {
+            auto free_buffer = std::ranges::find_if(
+                buffers_, [](const Buffer& buffer) {return !buffer.in_flight;}
+            );
+
+            if (free_buffer != buffers_.end())
+            {
+                current_ = free_buffer - buffers_.begin();
+                free_buffer->length = 0;
+                return;
+            }
+
+            reap_(true);
+        }
+    }
+
+    #ifdef LJ_HAVE_IO_URING
+
+    void UringFileSink::Ring::submit_(Buffer& buffer)
+    {
+        if (ring_fd_ < 0)
+        {
+            write_fully(fd_, buffer.data.get(), buffer.submitted, buffer.offset);
+            return;
+        }
+
+        // We are the only producer of submissions, so we own the tail
+        unsigned int tail = *sq_tail_;
+        unsigned int slot = tail & *sq_mask_;
+
+        io_uring_sqe& sqe = sqes_[slot];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_WRITE;
+        sqe.fd = fd_;
+        sqe.addr = reinterpret_cast<std::uint64_t>(buffer.data.get());
+        sqe.len = static_cast<std::uint32_t>(buffer.submitted);
+        sqe.off = static_cast<std::uint64_t>(buffer.offset);
+        sqe.user_data = static_cast<std::uint64_t>(&buffer - buffers_.data());
+
+        sq_array_[slot] = slot;
+        store_release(sq_tail_, tail + 1);
+
+        buffer.in_flight = true;
+        ++in_flight_;
+
+        if (enter_(1, 0, 0) < 0) {fail("UringFileSink: cannot submit write", errno);}
+
+        // Collect anything which has finished in the meantime, without waiting
+        reap_(false);
+    }
+
+    void UringFileSink::Ring::reap_(bool wait)
+    {
+        if (ring_fd_ < 0) {return;}
+
+        if (wait && in_flight_ > 0 && enter_(0, 1, IORING_ENTER_GETEVENTS) < 0)
+        {
+            fail("UringFileSink: cannot wait for write", errno);
+        }
+
+        unsigned int head = *cq_head_;
+        unsigned int tail = load_acquire(cq_tail_);
+        int error = 0;
+
+        for (; head != tail; ++head)
+        {
+            const io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+            Buffer& buffer = buffers_[cqe.user_data];
+
+            if (cqe.res < 0) {error = -cqe.res;}
+            else if (static_cast<std::size_t>(cqe.res) < buffer.submitted)
+            {
+                // Finish a short write ourselves
+                write_fully(
+                    fd_,
+                    buffer.data.get() + cqe.res,
+                    buffer.submitted - cqe.res,
+                    buffer.offset + cqe.res
+                );
+            }
+
+            buffer.in_flight = false;
+            --in_flight_;
+        }
+
+        store_release(cq_head_, head);
+
+        if (error != 0) {fail("UringFileSink: write failed", error);}
+    }
+
+    int UringFileSink::Ring::enter_(
+        unsigned int to_submit, unsigned int min_complete, unsigned int flags
+    )
+    {
+        while (true)
+        {
+            int result = static_cast<int>(::syscall(
+                __NR_io_uring_enter, ring_fd_, to_submit, min_complete, flags, nullptr, 0
+            ));
+
+            if (result >= 0 || errno != EINTR) {return result;}
+        }
+    }
+
+    void UringFileSink::Ring::setup_ring_(unsigned int entries)
+    {
+        io_uring_params params{};
+        ring_fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+
+        // Fall back to synchronous writes if the kernel does not let us use io_uring
+        if (ring_fd_ < 0) {return;}
+
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+        bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap) {sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);}
+
+        sq_ring_ = ::mmap(
+            nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            ring_fd_, IORING_OFF_SQ_RING
+        );
+
+        cq_ring_ = single_mmap ? sq_ring_ : ::mmap(
+            nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            ring_fd_, IORING_OFF_CQ_RING
+        );
+
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = ::mmap(
+            nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            ring_fd_, IORING_OFF_SQES
+        );
+
+        if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED || sqes == MAP_FAILED)
+        {
+            if (sqes != MAP_FAILED) {::munmap(sqes, sqes_size_);}
+            teardown_ring_();
+            return;
+        }
+
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+        auto sq = static_cast<char*>(sq_ring_);
+        sq_tail_ = reinterpret_cast<unsigned int*>(sq + params.sq_off.tail);
+        sq_mask_ = reinterpret_cast<unsigned int*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned int*>(sq + params.sq_off.array);
+
+        auto cq = static_cast<char*>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned int*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned int*>(cq + params.cq_off.tail);
+        cq_mask_ = reinterpret_cast<unsigned int*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    void UringFileSink::Ring::teardown_ring_()
+    {
+        if (sqes_) {::munmap(sqes_, sqes_size_);}
+        if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {::munmap(cq_ring_, cq_ring_size_);}
+        if (sq_ring_ != MAP_FAILED) {::munmap(sq_ring_, sq_ring_size_);}
+        if (ring_fd_ >= 0) {::close(ring_fd_);}
+
+        sqes_ = nullptr;
+        sq_ring_ = cq_ring_ = MAP_FAILED;
+        ring_fd_ = -1;
+    }
+
+    #else
+
+    // Without io_uring, every buffer is written synchronously
+
+    void UringFileSink::Ring::submit_(Buffer& buffer)
+        {write_fully(fd_, buffer.data.get(), buffer.submitted, buffer.offset);}
+
+    void UringFileSink::Ring::reap_(bool wait [[maybe_unused]]) {}
+
+    int UringFileSink::Ring::enter_(unsigned int, unsigned int, unsigned int) {return -1;}
+
+    void UringFileSink::Ring::setup_ring_(unsigned int entries [[maybe_unused]]) {}
+
+    void UringFileSink::Ring::teardown_ring_() {}
+
+    #endif
+
+    UringFileSink::UringFileSink(const std::filesystem::path& path)
+        : UringFileSink(path, Options{})
+    {}
+
+    UringFileSink::UringFileSink(const std::filesystem::path& path, Options options)
+        : ring_{std::make_shared<Ring>(path, options)}
+    {}
+
+    std::streamsize UringFileSink::write(const char* s, std::streamsize n)
+    {
+        ring_->write(s, static_cast<std::size_t>(n));
+        return n;
+    }
+
+    bool UringFileSink::flush()
+    {
+        ring_->flush();
+        return true;
+    }
+
+    void UringFileSink::close() {ring_->close();}
+
+    bool UringFileSink::is_open() const {return ring_->is_open();}
+
+    bool UringFileSink::asynchronous() const {return ring_->asynchronous();}
+} // namespace output
@@ -0,0 +1,104 @@
+/**
+ * uring_file_sink.hpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LJ_URING_FILE_SINK_HPP
+#define LJ_URING_FILE_SINK_HPP
+
+#include <filesystem>
+#include <ios>
+#include <memory>
+
+#include <boost/iostreams/categories.hpp>
+
+namespace output
+{
+    class UringFileSink
+    {
+        /**
+         * UringFileSink is a Boost.Iostreams Sink device which writes a file asynchronously using
+         * Linux io_uring, so it can be used wherever boost::iostreams::file_sink is, e.g.
+         * 
+         *  boost::iostreams::stream<UringFileSink> stream{UringFileSink{path}};
+         * 
+         * The data is gathered into a small number of large, page-aligned buffers.  Each full
+         * buffer is submitted as a single write at its offset in the file, and we only wait for
+         * a write to complete when we need its buffer again, so the thread calling write() makes
+         * one system call per buffer rather than one per stream buffer, and rarely waits for the
+         * disk.  Completions are collected in batches, by looking at the completion queue
+         * whenever a buffer is submitted.
+         * 
+         * With the direct option, the file is opened with O_DIRECT, so that a large trajectory
+         * does not push everything else out of the page cache.  Since O_DIRECT writes must be
+         * whole blocks, flush() does nothing in that case, and the last block is padded and then
+         * truncated when the file is closed.  If the filesystem does not support O_DIRECT, the
+         * file is opened normally.  Otherwise flush() submits whatever is in the current buffer
+         * (but does not wait for it).
+         * 
+         * With the append option, the data is written after the existing contents of the file
+         * rather than replacing them.  (With O_DIRECT, the partial block at the end of the file is
+         * read back into the first buffer, so that every write still covers whole blocks.)
+         * 
+         * If io_uring is not available (on other platforms, or if the kernel does not allow it),
+         * the buffers are written synchronously instead.
+         * 
+         * As with file_sink, the device is a handle to shared state, so that it may be copied.
+         * Errors are reported by throwing std::ios_base::failure, which the stream turns into
+         * badbit.
+         */
+
+        public:
+            using char_type = char;
+
+            struct category
+                : public boost::iostreams::sink_tag,
+                  public boost::iostreams::closable_tag,
+                  public boost::iostreams::flushable_tag
+            {};
+
+            struct Options
+            {
+                bool direct = false;
+                std::size_t buffer_size = 1 << 20;      // Rounded up to a whole page
+                unsigned int queue_depth = 8;           // Number of buffers
+                bool append = false;                    // Continue an existing file
+            };
+
+            explicit UringFileSink(const std::filesystem::path& path);
+            UringFileSink(const std::filesystem::path& path, Options options);
+
+            std::streamsize write(const char* s, std::streamsize n);
+            bool flush();
+            void close();
+
+            bool is_open() const;
+
+            // Whether the writes are actually done by io_uring
+            bool asynchronous() const;
+
+        private:
+            class Ring;
+            std::shared_ptr<Ring> ring_;
+    };
+} // namespace output
+
+
+#endif
@@ -20,11 +20,20 @@
  * <https://www.gnu.org/licenses/>.
  */
 
+#include <cmath>
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <ostream>
+
 #include <Eigen/Dense>
 
+#include <lennardjonesium/tools/binary_stream.hpp>
 #include <lennardjonesium/tools/system_parameters.hpp>
 #include <lennardjonesium/tools/moving_sample.hpp>
+#include <lennardjonesium/tools/block_average.hpp>
 #include <lennardjonesium/physics/measurements.hpp>
+#include <lennardjonesium/physics/energy_histogram.hpp>
 #include <lennardjonesium/physics/analyzers.hpp>
 
 namespace physics
@@ -157,5 +166,187 @@ namespace physics
             diffusion_coefficient
         };
     }
-} // namespace physics
 
+    void ThermodynamicAnalyzer::save(std::ostream& out) const
+    {
+        temperature_sample_.save(out);
+        total_energy_sample_.save(out);
+        virial_sample_.save(out);
+        msd_vs_time_sample_.save(out);
+    }
+
+    void ThermodynamicAnalyzer::restore(std::istream& in)
+    {
+        temperature_sample_.restore(in);
+        total_energy_sample_.restore(in);
+        virial_sample_.restore(in);
+        msd_vs_time_sample_.restore(in);
+    }
+
+    void BlockAveragingAnalyzer::collect(const ThermodynamicMeasurement& measurement)
+    {
+        double temperature_deviation =
+            measurement.result().temperature - system_parameters_.temperature;
+
+        temperature_sample_.push_back(
+            {temperature_deviation, temperature_deviation * temperature_deviation}
+        );
+
+        total_energy_sample_.push_back(measurement.result().total_energy);
+
+        // The instantaneous pressure, as in ThermodynamicAnalyzer, averages to the true pressure
+        pressure_sample_.push_back(
+            system_parameters_.density * (
+                measurement.result().temperature
+                + measurement.result().virial / (3.0 * system_parameters_.particle_count)
+            )
+        );
+    }
+
+    BlockAveragingAnalyzer::result_type BlockAveragingAnalyzer::result()
+    {
+        Eigen::Vector2d deviation_means = temperature_sample_.statistics().mean;
+
+        double temperature = system_parameters_.temperature + deviation_means(0);
+        double temperature_variance =
+            deviation_means(1) - deviation_means(0) * deviation_means(0);
+
+        /**
+         * The specific heat is C_V = (3/2) / (1 - (3/2) N r), where r = <(dT)^2> / <T>^2 is the
+         * relative temperature fluctuation (see ThermodynamicAnalyzer::result()).  To first
+         * order, an error in r propagates to the specific heat as
+         *
+         *      dC_V = N C_V^2 dr
+         *
+         * and r itself depends linearly on the means of dT and dT^2, with coefficients
+         *
+         *      dr/d<dT> = -2 <dT> / <T>^2 - 2 <(dT)^2> / <T>^3
+         *      dr/d<dT^2> = 1 / <T>^2
+         *
+         * so we ask the BlockAverage for the standard error of that linear combination.
+         */
+        double relative_temperature_fluctuation =
+            temperature_variance / (temperature * temperature);
+
+        double specific_heat = (3./2.) /
+            (1 - (3./2.) * system_parameters_.particle_count * relative_temperature_fluctuation);
+
+        Eigen::Vector2d fluctuation_coefficients{
+            -2.0 * deviation_means(0) / (temperature * temperature)
+                - 2.0 * temperature_variance / (temperature * temperature * temperature),
+            1.0 / (temperature * temperature)
+        };
+
+        double specific_heat_error = system_parameters_.particle_count
+            * specific_heat * specific_heat
+            * temperature_sample_.standard_error(fluctuation_coefficients);
+
+        return {
+            .temperature = temperature_sample_.standard_error({1.0, 0.0}),
+            .total_energy = total_energy_sample_.standard_error(),
+            .pressure = pressure_sample_.standard_error(),
+            .specific_heat = std::abs(specific_heat_error)
+        };
+    }
+
+    void BlockAveragingAnalyzer::save(std::ostream& out) const
+    {
+        temperature_sample_.save(out);
+        total_energy_sample_.save(out);
+        pressure_sample_.save(out);
+    }
+
+    void BlockAveragingAnalyzer::restore(std::istream& in)
+    {
+        temperature_sample_.restore(in);
+        total_energy_sample_.restore(in);
+        pressure_sample_.restore(in);
+    }
+
+    void EnergyHistogramAnalyzer::collect(const ThermodynamicMeasurement& measurement)
+    {
+        double potential_energy = measurement.result().potential_energy;
+        auto index = static_cast<long>(std::floor(potential_energy * inverse_bin_width_));
+
+        Bin& bin = bins_[index];
+        ++bin.count;
+        bin.potential_energy_sum += potential_energy;
+        bin.virial_sum += measurement.result().virial;
+
+        ++sample_count_;
+        temperature_sum_ += measurement.result().temperature;
+    }
+
+    EnergyHistogramAnalyzer::result_type EnergyHistogramAnalyzer::result()
+    {
+        EnergyHistogram histogram{
+            .temperature = (sample_count_ > 0)
+                ? temperature_sum_ / static_cast<double>(sample_count_)
+                : system_parameters_.temperature,
+            .density = system_parameters_.density,
+            .particle_count = system_parameters_.particle_count
+        };
+
+        // The map is ordered, so the bins come out in order of increasing energy
+        for (const auto& [index, bin] : bins_)
+        {
+            histogram.potential_energies.push_back(
+                bin.potential_energy_sum / static_cast<double>(bin.count)
+            );
+            histogram.virials.push_back(bin.virial_sum / static_cast<double>(bin.count));
+            histogram.counts.push_back(bin.count);
+        }
+
+        return histogram;
+    }
+
+    void EnergyHistogramAnalyzer::clear()
+    {
+        bins_.clear();
+        sample_count_ = 0;
+        temperature_sum_ = 0;
+    }
+
+    void EnergyHistogramAnalyzer::save(std::ostream& out) const
+    {
+        tools::write_binary(out, static_cast<std::uint64_t>(bins_.size()));
+
+        for (const auto& [index, bin] : bins_)
+        {
+            tools::write_binary(out, static_cast<std::int64_t>(index));
+            tools::write_binary(out, static_cast<std::int64_t>(bin.count));
+            tools::write_binary(out, bin.potential_energy_sum);
+            tools::write_binary(out, bin.virial_sum);
+        }
+
+        tools::write_binary(out, static_cast<std::int64_t>(sample_count_));
+        tools::write_binary(out, temperature_sum_);
+    }
+
+    void EnergyHistogramAnalyzer::restore(std::istream& in)
+    {
+        std::uint64_t bin_count{0};
+        tools::read_binary(in, bin_count);
+
+        bins_.clear();
+        for (std::uint64_t i = 0; i < bin_count && in; ++i)
+        {
+            std::int64_t index{0};
+            std::int64_t count{0};
+            Bin bin{};
+
+            tools::read_binary(in, index);
+            tools::read_binary(in, count);
+            tools::read_binary(in, bin.potential_energy_sum);
+            tools::read_binary(in, bin.virial_sum);
+
+            bin.count = static_cast<long>(count);
+            bins_.emplace(static_cast<long>(index), bin);
+        }
+
+        std::int64_t sample_count{0};
+        tools::read_binary(in, sample_count);
+        tools::read_binary(in, temperature_sum_);
+        sample_count_ = static_cast<long>(sample_count);
+    }
+} // namespace physics
@@ -23,12 +23,18 @@
 #ifndef LJ_ANALYZERS_HPP
 #define LJ_ANALYZERS_HPP
 
+#include <istream>
+#include <map>
+#include <ostream>
+
 #include <Eigen/Dense>
 
 #include <lennardjonesium/tools/system_parameters.hpp>
 #include <lennardjonesium/tools/moving_sample.hpp>
+#include <lennardjonesium/tools/block_average.hpp>
 #include <lennardjonesium/physics/measurements.hpp>
 #include <lennardjonesium/physics/observation.hpp>
+#include <lennardjonesium/physics/energy_histogram.hpp>
 
 namespace physics
 {
@@ -79,6 +85,10 @@ namespace physics
             
             virtual int sample_size() override {return sample_size_;}
 
+            // Save and restore the collected samples (for checkpoints)
+            void save(std::ostream& out) const {temperature_sample_.save(out);}
+            void restore(std::istream& in) {temperature_sample_.restore(in);}
+
             TemperatureAnalyzer
                 (tools::SystemParameters system_parameters, int sample_size)
                 : temperature_sample_{sample_size},
@@ -105,6 +115,14 @@ namespace physics
             virtual result_type result() override;
             virtual int sample_size() override {return sample_size_;}
 
+            // Save and restore the collected samples (for checkpoints)
+            void save(std::ostream& out) const;
+            void restore(std::istream& in);
+
+            // The mean square displacement only makes sense along a single trajectory, so its
+            // sample must be discarded when the state is replaced by a different one
+            void clear_mean_square_displacement() {msd_vs_time_sample_.clear();}
+
             ThermodynamicAnalyzer
                 (tools::SystemParameters system_parameters, int sample_size)
                 : temperature_sample_{sample_size},
@@ -123,6 +141,96 @@ namespace physics
             tools::SystemParameters system_parameters_;
             int sample_size_;
     };
+
+    struct StandardErrors
+    {
+        double temperature;
+        double total_energy;
+        double pressure;
+        double specific_heat;
+    };
+
+    class BlockAveragingAnalyzer : public Analyzer<StandardErrors>
+    {
+        /**
+         * BlockAveragingAnalyzer estimates the standard errors of the mean temperature, total
+         * energy, pressure, and specific heat, taking into account the time correlations between
+         * successive measurements.  Unlike the ThermodynamicAnalyzer, it does not keep a moving
+         * window; it accumulates every measurement it is given, using tools::BlockAverage, so
+         * its memory use grows only logarithmically with the number of measurements.
+         *
+         * The temperature is sampled as a pair (dT, dT^2) of deviations from the nominal
+         * temperature, so that the error in the temperature variance (and hence the specific
+         * heat) can be propagated with the covariance between the two.
+         */
+
+        public:
+            virtual void collect(const ThermodynamicMeasurement& measurement) override;
+            virtual result_type result() override;
+            virtual int sample_size() override {return total_energy_sample_.size();}
+
+            // Save and restore the accumulated blocks (for checkpoints)
+            void save(std::ostream& out) const;
+            void restore(std::istream& in);
+
+            BlockAveragingAnalyzer(tools::SystemParameters system_parameters)
+                : system_parameters_{system_parameters}
+            {}
+
+        private:
+            tools::BlockAverage<Eigen::Vector2d> temperature_sample_;
+            tools::BlockAverage<double> total_energy_sample_;
+            tools::BlockAverage<double> pressure_sample_;
+            tools::SystemParameters system_parameters_;
+    };
+
+    class EnergyHistogramAnalyzer : public Analyzer<EnergyHistogram>
+    {
+        /**
+         * EnergyHistogramAnalyzer accumulates the histogram of the potential energy (together
+         * with the mean virial in each bin) over every measurement it is given, so that the
+         * averages at this state point can later be reweighted to nearby temperatures.
+         * 
+         * The bin width is given per particle, so that the same width gives comparable
+         * resolution for any system size.  Bins are indexed by floor(U / (N * bin_width)), so
+         * histograms taken with the same width share the same bin edges.  Only the bins which
+         * have been visited are stored, so there is no need to know the range of energies in
+         * advance.
+         */
+
+        public:
+            virtual void collect(const ThermodynamicMeasurement& measurement) override;
+            virtual result_type result() override;
+            virtual int sample_size() override {return static_cast<int>(sample_count_);}
+
+            // Discard all samples
+            void clear();
+
+            // Save and restore the accumulated bins (for checkpoints)
+            void save(std::ostream& out) const;
+            void restore(std::istream& in);
+
+            EnergyHistogramAnalyzer(tools::SystemParameters system_parameters, double bin_width)
+                : system_parameters_{system_parameters},
+                  inverse_bin_width_{
+                      1.0 / (bin_width * static_cast<double>(system_parameters.particle_count))
+                  }
+            {}
+
+        private:
+            struct Bin
+            {
+                long count{0};
+                double potential_energy_sum{0};
+                double virial_sum{0};
+            };
+
+            tools::SystemParameters system_parameters_;
+            double inverse_bin_width_;
+            std::map<long, Bin> bins_;
+            long sample_count_{0};
+            double temperature_sum_{0};
+    };
 } // namespace physics
 
 #endif
@@ -0,0 +1,117 @@
+/**
+ * correlators.cpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include <lennardjonesium/tools/system_parameters.hpp>
+#include <lennardjonesium/tools/multiple_tau_correlator.hpp>
+#include <lennardjonesium/physics/system_state.hpp>
+#include <lennardjonesium/physics/correlators.hpp>
+
+namespace physics
+{
+    namespace
+    {
+        // Integrate a function sampled at increasing (not necessarily uniform) times
+        double trapezoid(const std::vector<double>& times, const std::vector<double>& values)
+        {
+            double integral = 0;
+
+            for (size_t k = 1; k < times.size(); ++k)
+            {
+                integral += 0.5 * (times[k] - times[k - 1]) * (values[k] + values[k - 1]);
+            }
+
+            return integral;
+        }
+    } // namespace
+
+    TransportCorrelator::TransportCorrelator(
+        tools::SystemParameters system_parameters, Parameters parameters
+    )
+        : velocity_correlator_{
+              [](const Eigen::Matrix4Xd& v0, const Eigen::Matrix4Xd& v1)
+                  {return v0.cwiseProduct(v1).sum() / static_cast<double>(v0.cols());},
+              parameters.block_length, parameters.averaging_length, parameters.level_count
+          },
+          stress_correlator_{
+              [](const Eigen::Vector3d& p0, const Eigen::Vector3d& p1)
+                  {return p0.dot(p1) / 3.0;},
+              parameters.block_length, parameters.averaging_length, parameters.level_count
+          },
+          system_parameters_{system_parameters}
+    {}
+
+    const SystemState& TransportCorrelator::operator() (const SystemState& state)
+    {
+        if (velocity_correlator_.size() == 0) {first_time_ = state.time;}
+        else if (velocity_correlator_.size() == 1) {sampling_interval_ = state.time - first_time_;}
+
+        velocity_correlator_.push_back(state.velocities);
+
+        // The off-diagonal components of the pressure tensor (times the volume)
+        auto kinetic_component = [&state](int a, int b)
+            {return state.velocities.row(a).dot(state.velocities.row(b));};
+
+        stress_correlator_.push_back({
+            kinetic_component(0, 1) + state.virial_tensor(0, 1),
+            kinetic_component(0, 2) + state.virial_tensor(0, 2),
+            kinetic_component(1, 2) + state.virial_tensor(1, 2)
+        });
+
+        return state;
+    }
+
+    TransportCorrelator::Result TransportCorrelator::result() const
+    {
+        assert(sample_size() > 1 && "Cannot compute correlations without at least 2 samples");
+
+        Result result;
+
+        auto velocity_correlation = velocity_correlator_.correlation();
+        auto stress_correlation = stress_correlator_.correlation();
+
+        for (long lag : velocity_correlation.lags)
+        {
+            result.times.push_back(static_cast<double>(lag) * sampling_interval_);
+        }
+
+        result.velocity_autocorrelation = std::move(velocity_correlation.values);
+        result.stress_autocorrelation = std::move(stress_correlation.values);
+
+        // Green-Kubo integrals
+        result.diffusion_coefficient =
+            trapezoid(result.times, result.velocity_autocorrelation) / 3.0;
+
+        double temperature = result.velocity_autocorrelation.front() / 3.0;
+        double volume = system_parameters_.particle_count / system_parameters_.density;
+
+        result.shear_viscosity =
+            trapezoid(result.times, result.stress_autocorrelation) / (volume * temperature);
+
+        return result;
+    }
+} // namespace physics
@@ -0,0 +1,114 @@
+/**
+ * correlators.hpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LJ_CORRELATORS_HPP
+#define LJ_CORRELATORS_HPP
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include <lennardjonesium/tools/system_parameters.hpp>
+#include <lennardjonesium/tools/multiple_tau_correlator.hpp>
+#include <lennardjonesium/physics/system_state.hpp>
+
+namespace physics
+{
+    class TransportCorrelator
+    {
+        /**
+         * TransportCorrelator is a Measurement which accumulates the time correlation functions
+         * needed for the Green-Kubo formulas for transport coefficients.  It must be given the
+         * SystemState at regular time intervals (typically every time step).  It measures:
+         * 
+         *  The velocity autocorrelation function (VACF)
+         * 
+         *      Z(t) = (1/N) sum_i <v_i(0) . v_i(t)>
+         * 
+         *  whose integral gives the diffusion coefficient D = (1/3) int_0^inf Z(t) dt.
+         * 
+         *  The stress autocorrelation function
+         * 
+         *      S(t) = <P_xy(0) P_xy(t)>,  P_xy = sum_i v_ix v_iy + W_xy
+         * 
+         *  (averaged over the three off-diagonal components xy, xz, yz), where W is the virial
+         *  tensor.  Its integral gives the shear viscosity eta = 1/(V T) int_0^inf S(t) dt.
+         * 
+         * The correlation functions are computed with tools::MultipleTauCorrelator, so the memory
+         * needed grows only logarithmically with the longest correlation time.  The integrals are
+         * truncated at the longest lag available, which should be chosen (via the parameters)
+         * to be well beyond the decay time of the correlations.
+         * 
+         * The temperature used in the viscosity is measured from the VACF itself, Z(0) = 3 T.
+         */
+
+        public:
+            struct Parameters
+            {
+                int block_length = 16;
+                int averaging_length = 2;
+                int level_count = 8;
+            };
+
+            struct Result
+            {
+                std::vector<double> times;
+                std::vector<double> velocity_autocorrelation;
+                std::vector<double> stress_autocorrelation;
+                double diffusion_coefficient{};
+                double shear_viscosity{};
+            };
+
+            // Collects the velocities and stresses from the state
+            const SystemState& operator() (const SystemState& state);
+
+            // Computes the correlation functions and transport coefficients
+            Result result() const;
+
+            // The number of states that have been collected
+            int sample_size() const {return velocity_correlator_.size();}
+
+            // Discard the collected states, e.g. when the trajectory has been interrupted
+            void clear()
+            {
+                velocity_correlator_.clear();
+                stress_correlator_.clear();
+            }
+
+            TransportCorrelator(tools::SystemParameters system_parameters, Parameters parameters);
+
+            explicit TransportCorrelator(tools::SystemParameters system_parameters)
+                : TransportCorrelator(system_parameters, Parameters{})
+            {}
+
+        private:
+            tools::MultipleTauCorrelator<Eigen::Matrix4Xd> velocity_correlator_;
+            tools::MultipleTauCorrelator<Eigen::Vector3d> stress_correlator_;
+            tools::SystemParameters system_parameters_;
+
+            // The sampling interval is inferred from the times of the first two states
+            double first_time_{};
+            double sampling_interval_{};
+    };
+} // namespace physics
+
+#endif
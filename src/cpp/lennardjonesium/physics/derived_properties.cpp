@@ -39,6 +39,35 @@ namespace physics
         return (1./2.) * state.velocities.colwise().squaredNorm().sum();
     }
 
+    Eigen::Matrix4d kinetic_tensor(const SystemState& state)
+    {
+        return state.velocities * state.velocities.transpose();
+    }
+
+    KineticMoments kinetic_moments(const SystemState& state)
+    {
+        assert(state.particle_count() > 0 && "Cannot compute kinetic moments of empty state.");
+
+        // Each particle's velocity and displacement is loaded once and used for every sum
+        KineticMoments moments;
+        double square_displacement{0};
+
+        for (int i : std::views::iota(0, state.particle_count()))
+        {
+            auto velocity = state.velocities.col(i);
+
+            moments.kinetic_tensor.noalias() += velocity * velocity.transpose();
+            moments.total_momentum += velocity;
+            square_displacement += state.displacements.col(i).squaredNorm();
+        }
+
+        moments.kinetic_energy = (1./2.) * moments.kinetic_tensor.trace();
+        moments.mean_square_displacement =
+            square_displacement / static_cast<double>(state.particle_count());
+
+        return moments;
+    }
+
     double mean_square_displacement(const SystemState& state)
     {
         assert(state.particle_count() > 0
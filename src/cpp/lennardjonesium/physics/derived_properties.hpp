@@ -40,6 +40,28 @@ namespace physics
 
     double mean_square_displacement(const SystemState&);
 
+    /**
+     * The kinetic tensor K_{ij} = sum_n v^n_i v^n_j (for unit masses) is the kinetic part of the
+     * pressure tensor, P_{ij} = (K_{ij} + W_{ij}) / V, where W is the virial tensor.  Its trace is
+     * twice the kinetic energy.  As with the inertia tensor below, it is given as a 4x4 matrix.
+     */
+    Eigen::Matrix4d kinetic_tensor(const SystemState&);
+
+    /**
+     * KineticMoments gathers the quantities which are sums over the velocities and displacements
+     * of the particles, so that they can be computed in a single sweep over the state rather than
+     * one pass per quantity.  This is what ThermodynamicMeasurement uses at every time step.
+     */
+    struct KineticMoments
+    {
+        Eigen::Matrix4d kinetic_tensor{Eigen::Matrix4d::Zero()};
+        Eigen::Vector4d total_momentum{Eigen::Vector4d::Zero()};
+        double kinetic_energy{};
+        double mean_square_displacement{};
+    };
+
+    KineticMoments kinetic_moments(const SystemState&);
+
     Eigen::Vector4d total_momentum(const SystemState&);
 
     Eigen::Vector4d total_force(const SystemState&);
@@ -0,0 +1,59 @@
+/**
+ * energy_histogram.hpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LJ_ENERGY_HISTOGRAM_HPP
+#define LJ_ENERGY_HISTOGRAM_HPP
+
+#include <numeric>
+#include <vector>
+
+namespace physics
+{
+    struct EnergyHistogram
+    {
+        /**
+         * An EnergyHistogram is the distribution of the potential energy sampled at one state
+         * point, which is all that is needed to reweight configurational averages to a nearby
+         * temperature (see histogram_reweighting.hpp).  Besides the number of samples in each
+         * bin, it keeps the mean potential energy and the mean virial of the samples in the bin.
+         * That is, the joint histogram of potential energy and virial is reduced to the
+         * conditional mean of the virial at each energy, which is exactly what is needed to
+         * reweight the pressure.
+         * 
+         * The energies and virials are totals over all particles (not per particle).  The
+         * temperature is the mean measured temperature of the samples, which may differ slightly
+         * from the nominal one since the ObservationPhase does not adjust it.
+         */
+
+        double temperature{};
+        double density{};
+        int particle_count{};
+        std::vector<double> potential_energies{};
+        std::vector<double> virials{};
+        std::vector<long> counts{};
+
+        long sample_count() const {return std::accumulate(counts.begin(), counts.end(), 0L);}
+    };
+} // namespace physics
+
+
+#endif
@@ -32,8 +32,12 @@ namespace physics
         /**
          * ForceContribution packages together the data that are needed to update the SystemState
          * when the force on a particle is calculated.  This includes not just the force value
-         * itself, but also contributions to the potential energy and virial (and their tensors,
-         * if those are later added).
+         * itself, but also contributions to the potential energy and the virial.
+         * 
+         * The contribution to the virial tensor is r F^T, where r is the separation vector (or
+         * the position, for a BackgroundForce).  The ForceCalculation computes it from the force
+         * when it has been asked to, so that the force itself does not have to build a 4x4
+         * matrix for every pair.
          * 
          * This is more convenient than using a std::tuple of these quantities, because using a
          * struct allows us to name the fields.
@@ -0,0 +1,261 @@
+/**
+ * histogram_reweighting.cpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include <lennardjonesium/physics/energy_histogram.hpp>
+#include <lennardjonesium/physics/histogram_reweighting.hpp>
+
+namespace
+{
+    // ln sum_i exp(x_i), without overflow
+    double log_sum_exp(const std::vector<double>& values)
+    {
+        double maximum = -std::numeric_limits<double>::infinity();
+        for (double value : values) {maximum = std::max(maximum, value);}
+
+        if (!std::isfinite(maximum)) {return maximum;}
+
+        double sum = 0;
+        for (double value : values) {sum += std::exp(value - maximum);}
+
+        return maximum + std::log(sum);
+    }
+} // namespace
+
+
+namespace physics
+{
+    HistogramReweighting::HistogramReweighting(
+        std::vector<EnergyHistogram> histograms, HistogramReweighting::Parameters parameters
+    )
+    {
+        assert(!histograms.empty() && "Cannot reweight without histograms");
+
+        density_ = histograms.front().density;
+        particle_count_ = histograms.front().particle_count;
+        kinetic_exponent_ = 1.5 * static_cast<double>(particle_count_) - 1.0;
+
+        // Estimates of the mean potential energy, to start the free energies
+        std::vector<double> mean_potential_energies;
+
+        for (const auto& histogram : histograms)
+        {
+            assert(histogram.density == density_ && histogram.particle_count == particle_count_
+                && "Reweighted histograms must share the density and particle count");
+            assert(histogram.sample_count() > 0 && "Cannot reweight an empty histogram");
+
+            inverse_temperatures_.push_back(1.0 / histogram.temperature);
+            log_sample_counts_.push_back(std::log(static_cast<double>(histogram.sample_count())));
+
+            double potential_energy_sum = 0;
+
+            for (size_t bin = 0; bin < histogram.counts.size(); ++bin)
+            {
+                if (histogram.counts[bin] <= 0) {continue;}
+
+                potential_energies_.push_back(histogram.potential_energies[bin]);
+                virials_.push_back(histogram.virials[bin]);
+                log_counts_.push_back(std::log(static_cast<double>(histogram.counts[bin])));
+
+                potential_energy_sum += histogram.counts[bin] * histogram.potential_energies[bin];
+            }
+
+            mean_potential_energies.push_back(
+                potential_energy_sum / static_cast<double>(histogram.sample_count())
+            );
+
+            total_energies_.push_back(
+                1.5 * static_cast<double>(particle_count_) * histogram.temperature
+                    + mean_potential_energies.back()
+            );
+        }
+
+        /**
+         * For canonical weights, df/db = <U>, so we start from the trapezoid rule for the
+         * integral of <U> over b, taking the runs in order of b.  Near the mean kinetic energy
+         * K_k = E_k - <U>_k, the kinetic weight is c_k(U) ~ K_k^(3N/2 - 1) exp(b_k (<U>_k - U)),
+         * which shifts each f_k by -(3N/2 - 1) ln K_k - b_k <U>_k.  This is usually close enough
+         * that the iteration converges quickly, even though the differences between the f_k are
+         * large.
+         */
+        size_t run_count = histograms.size();
+        std::vector<size_t> order(run_count);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(
+            order.begin(), order.end(),
+            [this](size_t j, size_t k) {return inverse_temperatures_[j] < inverse_temperatures_[k];}
+        );
+
+        free_energies_.assign(run_count, 0.0);
+        for (size_t n = 1; n < run_count; ++n)
+        {
+            size_t j = order[n - 1];
+            size_t k = order[n];
+
+            free_energies_[k] = free_energies_[j]
+                + 0.5 * (mean_potential_energies[j] + mean_potential_energies[k])
+                    * (inverse_temperatures_[k] - inverse_temperatures_[j]);
+        }
+
+        for (size_t k = 0; k < run_count; ++k)
+        {
+            free_energies_[k] -=
+                kinetic_exponent_ * std::log(total_energies_[k] - mean_potential_energies[k])
+                + inverse_temperatures_[k] * mean_potential_energies[k];
+        }
+
+        // Iterate the self-consistent equations, keeping f_0 = 0
+        std::vector<double> log_terms(potential_energies_.size());
+
+        for (int iteration = 0; iteration < parameters.maximum_iterations; ++iteration)
+        {
+            update_log_densities_();
+
+            std::vector<double> free_energies(run_count);
+            for (size_t k = 0; k < run_count; ++k)
+            {
+                for (size_t i = 0; i < potential_energies_.size(); ++i)
+                {
+                    log_terms[i] = log_densities_[i]
+                        + log_kinetic_weight_(k, potential_energies_[i]);
+                }
+
+                free_energies[k] = -log_sum_exp(log_terms);
+            }
+
+            double change = 0;
+            for (size_t k = 0; k < run_count; ++k)
+            {
+                free_energies[k] -= free_energies.front();
+                change = std::max(change, std::abs(free_energies[k] - free_energies_[k]));
+            }
+
+            free_energies_ = std::move(free_energies);
+
+            if (change < parameters.tolerance)
+            {
+                converged_ = true;
+                break;
+            }
+        }
+
+        update_log_densities_();
+    }
+
+    void HistogramReweighting::update_log_densities_()
+    {
+        log_densities_.resize(potential_energies_.size());
+        std::vector<double> terms(inverse_temperatures_.size());
+
+        for (size_t i = 0; i < potential_energies_.size(); ++i)
+        {
+            for (size_t k = 0; k < inverse_temperatures_.size(); ++k)
+            {
+                terms[k] = log_sample_counts_[k] + free_energies_[k]
+                    + log_kinetic_weight_(k, potential_energies_[i]);
+            }
+
+            log_densities_[i] = log_counts_[i] - log_sum_exp(terms);
+        }
+    }
+
+    double HistogramReweighting::log_kinetic_weight_(size_t run, double potential_energy) const
+    {
+        double kinetic_energy = total_energies_[run] - potential_energy;
+
+        if (kinetic_energy <= 0) {return -std::numeric_limits<double>::infinity();}
+
+        return kinetic_exponent_ * std::log(kinetic_energy);
+    }
+
+    std::vector<double> HistogramReweighting::log_weights_(double inverse_temperature) const
+    {
+        std::vector<double> log_weights(potential_energies_.size());
+
+        for (size_t i = 0; i < potential_energies_.size(); ++i)
+        {
+            log_weights[i] = log_densities_[i] - inverse_temperature * potential_energies_[i];
+        }
+
+        return log_weights;
+    }
+
+    ReweightedObservation HistogramReweighting::reweight(double temperature) const
+    {
+        assert(temperature > 0 && "Cannot reweight to a nonpositive temperature");
+
+        auto log_weights = log_weights_(1.0 / temperature);
+
+        // Normalize the weights relative to the largest, which is then 1
+        auto largest = std::max_element(log_weights.begin(), log_weights.end());
+        double maximum = *largest;
+
+        // Accumulate energies relative to the most probable one, to avoid cancellation
+        double reference = potential_energies_[largest - log_weights.begin()];
+
+        double weight_sum = 0;
+        double square_weight_sum = 0;
+        double potential_energy = 0;
+        double square_potential_energy = 0;
+        double virial = 0;
+
+        for (size_t i = 0; i < log_weights.size(); ++i)
+        {
+            double weight = std::exp(log_weights[i] - maximum);
+
+            weight_sum += weight;
+            square_weight_sum += weight * weight / std::exp(log_counts_[i]);
+            double relative_potential_energy = potential_energies_[i] - reference;
+
+            potential_energy += weight * relative_potential_energy;
+            square_potential_energy += weight * relative_potential_energy
+                * relative_potential_energy;
+            virial += weight * virials_[i];
+        }
+
+        potential_energy /= weight_sum;
+        square_potential_energy /= weight_sum;
+        virial /= weight_sum;
+
+        auto particle_count = static_cast<double>(particle_count_);
+        double potential_energy_variance = std::max(
+            0.0, square_potential_energy - potential_energy * potential_energy
+        );
+
+        return ReweightedObservation{
+            .temperature = temperature,
+            .density = density_,
+            .total_energy = 1.5 * particle_count * temperature + reference + potential_energy,
+            .pressure = density_ * (temperature + virial / (3.0 * particle_count)),
+            .specific_heat = 1.5
+                + potential_energy_variance / (particle_count * temperature * temperature),
+            .effective_sample_size = weight_sum * weight_sum / square_weight_sum
+        };
+    }
+} // namespace physics
@@ -0,0 +1,158 @@
+/**
+ * histogram_reweighting.hpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LJ_HISTOGRAM_REWEIGHTING_HPP
+#define LJ_HISTOGRAM_REWEIGHTING_HPP
+
+#include <utility>
+#include <vector>
+
+#include <lennardjonesium/physics/energy_histogram.hpp>
+
+namespace physics
+{
+    struct ReweightedObservation
+    {
+        /**
+         * The thermodynamic quantities predicted at a temperature which was not simulated.  They
+         * are defined as in the Observation, so that they can be compared directly.  The
+         * effective sample size measures how many of the samples actually contribute at this
+         * temperature; when it becomes small, the prediction is an extrapolation and cannot be
+         * trusted.
+         */
+
+        double temperature;
+        double density;
+        double total_energy;
+        double pressure;
+        double specific_heat;
+        double effective_sample_size;
+    };
+
+    class HistogramReweighting
+    {
+        /**
+         * HistogramReweighting combines the EnergyHistograms of one or more runs at the same
+         * density and particle count, and predicts the thermodynamic quantities at any nearby
+         * temperature.  This is the multiple-histogram method of Ferrenberg and Swendsen,
+         * 
+         *  A. M. Ferrenberg and R. H. Swendsen, "Optimized Monte Carlo data analysis",
+         *  Phys. Rev. Lett. 63, 1195 (1989), https://doi.org/10.1103/PhysRevLett.63.1195
+         * 
+         * (also known as WHAM), which with a single histogram reduces to ordinary single-
+         * histogram reweighting.
+         * 
+         * The histograms come from molecular dynamics, which samples the microcanonical ensemble
+         * rather than the canonical one.  At total energy E_k, a configuration with potential
+         * energy U leaves kinetic energy E_k - U to the 3N momenta, so run k samples U with the
+         * weight
+         * 
+         *      c_k(U) = (E_k - U)^(3N/2 - 1)
+         * 
+         * (the volume of the momentum shell) instead of exp(-b_k U).  The microcanonical
+         * distribution of U is noticeably narrower than the canonical one: its variance is
+         * (3/2) N T^2 (1 - 3/(2 C_V)) rather than N T^2 (C_V - 3/2), which is an O(1) difference.
+         * So we divide this weight out, and estimate the configurational density of states at the
+         * energy U_i of every bin i of every run (treated as n_i samples) by
+         * 
+         *      g_i = n_i / sum_k N_k exp(f_k) c_k(U_i)
+         * 
+         * where N_k is the number of samples of run k, E_k = (3/2) N T_k + <U>_k is its total
+         * energy, and the dimensionless free energies f_k solve the self-consistent equations
+         * 
+         *      f_k = -ln sum_i g_i c_k(U_i)
+         * 
+         * which are iterated (from an estimate obtained by integrating <U> over b) until they
+         * change by less than the tolerance.  The canonical weight of bin i at inverse
+         * temperature b is then w_i(b) = g_i exp(-b U_i).  All sums are done in the log domain,
+         * since the exponents are extensive and easily reach several thousand.
+         * 
+         * Only the configurational part of each quantity is reweighted; the kinetic part is known
+         * exactly at any temperature.  So the total energy is (3/2) N T + <U>, the pressure is
+         * density * (T + <W> / (3 N)), and the specific heat per particle is the canonical
+         * 
+         *      C_V = 3/2 + (<U^2> - <U>^2) / (N T^2)
+         * 
+         * of the reweighted distribution.  At the temperature of a run, this agrees with the
+         * microcanonical (Lebowitz) specific heat of its Observation, up to corrections of order
+         * 1/N and the statistical error.
+         */
+
+        public:
+            struct Parameters
+            {
+                double tolerance = 1.0e-10;
+                int maximum_iterations = 10000;
+            };
+
+            HistogramReweighting(std::vector<EnergyHistogram> histograms, Parameters parameters);
+
+            explicit HistogramReweighting(std::vector<EnergyHistogram> histograms)
+                : HistogramReweighting(std::move(histograms), Parameters{})
+            {}
+
+            // Whether the free energies reached the tolerance within the maximum iterations
+            bool converged() const {return converged_;}
+
+            // The dimensionless free energy f_k of each run, relative to the first one (these
+            // normalize the microcanonical weights c_k, so they are not the canonical f(b_k))
+            const std::vector<double>& free_energies() const {return free_energies_;}
+
+            // Predict the thermodynamic quantities at the given temperature
+            ReweightedObservation reweight(double temperature) const;
+
+        private:
+            // The bins of every run, pooled together
+            std::vector<double> potential_energies_;
+            std::vector<double> virials_;
+            std::vector<double> log_counts_;
+
+            // The inverse temperature, total energy, and log of the sample count of each run
+            std::vector<double> inverse_temperatures_;
+            std::vector<double> total_energies_;
+            std::vector<double> log_sample_counts_;
+
+            std::vector<double> free_energies_;
+
+            // The log of the density of states g_i, which depends only on the free energies
+            std::vector<double> log_densities_;
+
+            double density_;
+            int particle_count_;
+
+            // The exponent 3N/2 - 1 of the kinetic weight c_k
+            double kinetic_exponent_;
+
+            bool converged_{false};
+
+            void update_log_densities_();
+
+            // ln c_k(U), which is -infinity if U exceeds the total energy of run k
+            double log_kinetic_weight_(size_t run, double potential_energy) const;
+
+            // The log of each canonical weight w_i(b)
+            std::vector<double> log_weights_(double inverse_temperature) const;
+    };
+} // namespace physics
+
+
+#endif
@@ -23,6 +23,8 @@
 #ifndef LJ_MEASUREMENTS_HPP
 #define LJ_MEASUREMENTS_HPP
 
+#include <Eigen/Dense>
+
 #include <lennardjonesium/physics/system_state.hpp>
 #include <lennardjonesium/physics/derived_properties.hpp>
 
@@ -44,6 +46,10 @@ namespace physics
                 /**
                  * It is useful to package the result of the measurement into a struct, so that
                  * it can be passed between functions as a single piece of data.
+                 * 
+                 * The virial and kinetic tensors are the 3x3 blocks of the corresponding 4x4
+                 * tensors; together they give the pressure tensor P = (K + W) / V, whose
+                 * off-diagonal components are the shear stresses.
                  */
 
                 double time{};
@@ -53,18 +59,27 @@ namespace physics
                 double virial{};
                 double temperature{};
                 double mean_square_displacement{};
+                Eigen::Matrix3d virial_tensor{Eigen::Matrix3d::Zero()};
+                Eigen::Matrix3d kinetic_tensor{Eigen::Matrix3d::Zero()};
+                Eigen::Vector3d total_momentum{Eigen::Vector3d::Zero()};
             };
 
             // Takes the measurements and populates the internal fields
             const SystemState& operator() (const SystemState& state)
             {
+                // All of the sums over particles are done in one pass
+                auto moments = state | physics::kinetic_moments;
+
                 result_.time = state | physics::time;
-                result_.kinetic_energy = state | physics::kinetic_energy;
+                result_.kinetic_energy = moments.kinetic_energy;
                 result_.potential_energy = state | physics::potential_energy;
                 result_.total_energy = state | physics::total_energy(result_.kinetic_energy);
                 result_.virial = state | physics::virial;
                 result_.temperature = state | physics::temperature(result_.kinetic_energy);
-                result_.mean_square_displacement = state | physics::mean_square_displacement;
+                result_.mean_square_displacement = moments.mean_square_displacement;
+                result_.virial_tensor = state.virial_tensor.topLeftCorner<3, 3>();
+                result_.kinetic_tensor = moments.kinetic_tensor.topLeftCorner<3, 3>();
+                result_.total_momentum = moments.total_momentum.head<3>();
 
                 return state;
             }
@@ -34,6 +34,17 @@ namespace physics
         /**
          * An Observation collects together the main physical quantities that constitute the
          * "result" of the experiment.
+         *
+         * The *_error fields hold the standard errors of the mean of the corresponding
+         * quantities, estimated by block averaging (see BlockAveragingAnalyzer).
+         * 
+         * The Green-Kubo diffusion coefficient and the shear viscosity are obtained by
+         * integrating time correlation functions (see TransportCorrelator).  They provide an
+         * independent check on the diffusion coefficient obtained from the mean square
+         * displacement.
+         * 
+         * The order parameter is S(k) / N averaged over the first Bragg peak of the initial
+         * lattice (see StructureFactorMeasurement).  It is near 1 in a solid and near 0 in a fluid.
          */
 
         double temperature;
@@ -42,6 +53,13 @@ namespace physics
         double pressure;
         double specific_heat;
         double diffusion_coefficient;
+        double temperature_error{};
+        double total_energy_error{};
+        double pressure_error{};
+        double specific_heat_error{};
+        double green_kubo_diffusion_coefficient{};
+        double shear_viscosity{};
+        double order_parameter{};
     };
 } // namespace physics
 
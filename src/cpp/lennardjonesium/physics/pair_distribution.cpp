@@ -0,0 +1,104 @@
+/**
+ * pair_distribution.cpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include <algorithm>
+#include <istream>
+#include <numbers>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include <lennardjonesium/tools/binary_stream.hpp>
+#include <lennardjonesium/tools/system_parameters.hpp>
+#include <lennardjonesium/physics/pair_distribution.hpp>
+
+namespace physics
+{
+    PairDistributionHistogram::PairDistributionHistogram(
+        tools::SystemParameters system_parameters,
+        double maximum_distance,
+        int bin_count
+    )
+        : system_parameters_{system_parameters},
+          bin_width_{maximum_distance / bin_count},
+          inverse_bin_width_{bin_count / maximum_distance},
+          counts_(bin_count, 0)
+    {
+        assert(maximum_distance > 0 && bin_count > 0 && "Invalid histogram parameters");
+    }
+
+    PairDistributionHistogram::Result PairDistributionHistogram::result() const
+    {
+        assert(sample_count_ > 0 && "Cannot compute g(r) without any samples");
+
+        Result result{.sample_count = sample_count_};
+
+        // The number of pairs expected in a shell of unit volume, for an ideal gas
+        double ideal_pair_density = 0.5 * sample_count_ * system_parameters_.particle_count
+            * system_parameters_.density;
+
+        for (size_t bin = 0; bin < counts_.size(); ++bin)
+        {
+            double inner_radius = bin * bin_width_;
+            double outer_radius = inner_radius + bin_width_;
+
+            double shell_volume = (4./3.) * std::numbers::pi * (
+                outer_radius * outer_radius * outer_radius
+                - inner_radius * inner_radius * inner_radius
+            );
+
+            result.radii.push_back(inner_radius + 0.5 * bin_width_);
+            result.pair_distribution.push_back(counts_[bin] / (ideal_pair_density * shell_volume));
+        }
+
+        return result;
+    }
+
+    void PairDistributionHistogram::clear()
+    {
+        std::fill(counts_.begin(), counts_.end(), 0);
+        sample_count_ = 0;
+        sample_requested_ = false;
+    }
+
+    void PairDistributionHistogram::save(std::ostream& out) const
+    {
+        tools::write_binary(out, counts_);
+        tools::write_binary(out, sample_count_);
+        tools::write_binary(out, sample_requested_);
+    }
+
+    void PairDistributionHistogram::restore(std::istream& in)
+    {
+        std::vector<long> counts;
+        tools::read_binary(in, counts);
+
+        // The histogram must have been saved with the same binning
+        if (counts.size() != counts_.size()) {in.setstate(std::ios::failbit);}
+        if (!in) {return;}
+
+        counts_ = std::move(counts);
+        tools::read_binary(in, sample_count_);
+        tools::read_binary(in, sample_requested_);
+    }
+} // namespace physics
@@ -0,0 +1,113 @@
+/**
+ * pair_distribution.hpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LJ_PAIR_DISTRIBUTION_HPP
+#define LJ_PAIR_DISTRIBUTION_HPP
+
+#include <cmath>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include <lennardjonesium/tools/system_parameters.hpp>
+
+namespace physics
+{
+    class PairDistributionHistogram
+    {
+        /**
+         * PairDistributionHistogram accumulates a histogram of the distances between pairs of
+         * particles, from which we obtain the radial distribution function g(r).  Computing g(r)
+         * requires visiting every pair of particles, which is exactly what the short-range force
+         * calculation already does.  So rather than making a second pass over the pairs, the
+         * ShortRangeForceCalculation feeds the histogram directly from its pair loop, reusing the
+         * square distance which the ParticlePairFilter had to compute anyway.
+         * 
+         * Sampling is done on request: whoever wants a sample (e.g. the ObservationPhase) calls
+         * request_sample(), and the next force calculation fills the histogram and marks the
+         * sample complete.  The distances covered are those up to maximum_distance, which should
+         * not exceed the cutoff distance of the force (since other pairs are never visited).
+         * 
+         * The radial distribution function is normalized so that g(r) -> 1 for an ideal gas:
+         * 
+         *      g(r) = 2 n(r) / (M N density 4 pi r^2 dr)
+         * 
+         * where n(r) is the number of pairs counted in the bin at r (each pair counted once), M
+         * is the number of samples, and N is the particle count.
+         */
+
+        public:
+            struct Result
+            {
+                std::vector<double> radii{};                // Centers of the bins
+                std::vector<double> pair_distribution{};    // g(r) at each bin center
+                int sample_count{};
+            };
+
+            PairDistributionHistogram(
+                tools::SystemParameters system_parameters,
+                double maximum_distance,
+                int bin_count = 100
+            );
+
+            // Ask for the next force calculation to collect a sample
+            void request_sample() {sample_requested_ = true;}
+
+            bool sample_requested() const {return sample_requested_;}
+
+            // Add a single pair to the histogram (called from the pair loop)
+            void add(double square_distance)
+            {
+                auto bin = static_cast<size_t>(std::sqrt(square_distance) * inverse_bin_width_);
+                if (bin < counts_.size()) {++counts_[bin];}
+            }
+
+            // Mark the end of the pair loop for the requested sample
+            void complete_sample()
+            {
+                ++sample_count_;
+                sample_requested_ = false;
+            }
+
+            int sample_count() const {return sample_count_;}
+
+            // Normalize the histogram to obtain g(r)
+            Result result() const;
+
+            // Discard all samples
+            void clear();
+
+            // Save and restore the accumulated counts (for checkpoints)
+            void save(std::ostream& out) const;
+            void restore(std::istream& in);
+
+        private:
+            tools::SystemParameters system_parameters_;
+            double bin_width_;
+            double inverse_bin_width_;
+            std::vector<long> counts_;
+            int sample_count_{0};
+            bool sample_requested_{false};
+    };
+} // namespace physics
+
+#endif
@@ -0,0 +1,131 @@
+/**
+ * structure_factor.cpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include <algorithm>
+#include <complex>
+#include <numbers>
+#include <ranges>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include <lennardjonesium/tools/bounding_box.hpp>
+#include <lennardjonesium/physics/system_state.hpp>
+#include <lennardjonesium/physics/structure_factor.hpp>
+
+namespace physics
+{
+    StructureFactorMeasurement::StructureFactorMeasurement(
+        tools::BoundingBox bounding_box, Parameters parameters
+    )
+        : bounding_box_{bounding_box.array()},
+          parameters_{parameters},
+          maximum_wavenumber_{Eigen::Array4i::Zero()},
+          harmonics_(3),
+          structure_factor_sums_(parameters.wavenumbers.size(), 0.0)
+    {
+        assert(!parameters_.wavenumbers.empty() && "No wavenumbers given");
+        assert(parameters_.stride > 0 && "Stride must be positive");
+
+        for (const auto& n : parameters_.wavenumbers)
+        {
+            maximum_wavenumber_ = maximum_wavenumber_.max(n.array().abs());
+        }
+    }
+
+    const SystemState& StructureFactorMeasurement::operator() (const SystemState& state)
+    {
+        if (call_count_++ % parameters_.stride != 0) {return state;}
+
+        particle_count_ = state.particle_count();
+
+        // Compute the harmonics along each axis by recurrence
+        for (int axis : std::views::iota(0, 3))
+        {
+            int maximum = maximum_wavenumber_[axis];
+            auto& harmonics = harmonics_[axis];
+            harmonics.resize(2 * maximum + 1);
+
+            harmonics[maximum] = Eigen::ArrayXcd::Ones(particle_count_);
+
+            if (maximum == 0) {continue;}
+
+            Eigen::ArrayXd phase = (2 * std::numbers::pi / bounding_box_[axis])
+                * state.positions.row(axis).transpose().array();
+
+            harmonics[maximum + 1] = phase.cos().cast<std::complex<double>>()
+                + std::complex<double>{0, 1} * phase.sin().cast<std::complex<double>>();
+
+            for (int m = 2; m <= maximum; ++m)
+            {
+                harmonics[maximum + m] = harmonics[maximum + m - 1] * harmonics[maximum + 1];
+            }
+
+            // Negative wavenumbers are obtained by complex conjugation
+            for (int m = 1; m <= maximum; ++m)
+            {
+                harmonics[maximum - m] = harmonics[maximum + m].conjugate();
+            }
+        }
+
+        for (size_t k = 0; k < parameters_.wavenumbers.size(); ++k)
+        {
+            Eigen::Array4i index = parameters_.wavenumbers[k].array() + maximum_wavenumber_;
+
+            std::complex<double> density_mode = (
+                harmonics_[0][index[0]] * harmonics_[1][index[1]] * harmonics_[2][index[2]]
+            ).sum();
+
+            structure_factor_sums_[k] += std::norm(density_mode) / particle_count_;
+        }
+
+        ++sample_count_;
+
+        return state;
+    }
+
+    StructureFactorMeasurement::Result StructureFactorMeasurement::result() const
+    {
+        assert(sample_count_ > 0 && "Cannot compute S(k) without any samples");
+
+        Result result{.sample_count = sample_count_};
+
+        for (double sum : structure_factor_sums_)
+        {
+            double structure_factor = sum / sample_count_;
+
+            result.structure_factor.push_back(structure_factor);
+            result.order_parameter += structure_factor / particle_count_;
+        }
+
+        result.order_parameter /= static_cast<double>(structure_factor_sums_.size());
+
+        return result;
+    }
+
+    void StructureFactorMeasurement::clear()
+    {
+        std::fill(structure_factor_sums_.begin(), structure_factor_sums_.end(), 0.0);
+        sample_count_ = 0;
+    }
+} // namespace physics
@@ -0,0 +1,104 @@
+/**
+ * structure_factor.hpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LJ_STRUCTURE_FACTOR_HPP
+#define LJ_STRUCTURE_FACTOR_HPP
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include <lennardjonesium/tools/bounding_box.hpp>
+#include <lennardjonesium/physics/system_state.hpp>
+
+namespace physics
+{
+    class StructureFactorMeasurement
+    {
+        /**
+         * StructureFactorMeasurement is a Measurement of the static structure factor
+         * 
+         *      S(k) = (1/N) |sum_j exp(i k . r_j)|^2
+         * 
+         * at a fixed set of wavevectors k.  The wavevectors must be compatible with the periodic
+         * boundary conditions, so they are given as integer wavenumbers n relative to the
+         * BoundingBox, with k = 2 pi n / L componentwise.
+         * 
+         * At the Bragg peaks of a crystal, S(k) is of order N, whereas in a fluid it is of order
+         * 1.  So S(k) / N, averaged over the wavevectors of the first Bragg peak of the initial
+         * lattice (see tools::CubicLattice::bragg_wavenumbers()), is a convenient order parameter:
+         * it is 1 for the perfect initial lattice, and nearly 0 once the lattice has melted.
+         * 
+         * To avoid evaluating sin and cos for every particle and every wavevector, we compute
+         * exp(2 pi i x_j / L) once per particle and axis, and obtain the higher harmonics by
+         * repeated multiplication (a trigonometric recurrence).  Each S(k) is then a product of
+         * three harmonics summed over the particles, which Eigen vectorizes.
+         * 
+         * Since S(k) changes slowly, it only needs to be computed every few time steps: the
+         * measurement is taken on every stride-th call, and the other calls do nothing.  The
+         * result is averaged over all the measurements taken since the last clear().
+         */
+
+        public:
+            struct Parameters
+            {
+                std::vector<Eigen::Vector4i> wavenumbers{};
+                int stride = 1;
+            };
+
+            struct Result
+            {
+                std::vector<double> structure_factor{};     // Mean S(k) for each wavevector
+                double order_parameter{};                   // Mean S(k) / N over the wavevectors
+                int sample_count{};
+            };
+
+            // Measures S(k) on every stride-th state given
+            const SystemState& operator() (const SystemState& state);
+
+            // The averages over the samples taken since the last clear()
+            Result result() const;
+
+            int sample_count() const {return sample_count_;}
+
+            void clear();
+
+            StructureFactorMeasurement(tools::BoundingBox bounding_box, Parameters parameters);
+
+        private:
+            Eigen::Array4d bounding_box_;
+            Parameters parameters_;
+
+            // Highest harmonic needed along each axis
+            Eigen::Array4i maximum_wavenumber_;
+
+            // harmonics_[axis][m + maximum] holds exp(2 pi i m x_j / L) for each particle j
+            std::vector<std::vector<Eigen::ArrayXcd>> harmonics_;
+
+            std::vector<double> structure_factor_sums_;
+            int particle_count_{0};
+            int sample_count_{0};
+            int call_count_{0};
+    };
+} // namespace physics
+
+#endif
@@ -36,12 +36,13 @@ namespace physics
         forces.setZero(4, particle_count);
     }
 
-    // Clears the force, potential energy, and virial, so that they can be recomputed
+    // Clears the force, potential energy, and virial (and its tensor), so they can be recomputed
     SystemState& clear_dynamics(SystemState& state)
     {
         state.forces.setZero(4, state.particle_count());
         state.potential_energy = 0;
         state.virial = 0;
+        state.virial_tensor.setZero();
 
         return state;
     }
@@ -46,10 +46,10 @@ namespace physics
          *  potential energy
          *  virial
          *  (*kinetic energy tensor)
-         *  (virial tensor)
+         *  virial tensor
          * 
-         * The last two are not necessary for the most basic simulator, but may be interesting in
-         * the future for measuring things like shear stress and pressure.
+         * The last two are not necessary for the most basic simulator, but are needed for
+         * measuring things like shear stress (and hence the shear viscosity).
          * 
          * Note also that kinetic energy and mean square displacement are derived quantities, and
          * will be considered measurements rather than state variables (especially considering we
@@ -91,6 +91,9 @@ namespace physics
         double potential_energy{0.0};      // Potential energy from particle interactions
         double virial{0.0};                // Virial from pairwise forces
 
+        // Virial tensor sum(r_ij F_ij^T), as a 4x4 matrix for alignment (its trace is the virial)
+        Eigen::Matrix4d virial_tensor{Eigen::Matrix4d::Zero()};
+
         // It is also useful to keep track of the total time elapsed from the beginning
         double time{0.0};
 
@@ -110,7 +113,7 @@ namespace physics
      * Some additional useful Operators which modify the SystemState.
      */
 
-    // Clears the force, potential energy, and virial, so that they can be recomputed
+    // Clears the force, potential energy, and virial (and its tensor), so they can be recomputed
     SystemState& clear_dynamics(SystemState&);
 
     // Clears the displacements so that the main experiment can start from the current positions
@@ -123,6 +126,7 @@ namespace physics
 
     inline double potential_energy(const SystemState& state) {return state.potential_energy;}
     inline double virial(const SystemState& state) {return state.virial;}
+    inline Eigen::Matrix4d virial_tensor(const SystemState& state) {return state.virial_tensor;}
     inline double time(const SystemState& state) {return state.time;}
     inline int particle_count(const SystemState& state) {return state.particle_count();}
 
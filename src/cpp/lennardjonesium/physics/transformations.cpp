@@ -34,7 +34,8 @@ namespace physics
 {
     SystemState::Operator set_momentum(const Eigen::Ref<const Eigen::Vector4d>& momentum)
     {
-        return [&momentum](SystemState& state) -> SystemState&
+        // Capture a copy, since the argument may be a temporary (e.g. in zero_momentum())
+        return [momentum = Eigen::Vector4d{momentum}](SystemState& state) -> SystemState&
         {
             assert(state.particle_count() > 0 && "Cannot set momentum of empty state");
 
@@ -56,7 +57,10 @@ namespace physics
         const Eigen::Ref<const Eigen::Vector4d>& center
     )
     {
-        return [&angular_momentum, &center](SystemState& state) -> SystemState&
+        return [
+            angular_momentum = Eigen::Vector4d{angular_momentum},
+            center = Eigen::Vector4d{center}
+        ](SystemState& state) -> SystemState&
         {
             assert(state.particle_count() > 0 && "Cannot set angular momentum of empty state");
 
@@ -0,0 +1,135 @@
+/**
+ * binary_stream.hpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LJ_BINARY_STREAM_HPP
+#define LJ_BINARY_STREAM_HPP
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <Eigen/Dense>
+
+namespace tools
+{
+    /**
+     * These functions write and read values to and from binary streams, for saving the internal
+     * state of the simulation (see control::SimulationController's checkpoints).  Values are
+     * written in the native byte order, so a binary stream can only be read back on the same
+     * kind of machine which wrote it.  Containers are written with their sizes first, so that
+     * they can be resized when read back.
+     * 
+     * The read functions do no validation themselves; the caller should check the state of the
+     * stream afterwards.
+     */
+
+    template<class T> requires std::is_arithmetic_v<T>
+    void write_binary(std::ostream& out, T value)
+        {out.write(reinterpret_cast<const char*>(&value), sizeof(T));}
+
+    template<class T> requires std::is_arithmetic_v<T>
+    void read_binary(std::istream& in, T& value)
+        {in.read(reinterpret_cast<char*>(&value), sizeof(T));}
+
+    // Eigen matrices and arrays are written as (rows, cols, coefficients in storage order)
+    template<class Derived>
+    void write_binary(std::ostream& out, const Eigen::PlainObjectBase<Derived>& value)
+    {
+        using Scalar = typename Derived::Scalar;
+
+        write_binary(out, static_cast<std::int64_t>(value.rows()));
+        write_binary(out, static_cast<std::int64_t>(value.cols()));
+        out.write(
+            reinterpret_cast<const char*>(value.data()),
+            static_cast<std::streamsize>(value.size() * sizeof(Scalar))
+        );
+    }
+
+    template<class Derived>
+    void read_binary(std::istream& in, Eigen::PlainObjectBase<Derived>& value)
+    {
+        using Scalar = typename Derived::Scalar;
+
+        std::int64_t rows{0};
+        std::int64_t cols{0};
+        read_binary(in, rows);
+        read_binary(in, cols);
+
+        // Do not attempt to resize a fixed-size object to the wrong shape
+        if (!in || rows < 0 || cols < 0
+            || (Derived::RowsAtCompileTime != Eigen::Dynamic && rows != value.rows())
+            || (Derived::ColsAtCompileTime != Eigen::Dynamic && cols != value.cols()))
+        {
+            in.setstate(std::ios::failbit);
+            return;
+        }
+
+        value.resize(rows, cols);
+        in.read(
+            reinterpret_cast<char*>(value.data()),
+            static_cast<std::streamsize>(value.size() * sizeof(Scalar))
+        );
+    }
+
+    template<class T>
+    void write_binary(std::ostream& out, const std::vector<T>& values)
+    {
+        write_binary(out, static_cast<std::uint64_t>(values.size()));
+        for (const auto& value : values) {write_binary(out, value);}
+    }
+
+    template<class T>
+    void read_binary(std::istream& in, std::vector<T>& values)
+    {
+        std::uint64_t size{0};
+        read_binary(in, size);
+
+        values.clear();
+        for (std::uint64_t i = 0; i < size && in; ++i)
+        {
+            T value{};
+            read_binary(in, value);
+            values.push_back(value);
+        }
+    }
+
+    inline void write_binary(std::ostream& out, const std::string& value)
+    {
+        write_binary(out, static_cast<std::uint64_t>(value.size()));
+        out.write(value.data(), static_cast<std::streamsize>(value.size()));
+    }
+
+    inline void read_binary(std::istream& in, std::string& value)
+    {
+        std::uint64_t size{0};
+        read_binary(in, size);
+
+        value.assign(in ? size : 0, '\0');
+        in.read(value.data(), static_cast<std::streamsize>(value.size()));
+    }
+} // namespace tools
+
+
+#endif
@@ -0,0 +1,250 @@
+/**
+ * block_average.hpp
+ *
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ *
+ * This file is part of Lennard-Jonesium.
+ *
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LJ_BLOCK_AVERAGE_HPP
+#define LJ_BLOCK_AVERAGE_HPP
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include <lennardjonesium/tools/binary_stream.hpp>
+
+namespace detail
+{
+    template<class T>
+    struct BlockAverageTraits
+    {
+        // For ordinary numeric types, the second moment is the same type as the value
+        using moment_type = T;
+
+        static T zero() {return T{};}
+
+        static moment_type outer_product(const T& a, const T& b) {return a * b;}
+
+        static double project(const T& coefficients, const moment_type& moment)
+            {return coefficients * coefficients * moment;}
+    };
+
+    template<class Scalar, int Size>
+    struct BlockAverageTraits<Eigen::Vector<Scalar, Size>>
+    {
+        // For Eigen::Vector types, the second moment is a covariance matrix
+        using moment_type = Eigen::Matrix<Scalar, Size, Size>;
+
+        static Eigen::Vector<Scalar, Size> zero() {return Eigen::Vector<Scalar, Size>::Zero();}
+
+        static moment_type outer_product(
+            const Eigen::Vector<Scalar, Size>& a, const Eigen::Vector<Scalar, Size>& b
+        )
+            {return a * b.transpose();}
+
+        static double project(
+            const Eigen::Vector<Scalar, Size>& coefficients, const moment_type& moment
+        )
+            {return coefficients.dot(moment * coefficients);}
+    };
+} // namespace detail
+
+
+namespace tools
+{
+    /**
+     * BlockAverage estimates the standard error of the mean of a time-correlated quantity, using
+     * the blocking method of Flyvbjerg and Petersen:
+     *
+     *  H. Flyvbjerg and H. G. Petersen, "Error estimates on averages of correlated data",
+     *  J. Chem. Phys. 91, 461 (1989), https://doi.org/10.1063/1.457480
+     *
+     * Successive samples in a molecular dynamics run are strongly correlated, so the naive
+     * estimate Var(x)/n underestimates the error in the mean.  The blocking method repeatedly
+     * replaces the series by the averages of adjacent pairs.  At blocking level k, each value is
+     * the average of 2^k consecutive samples, and once the blocks are longer than the
+     * correlation time, the naive estimate applied to the blocked series levels off at the true
+     * standard error of the mean.
+     *
+     * The blocking is done online: each level keeps a running mean and second moment (using
+     * Welford's algorithm), plus at most one unpaired value waiting for its partner.  So the
+     * memory required is O(log n) in the number of samples n.
+     *
+     * To choose the plateau, we take the largest error estimate among the levels which still
+     * have at least minimum_block_count blocks (the estimates at deeper levels are too noisy to
+     * be trusted).  If no level beyond the first qualifies, we fall back to the naive estimate.
+     *
+     * As with MovingSample, T may be an ordinary numeric type or an Eigen::Vector type.  In the
+     * latter case, standard_error() takes a vector of coefficients and returns the standard error
+     * of the corresponding linear combination of the means, which accounts for correlations
+     * between the components.
+     */
+
+    template<class T>
+    class BlockAverage
+    {
+        using traits = detail::BlockAverageTraits<T>;
+        using mean_type = T;
+        using moment_type = typename traits::moment_type;
+
+        public:
+            explicit BlockAverage(int minimum_block_count = 16)
+                : minimum_block_count_{minimum_block_count}
+            {}
+
+            struct Statistics
+            {
+                mean_type mean;
+                moment_type variance;
+            };
+
+            void push_back(T value)
+            {
+                for (size_t level = 0; ; ++level)
+                {
+                    if (level == levels_.size()) {levels_.push_back(Level{});}
+
+                    Level& current = levels_[level];
+                    current.add(value);
+
+                    if (!current.has_partner)
+                    {
+                        current.partner = value;
+                        current.has_partner = true;
+                        return;
+                    }
+
+                    // Pair this value with the waiting one and promote the average
+                    value = (current.partner + value) / 2.0;
+                    current.has_partner = false;
+                }
+            }
+
+            size_t size() const {return levels_.empty() ? 0 : levels_.front().count;}
+
+            bool empty() const {return size() == 0;}
+
+            void clear() {levels_.clear();}
+
+            // Statistics of the unblocked samples (using Bessel's correction for the variance)
+            Statistics statistics() const
+            {
+                assert(size() > 1 && "Cannot compute statistics without at least 2 samples");
+
+                return Statistics{levels_.front().mean, levels_.front().variance()};
+            }
+
+            // Standard error of the mean of a linear combination of the components
+            double standard_error(const T& coefficients) const
+            {
+                assert(size() > 1 && "Cannot compute standard error without at least 2 samples");
+
+                double variance_of_mean = levels_.front().variance_of_mean(coefficients);
+
+                for (const auto& level : levels_)
+                {
+                    if (level.count < static_cast<size_t>(minimum_block_count_)) {break;}
+
+                    double estimate = level.variance_of_mean(coefficients);
+                    if (estimate > variance_of_mean) {variance_of_mean = estimate;}
+                }
+
+                return std::sqrt(variance_of_mean);
+            }
+
+            // For ordinary numeric types, the standard error of the mean itself
+            double standard_error() const {return standard_error(T{1});}
+
+            // Write the state of every blocking level to a binary stream
+            void save(std::ostream& out) const
+            {
+                write_binary(out, static_cast<std::uint64_t>(levels_.size()));
+
+                for (const auto& level : levels_)
+                {
+                    write_binary(out, static_cast<std::uint64_t>(level.count));
+                    write_binary(out, level.mean);
+                    write_binary(out, level.sum_of_squares);
+                    write_binary(out, level.partner);
+                    write_binary(out, level.has_partner);
+                }
+            }
+
+            // Replace the blocking levels with those read from a binary stream
+            void restore(std::istream& in)
+            {
+                std::uint64_t level_count{0};
+                read_binary(in, level_count);
+
+                levels_.clear();
+                for (std::uint64_t i = 0; i < level_count && in; ++i)
+                {
+                    Level level{};
+                    std::uint64_t count{0};
+
+                    read_binary(in, count);
+                    read_binary(in, level.mean);
+                    read_binary(in, level.sum_of_squares);
+                    read_binary(in, level.partner);
+                    read_binary(in, level.has_partner);
+
+                    level.count = count;
+                    levels_.push_back(level);
+                }
+            }
+
+        private:
+            struct Level
+            {
+                size_t count{0};
+                mean_type mean{traits::zero()};
+                moment_type sum_of_squares{traits::outer_product(traits::zero(), traits::zero())};
+                mean_type partner{traits::zero()};
+                bool has_partner{false};
+
+                void add(const T& value)
+                {
+                    ++count;
+                    mean_type delta = value - mean;
+                    mean += delta / static_cast<double>(count);
+                    sum_of_squares += traits::outer_product(delta, value - mean);
+                }
+
+                moment_type variance() const
+                    {return sum_of_squares / static_cast<double>(count - 1);}
+
+                double variance_of_mean(const T& coefficients) const
+                {
+                    if (count < 2) {return 0;}
+                    return traits::project(coefficients, variance()) / static_cast<double>(count);
+                }
+            };
+
+            std::vector<Level> levels_;
+            int minimum_block_count_;
+    };
+} // namespace tools
+
+
+#endif
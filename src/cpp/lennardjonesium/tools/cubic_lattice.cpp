@@ -23,8 +23,12 @@
 #include <cassert>
 #include <cstdlib>
 #include <cmath>
+#include <complex>
+#include <limits>
+#include <numbers>
 #include <utility>
 #include <ranges>
+#include <vector>
 
 #include <Eigen/Dense>
 
@@ -84,5 +88,53 @@ namespace tools
             co_yield (lattice_cell.cast<double>() + unit_cell_.col(xyz_s.rem)) * scale_factor_;
         }
     }
-} // namespace tools
 
+    std::vector<Eigen::Vector4i> CubicLattice::bragg_wavenumbers() const
+    {
+        /**
+         * A reciprocal lattice vector h (in units of the inverse lattice cell) gives a Bragg peak
+         * when the structure factor of the unit cell, F(h) = sum_s exp(2 pi i h . s), is nonzero.
+         * We search the small h for the shell of smallest |h|^2 with nonzero F(h).  (The first
+         * peak of every cubic lattice lies within this range.)
+         */
+        constexpr int search_range = 2;
+        int shortest_length = std::numeric_limits<int>::max();
+        std::vector<Eigen::Vector4i> wavenumbers;
+
+        for (int x : std::views::iota(-search_range, search_range + 1))
+        {
+            for (int y : std::views::iota(-search_range, search_range + 1))
+            {
+                for (int z : std::views::iota(-search_range, search_range + 1))
+                {
+                    Eigen::Vector4i h{x, y, z, 0};
+                    int length = h.squaredNorm();
+
+                    // Skip the origin, and keep only one of each pair h, -h
+                    if (length == 0 || length > shortest_length) {continue;}
+                    if ((x < 0) || (x == 0 && y < 0) || (x == 0 && y == 0 && z < 0)) {continue;}
+
+                    std::complex<double> structure_factor = 0;
+                    for (auto site : unit_cell_.colwise())
+                    {
+                        structure_factor += std::polar(
+                            1.0, 2 * std::numbers::pi * h.cast<double>().dot(site)
+                        );
+                    }
+
+                    if (std::abs(structure_factor) < 1.0e-8) {continue;}
+
+                    if (length < shortest_length)
+                    {
+                        shortest_length = length;
+                        wavenumbers.clear();
+                    }
+
+                    wavenumbers.push_back(cells_per_side_ * h);
+                }
+            }
+        }
+
+        return wavenumbers;
+    }
+} // namespace tools
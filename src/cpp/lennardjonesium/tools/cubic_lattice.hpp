@@ -24,6 +24,7 @@
 #define LJ_CUBIC_LATTICE_HPP
 
 #include <type_traits>
+#include <vector>
 
 #include <Eigen/Dense>
 
@@ -75,6 +76,17 @@ namespace tools
 
             BoundingBox bounding_box()
                 {return BoundingBox(static_cast<double>(cells_per_side_) * scale_factor_);}
+
+            int cells_per_side() const {return cells_per_side_;}
+
+            /**
+             * The wavenumbers of the first Bragg peak of the lattice (the shortest reciprocal
+             * lattice vectors at which the unit cell does not interfere destructively).  These
+             * are given as integer vectors n relative to the BoundingBox, so that the wavevector
+             * is k = 2 pi n / L componentwise.  Only one of each pair n, -n is included.  For
+             * the face-centered lattice, these are cells_per_side * (1, 1, 1) and its images.
+             */
+            std::vector<Eigen::Vector4i> bragg_wavenumbers() const;
         
         private:
             UnitCell unit_cell_;
@@ -0,0 +1,171 @@
+/**
+ * drift_test.hpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LJ_DRIFT_TEST_HPP
+#define LJ_DRIFT_TEST_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <istream>
+#include <limits>
+#include <ostream>
+
+#include <lennardjonesium/tools/binary_stream.hpp>
+
+namespace tools
+{
+    /**
+     * DriftTest decides whether a time series is stationary, by fitting a straight line to it
+     * and testing whether the slope is significantly different from zero (a t-test on the
+     * least-squares slope).
+     * 
+     * The samples of a molecular dynamics run are correlated in time, which would make the naive
+     * standard error of the slope much too small.  So the samples are first averaged in blocks of
+     * block_length consecutive values, and the line is fitted to the block means.  If the blocks
+     * are longer than the correlation time, the block means are nearly independent, and the usual
+     * t-statistic applies.
+     * 
+     * Everything is computed with running sums (the bivariate version of Welford's algorithm), so
+     * the memory and the work per sample are O(1).
+     */
+
+    class DriftTest
+    {
+        public:
+            explicit DriftTest(int block_length = 50)
+                : block_length_{block_length}
+            {
+                assert(block_length_ > 0 && "DriftTest block length must be positive");
+            }
+
+            // Returns whether the value completed a block (and so changed the fit)
+            bool push_back(double value)
+            {
+                block_sum_ += value;
+
+                if (++block_fill_ < block_length_) {return false;}
+
+                add_block_(block_sum_ / block_length_);
+                block_sum_ = 0;
+                block_fill_ = 0;
+                return true;
+            }
+
+            // The number of complete blocks which have been fitted
+            long block_count() const {return count_;}
+
+            void clear()
+            {
+                block_sum_ = 0;
+                block_fill_ = 0;
+                count_ = 0;
+                mean_x_ = mean_y_ = sxx_ = sxy_ = syy_ = 0;
+            }
+
+            // The least-squares slope, per block
+            double slope() const
+            {
+                assert(count_ > 1 && "Cannot fit a slope without at least 2 blocks");
+                return sxy_ / sxx_;
+            }
+
+            // The slope divided by its standard error
+            double t_statistic() const
+            {
+                assert(count_ > 2 && "Cannot estimate the error in the slope with 2 blocks");
+
+                double residual_variance = (syy_ - sxy_ * sxy_ / sxx_) / (count_ - 2);
+
+                // The block means lie exactly on a line
+                if (residual_variance <= 0)
+                {
+                    if (sxy_ == 0) {return 0;}
+                    return std::copysign(std::numeric_limits<double>::infinity(), sxy_);
+                }
+
+                return slope() / std::sqrt(residual_variance / sxx_);
+            }
+
+            // Whether at least minimum_block_count blocks show no significant drift
+            bool stationary(double threshold, long minimum_block_count) const
+            {
+                return count_ >= std::max(minimum_block_count, 3L)
+                    && std::abs(t_statistic()) < threshold;
+            }
+
+            void save(std::ostream& out) const
+            {
+                write_binary(out, block_sum_);
+                write_binary(out, block_fill_);
+                write_binary(out, count_);
+                write_binary(out, mean_x_);
+                write_binary(out, mean_y_);
+                write_binary(out, sxx_);
+                write_binary(out, sxy_);
+                write_binary(out, syy_);
+            }
+
+            void restore(std::istream& in)
+            {
+                read_binary(in, block_sum_);
+                read_binary(in, block_fill_);
+                read_binary(in, count_);
+                read_binary(in, mean_x_);
+                read_binary(in, mean_y_);
+                read_binary(in, sxx_);
+                read_binary(in, sxy_);
+                read_binary(in, syy_);
+            }
+
+        private:
+            void add_block_(double y)
+            {
+                // The blocks are fitted against their index
+                double x = static_cast<double>(count_);
+                ++count_;
+
+                double dx = x - mean_x_;
+                double dy = y - mean_y_;
+                mean_x_ += dx / count_;
+                mean_y_ += dy / count_;
+
+                sxx_ += dx * (x - mean_x_);
+                sxy_ += dx * (y - mean_y_);
+                syy_ += dy * (y - mean_y_);
+            }
+
+            int block_length_;
+            double block_sum_{0};
+            int block_fill_{0};
+
+            long count_{0};
+            double mean_x_{0};
+            double mean_y_{0};
+            double sxx_{0};
+            double sxy_{0};
+            double syy_{0};
+    };
+} // namespace tools
+
+
+#endif
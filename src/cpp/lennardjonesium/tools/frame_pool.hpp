@@ -0,0 +1,182 @@
+/**
+ * frame_pool.hpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LJ_FRAME_POOL_HPP
+#define LJ_FRAME_POOL_HPP
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <lennardjonesium/tools/ring_buffer.hpp>
+
+namespace tools
+{
+    template<class Frame>
+    class FramePool
+    {
+        /**
+         * FramePool recycles a handful of preallocated frames (e.g. copies of the particle
+         * positions) which are sent from one thread to another by shared_ptr.  The producer
+         * acquire()s a frame which nobody else refers to, overwrites it, and sends a shared_ptr
+         * to it; the consumer simply drops its shared_ptr once it is done with the frame, which
+         * returns the frame to the pool.  So once the frames have been filled for the first time
+         * (or from the prototype), sending a frame allocates nothing:  Eigen reuses the storage
+         * of a matrix when it is assigned one of the same size, and the control block of each
+         * shared_ptr is placed in storage which the frame's slot keeps for it.
+         * 
+         * Freeing that control block is how the pool finds out that the last reference to a
+         * frame was dropped, so it marks the slot free and rings a Doorbell.  If every frame is
+         * still in use, acquire() sleeps on the Doorbell until the consumer releases one.  The
+         * slots are kept alive by the shared_ptrs as well as by the pool, so the pool may be
+         * destroyed while the consumer still holds some of its frames.
+         * 
+         * NOTE: Only one thread may acquire() frames from a given pool.
+         */
+
+        public:
+            explicit FramePool(size_t size = 4, const Frame& prototype = Frame{})
+                : shared_{std::make_shared<Shared_>()}
+            {
+                assert(size > 0 && "FramePool must have at least one frame");
+
+                shared_->slots.reserve(size);
+                for (size_t i = 0; i < size; ++i)
+                {
+                    shared_->slots.push_back(std::make_unique<Slot_>(prototype));
+                }
+            }
+
+            // A frame which no message refers to any more, waiting for one if necessary
+            std::shared_ptr<Frame> acquire()
+            {
+                for (;;)
+                {
+                    if (auto frame = try_acquire_()) {return frame;}
+
+                    auto token = shared_->doorbell.prepare();
+
+                    if (auto frame = try_acquire_())
+                    {
+                        shared_->doorbell.cancel();
+                        return frame;
+                    }
+
+                    shared_->doorbell.wait(token);
+                }
+            }
+
+            size_t size() const {return shared_->slots.size();}
+
+        private:
+            struct Slot_
+            {
+                explicit Slot_(const Frame& prototype) : frame{prototype} {}
+
+                Frame frame;
+                std::atomic<bool> leased{false};
+
+                // Room for the control block of the shared_ptr to the frame
+                alignas(std::max_align_t) std::byte control_block[64];
+            };
+
+            struct Shared_
+            {
+                std::vector<std::unique_ptr<Slot_>> slots;
+                Doorbell doorbell;
+            };
+
+            template<class T>
+            struct SlotAllocator_
+            {
+                // The shared_ptr allocates its control block in the slot, and deallocates it
+                // once the last reference to the frame is gone, which returns the slot to the
+                // pool.  (The allocator is copied out of the control block before it is
+                // deallocated, so this copy of shared may be the one which frees the slots.)
+                using value_type = T;
+
+                SlotAllocator_(std::shared_ptr<Shared_> shared, Slot_* slot)
+                    : shared{std::move(shared)}, slot{slot}
+                {}
+
+                template<class U>
+                SlotAllocator_(const SlotAllocator_<U>& other)
+                    : shared{other.shared}, slot{other.slot}
+                {}
+
+                T* allocate(size_t n)
+                {
+                    static_assert(
+                        sizeof(T) <= sizeof(Slot_::control_block)
+                            && alignof(T) <= alignof(std::max_align_t),
+                        "The control block of a shared_ptr does not fit in a FramePool slot"
+                    );
+
+                    assert(n == 1 && "FramePool slot holds a single control block");
+                    return reinterpret_cast<T*>(slot->control_block);
+                }
+
+                void deallocate(T*, size_t)
+                {
+                    // The consumer released the frame with an acq_rel decrement, so with this
+                    // release store, its reads of the frame happen before our next writes to it
+                    slot->leased.store(false, std::memory_order_release);
+                    shared->doorbell.ring();
+                }
+
+                template<class U>
+                bool operator==(const SlotAllocator_<U>& other) const {return slot == other.slot;}
+
+                std::shared_ptr<Shared_> shared;
+                Slot_* slot;
+            };
+
+            std::shared_ptr<Frame> try_acquire_()
+            {
+                for (size_t i = 0; i < shared_->slots.size(); ++i)
+                {
+                    auto* slot = shared_->slots[next_].get();
+                    next_ = (next_ + 1) % shared_->slots.size();
+
+                    if (!slot->leased.load(std::memory_order_acquire))
+                    {
+                        slot->leased.store(true, std::memory_order_relaxed);
+
+                        // The frame belongs to the slot, so the shared_ptr must not delete it
+                        return std::shared_ptr<Frame>{
+                            &slot->frame, [](Frame*) {}, SlotAllocator_<Frame>{shared_, slot}
+                        };
+                    }
+                }
+
+                return nullptr;
+            }
+
+            std::shared_ptr<Shared_> shared_;
+            size_t next_{0};
+    };
+} // namespace tools
+
+
+#endif
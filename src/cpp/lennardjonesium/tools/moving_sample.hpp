@@ -24,13 +24,18 @@
 #define LJ_MOVING_SAMPLE_HPP
 
 #include <cassert>
+#include <cstdint>
+#include <istream>
 #include <memory>
 #include <numeric>
+#include <ostream>
 
 #include <boost/circular_buffer.hpp>
 
 #include <Eigen/Dense>
 
+#include <lennardjonesium/tools/binary_stream.hpp>
+
 namespace detail
 {
     template<class T, class Alloc = std::allocator<T>>
@@ -48,6 +53,28 @@ namespace detail
             bool empty() const {return buffer_.empty();}
 
             bool full() const {return buffer_.full();}
+
+            // Write the sampled values (oldest first) to a binary stream
+            void save(std::ostream& out) const
+            {
+                tools::write_binary(out, static_cast<std::uint64_t>(buffer_.size()));
+                for (const auto& value : buffer_) {tools::write_binary(out, value);}
+            }
+
+            // Replace the sampled values with those read from a binary stream
+            void restore(std::istream& in)
+            {
+                std::uint64_t size{0};
+                tools::read_binary(in, size);
+
+                buffer_.clear();
+                for (std::uint64_t i = 0; i < size && in; ++i)
+                {
+                    T value{};
+                    tools::read_binary(in, value);
+                    buffer_.push_back(value);
+                }
+            }
         
         protected:
             explicit MovingSampleBase(int size) : buffer_(size) {}
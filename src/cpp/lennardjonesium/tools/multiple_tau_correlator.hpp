@@ -0,0 +1,183 @@
+/**
+ * multiple_tau_correlator.hpp
+ *
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ *
+ * This file is part of Lennard-Jonesium.
+ *
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LJ_MULTIPLE_TAU_CORRELATOR_HPP
+#define LJ_MULTIPLE_TAU_CORRELATOR_HPP
+
+#include <cassert>
+#include <functional>
+#include <vector>
+
+#include <boost/circular_buffer.hpp>
+
+namespace tools
+{
+    /**
+     * MultipleTauCorrelator computes the time autocorrelation function <A(0) A(t)> of a sampled
+     * quantity A, using the order-n "multiple-tau" scheme described in
+     *
+     *  J. Ramirez, S. K. Sukumaran, B. Vorselaars, and A. E. Likhtman, "Efficient on the fly
+     *  calculation of time correlation functions in computer simulations", J. Chem. Phys. 133,
+     *  154103 (2010), https://doi.org/10.1063/1.3491098
+     *
+     * and in Frenkel and Smit, "Understanding Molecular Simulation", section 4.4.2.
+     *
+     * The correlator has a hierarchy of levels.  Level 0 keeps the last block_length samples and
+     * correlates each new sample against all of them.  Every averaging_length values at one
+     * level are averaged together and passed on to the next level, so level k sees a coarse-
+     * grained copy of the series with resolution averaging_length^k.  The lags covered by level
+     * k (other than the ones already covered by level k - 1) run from
+     * (block_length / averaging_length) * averaging_length^k up to
+     * (block_length - 1) * averaging_length^k.  Hence the longest lag grows exponentially with
+     * the number of levels, while the memory and the work per sample grow only linearly.
+     *
+     * The "product" of two samples is supplied as a function, so that T can be any type for which
+     * a meaningful scalar product exists (e.g. a double, an Eigen::Vector, or a whole matrix of
+     * particle velocities).  T must support addition and division by a double.
+     */
+
+    template<class T>
+    class MultipleTauCorrelator
+    {
+        public:
+            using Product = std::function<double (const T&, const T&)>;
+
+            struct Correlation
+            {
+                std::vector<long> lags;         // In units of the sampling interval
+                std::vector<double> values;
+            };
+
+            MultipleTauCorrelator(
+                Product product,
+                int block_length = 16,
+                int averaging_length = 2,
+                int level_count = 8
+            )
+                : product_{product},
+                  block_length_{block_length},
+                  averaging_length_{averaging_length}
+            {
+                assert(block_length_ > 0 && averaging_length_ > 1 && level_count > 0
+                    && "Invalid MultipleTauCorrelator parameters");
+                assert(block_length_ % averaging_length_ == 0
+                    && "block_length must be a multiple of averaging_length");
+
+                levels_.reserve(level_count);
+                for (int level = 0; level < level_count; ++level)
+                {
+                    levels_.emplace_back(block_length_);
+                }
+            }
+
+            void push_back(const T& value) {push_back(value, 0);}
+
+            // The number of samples given to the correlator
+            size_t size() const {return size_;}
+
+            void clear()
+            {
+                for (auto& level : levels_) {level = Level(block_length_);}
+                size_ = 0;
+            }
+
+            // The correlation function, at every lag for which there is data
+            Correlation correlation() const
+            {
+                Correlation correlation;
+                long resolution = 1;
+
+                for (size_t level = 0; level < levels_.size(); ++level)
+                {
+                    for (int j = first_lag(level); j < block_length_; ++j)
+                    {
+                        if (levels_[level].counts[j] == 0) {continue;}
+
+                        correlation.lags.push_back(j * resolution);
+                        correlation.values.push_back(
+                            levels_[level].sums[j] / static_cast<double>(levels_[level].counts[j])
+                        );
+                    }
+
+                    resolution *= averaging_length_;
+                }
+
+                return correlation;
+            }
+
+        private:
+            struct Level
+            {
+                explicit Level(int block_length)
+                    : history(block_length), sums(block_length, 0.0), counts(block_length, 0)
+                {}
+
+                boost::circular_buffer<T> history;      // history[j] is the value j steps ago
+                T accumulator{};
+                int accumulated{0};
+                std::vector<double> sums;
+                std::vector<long> counts;
+            };
+
+            // Lags below this index at a given level are already covered by the previous level
+            int first_lag(size_t level) const
+                {return (level == 0) ? 0 : block_length_ / averaging_length_;}
+
+            void push_back(const T& value, size_t level)
+            {
+                if (level == 0) {++size_;}
+
+                Level& current = levels_[level];
+                current.history.push_front(value);
+
+                for (int j = first_lag(level); j < static_cast<int>(current.history.size()); ++j)
+                {
+                    current.sums[j] += product_(current.history[0], current.history[j]);
+                    ++current.counts[j];
+                }
+
+                // Coarse-grain the series and pass it up to the next level
+                if (current.accumulated == 0) {current.accumulator = value;}
+                else {current.accumulator += value;}
+
+                if (++current.accumulated == averaging_length_)
+                {
+                    current.accumulated = 0;
+
+                    if (level + 1 < levels_.size())
+                    {
+                        T average = current.accumulator / static_cast<double>(averaging_length_);
+                        push_back(average, level + 1);
+                    }
+                }
+            }
+
+            Product product_;
+            int block_length_;
+            int averaging_length_;
+            std::vector<Level> levels_;
+            size_t size_{0};
+    };
+} // namespace tools
+
+
+#endif
@@ -0,0 +1,399 @@
+/**
+ * ring_buffer.hpp
+ * 
+ * Copyright (c) 2021-2022 Benjamin E. Niehoff
+ * 
+ * This file is part of Lennard-Jonesium.
+ * 
+ * Lennard-Jonesium is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ * 
+ * Lennard-Jonesium is distributed in the hope that it will
+ * be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public
+ * License along with Lennard-Jonesium.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LJ_RING_BUFFER_HPP
+#define LJ_RING_BUFFER_HPP
+
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace detail
+{
+    // Hint to the processor that we are in a spin loop
+    inline void cpu_relax()
+    {
+        #if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+        #endif
+    }
+} // namespace detail
+
+
+namespace tools
+{
+    class Doorbell
+    {
+        /**
+         * A Doorbell lets one thread sleep until another thread has published something for it,
+         * where the publishing thread only pays for a notification if the sleeper is actually
+         * asleep.  The sleeper uses it as follows:
+         * 
+         *  auto token = doorbell.prepare();
+         *  if (nothing to do) {doorbell.wait(token);}
+         *  else {doorbell.cancel();}
+         * 
+         * and the publisher calls ring() after publishing.  Either the sleeper's check sees what
+         * was published, or ring() sees that the sleeper is waiting and wakes it.  Any number of
+         * publishers may share one Doorbell, but only one thread may sleep on it.
+         * 
+         * The sleeping itself is an atomic wait, which is a futex on Linux.
+         */
+
+        public:
+            std::uint32_t prepare()
+            {
+                // Read the signal before announcing that we are waiting, so that any notification
+                // sent after the announcement changes it and the wait returns immediately
+                auto token = signal_.load(std::memory_order_acquire);
+                waiting_.store(true, std::memory_order_seq_cst);
+                return token;
+            }
+
+            void wait(std::uint32_t token)
+            {
+                signal_.wait(token, std::memory_order_acquire);
+                waiting_.store(false, std::memory_order_relaxed);
+            }
+
+            void cancel() {waiting_.store(false, std::memory_order_relaxed);}
+
+            void ring()
+            {
+                // The fence orders what was published before the check of waiting_.  Clearing the
+                // flag means that we only pay for one notification however long the sleeper sleeps.
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (waiting_.load(std::memory_order_relaxed)
+                    && waiting_.exchange(false, std::memory_order_relaxed))
+                {
+                    signal_.fetch_add(1, std::memory_order_release);
+                    signal_.notify_one();
+                }
+            }
+
+            // Wake the sleeper whether or not it is waiting (e.g. to tell it to shut down)
+            void wake()
+            {
+                signal_.fetch_add(1, std::memory_order_seq_cst);
+                signal_.notify_all();
+            }
+
+        private:
+            std::atomic<bool> waiting_{false};
+            std::atomic<std::uint32_t> signal_{0};
+    };
+
+    template<class T>
+    class RingBuffer
+    {
+        /**
+         * RingBuffer is a bounded, lock-free queue for exactly one producer thread and one
+         * consumer thread.  It has the same interface as MessageBuffer (put(), get(), and close())
+         * and the same semantics for closing, but it never takes a lock:  the producer owns the
+         * tail index and the consumer owns the head index, and each only reads the other's.
+         * 
+         * When the buffer is empty, the consumer spins for a short while and then sleeps on a
+         * Doorbell, so in the common case put() is just a copy into the slot and a release store.
+         * The same applies in reverse when the buffer is full:  put() blocks until the consumer
+         * has made room.
+         * 
+         * The consumer should preferably use get_batch(callback), which processes every message
+         * available at the time of the call and then releases all of their slots at once.
+         * 
+         * A consumer which serves several RingBuffers can instead connect() them all to a single
+         * Doorbell of its own, and use poll_batch(), which never blocks.
+         * 
+         * NOTE: The capacity is rounded up to a power of 2.
+         * 
+         * NOTE: Calling put() from more than one thread, or get() from more than one thread, is a
+         * data race.  Use MessageBuffer for multiple producers or consumers.
+         */
+
+        public:
+            explicit RingBuffer(size_t capacity = 4096)
+                : slots_(std::bit_ceil(capacity)), mask_{slots_.size() - 1}
+            {
+                assert(capacity > 0 && "RingBuffer must have positive capacity");
+            }
+
+            void put(T);
+            std::optional<T> get();
+
+            // Like put(), but returns false rather than waiting if the buffer is full (in which
+            // case the message is left as it was)
+            bool try_put(T& message);
+
+            // Calls callback(T) on every available message, and returns the number of messages
+            // processed.  Returns 0 only when the buffer is closed and empty.
+            template<class Callback>
+            size_t get_batch(Callback&& callback);
+
+            // Like get_batch(), but returns 0 immediately if there are no messages
+            template<class Callback>
+            size_t poll_batch(Callback&& callback);
+
+            void close();
+
+            // For the producer:  wait until the consumer has taken every message put so far (and
+            // with get_batch() or poll_batch(), until the callbacks on them have returned)
+            void wait_until_empty();
+
+            // Ring the given Doorbell instead of our own when messages arrive.  Must be called
+            // before anything is put().
+            void connect(Doorbell& doorbell) {consumer_doorbell_ = &doorbell;}
+
+            size_t capacity() const {return slots_.size();}
+
+            // Number of messages in the buffer.  When called by the producer, this is an upper
+            // bound, since the consumer may be taking messages at the same time.
+            size_t size() const
+            {
+                return tail_.load(std::memory_order_relaxed)
+                    - head_.load(std::memory_order_acquire);
+            }
+
+            // For the consumer:  whether the producer has closed the buffer, and whether there
+            // is anything left to take.  (Check closed() first, then empty().)
+            bool closed() const {return !open_for_write_.load(std::memory_order_seq_cst);}
+
+            bool empty() const
+            {
+                return tail_.load(std::memory_order_seq_cst)
+                    == head_.load(std::memory_order_relaxed);
+            }
+
+        private:
+            // Number of times to poll before going to sleep.  With only one hardware thread,
+            // spinning just keeps the other side from running, so we sleep straight away.
+            static inline const int spin_limit_ =
+                (std::thread::hardware_concurrency() > 1) ? 1024 : 0;
+
+            // Wait until there is an item past head (returns false if closed and empty)
+            bool wait_for_items_(size_t head);
+
+            // Wait until there is room for an item at tail
+            void wait_for_space_(size_t tail);
+
+            // Process the messages from head up to cached_tail_
+            template<class Callback>
+            size_t take_(size_t head, Callback&& callback);
+
+            // Make the slots up to tail available to the consumer
+            void publish_(size_t tail);
+
+            // Release the slots up to head back to the producer
+            void release_(size_t head);
+
+            std::vector<T> slots_;
+            size_t mask_;
+
+            // Written by the consumer (and its cached copy of tail_)
+            alignas(64) std::atomic<size_t> head_{0};
+            size_t cached_tail_{0};
+
+            // Written by the producer (and its cached copy of head_)
+            alignas(64) std::atomic<size_t> tail_{0};
+            size_t cached_head_{0};
+
+            // Sleeping and waking
+            alignas(64) std::atomic<bool> open_for_write_{true};
+            Doorbell own_consumer_doorbell_;
+            Doorbell producer_doorbell_;
+            Doorbell* consumer_doorbell_{&own_consumer_doorbell_};
+    };
+
+    template<class T>
+    void RingBuffer<T>::put(T message)
+    {
+        if (!open_for_write_.load(std::memory_order_relaxed)) {return;}
+
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ == capacity()) {wait_for_space_(tail);}
+
+        slots_[tail & mask_] = std::move(message);
+        publish_(tail + 1);
+    }
+
+    template<class T>
+    bool RingBuffer<T>::try_put(T& message)
+    {
+        if (!open_for_write_.load(std::memory_order_relaxed)) {return true;}
+
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ == capacity())
+        {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ == capacity()) {return false;}
+        }
+
+        slots_[tail & mask_] = std::move(message);
+        publish_(tail + 1);
+        return true;
+    }
+
+    template<class T>
+    std::optional<T> RingBuffer<T>::get()
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_ && !wait_for_items_(head)) {return {};}
+
+        auto message = std::move(slots_[head & mask_]);
+        release_(head + 1);
+        return message;
+    }
+
+    template<class T>
+    template<class Callback>
+    size_t RingBuffer<T>::get_batch(Callback&& callback)
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_ && !wait_for_items_(head)) {return 0;}
+
+        return take_(head, callback);
+    }
+
+    template<class T>
+    template<class Callback>
+    size_t RingBuffer<T>::poll_batch(Callback&& callback)
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_)
+        {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) {return 0;}
+        }
+
+        return take_(head, callback);
+    }
+
+    template<class T>
+    template<class Callback>
+    size_t RingBuffer<T>::take_(size_t head, Callback&& callback)
+    {
+        size_t count = cached_tail_ - head;
+        for (size_t i = 0; i < count; ++i)
+        {
+            callback(std::move(slots_[(head + i) & mask_]));
+        }
+
+        release_(head + count);
+        return count;
+    }
+
+    template<class T>
+    void RingBuffer<T>::close()
+    {
+        open_for_write_.store(false, std::memory_order_seq_cst);
+
+        // Wake the consumer regardless, so that it sees the buffer is closed
+        consumer_doorbell_->wake();
+    }
+
+    template<class T>
+    void RingBuffer<T>::wait_until_empty()
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+
+        for (int spin = 0; ; ++spin)
+        {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (cached_head_ == tail) {return;}
+
+            if (spin < spin_limit_) {detail::cpu_relax(); continue;}
+
+            auto token = producer_doorbell_.prepare();
+
+            if (head_.load(std::memory_order_seq_cst) != tail) {producer_doorbell_.wait(token);}
+            else {producer_doorbell_.cancel();}
+        }
+    }
+
+    template<class T>
+    bool RingBuffer<T>::wait_for_items_(size_t head)
+    {
+        for (int spin = 0; ; ++spin)
+        {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (cached_tail_ != head) {return true;}
+
+            if (!open_for_write_.load(std::memory_order_acquire))
+            {
+                // Anything put() before close() is now visible
+                cached_tail_ = tail_.load(std::memory_order_acquire);
+                return cached_tail_ != head;
+            }
+
+            if (spin < spin_limit_) {detail::cpu_relax(); continue;}
+
+            auto token = consumer_doorbell_->prepare();
+
+            if (tail_.load(std::memory_order_seq_cst) == head
+                && open_for_write_.load(std::memory_order_seq_cst))
+            {
+                consumer_doorbell_->wait(token);
+            }
+            else {consumer_doorbell_->cancel();}
+        }
+    }
+
+    template<class T>
+    void RingBuffer<T>::wait_for_space_(size_t tail)
+    {
+        for (int spin = 0; ; ++spin)
+        {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ < capacity()) {return;}
+
+            if (spin < spin_limit_) {detail::cpu_relax(); continue;}
+
+            auto token = producer_doorbell_.prepare();
+
+            if (tail - head_.load(std::memory_order_seq_cst) == capacity())
+            {
+                producer_doorbell_.wait(token);
+            }
+            else {producer_doorbell_.cancel();}
+        }
+    }
+
+    template<class T>
+    void RingBuffer<T>::publish_(size_t tail)
+    {
+        tail_.store(tail, std::memory_order_release);
+        consumer_doorbell_->ring();
+    }
+
+    template<class T>
+    void RingBuffer<T>::release_(size_t head)
+    {
+        head_.store(head, std::memory_order_release);
+        producer_doorbell_.ring();
+    }
+} // namespace tools
+
+
+#endif
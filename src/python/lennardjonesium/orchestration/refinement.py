@@ -0,0 +1,176 @@
+"""
+refinement.py
+
+Copyright (c) 2021-2022 Benjamin E. Niehoff
+
+This file is part of Lennard-Jonesium.
+
+Lennard-Jonesium is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public
+License as published by the Free Software Foundation, either
+version 3 of the License, or (at your option) any later version.
+
+Lennard-Jonesium is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public
+License along with Lennard-Jonesium.  If not, see
+<https://www.gnu.org/licenses/>.
+"""
+
+
+
+from dataclasses import dataclass
+from typing import Optional, TextIO, Union
+import csv
+import io
+import math
+import pathlib
+
+from lennardjonesium.tools import read_log
+
+
+Point = tuple[float, float]     # (temperature, density)
+
+
+def read_observables(
+    observation_log: Union[pathlib.Path, TextIO],
+    observables: list[str]
+) -> Optional[dict[str, float]]:
+    """
+    Reads the given observables from the last row of an observations file (or an open text
+    stream, e.g. a log read from an output store), which holds the most accurate estimates of
+    the run.  Returns None if the file is missing or has no observations (e.g. because the
+    simulation aborted during equilibration).
+    """
+    if isinstance(observation_log, (str, pathlib.Path)):
+        try:
+            contents = read_log(observation_log).decode('utf-8')
+        except OSError:
+            return None
+        
+        return read_observables(io.StringIO(contents, newline=''), observables)
+    
+    last_row = None
+    for last_row in csv.DictReader(observation_log):
+        pass
+    
+    if last_row is None:
+        return None
+    
+    return {name: float(last_row[name]) for name in observables if name in last_row}
+
+
+class Refinement:
+    """
+    Refinement decides where to add points to a (temperature, density) grid, based on the
+    observables measured at the points already run.
+
+    The grid is viewed as a set of edges between neighboring points (at the same density and
+    adjacent temperatures, or at the same temperature and adjacent densities).  Once both ends of
+    an edge have been measured, the edge is split at its midpoint if any observable changes
+    sharply along it, i.e. if |a - b| > threshold * max(|a|, |b|).  An edge with measurements at
+    only one end (the other simulation having aborted before observing anything) is also split,
+    since this usually indicates a phase boundary.  The two halves of a split edge are refined
+    in turn, up to the given number of levels.
+
+    Points are fed in one at a time with record(), in whatever order the simulations finish, and
+    each call returns the new points which should be run as a result.
+    """
+
+    @dataclass
+    class _Edge:
+        lower: Point
+        upper: Point
+        level: int
+
+    def __init__(
+        self,
+        points: list[Point],
+        levels: int,
+        threshold: float,
+        observables: list[str]
+    ) -> None:
+        self.levels = levels
+        self.threshold = threshold
+        self.observables = observables
+
+        self._results: dict[Point, Optional[dict[str, float]]] = {}
+        self._edges: dict[Point, list[Refinement._Edge]] = {point: [] for point in points}
+
+        # Connect neighbors along each line of constant density, and of constant temperature
+        lines: dict[tuple[int, float], list[Point]] = {}
+
+        for temperature, density in points:
+            lines.setdefault((0, density), []).append((temperature, density))
+            lines.setdefault((1, temperature), []).append((temperature, density))
+        
+        for line in lines.values():
+            line.sort()
+            for lower, upper in zip(line, line[1:]):
+                self._add_edge(Refinement._Edge(lower, upper, 0))
+    
+    def record(
+        self,
+        point: Point,
+        observables: Optional[dict[str, float]]
+    ) -> list[tuple[Point, Point]]:
+        """
+        Records the observables measured at a point (or None if there are none), and returns a
+        list of (new_point, neighbor) pairs for the points which should now be run.  The neighbor
+        is a finished point adjacent to the new one, whose final snapshot may be used as a warm
+        start.
+        """
+        self._results[point] = observables
+        new_points = []
+
+        for edge in list(self._edges.get(point, [])):
+            if edge.lower not in self._results or edge.upper not in self._results:
+                continue
+
+            self._remove_edge(edge)
+
+            if edge.level >= self.levels or not self._is_sharp(edge):
+                continue
+            
+            midpoint = (
+                (edge.lower[0] + edge.upper[0]) / 2,
+                (edge.lower[1] + edge.upper[1]) / 2
+            )
+
+            self._edges.setdefault(midpoint, [])
+            self._add_edge(Refinement._Edge(edge.lower, midpoint, edge.level + 1))
+            self._add_edge(Refinement._Edge(midpoint, edge.upper, edge.level + 1))
+
+            # Prefer to start from the hotter (or, at equal temperature, denser) neighbor, if it
+            # got far enough to measure anything
+            neighbor = edge.upper if self._results[edge.upper] is not None else edge.lower
+            new_points.append((midpoint, neighbor))
+        
+        return new_points
+    
+    def _is_sharp(self, edge: _Edge) -> bool:
+        a = self._results[edge.lower]
+        b = self._results[edge.upper]
+
+        if a is None or b is None:
+            return (a is None) != (b is None)
+        
+        for name in self.observables:
+            if name not in a or name not in b or math.isnan(a[name]) or math.isnan(b[name]):
+                continue
+
+            if abs(a[name] - b[name]) > self.threshold * max(abs(a[name]), abs(b[name])):
+                return True
+        
+        return False
+    
+    def _add_edge(self, edge: _Edge):
+        self._edges[edge.lower].append(edge)
+        self._edges[edge.upper].append(edge)
+    
+    def _remove_edge(self, edge: _Edge):
+        self._edges[edge.lower].remove(edge)
+        self._edges[edge.upper].remove(edge)
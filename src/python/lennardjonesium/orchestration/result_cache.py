@@ -0,0 +1,220 @@
+"""
+result_cache.py
+
+Copyright (c) 2021-2022 Benjamin E. Niehoff
+
+This file is part of Lennard-Jonesium.
+
+Lennard-Jonesium is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public
+License as published by the Free Software Foundation, either
+version 3 of the License, or (at your option) any later version.
+
+Lennard-Jonesium is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public
+License along with Lennard-Jonesium.  If not, see
+<https://www.gnu.org/licenses/>.
+"""
+
+
+
+from importlib import metadata
+from typing import Optional
+import hashlib
+import json
+import os
+import pathlib
+import shutil
+
+from lennardjonesium.simulation import Configuration, append_to_store
+from lennardjonesium.orchestration.run_result import RunResult
+from lennardjonesium.tools import SweepStore
+
+
+# The Filepaths fields which only say where the output goes.  Every other field (formats,
+# reductions, queue policies, compression, ...) changes what is written, so it is part of the key.
+_PATH_FIELDS = [
+    'event_log',
+    'thermodynamic_log',
+    'observation_log',
+    'pair_distribution_log',
+    'energy_histogram_log',
+    'snapshot_log',
+    'trajectory_log',
+    'checkpoint',
+    'store',
+    'store_run'
+]
+
+# The logs which are written to the output store, if the run uses one
+_STORE_LOGS = [
+    'thermodynamic_log',
+    'observation_log',
+    'pair_distribution_log',
+    'energy_histogram_log',
+    'snapshot_log'
+]
+
+
+def _library_version() -> str:
+    try:
+        return metadata.version('lennardjonesium')
+    except metadata.PackageNotFoundError:
+        return 'unknown'
+
+
+class ResultCache:
+    """
+    ResultCache stores the output files of finished simulations in a local directory, keyed by a
+    hash of everything which determines the result: the full run Configuration (including the
+    random seed), and the version of the library.  The output filepaths are left out of the key,
+    since they only say where the results go, but the other output options (such as the format
+    or reduction of the thermodynamic log) are kept.  For a warm-started run, the path of the
+    initial snapshot is replaced by the key of the run which produced it, so that the key is the
+    same wherever the sweep lives on disk.
+
+    A simulation whose key is already in the cache does not need to run; its files are simply
+    copied into its directory.  So a sweep which is relaunched after a crash, or extended to new
+    parameters, or which overlaps with an earlier sweep using the same cache, only runs the new
+    work.
+
+    If a run writes its logs to an output store, they are copied out of (and back into) the store
+    instead.  Cache entries are the same either way, so a sweep with a store can use the results
+    of one without, and vice versa.
+    """
+
+    def __init__(self, directory: pathlib.Path) -> None:
+        self.directory = pathlib.Path(directory)
+        self.directory.mkdir(parents=True, exist_ok=True)
+
+        # Output stores we have read from, so that each index is only read once
+        self._stores: dict[pathlib.Path, SweepStore] = {}
+    
+    @staticmethod
+    def key(run_cfg: Configuration, previous_key: Optional[str] = None) -> str:
+        """
+        Returns the cache key of a run configuration.  The previous_key is the key of the run
+        whose snapshot is used as the initial snapshot, if any.
+        """
+        cfg_dict = run_cfg.to_dict()
+
+        for name in _PATH_FIELDS:
+            del cfg_dict['filepaths'][name]
+
+        # A snapshot may come from a file or from an output store, which makes no difference
+        initial_snapshot = run_cfg.system.initial_snapshot or run_cfg.system.initial_snapshot_run
+        del cfg_dict['system']['initial_snapshot_run']
+
+        if initial_snapshot:
+            cfg_dict['system']['initial_snapshot'] = previous_key or initial_snapshot
+        
+        cfg_dict['version'] = _library_version()
+
+        return hashlib.sha256(json.dumps(cfg_dict, sort_keys=True).encode()).hexdigest()
+    
+    def restore(self, key: str, run_config_file: pathlib.Path) -> bool:
+        """
+        Copies the cached output files for the given key to the places named in run_config_file.
+        Returns False if the key is not in the cache.
+        """
+        entry_dir = self.directory / key
+
+        if not entry_dir.is_dir():
+            return False
+        
+        cfg = Configuration.from_file(run_config_file)
+
+        for name, filepath in self._output_files(run_config_file).items():
+            if not (entry_dir / name).is_file():
+                continue
+            
+            if cfg.filepaths.store and name in _STORE_LOGS:
+                append_to_store(
+                    str(run_config_file.parent / cfg.filepaths.store),
+                    cfg.filepaths.store_run,
+                    name,
+                    (entry_dir / name).read_bytes()
+                )
+            else:
+                shutil.copy2(entry_dir / name, filepath)
+        
+        return True
+    
+    def store(self, key: str, run_config_file: pathlib.Path) -> bool:
+        """
+        Copies the output files of the run described by run_config_file into the cache, provided
+        that it ran to the end (either completing or aborting).  Returns whether it was stored.
+        """
+        entry_dir = self.directory / key
+
+        if entry_dir.is_dir():
+            return True
+
+        cfg = Configuration.from_file(run_config_file)
+        store = None
+
+        try:
+            if cfg.filepaths.store:
+                store = self._store(run_config_file.parent / cfg.filepaths.store)
+
+            if RunResult(run_config_file).simulation_status is None:
+                return False
+        except OSError:
+            return False
+
+        # Fill a temporary directory and rename it, so that an interrupted store leaves no entry
+        staging_dir = self.directory / f'{key}.{os.getpid()}.tmp'
+        staging_dir.mkdir(parents=True, exist_ok=True)
+
+        for name, filepath in self._output_files(run_config_file).items():
+            if store is not None and name in _STORE_LOGS:
+                contents = store.read(cfg.filepaths.store_run, name)
+                if contents is not None:
+                    (staging_dir / name).write_bytes(contents)
+            elif filepath.is_file():
+                shutil.copy2(filepath, staging_dir / name)
+        
+        try:
+            staging_dir.rename(entry_dir)
+        except OSError:
+            # Another process stored the same key first
+            shutil.rmtree(staging_dir, ignore_errors=True)
+        
+        return True
+    
+    def _store(self, filepath: pathlib.Path) -> SweepStore:
+        """
+        The output store at the given path, brought up to date.
+        """
+        filepath = filepath.resolve()
+
+        if filepath in self._stores:
+            self._stores[filepath].refresh()
+        else:
+            self._stores[filepath] = SweepStore(filepath)
+        
+        return self._stores[filepath]
+    
+    @staticmethod
+    def _output_files(run_config_file: pathlib.Path) -> dict[str, pathlib.Path]:
+        """
+        The output files of a run (other than the checkpoint, which is only needed to resume an
+        unfinished run), keyed by their field name in Configuration.filepaths.  Cache entries use
+        the field names, so that the file names of the sweep do not matter.
+        """
+        filepaths = Configuration.from_file(run_config_file).filepaths
+        names = [
+            'event_log',
+            'thermodynamic_log',
+            'observation_log',
+            'pair_distribution_log',
+            'energy_histogram_log',
+            'snapshot_log',
+            'trajectory_log'
+        ]
+
+        return {name: run_config_file.parent / getattr(filepaths, name) for name in names}
@@ -127,9 +127,13 @@ def _preamble(cfg: Configuration):
 
         Results to be output to the following files:
         Events: {cfg.filepaths.event_log}
-        Thermodynamics: {cfg.filepaths.thermodynamic_log}
+        Thermodynamics: {cfg.filepaths.thermodynamic_log} ({cfg.filepaths.thermodynamic_log_format})
         Observations: {cfg.filepaths.observation_log}
+        Pair distribution: {cfg.filepaths.pair_distribution_log}
+        Energy histogram: {cfg.filepaths.energy_histogram_log}
         Snapshots: {cfg.filepaths.snapshot_log}
+        Trajectory: {cfg.filepaths.trajectory_log} (every {cfg.system.trajectory_interval} steps)
+        Checkpoint: {cfg.filepaths.checkpoint}
 
         Begin simulation..."""
 
@@ -26,6 +26,7 @@ from typing import Optional
 import pathlib
 
 from lennardjonesium.simulation import Configuration
+from lennardjonesium.tools import read_log
 
 
 class SimulationStatus(Enum):
@@ -44,6 +45,7 @@ class RunResult:
         - At what time step did the observation phase start?
         - How many temperature adjustments were required?  On which time steps?
         - How many observations were recorded?  On which time steps?
+        - How many thermodynamic measurements did the Logger drop?
     
     This will allow us to easily gather this information for a large collection of files.
     """
@@ -60,22 +62,29 @@ class RunResult:
 
     total_time_steps: int = 0
 
+    thermodynamic_measurements_dropped: int = 0
+
     temperature_adjustments: list[int]
     observations_recorded: list[int]
 
     def __init__(self, config_filepath: pathlib.Path) -> None:
+        """
+        The events are always read from the event log file, even if the run wrote its other logs
+        to an output store, since the event log is kept up to date while the run is going.
+        """
         # Read the config file and us it to determine the location of the events log file
         cfg = Configuration.from_file(config_filepath)
-        event_log_path = pathlib.Path(cfg.filepaths.event_log)
-        if not event_log_path.is_absolute():
-            event_log_path = config_filepath.parent / event_log_path
         
         # Parse the contents of the event file and fill in information about the run
         self.temperature_adjustments = []
         self.observations_recorded = []
+
+        event_log_path = pathlib.Path(cfg.filepaths.event_log)
+        if not event_log_path.is_absolute():
+            event_log_path = config_filepath.parent / event_log_path
         
-        with open(event_log_path, 'r') as event_log_file:
-            self._parse(event_log_file.readlines())
+        events = read_log(event_log_path).decode('utf-8')
+        self._parse(events.splitlines(keepends=True))
 
     def _parse(self, lines: list[str]):
         """
@@ -87,7 +96,8 @@ class RunResult:
             first, rest = line.split(': ', maxsplit=1)
             time_step = int(first)
 
-            self.total_time_steps = time_step
+            # (Dropped measurements may be reported after the fact)
+            self.total_time_steps = max(self.total_time_steps, time_step)
 
             # Look for phase started
             if rest.startswith('Phase started'):
@@ -119,6 +129,11 @@ class RunResult:
                 self.observations_recorded.append(time_step)
                 continue
             
+            # Measurements dropped by the Logger, e.g. "Logger dropped 12 thermodynamic ..."
+            if rest.startswith('Logger dropped'):
+                self.thermodynamic_measurements_dropped += int(rest.split()[2])
+                continue
+
             # Whether simulation finished
             if rest.startswith('Simulation aborted'):
                 if self.equilibration_completed is None:
@@ -23,15 +23,21 @@ License along with Lennard-Jonesium.  If not, see
 
 import os
 import pathlib
+from dataclasses import dataclass
 from typing import Union, Optional
 from types import FunctionType, BuiltinFunctionType
 from copy import deepcopy
 import time
 import textwrap
+import csv
+import io
 
 from lennardjonesium.simulation import Configuration, Simulation, SimulationPool
 from lennardjonesium.orchestration.sweep_configuration import SweepConfiguration
 from lennardjonesium.orchestration.sweep_result import SweepResult
+from lennardjonesium.orchestration.refinement import Refinement, read_observables
+from lennardjonesium.orchestration.result_cache import ResultCache
+from lennardjonesium.tools import SweepStore
 
 
 def run_sweep(
@@ -89,6 +95,19 @@ def run_sweep(
     
     We will always output a config file with the random seed actually used, which will overwrite
     the original config file.
+
+    If sweep_cfg.refinement.levels > 0, the sweep is adaptive: the grid points run on a single
+    SimulationPool, and as their results come in, further points are pushed onto the same pool
+    wherever the observables change sharply (see Refinement).  The refined points are recorded in
+    the refinement points file, so that SweepResult can find them.
+
+    If sweep_cfg.cache.directory is set, then the results of finished simulations are stored in
+    this cache, and any simulation whose configuration (including random seed) is found there is
+    restored from it instead of being run again (see ResultCache).
+
+    If sweep_cfg.store.file is set, then the logs of all the simulations in the chunk are written
+    to that one output store (see lennardjonesium.tools.SweepStore) rather than to separate files.
+    The individual run config files are still written, and name the store and the run within it.
     """
 
     sweep_config_filepath = pathlib.Path(sweep_config_file).resolve()
@@ -109,22 +128,45 @@ def run_sweep(
     cwd = os.getcwd()
     os.chdir(sweep_config_filepath.parent)
 
-    # Get the simulations and push them onto a SimulationPool to run them
-    simulations = _create_simulations(sweep_cfg, random_seed, chunk_count, chunk_index)
-    pool = SimulationPool(thread_count)
-    job_count = len(simulations)
+    cache = ResultCache(sweep_cfg.cache.directory) if sweep_cfg.cache.directory else None
 
-    if echo_status: _preamble(sweep_cfg, job_count, thread_count, chunk_count, chunk_index)
+    if sweep_cfg.refinement.levels > 0:
+        job_count = sum(1 for _ in sweep_cfg.sweep_range(chunk_count, chunk_index))
 
-    start_time = time.perf_counter()
+        if echo_status: _preamble(sweep_cfg, job_count, thread_count, chunk_count, chunk_index)
 
-    for simulation in simulations:
-        pool.push(simulation)
-    
-    if echo_status: _report_pool_status(pool, job_count, start_time, polling_interval)
-    
-    # Wait for all simulations to finish
-    pool.wait()
+        start_time = time.perf_counter()
+
+        _run_adaptive(
+            sweep_cfg, echo_status, polling_interval, thread_count, random_seed,
+            chunk_count, chunk_index, start_time, cache
+        )
+    else:
+        # Get the simulations, grouped into waves which must run one after the other
+        waves = _create_simulations(sweep_cfg, random_seed, chunk_count, chunk_index, cache)
+        waves = [[job for job in wave if job.simulation is not None] for wave in waves]
+        job_count = sum(len(wave) for wave in waves)
+
+        if echo_status: _preamble(sweep_cfg, job_count, thread_count, chunk_count, chunk_index)
+
+        start_time = time.perf_counter()
+
+        # Push each wave onto a SimulationPool, and wait for it to finish before the next one
+        # (whose simulations may need to warm start from the snapshots of this one)
+        for wave in waves:
+            pool = SimulationPool(thread_count)
+
+            for job in wave:
+                pool.push(job.simulation)
+            
+            if echo_status: _report_pool_status(pool, len(wave), start_time, polling_interval)
+            
+            # Wait for all simulations to finish
+            pool.wait()
+
+            if cache is not None:
+                for job in wave:
+                    cache.store(job.key, job.run_config_file)
 
     end_time = time.perf_counter()
 
@@ -160,6 +202,7 @@ def _preamble(
 
         Chunk {chunk_number} of {chunk_count} (index {chunk_index})
         Running {job_count} jobs over {thread_count} threads
+        Adaptive refinement levels: {refinement_levels}
 
         Begin simulation sweep...""".format(
             temp_start=sweep_cfg.system.temperature_start,
@@ -174,7 +217,8 @@ def _preamble(
             chunk_count=chunk_count,
             chunk_index=chunk_index,
             job_count=job_count,
-            thread_count=thread_count
+            thread_count=thread_count,
+            refinement_levels=sweep_cfg.refinement.levels
         )
 
     print(textwrap.dedent(preamble), flush=True)
@@ -219,15 +263,7 @@ def _report_pool_status(
     Polls the given SimulationPool and reports its status until all jobs finish.
     """
     while True:
-        status = pool.status()
-        elapsed_time = time.perf_counter() - start_time
-        print(
-            'Jobs queued: {}, Running: {}, Completed: {}, Elapsed time: {:.2f} seconds     '.format(
-                status.waiting, status.running, status.completed, elapsed_time
-            ),
-            flush=True,
-            end='\r'
-        )
+        status = _print_pool_status(pool, start_time)
         if status.completed == job_count:
             break
         time.sleep(polling_interval)
@@ -237,14 +273,162 @@ def _report_pool_status(
     print()
 
 
+def _print_pool_status(pool: SimulationPool, start_time: float) -> SimulationPool.Status:
+    """
+    Prints the status of the given SimulationPool on a single line, and returns it.
+    """
+    status = pool.status()
+    elapsed_time = time.perf_counter() - start_time
+    print(
+        'Jobs queued: {}, Running: {}, Completed: {}, Elapsed time: {:.2f} seconds     '.format(
+            status.waiting, status.running, status.completed, elapsed_time
+        ),
+        flush=True,
+        end='\r'
+    )
+    return status
+
+
+def _run_adaptive(
+    sweep_cfg: SweepConfiguration,
+    echo_status: bool,
+    polling_interval: float,
+    thread_count: int,
+    random_seed: Union[None, int, FunctionType, BuiltinFunctionType],
+    chunk_count: int,
+    chunk_index: int,
+    start_time: float,
+    cache: Optional[ResultCache] = None
+):
+    """
+    Runs the grid points of the chunk on a single SimulationPool, and feeds refinement points into
+    the same pool as the results come in.  Each job is pushed as soon as it can run: with warm
+    starts, a grid point waits for the previous point on its path, and a refined point starts
+    from the snapshot of a finished neighbor.
+
+    Precondition: Our working directory is the same directory that contains the sweep config file.
+
+    Postcondition: The refined points are written to the refinement points file.  Each point is
+    written as soon as it is produced, so that an interrupted sweep still lists the points it ran.
+    """
+    warm_start = sweep_cfg.system.warm_start
+
+    if warm_start:
+        paths = sweep_cfg.sweep_paths(chunk_count, chunk_index)
+    else:
+        paths = [[td_pair] for td_pair in sweep_cfg.sweep_range(chunk_count, chunk_index)]
+    
+    successors = {
+        previous: td_pair for path in paths for previous, td_pair in zip(path, path[1:])
+    }
+
+    refinement = Refinement(
+        [td_pair for path in paths for td_pair in path],
+        levels=sweep_cfg.refinement.levels,
+        threshold=sweep_cfg.refinement.threshold,
+        observables=[name.strip() for name in sweep_cfg.refinement.observables.split(',')]
+    )
+
+    store_file = sweep_cfg.store_file(chunk_index)
+    store: Optional[SweepStore] = None
+
+    pool = SimulationPool(thread_count, record_completed=True)
+    jobs: dict[tuple[float, float], _Job] = {}
+    running: dict[int, tuple[float, float]] = {}
+    restored: list[tuple[float, float]] = []
+
+    points_path = sweep_cfg.refinement.points_file.format(chunk_index=chunk_index)
+
+    def push(td_pair, previous):
+        previous_key = jobs[previous].key if previous is not None else None
+        job = _create_simulation(
+            sweep_cfg, *td_pair, previous, random_seed, cache, previous_key, store_file
+        )
+        jobs[td_pair] = job
+
+        if job.simulation is None:
+            restored.append(td_pair)
+        else:
+            running[id(job.simulation)] = td_pair
+            pool.push(job.simulation)
+
+    for path in paths:
+        push(path[0], None)
+    
+    with open(points_path, 'w', newline='') as points_file:
+        points_writer = csv.writer(points_file)
+        points_writer.writerow(['Temperature', 'Density'])
+
+        while running or restored:
+            finished, restored = restored, []
+
+            for simulation in pool.take_completed():
+                td_pair = running.pop(id(simulation))
+                finished.append(td_pair)
+
+                if cache is not None:
+                    cache.store(jobs[td_pair].key, jobs[td_pair].run_config_file)
+        
+            # Pick up the logs which have been added to the store since we last looked
+            if store_file is not None and finished:
+                if store is None:
+                    store = SweepStore(store_file)
+                else:
+                    store.refresh()
+
+            for td_pair in finished:
+                if td_pair in successors:
+                    push(successors[td_pair], td_pair)
+            
+                simulation_dir = sweep_cfg.simulation_dir(*td_pair)
+
+                if store is None:
+                    observation_log = simulation_dir / sweep_cfg.filenames.observation_log
+                else:
+                    observation_log = io.StringIO(
+                        store.read_text(simulation_dir.as_posix(), 'observation_log') or ''
+                    )
+
+                observables = read_observables(observation_log, refinement.observables)
+
+                for new_pair, neighbor in refinement.record(td_pair, observables):
+                    points_writer.writerow(new_pair)
+                    points_file.flush()
+                    push(new_pair, neighbor if warm_start else None)
+        
+            if echo_status: _print_pool_status(pool, start_time)
+
+            if running and not restored: time.sleep(polling_interval)
+    
+    pool.wait()
+
+    if echo_status: print()
+
+
+@dataclass
+class _Job:
+    """
+    A single simulation of the sweep, together with its cache key.  The simulation is None if its
+    results were restored from the cache.
+    """
+    run_config_file: pathlib.Path
+    key: str
+    simulation: Optional[Simulation]
+
+
 def _create_simulations(
     sweep_cfg: SweepConfiguration,
     random_seed: Union[None, int, FunctionType, BuiltinFunctionType] = None,
     chunk_count: int = 1,
     chunk_index: int = 0,
-) -> list[Simulation]:
+    cache: Optional[ResultCache] = None
+) -> list[list[_Job]]:
     """
-    Creates a list of Simulation objects for each (temperature, density) pair in the sweep.
+    Creates a list of _Job objects for each (temperature, density) pair in the sweep.
+
+    The jobs are returned in "waves".  Without warm starts, there is only one wave.  With
+    warm starts, wave k holds the k-th simulation along every path of sweep_cfg.sweep_paths(), so
+    that each simulation runs after the one it starts from.
 
     Precondition: Our working directory is the same directory that contains the sweep config file,
         so that relative directories from this location make sense.
@@ -252,37 +436,91 @@ def _create_simulations(
     Postcondition: All of the individual simulation directories will be created, and the individual
         run config files will be written (which allows simulations to be easily re-run)
     """
-    simulations = []
+    if sweep_cfg.system.warm_start:
+        paths = sweep_cfg.sweep_paths(chunk_count, chunk_index)
+    else:
+        paths = [[td_pair] for td_pair in sweep_cfg.sweep_range(chunk_count, chunk_index)]
+    
+    waves = [[] for _ in range(max((len(path) for path in paths), default=0))]
+
+    store_file = sweep_cfg.store_file(chunk_index)
+
+    for path in paths:
+        previous = None
+        previous_key = None
+
+        for wave, (temperature, density) in zip(waves, path):
+            job = _create_simulation(
+                sweep_cfg, temperature, density, previous, random_seed, cache, previous_key,
+                store_file
+            )
+            wave.append(job)
+            previous = (temperature, density)
+            previous_key = job.key
+    
+    return [wave for wave in waves if wave]
+
+
+def _create_simulation(
+    sweep_cfg: SweepConfiguration,
+    temperature: float,
+    density: float,
+    previous: Optional[tuple[float, float]],
+    random_seed: Union[None, int, FunctionType, BuiltinFunctionType] = None,
+    cache: Optional[ResultCache] = None,
+    previous_key: Optional[str] = None,
+    store_file: Optional[pathlib.Path] = None
+) -> _Job:
+    """
+    Creates the Simulation for a single (temperature, density) pair, which is warm started from
+    the final snapshot of the simulation at the previous (temperature, density), if given.  The
+    previous_key is the cache key of that simulation.  If store_file is given, the simulation
+    writes its logs to that output store.
 
-    for temperature, density in sweep_cfg.sweep_range(chunk_count, chunk_index):
-        # Get the directory where the individual simulation will be run
-        simulation_dir = sweep_cfg.simulation_dir(temperature, density)
-        run_config_file = simulation_dir / sweep_cfg.templates.run_config_file
-
-        # Create run configuration object (introduces default random seed)
-        run_cfg = _create_run_configuration(sweep_cfg, temperature, density)
-
-        # Determine whether random seed should be updated
-        if random_seed is None and run_config_file.is_file():
-            existing_cfg = Configuration.from_file(run_config_file)
-            run_cfg.system.random_seed = existing_cfg.system.random_seed
-        elif isinstance(random_seed, int):
-            run_cfg.system.random_seed = random_seed
-        elif isinstance(random_seed, (FunctionType, BuiltinFunctionType)):
-            run_cfg.system.random_seed = random_seed()
-        
-        # Write config to file (possibly overwrites with new sweep_cfg data)
-        run_config_file.parent.mkdir(parents=True, exist_ok=True)
-        run_cfg.write(run_config_file)
+    If the results are found in the cache, they are restored into the simulation directory, and no
+    Simulation is created.
+    """
+    # Get the directory where the individual simulation will be run
+    simulation_dir = sweep_cfg.simulation_dir(temperature, density)
+    run_config_file = simulation_dir / sweep_cfg.templates.run_config_file
 
-        # We cannot change working directory for each individual simulation, so before creating
-        # the Simulation object, we must prepend the simulation_dir to the output filepaths
-        _prepend_simulation_dir(simulation_dir, run_cfg)
+    # Create run configuration object (introduces default random seed)
+    run_cfg = _create_run_configuration(sweep_cfg, temperature, density, store_file)
 
-        # Now create a Simulation and append it to the list
-        simulations.append(Simulation(run_cfg))
+    if previous is not None:
+        previous_dir = sweep_cfg.simulation_dir(*previous)
+
+        if store_file is None:
+            run_cfg.system.initial_snapshot = str(previous_dir / sweep_cfg.filenames.snapshot_log)
+        else:
+            run_cfg.system.initial_snapshot_run = previous_dir.as_posix()
+        
+        run_cfg.system.initial_snapshot_density = previous[1]
+
+    # Determine whether random seed should be updated
+    if random_seed is None and run_config_file.is_file():
+        existing_cfg = Configuration.from_file(run_config_file)
+        run_cfg.system.random_seed = existing_cfg.system.random_seed
+    elif isinstance(random_seed, int):
+        run_cfg.system.random_seed = random_seed
+    elif isinstance(random_seed, (FunctionType, BuiltinFunctionType)):
+        run_cfg.system.random_seed = random_seed()
     
-    return simulations
+    # Write config to file (possibly overwrites with new sweep_cfg data)
+    run_config_file.parent.mkdir(parents=True, exist_ok=True)
+    run_cfg.write(run_config_file)
+
+    key = ResultCache.key(run_cfg, previous_key)
+
+    if cache is not None and cache.restore(key, run_config_file):
+        return _Job(run_config_file, key, None)
+
+    # We cannot change working directory for each individual simulation, so before creating
+    # the Simulation object, we must prepend the simulation_dir to the output filepaths
+    _prepend_simulation_dir(simulation_dir, run_cfg)
+
+    # Now create the Simulation
+    return _Job(run_config_file, key, Simulation(run_cfg))
 
 
 def _prepend_simulation_dir(simulation_dir: pathlib.Path, run_cfg: Configuration):
@@ -292,16 +530,28 @@ def _prepend_simulation_dir(simulation_dir: pathlib.Path, run_cfg: Configuration
     run_cfg.filepaths.event_log = str(simulation_dir / run_cfg.filepaths.event_log)
     run_cfg.filepaths.thermodynamic_log = str(simulation_dir / run_cfg.filepaths.thermodynamic_log)
     run_cfg.filepaths.observation_log = str(simulation_dir / run_cfg.filepaths.observation_log)
+    run_cfg.filepaths.pair_distribution_log = \
+        str(simulation_dir / run_cfg.filepaths.pair_distribution_log)
+    run_cfg.filepaths.energy_histogram_log = \
+        str(simulation_dir / run_cfg.filepaths.energy_histogram_log)
     run_cfg.filepaths.snapshot_log = str(simulation_dir / run_cfg.filepaths.snapshot_log)
+    run_cfg.filepaths.trajectory_log = str(simulation_dir / run_cfg.filepaths.trajectory_log)
+    run_cfg.filepaths.checkpoint = str(simulation_dir / run_cfg.filepaths.checkpoint)
+
+    if run_cfg.filepaths.store:
+        run_cfg.filepaths.store = str(simulation_dir / run_cfg.filepaths.store)
 
 
 def _create_run_configuration(
     sweep_cfg: SweepConfiguration,
     temperature: float,
-    density: float
+    density: float,
+    store_file: Optional[pathlib.Path] = None
 ) -> Configuration:
     """
     Creates a run configuration from the sweep configuration and a given temperature and density.
+    If store_file is given, the run writes its logs to that store, under the name of its
+    simulation directory.
     """
     run_cfg = Configuration()
 
@@ -310,6 +560,9 @@ def _create_run_configuration(
     run_cfg.system.particle_count = sweep_cfg.system.particle_count
     run_cfg.system.cutoff_distance = sweep_cfg.system.cutoff_distance
     run_cfg.system.time_delta = sweep_cfg.system.time_delta
+    run_cfg.system.checkpoint_interval = sweep_cfg.system.checkpoint_interval
+    run_cfg.system.trajectory_interval = sweep_cfg.system.trajectory_interval
+    run_cfg.system.trajectory_velocities = sweep_cfg.system.trajectory_velocities
 
     run_cfg.equilibration.name = (sweep_cfg.templates.phase_name.format(
         temperature=temperature, density=density, name=sweep_cfg.equilibration.name
@@ -319,6 +572,9 @@ def _create_run_configuration(
     run_cfg.equilibration.adjustment_interval = sweep_cfg.equilibration.adjustment_interval
     run_cfg.equilibration.steady_state_time = sweep_cfg.equilibration.steady_state_time
     run_cfg.equilibration.timeout = sweep_cfg.equilibration.timeout
+    run_cfg.equilibration.drift_threshold = sweep_cfg.equilibration.drift_threshold
+    run_cfg.equilibration.drift_block_count = sweep_cfg.equilibration.drift_block_count
+    run_cfg.equilibration.drift_pass_count = sweep_cfg.equilibration.drift_pass_count
 
     run_cfg.observation.name = (sweep_cfg.templates.phase_name.format(
         temperature=temperature, density=density, name=sweep_cfg.observation.name
@@ -327,10 +583,55 @@ def _create_run_configuration(
     run_cfg.observation.sample_size = sweep_cfg.observation.sample_size
     run_cfg.observation.observation_interval = sweep_cfg.observation.observation_interval
     run_cfg.observation.observation_count = sweep_cfg.observation.observation_count
+    run_cfg.observation.correlation_levels = sweep_cfg.observation.correlation_levels
+    run_cfg.observation.pair_distribution_interval = \
+        sweep_cfg.observation.pair_distribution_interval
+    run_cfg.observation.pair_distribution_bins = sweep_cfg.observation.pair_distribution_bins
+    run_cfg.observation.structure_factor_interval = \
+        sweep_cfg.observation.structure_factor_interval
+    run_cfg.observation.energy_error_tolerance = sweep_cfg.observation.energy_error_tolerance
+    run_cfg.observation.pressure_error_tolerance = sweep_cfg.observation.pressure_error_tolerance
+    run_cfg.observation.specific_heat_error_tolerance = \
+        sweep_cfg.observation.specific_heat_error_tolerance
+    run_cfg.observation.minimum_observation_count = \
+        sweep_cfg.observation.minimum_observation_count
+    run_cfg.observation.energy_histogram_bin_width = \
+        sweep_cfg.observation.energy_histogram_bin_width
 
     run_cfg.filepaths.event_log = sweep_cfg.filenames.event_log
     run_cfg.filepaths.thermodynamic_log = sweep_cfg.filenames.thermodynamic_log
     run_cfg.filepaths.observation_log = sweep_cfg.filenames.observation_log
+    run_cfg.filepaths.pair_distribution_log = sweep_cfg.filenames.pair_distribution_log
+    run_cfg.filepaths.energy_histogram_log = sweep_cfg.filenames.energy_histogram_log
     run_cfg.filepaths.snapshot_log = sweep_cfg.filenames.snapshot_log
+    run_cfg.filepaths.trajectory_log = sweep_cfg.filenames.trajectory_log
+    run_cfg.filepaths.checkpoint = sweep_cfg.filenames.checkpoint
+    run_cfg.filepaths.thermodynamic_log_format = sweep_cfg.filenames.thermodynamic_log_format
+    run_cfg.filepaths.thermodynamic_log_reduction = \
+        sweep_cfg.filenames.thermodynamic_log_reduction
+    run_cfg.filepaths.thermodynamic_log_interval = sweep_cfg.filenames.thermodynamic_log_interval
+    run_cfg.filepaths.thermodynamic_log_pressure_tensor = \
+        sweep_cfg.filenames.thermodynamic_log_pressure_tensor
+    run_cfg.filepaths.log_queue_capacity = sweep_cfg.filenames.log_queue_capacity
+    run_cfg.filepaths.log_queue_policy = sweep_cfg.filenames.log_queue_policy
+    run_cfg.filepaths.log_queue_decimation_interval = \
+        sweep_cfg.filenames.log_queue_decimation_interval
+    run_cfg.filepaths.output_backend = sweep_cfg.filenames.output_backend
+    run_cfg.filepaths.trajectory_direct_io = sweep_cfg.filenames.trajectory_direct_io
+    run_cfg.filepaths.thermodynamic_log_compression = \
+        sweep_cfg.filenames.thermodynamic_log_compression
+    run_cfg.filepaths.observation_log_compression = sweep_cfg.filenames.observation_log_compression
+    run_cfg.filepaths.pair_distribution_log_compression = \
+        sweep_cfg.filenames.pair_distribution_log_compression
+    run_cfg.filepaths.energy_histogram_log_compression = \
+        sweep_cfg.filenames.energy_histogram_log_compression
+    run_cfg.filepaths.snapshot_log_compression = sweep_cfg.filenames.snapshot_log_compression
+    run_cfg.filepaths.trajectory_log_compression = sweep_cfg.filenames.trajectory_log_compression
+
+    if store_file is not None:
+        # Like the other filepaths, the store is given relative to the run config file
+        simulation_dir = sweep_cfg.simulation_dir(temperature, density)
+        run_cfg.filepaths.store = os.path.relpath(store_file, simulation_dir)
+        run_cfg.filepaths.store_run = simulation_dir.as_posix()
 
     return run_cfg
@@ -22,8 +22,9 @@ License along with Lennard-Jonesium.  If not, see
 
 
 from dataclasses import dataclass, field
-from typing import Iterator
+from typing import Iterator, Optional
 import itertools
+import csv
 import pathlib
 
 from more_itertools import divide
@@ -45,6 +46,10 @@ class SweepConfiguration(INIParsable, DictParsable):
         These are mostly the same as the Configuration._System parameters, except that the
         temperature and density parameters describe a np.linspace, and we do not provide a random
         seed.  (A random seed will be obtained/stored separately for each run.)
+
+        If warm_start is set, then at each density the simulations are run in order of decreasing
+        temperature, and each one starts from the final snapshot of the previous (hotter) one,
+        rather than from the lattice.
         """
         temperature_start: float = 0.1
         temperature_stop: float = 1.0
@@ -55,6 +60,10 @@ class SweepConfiguration(INIParsable, DictParsable):
         particle_count: int = 100
         cutoff_distance: float = 2.5
         time_delta: float = 0.005
+        checkpoint_interval: int = 0
+        trajectory_interval: int = 0
+        trajectory_velocities: bool = True
+        warm_start: bool = False
     
     @dataclass
     class _Templates:
@@ -75,6 +84,9 @@ class SweepConfiguration(INIParsable, DictParsable):
         adjustment_interval: int = 200
         steady_state_time: int = 1000
         timeout: int = 5000
+        drift_threshold: float = 0.0
+        drift_block_count: int = 10
+        drift_pass_count: int = 3
     
     @dataclass
     class _Observation:
@@ -83,6 +95,15 @@ class SweepConfiguration(INIParsable, DictParsable):
         sample_size: int = 50
         observation_interval: int = 200
         observation_count: int = 20
+        correlation_levels: int = 0
+        pair_distribution_interval: int = 0          # e.g. 10 to record g(r)
+        pair_distribution_bins: int = 100
+        structure_factor_interval: int = 10
+        energy_error_tolerance: float = 0.0
+        pressure_error_tolerance: float = 0.0
+        specific_heat_error_tolerance: float = 0.0
+        minimum_observation_count: int = 5
+        energy_histogram_bin_width: float = 0.0      # e.g. 0.005 to record the histogram
     
     @dataclass
     class _Filenames:
@@ -94,7 +115,59 @@ class SweepConfiguration(INIParsable, DictParsable):
         event_log: str = 'events.log'
         thermodynamic_log: str = 'thermodynamics.csv'
         observation_log: str = 'observations.csv'
+        pair_distribution_log: str = 'pair_distribution.csv'
+        energy_histogram_log: str = 'energy_histogram.csv'
         snapshot_log: str = 'snapshots.csv'
+        trajectory_log: str = 'trajectory.bin'
+        checkpoint: str = 'checkpoint.bin'
+        thermodynamic_log_format: str = 'csv'   # or 'binary' (see read_columnar)
+        thermodynamic_log_reduction: str = 'none'   # or 'decimate', 'aggregate'
+        thermodynamic_log_interval: int = 10
+        thermodynamic_log_pressure_tensor: bool = False     # Virial and kinetic tensor columns
+        log_queue_capacity: int = 4096
+        log_queue_policy: str = 'block'         # or 'drop', 'decimate', 'coalesce'
+        log_queue_decimation_interval: int = 10
+        output_backend: str = 'stream'          # or 'uring' (asynchronous writes on Linux)
+        trajectory_direct_io: bool = False      # Only with 'uring'
+        thermodynamic_log_compression: str = 'none'     # or 'gzip', 'zstd' (read transparently)
+        observation_log_compression: str = 'none'
+        pair_distribution_log_compression: str = 'none'
+        energy_histogram_log_compression: str = 'none'
+        snapshot_log_compression: str = 'none'
+        trajectory_log_compression: str = 'none'
+    
+    @dataclass
+    class _Cache:
+        """
+        If directory is not empty, finished simulations are stored in this directory (relative to
+        the sweep config file), and simulations whose results are already there are not run
+        again.  The same cache can be shared between sweeps.
+        """
+        directory: str = ''
+    
+    @dataclass
+    class _Store:
+        """
+        If file is not empty, the logs of all the runs (other than their events and trajectories)
+        are written to this single output store, placed next to the sweep config file, instead of to
+        files in each simulation directory.  It may use the format field `chunk_index`, and it is
+        read with lennardjonesium.tools.SweepStore.
+        """
+        file: str = ''
+    
+    @dataclass
+    class _Refinement:
+        """
+        If levels > 0, the sweep is adaptive: wherever one of the observables (given as a
+        comma-separated list of columns of the observations file) changes by more than the
+        relative threshold between neighboring points, the midpoint is run as well, and so on up
+        to the given number of levels.  The refined points are listed in points_file, which is
+        placed next to the sweep config file and may use the format field `chunk_index`.
+        """
+        levels: int = 0
+        threshold: float = 0.1
+        observables: str = 'Pressure,SpecificHeat,DiffusionCoefficient'
+        points_file: str = 'refinement_{chunk_index}.csv'
     
     # Since these are mutable, they need to be specified with a default factory
     system: _System = field(default_factory=_System)
@@ -102,6 +175,9 @@ class SweepConfiguration(INIParsable, DictParsable):
     equilibration: _Equilibration = field(default_factory=_Equilibration)
     observation: _Observation = field(default_factory=_Observation)
     filenames: _Filenames = field(default_factory=_Filenames)
+    refinement: _Refinement = field(default_factory=_Refinement)
+    cache: _Cache = field(default_factory=_Cache)
+    store: _Store = field(default_factory=_Store)
 
     def sweep_range(self,
         chunk_count: int = 1,
@@ -135,6 +211,23 @@ class SweepConfiguration(INIParsable, DictParsable):
             divide(chunk_count, itertools.product(temperatures, densities))
         )[chunk_index]
     
+    def sweep_paths(self,
+        chunk_count: int = 1,
+        chunk_index: int = 0,
+    ) -> list[list[tuple[float, float]]]:
+        """
+        Groups the (temperature, density) pairs of sweep_range() into paths through the grid,
+        along which each simulation can be warm started from the one before it.  There is one
+        path per density, running from the highest temperature to the lowest, since a hot fluid
+        equilibrates quickly and is a good starting point for cooling.
+        """
+        paths: dict[float, list[tuple[float, float]]] = {}
+
+        for temperature, density in self.sweep_range(chunk_count, chunk_index):
+            paths.setdefault(density, []).append((temperature, density))
+        
+        return [sorted(path, reverse=True) for path in paths.values()]
+
     def simulation_dir(self, temperature, density) -> pathlib.Path:
         """
         Returns the (relative) simulation directory corresponding to a given temperature and
@@ -160,3 +253,30 @@ class SweepConfiguration(INIParsable, DictParsable):
         """
         return (self.simulation_dir(*td_pair)
                 for td_pair in self.sweep_range(chunk_count, chunk_index))
+    
+    def store_file(self, chunk_index: int = 0) -> Optional[pathlib.Path]:
+        """
+        Returns the (relative) path of the output store of the given chunk, or None if the sweep
+        does not use one.
+        """
+        if not self.store.file:
+            return None
+        
+        return pathlib.Path(self.store.file.format(chunk_index=chunk_index))
+    
+    def refined_range(self,
+        sweep_dir: pathlib.Path,
+        chunk_index: int = 0,
+    ) -> list[tuple[float, float]]:
+        """
+        Returns the (temperature, density) pairs which were added by adaptive refinement to the
+        given chunk, as recorded in the points file under sweep_dir.
+        """
+        points_file = sweep_dir / self.refinement.points_file.format(chunk_index=chunk_index)
+
+        if not points_file.is_file():
+            return []
+        
+        with open(points_file, newline='') as f:
+            return [(float(row['Temperature']), float(row['Density']))
+                    for row in csv.DictReader(f)]
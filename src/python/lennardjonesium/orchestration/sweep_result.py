@@ -22,12 +22,15 @@ License along with Lennard-Jonesium.  If not, see
 
 
 from dataclasses import dataclass
+import itertools
 import pathlib
+from typing import Optional
 
 
 from lennardjonesium.simulation import Configuration
 from lennardjonesium.orchestration.run_result import SimulationStatus, RunResult
 from lennardjonesium.orchestration.sweep_configuration import SweepConfiguration
+from lennardjonesium.tools import SweepStore
 
 
 class SweepResult:
@@ -46,6 +49,10 @@ class SweepResult:
     equilibration_aborted: list[_SimulationResult]
     observation_aborted: list[_SimulationResult]
 
+    # If the sweep used an output store, the logs of any run can be loaded from here, using the
+    # simulation_dir (as a posix path) as the run name
+    store: Optional[SweepStore]
+
     def __init__(self,
         sweep_config_file: pathlib.Path,
         chunk_count: int = 1,
@@ -54,6 +61,7 @@ class SweepResult:
         self.completed = []
         self.equilibration_aborted = []
         self.observation_aborted = []
+        self.store = None
 
         self._collect_results(sweep_config_file, chunk_count, chunk_index)
     
@@ -68,7 +76,17 @@ class SweepResult:
         sweep_dir = sweep_config_file.parent
         sweep_cfg = SweepConfiguration.from_file(sweep_config_file)
 
-        for simulation_dir in sweep_cfg.simulation_dir_range(chunk_count, chunk_index):
+        # Read the index of the store once, rather than for every run
+        store_file = sweep_cfg.store_file(chunk_index)
+        if store_file is not None:
+            self.store = SweepStore(sweep_dir / store_file)
+
+        refined_dirs = (sweep_cfg.simulation_dir(*td_pair)
+                        for td_pair in sweep_cfg.refined_range(sweep_dir, chunk_index))
+
+        for simulation_dir in itertools.chain(
+            sweep_cfg.simulation_dir_range(chunk_count, chunk_index), refined_dirs
+        ):
             run_config_file = sweep_dir / simulation_dir / sweep_cfg.templates.run_config_file
             
             run_result = RunResult(run_config_file)
@@ -1,4 +1,4 @@
 from lennardjonesium.simulation._seed_generator import SeedGenerator
 from lennardjonesium.simulation.configuration import Configuration
-from lennardjonesium.simulation._simulation import Simulation
+from lennardjonesium.simulation._simulation import Simulation, append_to_store
 from lennardjonesium.simulation._simulation_pool import SimulationPool
@@ -21,6 +21,7 @@ License along with Lennard-Jonesium.  If not, see
 """
 
 
+from libcpp cimport bool
 from libcpp.string cimport string
 
 
@@ -46,6 +47,18 @@ cdef extern from "<lennardjonesium/api/configuration.hpp>" namespace "api" nogil
             
             # Time step size
             double time_delta
+
+            # Time steps between checkpoints
+            int checkpoint_interval
+
+            # Warm start
+            string initial_snapshot
+            double initial_snapshot_density
+            string initial_snapshot_run
+
+            # Trajectory
+            int trajectory_interval
+            bool trajectory_velocities
         
         cppclass _Equilibration "api::Configuration::Equilibration":
             _Equilibration() except +
@@ -56,6 +69,9 @@ cdef extern from "<lennardjonesium/api/configuration.hpp>" namespace "api" nogil
             int adjustment_interval
             int steady_state_time
             int timeout
+            double drift_threshold
+            int drift_block_count
+            int drift_pass_count
         
         cppclass _Observation "api::Configuration::Observation":
             _Observation() except +
@@ -65,6 +81,15 @@ cdef extern from "<lennardjonesium/api/configuration.hpp>" namespace "api" nogil
             int sample_size
             int observation_interval
             int observation_count
+            int correlation_levels
+            int pair_distribution_interval
+            int pair_distribution_bins
+            int structure_factor_interval
+            double energy_error_tolerance
+            double pressure_error_tolerance
+            double specific_heat_error_tolerance
+            int minimum_observation_count
+            double energy_histogram_bin_width
         
         cppclass _Filepaths "api::Configuration::Filepaths":
             _Filepaths() except +
@@ -72,7 +97,28 @@ cdef extern from "<lennardjonesium/api/configuration.hpp>" namespace "api" nogil
             string event_log
             string thermodynamic_log
             string observation_log
+            string pair_distribution_log
+            string energy_histogram_log
             string snapshot_log
+            string trajectory_log
+            string checkpoint
+            string thermodynamic_log_format
+            string thermodynamic_log_reduction
+            int thermodynamic_log_interval
+            bool thermodynamic_log_pressure_tensor
+            int log_queue_capacity
+            string log_queue_policy
+            int log_queue_decimation_interval
+            string output_backend
+            bool trajectory_direct_io
+            string store
+            string store_run
+            string thermodynamic_log_compression
+            string observation_log_compression
+            string pair_distribution_log_compression
+            string energy_histogram_log_compression
+            string snapshot_log_compression
+            string trajectory_log_compression
         
         # Now declare the actual member variables
         _System system
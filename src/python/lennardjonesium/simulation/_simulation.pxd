@@ -60,6 +60,14 @@ cdef extern from "<lennardjonesium/api/simulation_buffer.hpp>" namespace "api" n
 
 
 # Also grab the factory function needed to create a Simulation from a Configuration
+cdef extern from "<lennardjonesium/output/sweep_store.hpp>" namespace "output" nogil:
+    cdef cppclass _SweepStore "output::SweepStore":
+        @staticmethod
+        shared_ptr[_SweepStore] open(string) except +
+
+        void append(string, string, string) except +
+
+
 cdef extern from "<lennardjonesium/api/configuration.hpp>" namespace "api" nogil:
     cdef unique_ptr[_Simulation] make_simulation(_Configuration) except +
 
@@ -22,7 +22,7 @@ License along with Lennard-Jonesium.  If not, see
 
 
 # cimports
-from libcpp.memory cimport unique_ptr, make_unique
+from libcpp.memory cimport unique_ptr, make_unique, shared_ptr
 from libcpp.utility cimport move
 from libcpp.string cimport string
 
@@ -30,6 +30,7 @@ from lennardjonesium.simulation._configuration cimport _Configuration
 from lennardjonesium.simulation._simulation cimport (
     _Simulation,
     _SimulationBuffer,
+    _SweepStore,
     make_simulation
 )
 
@@ -117,6 +118,15 @@ cdef class Simulation:
         return self.cpp_simulation().force(separation)
 
 
+def append_to_store(store: str, run: str, log: str, contents: bytes):
+    """
+    Writes a whole log of a run to the given output store, through the same writer as any
+    Simulations in this process which use that store (see lennardjonesium.tools.SweepStore).
+    """
+    cdef shared_ptr[_SweepStore] _store = _SweepStore.open(bytes(store, 'utf-8'))
+    _store.get().append(bytes(run, 'utf-8'), bytes(log, 'utf-8'), contents)
+
+
 cdef _Configuration make_cpp_configuration(py_configuration: Configuration):
     """
     Since Cython has not yet implemented the @dataclass decorator, we were forced to implement the
@@ -139,6 +149,15 @@ cdef _Configuration make_cpp_configuration(py_configuration: Configuration):
     cpp_configuration.system.random_seed = py_configuration.system.random_seed
     cpp_configuration.system.cutoff_distance = py_configuration.system.cutoff_distance
     cpp_configuration.system.time_delta = py_configuration.system.time_delta
+    cpp_configuration.system.checkpoint_interval = py_configuration.system.checkpoint_interval
+    cpp_configuration.system.initial_snapshot = \
+        bytes(py_configuration.system.initial_snapshot, 'utf-8')
+    cpp_configuration.system.initial_snapshot_density = \
+        py_configuration.system.initial_snapshot_density
+    cpp_configuration.system.initial_snapshot_run = \
+        bytes(py_configuration.system.initial_snapshot_run, 'utf-8')
+    cpp_configuration.system.trajectory_interval = py_configuration.system.trajectory_interval
+    cpp_configuration.system.trajectory_velocities = py_configuration.system.trajectory_velocities
 
     # Equilibration settings
     cpp_configuration.equilibration.name = bytes(py_configuration.equilibration.name, 'utf-8')
@@ -149,6 +168,12 @@ cdef _Configuration make_cpp_configuration(py_configuration: Configuration):
     cpp_configuration.equilibration.steady_state_time = \
         py_configuration.equilibration.steady_state_time
     cpp_configuration.equilibration.timeout = py_configuration.equilibration.timeout
+    cpp_configuration.equilibration.drift_threshold = \
+        py_configuration.equilibration.drift_threshold
+    cpp_configuration.equilibration.drift_block_count = \
+        py_configuration.equilibration.drift_block_count
+    cpp_configuration.equilibration.drift_pass_count = \
+        py_configuration.equilibration.drift_pass_count
 
     # Observation settings
     cpp_configuration.observation.name = bytes(py_configuration.observation.name, 'utf-8')
@@ -158,6 +183,24 @@ cdef _Configuration make_cpp_configuration(py_configuration: Configuration):
         py_configuration.observation.observation_interval
     cpp_configuration.observation.observation_count = \
         py_configuration.observation.observation_count
+    cpp_configuration.observation.correlation_levels = \
+        py_configuration.observation.correlation_levels
+    cpp_configuration.observation.pair_distribution_interval = \
+        py_configuration.observation.pair_distribution_interval
+    cpp_configuration.observation.pair_distribution_bins = \
+        py_configuration.observation.pair_distribution_bins
+    cpp_configuration.observation.structure_factor_interval = \
+        py_configuration.observation.structure_factor_interval
+    cpp_configuration.observation.energy_error_tolerance = \
+        py_configuration.observation.energy_error_tolerance
+    cpp_configuration.observation.pressure_error_tolerance = \
+        py_configuration.observation.pressure_error_tolerance
+    cpp_configuration.observation.specific_heat_error_tolerance = \
+        py_configuration.observation.specific_heat_error_tolerance
+    cpp_configuration.observation.minimum_observation_count = \
+        py_configuration.observation.minimum_observation_count
+    cpp_configuration.observation.energy_histogram_bin_width = \
+        py_configuration.observation.energy_histogram_bin_width
 
     # Output files
     cpp_configuration.filepaths.event_log = \
@@ -166,7 +209,46 @@ cdef _Configuration make_cpp_configuration(py_configuration: Configuration):
         bytes(py_configuration.filepaths.thermodynamic_log, 'utf-8')
     cpp_configuration.filepaths.observation_log = \
         bytes(py_configuration.filepaths.observation_log, 'utf-8')
+    cpp_configuration.filepaths.pair_distribution_log = \
+        bytes(py_configuration.filepaths.pair_distribution_log, 'utf-8')
+    cpp_configuration.filepaths.energy_histogram_log = \
+        bytes(py_configuration.filepaths.energy_histogram_log, 'utf-8')
     cpp_configuration.filepaths.snapshot_log = \
         bytes(py_configuration.filepaths.snapshot_log, 'utf-8')
+    cpp_configuration.filepaths.trajectory_log = \
+        bytes(py_configuration.filepaths.trajectory_log, 'utf-8')
+    cpp_configuration.filepaths.checkpoint = \
+        bytes(py_configuration.filepaths.checkpoint, 'utf-8')
+    cpp_configuration.filepaths.thermodynamic_log_format = \
+        bytes(py_configuration.filepaths.thermodynamic_log_format, 'utf-8')
+    cpp_configuration.filepaths.thermodynamic_log_reduction = \
+        bytes(py_configuration.filepaths.thermodynamic_log_reduction, 'utf-8')
+    cpp_configuration.filepaths.thermodynamic_log_interval = \
+        py_configuration.filepaths.thermodynamic_log_interval
+    cpp_configuration.filepaths.thermodynamic_log_pressure_tensor = \
+        py_configuration.filepaths.thermodynamic_log_pressure_tensor
+    cpp_configuration.filepaths.log_queue_capacity = py_configuration.filepaths.log_queue_capacity
+    cpp_configuration.filepaths.log_queue_policy = \
+        bytes(py_configuration.filepaths.log_queue_policy, 'utf-8')
+    cpp_configuration.filepaths.log_queue_decimation_interval = \
+        py_configuration.filepaths.log_queue_decimation_interval
+    cpp_configuration.filepaths.output_backend = \
+        bytes(py_configuration.filepaths.output_backend, 'utf-8')
+    cpp_configuration.filepaths.trajectory_direct_io = \
+        py_configuration.filepaths.trajectory_direct_io
+    cpp_configuration.filepaths.store = bytes(py_configuration.filepaths.store, 'utf-8')
+    cpp_configuration.filepaths.store_run = bytes(py_configuration.filepaths.store_run, 'utf-8')
+    cpp_configuration.filepaths.thermodynamic_log_compression = \
+        bytes(py_configuration.filepaths.thermodynamic_log_compression, 'utf-8')
+    cpp_configuration.filepaths.observation_log_compression = \
+        bytes(py_configuration.filepaths.observation_log_compression, 'utf-8')
+    cpp_configuration.filepaths.pair_distribution_log_compression = \
+        bytes(py_configuration.filepaths.pair_distribution_log_compression, 'utf-8')
+    cpp_configuration.filepaths.energy_histogram_log_compression = \
+        bytes(py_configuration.filepaths.energy_histogram_log_compression, 'utf-8')
+    cpp_configuration.filepaths.snapshot_log_compression = \
+        bytes(py_configuration.filepaths.snapshot_log_compression, 'utf-8')
+    cpp_configuration.filepaths.trajectory_log_compression = \
+        bytes(py_configuration.filepaths.trajectory_log_compression, 'utf-8')
     
     return cpp_configuration
@@ -22,6 +22,7 @@ License along with Lennard-Jonesium.  If not, see
 
 
 from libcpp.memory cimport unique_ptr
+from libcpp.vector cimport vector
 
 from lennardjonesium.simulation._simulation cimport _Simulation
 
@@ -42,10 +43,14 @@ cdef extern from "<lennardjonesium/api/simulation_pool.hpp>" namespace "api" nog
         void wait() except +
 
         _Status status() except +
+        vector[_Simulation*] take_completed() except +
 
 
 # C++ declarations for SimulationPool
 cdef class SimulationPool:
     cdef unique_ptr[_SimulationPool] _cpp_simulation_pool
 
+    # Pushed Simulations which have not yet been reported as completed, keyed by address
+    cdef dict _jobs
+
     cdef _SimulationPool* cpp_simulation_pool(self)
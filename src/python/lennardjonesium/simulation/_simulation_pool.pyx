@@ -24,6 +24,7 @@ License along with Lennard-Jonesium.  If not, see
 # cimports
 from libcpp.memory cimport unique_ptr, make_unique
 from libcpp.utility cimport move
+from libcpp.vector cimport vector
 
 from lennardjonesium.simulation._simulation cimport _Simulation, Simulation
 from lennardjonesium.simulation._simulation_pool cimport _SimulationPool
@@ -50,8 +51,12 @@ cdef class SimulationPool:
         ('completed', int)      # Number of jobs completed
     ])
 
-    def __cinit__(self, thread_count: int = 4):
+    def __cinit__(self, thread_count: int = 4, record_completed: bool = False):
         """
+        If record_completed is set, the completed Simulations can be collected with
+        take_completed().  Otherwise they are not recorded, so that a long-lived pool does not
+        accumulate them.
+
         NOTE: We do not do any checks as to whether the hardware has enough independent cores to
         run the jobs in parallel.  Apparently it's hard to do this in a platform-independent way.
         Therefore be judicious in terms of how many threads you wish to spawn.
@@ -60,10 +65,13 @@ cdef class SimulationPool:
             raise TypeError('Thread count must be an integer')
         
         cdef int cpp_thread_count = <int> thread_count
+        cdef bint cpp_record_completed = record_completed
 
         self._cpp_simulation_pool = move[unique_ptr[_SimulationPool]](
-            make_unique[_SimulationPool](cpp_thread_count)
+            make_unique[_SimulationPool](cpp_thread_count, cpp_record_completed)
         )
+
+        self._jobs = {}
     
     cdef _SimulationPool* cpp_simulation_pool(self):
         return self._cpp_simulation_pool.get()
@@ -74,6 +82,9 @@ cdef class SimulationPool:
         """
         cdef Simulation _simulation = <Simulation?> simulation
 
+        # Keep a reference, so that the Simulation outlives its run on a worker thread
+        self._jobs[<size_t> _simulation.cpp_simulation()] = simulation
+
         self.cpp_simulation_pool().push(_simulation.cpp_simulation()[0])
     
     def close(self):
@@ -106,3 +117,14 @@ cdef class SimulationPool:
             running=_status.running,
             completed=_status.completed
         )
+    
+    def take_completed(self):
+        """
+        Returns the list of Simulations which have completed since the last call, in order of
+        completion.  Their output files are closed, so they can be inspected right away, and
+        further jobs can be pushed in response while the pool is still running.  This is always
+        empty unless the pool was created with record_completed.
+        """
+        cdef vector[_Simulation*] _completed = self.cpp_simulation_pool().take_completed()
+
+        return [self._jobs.pop(<size_t> _simulation) for _simulation in _completed]
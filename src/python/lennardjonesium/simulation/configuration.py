@@ -42,6 +42,12 @@ class Configuration(INIParsable, DictParsable):
         particle_count: int = 100
         cutoff_distance: float = 2.5
         time_delta: float = 0.005
+        checkpoint_interval: int = 0
+        initial_snapshot: str = ''
+        initial_snapshot_density: float = 0.0
+        initial_snapshot_run: str = ''              # Warm start from this run of the store
+        trajectory_interval: int = 0                # 0 disables the trajectory log
+        trajectory_velocities: bool = True
         random_seed: int = SeedGenerator.default_seed()
     
     @dataclass
@@ -52,6 +58,9 @@ class Configuration(INIParsable, DictParsable):
         adjustment_interval: int = 200
         steady_state_time: int = 1000
         timeout: int = 5000
+        drift_threshold: float = 0.0
+        drift_block_count: int = 10
+        drift_pass_count: int = 3
     
     @dataclass
     class _Observation:
@@ -60,13 +69,43 @@ class Configuration(INIParsable, DictParsable):
         sample_size: int = 50
         observation_interval: int = 200
         observation_count: int = 20
+        correlation_levels: int = 0
+        pair_distribution_interval: int = 0          # e.g. 10 to record g(r)
+        pair_distribution_bins: int = 100
+        structure_factor_interval: int = 10
+        energy_error_tolerance: float = 0.0
+        pressure_error_tolerance: float = 0.0
+        specific_heat_error_tolerance: float = 0.0
+        minimum_observation_count: int = 5
+        energy_histogram_bin_width: float = 0.0      # e.g. 0.005 to record the histogram
     
     @dataclass
     class _Filepaths:
         event_log: str = 'events.log'
         thermodynamic_log: str = 'thermodynamics.csv'
         observation_log: str = 'observations.csv'
+        pair_distribution_log: str = 'pair_distribution.csv'
+        energy_histogram_log: str = 'energy_histogram.csv'
         snapshot_log: str = 'snapshots.csv'
+        trajectory_log: str = 'trajectory.bin'      # See read_trajectory
+        checkpoint: str = 'checkpoint.bin'
+        thermodynamic_log_format: str = 'csv'   # or 'binary' (see read_columnar)
+        thermodynamic_log_reduction: str = 'none'   # or 'decimate', 'aggregate'
+        thermodynamic_log_interval: int = 10
+        thermodynamic_log_pressure_tensor: bool = False     # Virial and kinetic tensor columns
+        log_queue_capacity: int = 4096
+        log_queue_policy: str = 'block'         # or 'drop', 'decimate', 'coalesce'
+        log_queue_decimation_interval: int = 10
+        output_backend: str = 'stream'          # or 'uring' (Linux; with a store, trajectory only)
+        trajectory_direct_io: bool = False      # Only with 'uring'
+        thermodynamic_log_compression: str = 'none'     # or 'gzip', 'zstd' (read transparently)
+        observation_log_compression: str = 'none'
+        pair_distribution_log_compression: str = 'none'
+        energy_histogram_log_compression: str = 'none'
+        snapshot_log_compression: str = 'none'
+        trajectory_log_compression: str = 'none'
+        store: str = ''                         # See lennardjonesium.tools.SweepStore
+        store_run: str = ''
     
     # Since these are mutable, they need to be specified with a default factory
     system: _System = field(default_factory=_System)
@@ -1,3 +1,7 @@
 from lennardjonesium.tools.ini_parsable import INIParsable
 from lennardjonesium.tools.dict_parsable import DictParsable
 from lennardjonesium.tools.linspace import linspace
+from lennardjonesium.tools.read_columnar import read_columnar
+from lennardjonesium.tools.read_trajectory import read_trajectory, decode_positions
+from lennardjonesium.tools.sweep_store import SweepStore
+from lennardjonesium.tools.compression import decompress, read_log
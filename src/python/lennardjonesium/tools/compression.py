@@ -0,0 +1,68 @@
+"""
+compression.py
+
+Copyright (c) 2021-2022 Benjamin E. Niehoff
+
+This file is part of Lennard-Jonesium.
+
+Lennard-Jonesium is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public
+License as published by the Free Software Foundation, either
+version 3 of the License, or (at your option) any later version.
+
+Lennard-Jonesium is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public
+License along with Lennard-Jonesium.  If not, see
+<https://www.gnu.org/licenses/>.
+"""
+
+
+
+
+import pathlib
+import zlib
+from typing import Union
+
+
+_GZIP_MAGIC = b'\x1f\x8b'
+_ZSTD_MAGIC = b'\x28\xb5\x2f\xfd'
+
+
+def is_compressed(data: bytes) -> bool:
+    """
+    Whether the given data (or at least its first 4 bytes) begins a gzip or zstd stream.  The C++
+    logs may be compressed according to filepaths.<log>_compression, but keep their file names,
+    so the format is detected from the magic bytes, as in output::detect_compression().
+    """
+    return data.startswith(_GZIP_MAGIC) or data.startswith(_ZSTD_MAGIC)
+
+
+def decompress(data: bytes) -> bytes:
+    """
+    Decompresses the contents of a log written with gzip or zstd compression.  Uncompressed data
+    is returned unchanged.  A stream which is cut short (e.g. from a simulation which is still
+    running) gives as much as can be decompressed.
+
+    NOTE: zstd needs the zstandard package, which is imported here rather than made a dependency
+    of the whole package.
+    """
+    if data.startswith(_GZIP_MAGIC):
+        # 16 + MAX_WBITS selects the gzip header and trailer
+        return zlib.decompressobj(16 + zlib.MAX_WBITS).decompress(data)
+    
+    if data.startswith(_ZSTD_MAGIC):
+        import zstandard
+        return zstandard.ZstdDecompressor().decompressobj().decompress(data)
+    
+    return data
+
+
+def read_log(filepath: Union[str, pathlib.Path]) -> bytes:
+    """
+    Reads the whole of a (possibly compressed) log file, and decompresses it.
+    """
+    return decompress(pathlib.Path(filepath).read_bytes())
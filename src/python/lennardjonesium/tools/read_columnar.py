@@ -0,0 +1,94 @@
+"""
+read_columnar.py
+
+Copyright (c) 2021-2022 Benjamin E. Niehoff
+
+This file is part of Lennard-Jonesium.
+
+Lennard-Jonesium is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public
+License as published by the Free Software Foundation, either
+version 3 of the License, or (at your option) any later version.
+
+Lennard-Jonesium is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public
+License along with Lennard-Jonesium.  If not, see
+<https://www.gnu.org/licenses/>.
+"""
+
+
+
+import io
+import pathlib
+import struct
+from typing import Union
+
+from lennardjonesium.tools.compression import is_compressed, read_log
+
+
+_MAGIC = b'LJCOLUMN'
+_BYTE_ORDER_MARK = 0x01020304
+
+
+def read_columnar(filepath: Union[str, pathlib.Path]):
+    """
+    Memory-maps a binary columnar file, as written by the C++ ThermodynamicSink with
+    thermodynamic_log_format = 'binary'.  Returns a read-only numpy.memmap of records, whose
+    fields are named after the columns (the same names as in the CSV header).  So a single column
+    can be taken as e.g. `data['Temperature']`, and `pandas.DataFrame(data)` gives the same
+    DataFrame as reading the CSV file, without any parsing.
+
+    The file header describes the columns (see ThermodynamicSink).  An incomplete record at the
+    end of the file (e.g. from a simulation which is still running) is ignored.
+
+    A compressed file (see thermodynamic_log_compression) cannot be mapped, so it is decompressed
+    into memory instead, and an ordinary read-only numpy array is returned.
+
+    NOTE: This is the only function in the package which needs Numpy, so it is imported here
+    rather than made a dependency of the whole package.
+    """
+    import numpy as np
+
+    filepath = pathlib.Path(filepath)
+
+    with open(filepath, 'rb') as f:
+        contents = read_log(filepath) if is_compressed(f.read(4)) else None
+    
+    with (open(filepath, 'rb') if contents is None else io.BytesIO(contents)) as f:
+        if f.read(len(_MAGIC)) != _MAGIC:
+            raise ValueError(f'{filepath} is not a binary columnar file')
+        
+        # The byte order mark tells us the byte order of the machine which wrote the file
+        for byte_order in ('<', '>'):
+            f.seek(len(_MAGIC))
+            version, byte_order_mark, column_count, data_offset = \
+                struct.unpack(byte_order + '4I', f.read(16))
+            if byte_order_mark == _BYTE_ORDER_MARK:
+                break
+        else:
+            raise ValueError(f'{filepath} has an invalid byte order mark')
+        
+        if version != 1:
+            raise ValueError(f'{filepath} has unsupported format version {version}')
+        
+        columns = []
+        for _ in range(column_count):
+            (length,) = struct.unpack(byte_order + 'I', f.read(4))
+            columns.append(f.read(length).decode('utf-8'))
+    
+    dtype = np.dtype([(column, byte_order + 'f8') for column in columns])
+    size = filepath.stat().st_size if contents is None else len(contents)
+    record_count = (size - data_offset) // dtype.itemsize
+
+    # A zero-length memory map is not allowed
+    if record_count <= 0:
+        return np.zeros(0, dtype=dtype)
+    
+    if contents is not None:
+        return np.frombuffer(contents, dtype=dtype, count=record_count, offset=data_offset)
+
+    return np.memmap(filepath, dtype=dtype, mode='r', offset=data_offset, shape=(record_count,))
@@ -0,0 +1,129 @@
+"""
+read_trajectory.py
+
+Copyright (c) 2021-2022 Benjamin E. Niehoff
+
+This file is part of Lennard-Jonesium.
+
+Lennard-Jonesium is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public
+License as published by the Free Software Foundation, either
+version 3 of the License, or (at your option) any later version.
+
+Lennard-Jonesium is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public
+License along with Lennard-Jonesium.  If not, see
+<https://www.gnu.org/licenses/>.
+"""
+
+
+
+import io
+import pathlib
+import struct
+from typing import Union
+
+from lennardjonesium.tools.compression import is_compressed, read_log
+
+
+_MAGIC = b'LJTRAJEC'
+_BYTE_ORDER_MARK = 0x01020304
+_HEADER_SIZE = 24
+
+
+def read_trajectory(filepath: Union[str, pathlib.Path]):
+    """
+    Memory-maps a trajectory file, as written by the C++ TrajectorySink when
+    trajectory_interval > 0.  Returns a read-only numpy.memmap with one record per frame, with the
+    fields:
+
+        time_step       The time step of the frame
+        time            The simulation time of the frame
+        box             The box dimensions, shape (3,)
+        positions       The quantized positions, shape (N, 3); see decode_positions()
+        velocities      The velocities, shape (N, 3) (only if they were recorded)
+    
+    Since the file is only mapped, a single frame of a long trajectory can be read without
+    loading the rest.  An incomplete frame at the end of the file is ignored.  A compressed file
+    (see trajectory_log_compression) cannot be mapped, so it is decompressed into memory instead,
+    and an ordinary read-only numpy array is returned.
+
+    NOTE: As with read_columnar(), Numpy is imported here rather than made a dependency of the
+    whole package.
+    """
+    import numpy as np
+
+    filepath = pathlib.Path(filepath)
+
+    with open(filepath, 'rb') as f:
+        contents = read_log(filepath) if is_compressed(f.read(4)) else None
+    
+    with (open(filepath, 'rb') if contents is None else io.BytesIO(contents)) as f:
+        if f.read(len(_MAGIC)) != _MAGIC:
+            raise ValueError(f'{filepath} is not a trajectory file')
+        
+        # The byte order mark tells us the byte order of the machine which wrote the file
+        for byte_order in ('<', '>'):
+            f.seek(len(_MAGIC))
+            version, byte_order_mark, particle_count, has_velocities = \
+                struct.unpack(byte_order + '4I', f.read(16))
+            if byte_order_mark == _BYTE_ORDER_MARK:
+                break
+        else:
+            raise ValueError(f'{filepath} has an invalid byte order mark')
+        
+        if version not in (1, 2):
+            raise ValueError(f'{filepath} has unsupported format version {version}')
+    
+    # Since version 2, the velocities start on a multiple of 4 bytes, and each frame is padded
+    # to a multiple of 8 bytes
+    def pad(size, alignment):
+        return size if version == 1 else -(-size // alignment) * alignment
+
+    positions_end = 40 + 6 * particle_count
+    velocities_start = pad(positions_end, 4) if has_velocities else positions_end
+    velocities_end = velocities_start + (12 * particle_count if has_velocities else 0)
+
+    fields = {
+        'names': ['frame_size', 'time_step', 'time', 'box', 'positions'],
+        'formats': [
+            byte_order + 'u4',
+            byte_order + 'i4',
+            byte_order + 'f8',
+            (byte_order + 'f8', (3,)),
+            (byte_order + 'u2', (particle_count, 3))
+        ],
+        'offsets': [0, 4, 8, 16, 40],
+        'itemsize': pad(velocities_end, 8)
+    }
+
+    if has_velocities:
+        fields['names'].append('velocities')
+        fields['formats'].append((byte_order + 'f4', (particle_count, 3)))
+        fields['offsets'].append(velocities_start)
+    
+    dtype = np.dtype(fields)
+    size = filepath.stat().st_size if contents is None else len(contents)
+    frame_count = (size - _HEADER_SIZE) // dtype.itemsize
+
+    # A zero-length memory map is not allowed
+    if frame_count <= 0:
+        return np.zeros(0, dtype=dtype)
+    
+    if contents is not None:
+        return np.frombuffer(contents, dtype=dtype, count=frame_count, offset=_HEADER_SIZE)
+
+    return np.memmap(filepath, dtype=dtype, mode='r', offset=_HEADER_SIZE, shape=(frame_count,))
+
+
+def decode_positions(frames):
+    """
+    Converts the quantized positions of the given frames (as returned by read_trajectory()) back
+    into coordinates within the box.  Each coordinate is accurate to half of 1/65536 of the box
+    side.
+    """
+    return (frames['positions'] + 0.5) / 65536.0 * frames['box'][..., None, :]
@@ -0,0 +1,178 @@
+"""
+sweep_store.py
+
+Copyright (c) 2021-2022 Benjamin E. Niehoff
+
+This file is part of Lennard-Jonesium.
+
+Lennard-Jonesium is free software: you can redistribute
+it and/or modify it under the terms of the GNU General Public
+License as published by the Free Software Foundation, either
+version 3 of the License, or (at your option) any later version.
+
+Lennard-Jonesium is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public
+License along with Lennard-Jonesium.  If not, see
+<https://www.gnu.org/licenses/>.
+"""
+
+
+
+import pathlib
+import struct
+from typing import Optional, Union
+
+from lennardjonesium.tools.compression import decompress
+
+
+_INDEX_MAGIC = b'LJSINDEX'
+_DATA_MAGIC = b'LJSTORED'
+_BYTE_ORDER_MARK = 0x01020304
+_HEADER_SIZE = 16
+_RECORD_SIZE = 32
+_FORMAT_VERSION = 2
+_CLOSING_OFFSET = 2**64 - 1     # The offset of the record which closes a segment
+
+
+class SweepStore:
+    """
+    SweepStore reads the single output store of a sweep, as written by the C++ output::SweepStore
+    when the sweep config sets store.file.  The store holds the logs of every run (all but the
+    events, the trajectory and the checkpoint), each under the name of the run (its simulation
+    directory, relative to the sweep config file) and the name of the log (the field name in
+    Configuration.filepaths, e.g. 'observation_log').
+
+    Only the index is read when the store is opened, so the logs of a few runs can be loaded
+    without touching the rest:
+
+        store = SweepStore('sweep_0.store')
+        observations = store.read_text('T_0.800000/d_0.700000', 'observation_log')
+    
+    If the store is still being written to, refresh() reads whatever has been added to the index
+    since.  Where a log has been written more than once, the newest version is returned.  A log
+    which is still being written (or whose run was killed) is not returned until its segment is
+    closed, so that it does not hide an earlier, complete version.
+    """
+
+    def __init__(self, filepath: Union[str, pathlib.Path]) -> None:
+        self.filepath = pathlib.Path(filepath)
+        self.index_filepath = self.filepath.with_name(self.filepath.name + '.index')
+
+        # The newest closed segment of each (run, log), and its chunks as (offset, length) pairs
+        self._entries: dict[tuple[str, str], tuple[int, list[tuple[int, int]]]] = {}
+
+        # The chunks of the segments which have not been closed yet
+        self._open_segments: dict[int, list[tuple[int, int]]] = {}
+        self._byte_order: Optional[str] = None
+        self._index_position = 0
+
+        self.refresh()
+    
+    def refresh(self) -> None:
+        """
+        Reads the records which have been added to the index since it was last read.
+        """
+        with open(self.index_filepath, 'rb') as f:
+            if self._byte_order is None:
+                self._byte_order = self._read_header(f, _INDEX_MAGIC, self.index_filepath)
+                self._index_position = _HEADER_SIZE
+            
+            f.seek(self._index_position)
+            data_size = self.filepath.stat().st_size
+
+            while True:
+                record = f.read(_RECORD_SIZE)
+                if len(record) < _RECORD_SIZE:
+                    break
+                
+                segment, offset, length, run_size, log_size = \
+                    struct.unpack(self._byte_order + '3Q2I', record)
+                names = f.read(run_size + log_size)
+
+                # Stop at an incomplete record, and read it again on the next refresh
+                if len(names) < run_size + log_size or \
+                        (offset != _CLOSING_OFFSET and offset + length > data_size):
+                    break
+                
+                run = names[:run_size].decode('utf-8')
+                log = names[run_size:].decode('utf-8')
+                self._record(segment, run, log, offset, length)
+
+                self._index_position = f.tell()
+    
+    def runs(self) -> list[str]:
+        """
+        The names of the runs in the store.
+        """
+        return sorted({run for run, _ in self._entries})
+    
+    def logs(self, run: str) -> list[str]:
+        """
+        The names of the logs of the given run.
+        """
+        return sorted(log for entry_run, log in self._entries if entry_run == run)
+    
+    def __contains__(self, run_and_log: tuple[str, str]) -> bool:
+        return run_and_log in self._entries
+    
+    def read(self, run: str, log: str) -> Optional[bytes]:
+        """
+        Returns the contents of the given log of the given run, or None if it is not in the store.
+        A compressed log is decompressed.
+        """
+        entry = self._entries.get((run, log))
+
+        if entry is None:
+            return None
+        
+        with open(self.filepath, 'rb') as f:
+            chunks = []
+            for offset, length in entry[1]:
+                f.seek(offset)
+                chunks.append(f.read(length))
+        
+        return decompress(b''.join(chunks))
+    
+    def read_text(self, run: str, log: str) -> Optional[str]:
+        """
+        As read(), for the logs which are text (i.e. all but a binary thermodynamic log).
+        """
+        contents = self.read(run, log)
+        return None if contents is None else contents.decode('utf-8')
+    
+    def _record(self, segment: int, run: str, log: str, offset: int, length: int) -> None:
+        if offset != _CLOSING_OFFSET:
+            self._open_segments.setdefault(segment, []).append((offset, length))
+            return
+        
+        chunks = self._open_segments.pop(segment, [])
+        entry = self._entries.get((run, log))
+
+        if entry is None or segment > entry[0]:
+            self._entries[(run, log)] = (segment, chunks)
+    
+    @staticmethod
+    def _read_header(f, magic: bytes, filepath: pathlib.Path) -> str:
+        """
+        Checks the header of a store file, and returns its byte order (for struct).
+        """
+        if f.read(len(magic)) != magic:
+            raise ValueError(f'{filepath} is not a sweep store file')
+        
+        # The byte order mark tells us the byte order of the machine which wrote the file
+        for byte_order in ('<', '>'):
+            f.seek(len(magic))
+            version, byte_order_mark = struct.unpack(byte_order + '2I', f.read(8))
+            if byte_order_mark == _BYTE_ORDER_MARK:
+                break
+        else:
+            raise ValueError(f'{filepath} has an invalid byte order mark')
+        
+        if version != _FORMAT_VERSION:
+            raise ValueError(f'{filepath} has unsupported format version {version}')
+        
+        return byte_order
@@ -0,0 +1,94 @@
+/**
+ * Benchmark the fused kinetic_moments() against the separate Eigen reductions it replaces in
+ * ThermodynamicMeasurement:  kinetic_energy(), kinetic_tensor(), total_momentum(), and
+ * mean_square_displacement(), each of which makes its own pass over the particles.
+ *
+ * We report the time per evaluation for several particle counts, from ones which fit in cache
+ * to ones which do not.
+ *
+ * Usage:  benchmark_kinetic_moments [evaluation_count]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include <Eigen/Dense>
+
+#include <src/cpp/lennardjonesium/physics/system_state.hpp>
+#include <src/cpp/lennardjonesium/physics/derived_properties.hpp>
+
+struct Result
+{
+    double seconds;
+    double checksum;
+};
+
+template<class Measure>
+Result run(const physics::SystemState& state, Measure measure, long evaluation_count)
+{
+    using clock = std::chrono::steady_clock;
+
+    // Accumulate the results, so that the compiler cannot drop the measurements
+    double checksum = 0;
+    auto start = clock::now();
+
+    for (long i = 0; i < evaluation_count; ++i)
+    {
+        checksum += measure(state);
+    }
+
+    auto finished = clock::now();
+
+    return Result{
+        std::chrono::duration<double>(finished - start).count() / evaluation_count,
+        checksum
+    };
+}
+
+void report(const std::string& name, const Result& result)
+{
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed
+        << std::setw(12) << std::setprecision(1) << 1e9 * result.seconds << " ns/evaluation"
+        << "    (checksum " << std::setprecision(3) << result.checksum << ")\n";
+}
+
+int main(int argc, char* argv[])
+{
+    long evaluation_count = (argc > 1) ? std::atol(argv[1]) : 10'000;
+
+    for (int particle_count : {100, 1'000, 10'000, 100'000})
+    {
+        physics::SystemState state(particle_count);
+        state.velocities.topRows<3>().setRandom();
+        state.displacements.topRows<3>().setRandom();
+
+        std::cout << particle_count << " particles, " << evaluation_count << " evaluations\n\n";
+
+        auto separate = [](const physics::SystemState& state)
+        {
+            return physics::kinetic_energy(state)
+                + physics::kinetic_tensor(state).sum()
+                + physics::total_momentum(state).sum()
+                + physics::mean_square_displacement(state);
+        };
+
+        auto fused = [](const physics::SystemState& state)
+        {
+            auto moments = physics::kinetic_moments(state);
+
+            return moments.kinetic_energy
+                + moments.kinetic_tensor.sum()
+                + moments.total_momentum.sum()
+                + moments.mean_square_displacement;
+        };
+
+        report("Separate passes", run(state, separate, evaluation_count));
+        report("kinetic_moments()", run(state, fused, evaluation_count));
+        std::cout << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,117 @@
+/**
+ * Benchmark the transport used by the Logger:  MessageBuffer (mutex and condition variable)
+ * against RingBuffer (lock-free, single producer and single consumer).
+ * 
+ * One thread puts messages of the same size as the Logger's as fast as it can, while another
+ * takes them off.  We report the time the producer spends per message (which is what the
+ * simulation thread pays) and the overall throughput.
+ * 
+ * Usage:  benchmarks [message_count]
+ */
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <src/cpp/lennardjonesium/tools/message_buffer.hpp>
+#include <src/cpp/lennardjonesium/tools/ring_buffer.hpp>
+
+// Same size as std::pair<int, output::LogMessage>
+using Message = std::pair<int, std::array<double, 8>>;
+
+struct Result
+{
+    double producer_seconds;
+    double total_seconds;
+    double checksum;
+};
+
+template<class Buffer, class Consume>
+Result run(Buffer& buffer, Consume consume, long message_count)
+{
+    using clock = std::chrono::steady_clock;
+
+    double checksum = 0;
+    auto start = clock::now();
+
+    std::thread consumer([&buffer, &consume, &checksum]() {checksum = consume(buffer);});
+
+    for (long i = 0; i < message_count; ++i)
+    {
+        buffer.put(Message{static_cast<int>(i), {static_cast<double>(i)}});
+    }
+
+    auto produced = clock::now();
+
+    buffer.close();
+    consumer.join();
+
+    auto finished = clock::now();
+
+    return Result{
+        std::chrono::duration<double>(produced - start).count(),
+        std::chrono::duration<double>(finished - start).count(),
+        checksum
+    };
+}
+
+void report(const std::string& name, const Result& result, long message_count)
+{
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed
+        << std::setw(10) << std::setprecision(1)
+        << 1e9 * result.producer_seconds / message_count << " ns/put"
+        << std::setw(12) << std::setprecision(2)
+        << message_count / result.total_seconds / 1e6 << " M messages/s"
+        << "    (checksum " << std::setprecision(0) << result.checksum << ")\n";
+}
+
+int main(int argc, char* argv[])
+{
+    long message_count = (argc > 1) ? std::atol(argv[1]) : 10'000'000;
+
+    std::cout << "Sending " << message_count << " messages of " << sizeof(Message)
+        << " bytes\n\n";
+
+    {
+        tools::MessageBuffer<Message> buffer;
+        auto consume = [](tools::MessageBuffer<Message>& buffer)
+        {
+            double checksum = 0;
+            while (auto o = buffer.get()) {checksum += o->second[0];}
+            return checksum;
+        };
+
+        report("MessageBuffer::get()", run(buffer, consume, message_count), message_count);
+    }
+
+    {
+        tools::RingBuffer<Message> buffer;
+        auto consume = [](tools::RingBuffer<Message>& buffer)
+        {
+            double checksum = 0;
+            while (auto o = buffer.get()) {checksum += o->second[0];}
+            return checksum;
+        };
+
+        report("RingBuffer::get()", run(buffer, consume, message_count), message_count);
+    }
+
+    {
+        tools::RingBuffer<Message> buffer;
+        auto consume = [](tools::RingBuffer<Message>& buffer)
+        {
+            double checksum = 0;
+            while (buffer.get_batch([&checksum](Message m) {checksum += m.second[0];}) > 0);
+            return checksum;
+        };
+
+        report("RingBuffer::get_batch()", run(buffer, consume, message_count), message_count);
+    }
+
+    return 0;
+}
@@ -61,6 +61,8 @@ SCENARIO("A complete run of the simulation")
         .event_log_path = test_dir / "events.log",
         .thermodynamic_log_path = test_dir / "thermodynamics.csv",
         .observation_log_path = test_dir / "observations.csv",
+        .pair_distribution_log_path = test_dir / "pair_distribution.csv",
+        .energy_histogram_log_path = test_dir / "energy_histogram.csv",
         .snapshot_log_path = test_dir / "snapshots.csv"
     };
 
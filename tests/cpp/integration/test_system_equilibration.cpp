@@ -116,15 +116,27 @@ SCENARIO("Equilibrating the system")
         
         fs::path observation_log_path = local_dir / "observations.csv";
         std::ofstream observation_log{observation_log_path};
+        
+        fs::path pair_distribution_log_path = local_dir / "pair_distribution.csv";
+        std::ofstream pair_distribution_log{pair_distribution_log_path};
+        
+        fs::path energy_histogram_log_path = local_dir / "energy_histogram.csv";
+        std::ofstream energy_histogram_log{energy_histogram_log_path};
     
         fs::path snapshot_log_path = test_dir / "snapshots.csv";
         std::ofstream snapshot_log{snapshot_log_path};
 
+        fs::path trajectory_log_path = test_dir / "trajectory.bin";
+        std::ofstream trajectory_log{trajectory_log_path, std::ios::binary};
+
         output::Logger::Streams streams = {
             .event_log = event_log,
             .thermodynamic_log = thermodynamic_log,
             .observation_log = observation_log,
-            .snapshot_log = snapshot_log
+            .pair_distribution_log = pair_distribution_log,
+            .energy_histogram_log = energy_histogram_log,
+            .snapshot_log = snapshot_log,
+            .trajectory_log = trajectory_log
         };
 
         // Set up the logger
@@ -189,15 +201,27 @@ SCENARIO("Equilibrating the system")
         
         fs::path observation_log_path = local_dir / "observations.csv";
         std::ofstream observation_log{observation_log_path};
+        
+        fs::path pair_distribution_log_path = local_dir / "pair_distribution.csv";
+        std::ofstream pair_distribution_log{pair_distribution_log_path};
+        
+        fs::path energy_histogram_log_path = local_dir / "energy_histogram.csv";
+        std::ofstream energy_histogram_log{energy_histogram_log_path};
     
         fs::path snapshot_log_path = test_dir / "snapshots.csv";
         std::ofstream snapshot_log{snapshot_log_path};
 
+        fs::path trajectory_log_path = test_dir / "trajectory.bin";
+        std::ofstream trajectory_log{trajectory_log_path, std::ios::binary};
+
         output::Logger::Streams streams = {
             .event_log = event_log,
             .thermodynamic_log = thermodynamic_log,
             .observation_log = observation_log,
-            .snapshot_log = snapshot_log
+            .pair_distribution_log = pair_distribution_log,
+            .energy_histogram_log = energy_histogram_log,
+            .snapshot_log = snapshot_log,
+            .trajectory_log = trajectory_log
         };
 
         // Set up the logger
@@ -0,0 +1,179 @@
+/**
+ * Test forking replicas of an equilibrated simulation
+ */
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <catch2/catch.hpp>
+
+#include <src/cpp/lennardjonesium/physics/lennard_jones_force.hpp>
+#include <src/cpp/lennardjonesium/control/simulation_phase.hpp>
+#include <src/cpp/lennardjonesium/output/snapshot_reader.hpp>
+#include <src/cpp/lennardjonesium/api/simulation.hpp>
+#include <src/cpp/lennardjonesium/api/simulation_pool.hpp>
+#include <src/cpp/lennardjonesium/api/replica_ensemble.hpp>
+
+namespace fs = std::filesystem;
+
+inline int count_lines(fs::path file_path)
+{
+    std::ifstream fin{file_path};
+
+    std::string unused;
+    int count = 0;
+
+    while (std::getline(fin, unused))
+    {
+        ++count;
+    }
+
+    fin.close();
+
+    return count;
+}
+
+SCENARIO("Forking observation replicas from one equilibration")
+{
+    // First set up the directory for writing simulation data files
+    fs::path test_dir{"test_replica_ensemble"};
+    fs::create_directory(test_dir);
+
+    int observation_interval = 50;
+    int observation_count = 10;
+    int replica_count = 3;
+
+    auto parameters = api::ReplicaEnsemble::Parameters
+    {
+        .simulation_parameters = {
+            .system_parameters = {
+                .temperature = 0.8,
+                .density = 0.8,
+                .particle_count = 50
+            },
+
+            .random_seed = 12345,
+
+            .force_parameters = physics::LennardJonesForce::Parameters
+            {
+                .cutoff_distance = 2.0
+            },
+
+            .time_delta = 0.005,
+
+            .schedule_parameters = {
+                {
+                    "Equilibration Phase",
+                    control::EquilibrationPhase::Parameters
+                    {
+                        .tolerance = 0.5,
+                        .sample_size = 20,
+                        .adjustment_interval = 50,
+                        .steady_state_time = 100,
+                        .timeout = 2000
+                    }
+                },
+                {
+                    "Observation Phase",
+                    control::ObservationPhase::Parameters
+                    {
+                        .tolerance = 10.0,
+                        .sample_size = 25,
+                        .observation_interval = observation_interval,
+                        .observation_count = observation_count
+                    }
+                }
+            },
+
+            .event_log_path = test_dir / "events.log",
+            .thermodynamic_log_path = test_dir / "thermodynamics.csv",
+            .observation_log_path = test_dir / "observations.csv",
+            .pair_distribution_log_path = test_dir / "pair_distribution.csv",
+            .energy_histogram_log_path = test_dir / "energy_histogram.csv",
+            .snapshot_log_path = test_dir / "snapshots.csv"
+        },
+
+        .replica_count = replica_count
+    };
+
+    api::ReplicaEnsemble ensemble{parameters};
+
+    THEN("The schedule is split between the equilibration and the replicas")
+    {
+        REQUIRE(1 == ensemble.equilibration().parameters().schedule_parameters.size());
+        REQUIRE(replica_count == static_cast<int>(ensemble.replicas().size()));
+
+        for (int i = 0; i < replica_count; ++i)
+        {
+            auto replica_parameters = ensemble.replicas()[i].parameters();
+
+            REQUIRE(1 == replica_parameters.schedule_parameters.size());
+            REQUIRE(replica_parameters.redraw_initial_velocities);
+            REQUIRE(test_dir / "snapshots.csv" == replica_parameters.initial_snapshot_path);
+            REQUIRE(
+                test_dir / ("replica_" + std::to_string(i)) / "observations.csv"
+                    == replica_parameters.observation_log_path
+            );
+
+            // Every replica gets its own seed
+            for (int j = 0; j < i; ++j)
+            {
+                REQUIRE(
+                    ensemble.replicas()[j].parameters().random_seed
+                        != replica_parameters.random_seed
+                );
+            }
+        }
+    }
+
+    WHEN("I run the ensemble on a SimulationPool")
+    {
+        bool equilibrated = false;
+
+        {
+            api::SimulationPool pool{replica_count};
+            equilibrated = ensemble.run(pool);
+            pool.wait();
+        }
+
+        THEN("Every replica observes from the equilibrated state")
+        {
+            REQUIRE(equilibrated);
+
+            int observation_lines = observation_count + 1;
+
+            std::ifstream equilibrated_fin{test_dir / "snapshots.csv"};
+            auto equilibrated_snapshot = output::read_snapshot(equilibrated_fin);
+            REQUIRE(equilibrated_snapshot.has_value());
+
+            for (auto& replica : ensemble.replicas())
+            {
+                REQUIRE(replica.completed());
+                REQUIRE(
+                    observation_lines == count_lines(replica.parameters().observation_log_path)
+                );
+
+                // The replicas have evolved away from the equilibrated state
+                std::ifstream fin{replica.parameters().snapshot_log_path};
+                auto snapshot = output::read_snapshot(fin);
+                REQUIRE(snapshot.has_value());
+                REQUIRE_FALSE(
+                    snapshot->data->positions.isApprox(equilibrated_snapshot->data->positions)
+                );
+            }
+
+            // And they have done so independently
+            std::ifstream fin_0{ensemble.replicas()[0].parameters().snapshot_log_path};
+            std::ifstream fin_1{ensemble.replicas()[1].parameters().snapshot_log_path};
+            REQUIRE_FALSE(
+                output::read_snapshot(fin_0)->data->velocities.isApprox(
+                    output::read_snapshot(fin_1)->data->velocities
+                )
+            );
+        }
+    }
+
+    // Clean up
+    fs::remove_all(test_dir);
+}
@@ -0,0 +1,303 @@
+/**
+ * Test parallel tempering across a ladder of temperatures
+ */
+
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <src/cpp/lennardjonesium/physics/system_state.hpp>
+#include <src/cpp/lennardjonesium/physics/lennard_jones_force.hpp>
+#include <src/cpp/lennardjonesium/control/simulation_phase.hpp>
+#include <src/cpp/lennardjonesium/control/simulation_controller.hpp>
+#include <src/cpp/lennardjonesium/api/simulation.hpp>
+#include <src/cpp/lennardjonesium/api/simulation_pool.hpp>
+#include <src/cpp/lennardjonesium/api/replica_exchange.hpp>
+
+namespace fs = std::filesystem;
+
+inline int count_matching_lines(fs::path file_path, const std::string& pattern)
+{
+    std::ifstream fin{file_path};
+
+    std::string line;
+    int count = 0;
+
+    while (std::getline(fin, line))
+    {
+        if (line.find(pattern) != std::string::npos) {++count;}
+    }
+
+    fin.close();
+
+    return count;
+}
+
+SCENARIO("Exchanging configurations between a ladder of temperatures")
+{
+    // First set up the directory for writing simulation data files
+    fs::path test_dir{"test_replica_exchange"};
+    fs::create_directory(test_dir);
+
+    int observation_interval = 50;
+    int observation_count = 10;
+    int exchange_interval = 25;
+
+    auto simulation_parameters = api::Simulation::Parameters
+    {
+        .system_parameters = {
+            .temperature = 0.8,         // Replaced by each rung's temperature
+            .density = 0.8,
+            .particle_count = 50
+        },
+
+        .random_seed = 12345,
+
+        .force_parameters = physics::LennardJonesForce::Parameters
+        {
+            .cutoff_distance = 2.0
+        },
+
+        .time_delta = 0.005,
+
+        .schedule_parameters = {
+            {
+                "Observation Phase",
+                control::ObservationPhase::Parameters
+                {
+                    .tolerance = 10.0,
+                    .sample_size = 25,
+                    .observation_interval = observation_interval,
+                    .observation_count = observation_count
+                }
+            }
+        },
+
+        .event_log_path = test_dir / "events.log",
+        .thermodynamic_log_path = test_dir / "thermodynamics.csv",
+        .observation_log_path = test_dir / "observations.csv",
+        .pair_distribution_log_path = test_dir / "pair_distribution.csv",
+        .energy_histogram_log_path = test_dir / "energy_histogram.csv",
+        .snapshot_log_path = test_dir / "snapshots.csv"
+    };
+
+    GIVEN("A ladder of distinct temperatures")
+    {
+        std::vector<double> temperatures{0.8, 0.9, 1.0};
+
+        api::ReplicaExchange replica_exchange{{
+            .simulation_parameters = simulation_parameters,
+            .temperatures = temperatures,
+            .exchange_interval = exchange_interval
+        }};
+
+        THEN("Each rung runs at its own temperature and writes to its own directory")
+        {
+            REQUIRE(temperatures.size() == replica_exchange.rungs().size());
+
+            for (int i = 0; i < static_cast<int>(temperatures.size()); ++i)
+            {
+                auto parameters = replica_exchange.rungs()[i].parameters();
+
+                REQUIRE(temperatures[i] == parameters.system_parameters.temperature);
+                REQUIRE(
+                    test_dir / ("rung_" + std::to_string(i)) / "events.log"
+                        == parameters.event_log_path
+                );
+            }
+        }
+
+        WHEN("I run the ladder on a SimulationPool with too few threads")
+        {
+            api::SimulationPool pool{static_cast<int>(temperatures.size()) - 1};
+
+            THEN("The ladder refuses to run")
+            {
+                REQUIRE_THROWS_AS(replica_exchange.run(pool), std::invalid_argument);
+            }
+        }
+
+        WHEN("I run the ladder on a SimulationPool whose threads are busy with another job")
+        {
+            // The other job holds on to its thread until we let it go
+            std::promise<void> release;
+            auto released = release.get_future().share();
+
+            auto busy_parameters = simulation_parameters;
+            busy_parameters.exchange = {
+                .exchange = [released](physics::SystemState&)
+                    -> control::SimulationController::Exchange::event_type
+                {
+                    released.wait();
+                    return {};
+                },
+                .interval = exchange_interval
+            };
+
+            api::Simulation busy{busy_parameters};
+            api::SimulationPool pool{static_cast<int>(temperatures.size())};
+            pool.push(busy);
+
+            THEN("The ladder refuses to run")
+            {
+                REQUIRE_THROWS_AS(replica_exchange.run(pool), std::invalid_argument);
+            }
+
+            release.set_value();
+            pool.wait();
+        }
+
+        WHEN("I run the ladder on a SimulationPool")
+        {
+            {
+                api::SimulationPool pool{static_cast<int>(temperatures.size())};
+                replica_exchange.run(pool);
+                pool.wait();
+            }
+
+            THEN("Every rung completes and neighbors have attempted exchanges")
+            {
+                for (auto& rung : replica_exchange.rungs())
+                {
+                    REQUIRE(rung.completed());
+                    REQUIRE(
+                        observation_count + 1 == count_matching_lines(
+                            rung.parameters().observation_log_path, ""
+                        )
+                    );
+                }
+
+                // The rungs run in lockstep, so only neighbors are ever paired
+                auto swap_counts = replica_exchange.swap_counts();
+                REQUIRE(temperatures.size() - 1 == swap_counts.size());
+
+                int total_attempts = 0;
+
+                for (auto [pair, count] : swap_counts)
+                {
+                    REQUIRE(pair.first + 1 == pair.second);
+                    REQUIRE(count.attempted > 0);
+                    REQUIRE(count.accepted <= count.attempted);
+                    total_attempts += count.attempted;
+                }
+
+                // Each attempt is logged by both rungs involved
+                int logged_attempts = 0;
+
+                for (auto& rung : replica_exchange.rungs())
+                {
+                    logged_attempts += count_matching_lines(
+                        rung.parameters().event_log_path, "Replica exchange"
+                    );
+                }
+
+                REQUIRE(2 * total_attempts == logged_attempts);
+            }
+        }
+    }
+
+    GIVEN("A ladder whose rungs were killed between their checkpoints")
+    {
+        auto checkpoint_parameters = simulation_parameters;
+        checkpoint_parameters.checkpoint_interval = 100;
+        checkpoint_parameters.checkpoint_path = test_dir / "checkpoint.bin";
+
+        api::ReplicaExchange replica_exchange{{
+            .simulation_parameters = checkpoint_parameters,
+            .temperatures = {0.8, 0.9},
+            .exchange_interval = exchange_interval
+        }};
+
+        // Run each rung on its own, killing it after a different number of checkpoints
+        for (int i = 0; i < 2; ++i)
+        {
+            auto parameters = replica_exchange.rungs()[i].parameters();
+            fs::create_directories(parameters.checkpoint_path.parent_path());
+
+            parameters.exchange = {
+                .exchange = [calls = 0, i](physics::SystemState&) mutable
+                    -> control::SimulationController::Exchange::event_type
+                {
+                    if (++calls == 2 + i) {throw std::runtime_error{"Killed"};}
+                    return {};
+                },
+                .interval = 150
+            };
+
+            REQUIRE_THROWS_AS(api::Simulation{parameters}.run(), std::runtime_error);
+        }
+
+        auto& rungs = replica_exchange.rungs();
+        REQUIRE(rungs[0].resumable_time_step().has_value());
+        REQUIRE(rungs[1].resumable_time_step().has_value());
+        REQUIRE(rungs[0].resumable_time_step() != rungs[1].resumable_time_step());
+
+        WHEN("I run the ladder on a SimulationPool")
+        {
+            {
+                api::SimulationPool pool{2};
+                replica_exchange.run(pool);
+                pool.wait();
+            }
+
+            THEN("The whole ladder starts over")
+            {
+                auto count = replica_exchange.swap_counts().at({0, 1});
+                int logged_attempts = 0;
+
+                for (auto& rung : rungs)
+                {
+                    REQUIRE(rung.completed());
+                    REQUIRE_FALSE(fs::exists(rung.parameters().checkpoint_path));
+                    REQUIRE(
+                        observation_count + 1 == count_matching_lines(
+                            rung.parameters().observation_log_path, ""
+                        )
+                    );
+
+                    logged_attempts += count_matching_lines(
+                        rung.parameters().event_log_path, "Replica exchange"
+                    );
+                }
+
+                // Neither rung kept the statistics or the logs of its earlier run
+                REQUIRE(count.attempted > 0);
+                REQUIRE(2 * count.attempted == logged_attempts);
+            }
+        }
+    }
+
+    GIVEN("A ladder of equal temperatures")
+    {
+        api::ReplicaExchange replica_exchange{{
+            .simulation_parameters = simulation_parameters,
+            .temperatures = {0.9, 0.9},
+            .exchange_interval = exchange_interval
+        }};
+
+        WHEN("I run the ladder on a SimulationPool")
+        {
+            {
+                api::SimulationPool pool{2};
+                replica_exchange.run(pool);
+                pool.wait();
+            }
+
+            THEN("Every exchange is accepted")
+            {
+                auto count = replica_exchange.swap_counts().at({0, 1});
+
+                REQUIRE(count.attempted > 0);
+                REQUIRE(count.accepted == count.attempted);
+            }
+        }
+    }
+
+    // Clean up
+    fs::remove_all(test_dir);
+}
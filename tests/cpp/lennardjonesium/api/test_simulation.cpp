@@ -2,15 +2,21 @@
  * Test a complete run of a Simulation
  */
 
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
+#include <iterator>
+#include <stdexcept>
 #include <string>
 
 #include <catch2/catch.hpp>
 
 #include <src/cpp/lennardjonesium/physics/lennard_jones_force.hpp>
+#include <src/cpp/lennardjonesium/output/sweep_store.hpp>
+#include <src/cpp/lennardjonesium/output/compression.hpp>
 #include <src/cpp/lennardjonesium/control/simulation_phase.hpp>
 #include <src/cpp/lennardjonesium/api/simulation.hpp>
+#include <src/cpp/lennardjonesium/api/configuration.hpp>
 
 namespace fs = std::filesystem;
 
@@ -66,7 +72,9 @@ SCENARIO("Running a simulation from a Simulation object")
                     .tolerance = 10.0,
                     .sample_size = 25,
                     .observation_interval = observation_interval,
-                    .observation_count = observation_count
+                    .observation_count = observation_count,
+                    .pair_distribution_interval = 10,
+                    .energy_histogram_bin_width = 0.005
                 }
             }
         },
@@ -74,6 +82,8 @@ SCENARIO("Running a simulation from a Simulation object")
         .event_log_path = test_dir / "events.log",
         .thermodynamic_log_path = test_dir / "thermodynamics.csv",
         .observation_log_path = test_dir / "observations.csv",
+        .pair_distribution_log_path = test_dir / "pair_distribution.csv",
+        .energy_histogram_log_path = test_dir / "energy_histogram.csv",
         .snapshot_log_path = test_dir / "snapshots.csv"
     };
 
@@ -89,10 +99,13 @@ SCENARIO("Running a simulation from a Simulation object")
             int event_lines = observation_count + 2;
             int thermodynamic_lines = (observation_count * observation_interval) + 1;
             int observation_lines = observation_count + 1;
+            int pair_distribution_lines = parameters.pair_distribution_bins + 1;
 
             REQUIRE(event_lines == count_lines(parameters.event_log_path));
             REQUIRE(thermodynamic_lines == count_lines(parameters.thermodynamic_log_path));
             REQUIRE(observation_lines == count_lines(parameters.observation_log_path));
+            REQUIRE(pair_distribution_lines == count_lines(parameters.pair_distribution_log_path));
+            REQUIRE(1 < count_lines(parameters.energy_histogram_log_path));
         }
     }
 
@@ -105,13 +118,196 @@ SCENARIO("Running a simulation from a Simulation object")
             int event_lines = observation_count + 2;
             int thermodynamic_lines = (observation_count * observation_interval) + 1;
             int observation_lines = observation_count + 1;
+            int pair_distribution_lines = parameters.pair_distribution_bins + 1;
 
             REQUIRE(event_lines == count_lines(parameters.event_log_path));
             REQUIRE(thermodynamic_lines == count_lines(parameters.thermodynamic_log_path));
             REQUIRE(observation_lines == count_lines(parameters.observation_log_path));
+            REQUIRE(pair_distribution_lines == count_lines(parameters.pair_distribution_log_path));
+            REQUIRE(1 < count_lines(parameters.energy_histogram_log_path));
+        }
+    }
+
+    WHEN("I run the simulation without sampling the pair distribution")
+    {
+        auto unsampled_parameters = parameters;
+        std::get<control::ObservationPhase::Parameters>(
+            unsampled_parameters.schedule_parameters.front().second
+        ).pair_distribution_interval = 0;
+
+        fs::remove(parameters.pair_distribution_log_path);
+        api::Simulation{unsampled_parameters}.run();
+
+        THEN("The pair distribution log is not created")
+        {
+            REQUIRE_FALSE(fs::exists(parameters.pair_distribution_log_path));
+            REQUIRE(observation_count + 1 == count_lines(parameters.observation_log_path));
+        }
+    }
+
+    WHEN("I warm start the simulation from a snapshot file which does not exist")
+    {
+        auto warm_parameters = parameters;
+        warm_parameters.initial_snapshot_path = test_dir / "missing_snapshots.csv";
+        warm_parameters.initial_snapshot_density = 0.8;
+
+        api::Simulation{warm_parameters}.run();
+
+        THEN("The simulation starts from the lattice, and the events log says why")
+        {
+            std::ifstream fin{parameters.event_log_path};
+            std::string first_line;
+            std::getline(fin, first_line);
+
+            REQUIRE(first_line.starts_with("0: Warm start failed: Cannot open "));
+            REQUIRE(observation_count + 3 == count_lines(parameters.event_log_path));
+        }
+    }
+
+    WHEN("I run the simulation with an output store")
+    {
+        auto store_parameters = parameters;
+        store_parameters.store_path = test_dir / "store.bin";
+        store_parameters.store_run = "run";
+
+        api::Simulation{store_parameters}.run();
+
+        THEN("The logs other than the events are written to the store instead of to files")
+        {
+            auto store = output::SweepStore::open(store_parameters.store_path);
+
+            auto count_store_lines = [&](const char* log)
+            {
+                auto contents = store->read("run", log).value_or("");
+                return static_cast<int>(std::ranges::count(contents, '\n'));
+            };
+
+            REQUIRE_FALSE(store->read("run", "event_log").has_value());
+            REQUIRE(observation_count + 2 == count_lines(store_parameters.event_log_path));
+            REQUIRE(
+                (observation_count * observation_interval) + 1
+                    == count_store_lines("thermodynamic_log")
+            );
+            REQUIRE(observation_count + 1 == count_store_lines("observation_log"));
+            REQUIRE(1 < count_store_lines("snapshot_log"));
+
+            REQUIRE_FALSE(fs::exists(parameters.thermodynamic_log_path));
+        }
+    }
+
+    WHEN("I run the simulation with compressed logs")
+    {
+        auto compressed_parameters = parameters;
+        compressed_parameters.log_compression = {
+            .thermodynamic_log = output::Compression::zstd,
+            .snapshot_log = output::Compression::gzip
+        };
+
+        api::Simulation{compressed_parameters}.run();
+
+        THEN("The logs read back the same as uncompressed ones")
+        {
+            auto count_compressed_lines = [](const fs::path& path)
+            {
+                auto source = output::open_input(path);
+                std::string contents{std::istreambuf_iterator<char>{*source}, {}};
+                return static_cast<int>(std::ranges::count(contents, '\n'));
+            };
+
+            REQUIRE(
+                (observation_count * observation_interval) + 1
+                    == count_compressed_lines(parameters.thermodynamic_log_path)
+            );
+            REQUIRE(1 < count_compressed_lines(parameters.snapshot_log_path));
+            REQUIRE(observation_count + 1 == count_lines(parameters.observation_log_path));
+        }
+    }
+
+    WHEN("I run the simulation again after it was killed part way through")
+    {
+        auto checkpoint_parameters = parameters;
+        checkpoint_parameters.checkpoint_interval = 250;
+        checkpoint_parameters.checkpoint_path = test_dir / "checkpoint.bin";
+        checkpoint_parameters.trajectory_interval = 100;
+        checkpoint_parameters.trajectory_log_path = test_dir / "trajectory.bin";
+
+        auto read_file = [](const fs::path& path)
+        {
+            std::ifstream fin{path, std::ios::binary};
+            return std::string{std::istreambuf_iterator<char>{fin}, {}};
+        };
+
+        // The logs of the same run without interruption
+        api::Simulation{checkpoint_parameters}.run();
+
+        auto thermodynamics = read_file(parameters.thermodynamic_log_path);
+        auto snapshots = read_file(parameters.snapshot_log_path);
+        auto trajectory = read_file(checkpoint_parameters.trajectory_log_path);
+
+        // The exchange is attempted at the same point as the checkpoints, so we can use it to
+        // kill the run after the third checkpoint, when the logs have gone past it
+        auto interrupted_parameters = checkpoint_parameters;
+        interrupted_parameters.exchange = {
+            .exchange = [calls = 0](physics::SystemState&) mutable
+                -> control::SimulationController::Exchange::event_type
+            {
+                if (++calls == 3) {throw std::runtime_error{"Killed"};}
+                return {};
+            },
+            .interval = 300
+        };
+
+        REQUIRE_THROWS_AS(api::Simulation{interrupted_parameters}.run(), std::runtime_error);
+        REQUIRE(fs::exists(checkpoint_parameters.checkpoint_path));
+
+        api::Simulation{checkpoint_parameters}.run();
+
+        THEN("The logs are continued from the checkpoint, as if nothing had happened")
+        {
+            REQUIRE(thermodynamics == read_file(parameters.thermodynamic_log_path));
+            REQUIRE(snapshots == read_file(parameters.snapshot_log_path));
+            REQUIRE(trajectory == read_file(checkpoint_parameters.trajectory_log_path));
+            REQUIRE(observation_count + 1 == count_lines(parameters.observation_log_path));
+
+            // The resumed phase announces its start again
+            REQUIRE(observation_count + 3 == count_lines(parameters.event_log_path));
+
+            REQUIRE_FALSE(fs::exists(checkpoint_parameters.checkpoint_path));
         }
     }
 
     // Clean up
     fs::remove_all(test_dir);
 }
+
+SCENARIO("Creating a Simulation from a Configuration")
+{
+    GIVEN("A Configuration with a misspelled option")
+    {
+        auto field = GENERATE(
+            &api::Configuration::Filepaths::thermodynamic_log_format,
+            &api::Configuration::Filepaths::thermodynamic_log_reduction,
+            &api::Configuration::Filepaths::log_queue_policy,
+            &api::Configuration::Filepaths::output_backend,
+            &api::Configuration::Filepaths::thermodynamic_log_compression
+        );
+
+        api::Configuration configuration;
+        configuration.filepaths.*field = "unknown";
+
+        THEN("It is rejected rather than replaced by the default")
+        {
+            REQUIRE_THROWS_AS(api::make_simulation(configuration), std::invalid_argument);
+        }
+    }
+
+    GIVEN("The default Configuration")
+    {
+        api::Configuration configuration;
+
+        THEN("It is accepted")
+        {
+            REQUIRE(api::make_simulation(configuration) != nullptr);
+        }
+    }
+}
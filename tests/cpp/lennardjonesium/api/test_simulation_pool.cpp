@@ -7,6 +7,7 @@
 #include <string>
 #include <vector>
 #include <ranges>
+#include <algorithm>
 
 #include <catch2/catch.hpp>
 
@@ -81,6 +82,8 @@ SCENARIO("Running a pool of simulations")
     fs::path event_log_path = "events.log";
     fs::path thermodynamic_log_path = "thermodynamics.csv";
     fs::path observation_log_path = "observations.csv";
+    fs::path pair_distribution_log_path = "pair_distribution.csv";
+    fs::path energy_histogram_log_path = "energy_histogram.csv";
     fs::path snapshot_log_path = "snapshots.csv";
 
     // Now prepare Simulations with multiple different subdirectories for output
@@ -93,13 +96,15 @@ SCENARIO("Running a pool of simulations")
         parameters.event_log_path = subdirectory / event_log_path;
         parameters.thermodynamic_log_path = subdirectory / thermodynamic_log_path;
         parameters.observation_log_path = subdirectory / observation_log_path;
+        parameters.pair_distribution_log_path = subdirectory / pair_distribution_log_path;
+        parameters.energy_histogram_log_path = subdirectory / energy_histogram_log_path;
         parameters.snapshot_log_path = subdirectory / snapshot_log_path;
 
         simulations.emplace_back(parameters);
     }
 
     // Finally, create the SimulationPool
-    api::SimulationPool simulation_pool(thread_count);
+    api::SimulationPool simulation_pool(thread_count, true);
 
     WHEN("I push all the jobs onto the queue and wait for them to finish")
     {
@@ -123,6 +128,20 @@ SCENARIO("Running a pool of simulations")
                 REQUIRE(observation_lines == count_lines(s.parameters().observation_log_path));
             }
         }
+
+        THEN("Every job is reported as completed exactly once")
+        {
+            auto completed = simulation_pool.take_completed();
+
+            REQUIRE(completed.size() == simulations.size());
+
+            for (auto& s : simulations)
+            {
+                REQUIRE(std::ranges::count(completed, &s) == 1);
+            }
+
+            REQUIRE(simulation_pool.take_completed().empty());
+        }
     }
 
     // Clean up
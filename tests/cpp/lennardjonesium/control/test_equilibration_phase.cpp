@@ -170,6 +170,48 @@ SCENARIO("Equilibration Phase decision-making")
         }
     }
 
+    WHEN("I enable the drift test and measure a constant, correct temperature")
+    {
+        state | physics::set_temperature(system_parameters.temperature) | measurement;
+
+        auto drift_parameters = equilibration_parameters;
+        drift_parameters.drift_threshold = 2.0;
+        drift_parameters.drift_block_count = 5;
+
+        control::EquilibrationPhase drift_phase{
+            "Drift Test Equilibration Phase",
+            system_parameters,
+            drift_parameters
+        };
+
+        drift_phase.set_start_time(start_time);
+
+        // Each block holds sample_size measurements, and the test is first made when
+        // drift_block_count blocks are complete, after which it must pass drift_pass_count times
+        int stationary_time =
+            (drift_parameters.drift_block_count + drift_parameters.drift_pass_count - 1)
+                * drift_parameters.sample_size - 1;
+
+        for (int time_step : std::views::iota(0, stationary_time))
+        {
+            drift_phase.evaluate(command_queue, start_time + time_step, measurement);
+
+            REQUIRE(1 == command_queue.size());
+            REQUIRE(std::holds_alternative<control::AdvanceTime>(command_queue.front()));
+
+            command_queue.pop();
+        }
+
+        drift_phase.evaluate(command_queue, start_time + stationary_time, measurement);
+
+        THEN("The phase completes as soon as enough consecutive blocks show no drift")
+        {
+            REQUIRE(stationary_time < drift_parameters.steady_state_time);
+            REQUIRE(1 == command_queue.size());
+            REQUIRE(std::holds_alternative<control::PhaseComplete>(command_queue.front()));
+        }
+    }
+
     WHEN("I measure the wrong temperature at timeout")
     {
         state | physics::set_temperature(system_parameters.temperature * 2) | measurement;
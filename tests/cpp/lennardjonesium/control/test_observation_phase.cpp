@@ -2,6 +2,7 @@
  * Test ObservationPhase
  */
 
+#include <memory>
 #include <ranges>
 #include <string>
 #include <variant>
@@ -14,6 +15,7 @@
 #include <src/cpp/lennardjonesium/physics/transformations.hpp>
 #include <src/cpp/lennardjonesium/physics/measurements.hpp>
 #include <src/cpp/lennardjonesium/physics/observation.hpp>
+#include <src/cpp/lennardjonesium/physics/pair_distribution.hpp>
 #include <src/cpp/lennardjonesium/control/command_queue.hpp>
 #include <src/cpp/lennardjonesium/control/simulation_phase.hpp>
 
@@ -39,7 +41,8 @@ SCENARIO("Observation Phase decision-making")
     control::ObservationPhase::Parameters observation_parameters{
         .sample_size {2},
         .observation_interval {10},
-        .observation_count {10}
+        .observation_count {10},
+        .energy_histogram_bin_width {0.005}
     };
 
     int start_time{37};
@@ -140,11 +143,82 @@ SCENARIO("Observation Phase decision-making")
 
         THEN("The final list of commands should indicate success")
         {
-            REQUIRE(2 == command_queue.size());
+            REQUIRE(3 == command_queue.size());
             REQUIRE(std::holds_alternative<control::RecordObservation>(command_queue.front()));
             command_queue.pop();
+            REQUIRE(std::holds_alternative<control::RecordEnergyHistogram>(command_queue.front()));
+            command_queue.pop();
             REQUIRE(std::holds_alternative<control::PhaseComplete>(command_queue.front()));
         }
+
+        THEN("The energy histogram holds every measurement in a single bin")
+        {
+            command_queue.pop();
+            auto histogram = std::get<control::RecordEnergyHistogram>(
+                command_queue.front()
+            ).energy_histogram;
+
+            REQUIRE(total_time + 1 == histogram.sample_count());
+            REQUIRE(1 == histogram.counts.size());
+            REQUIRE(Approx(system_parameters.temperature) == histogram.temperature);
+            REQUIRE(
+                Approx(measurement.result().potential_energy) == histogram.potential_energies[0]
+            );
+            REQUIRE(Approx(measurement.result().virial) == histogram.virials[0]);
+        }
+    }
+
+    WHEN("I set error tolerances and the observed quantities do not fluctuate")
+    {
+        state | physics::set_temperature(system_parameters.temperature) | measurement;
+
+        auto early_stopping_parameters = observation_parameters;
+        early_stopping_parameters.energy_error_tolerance = 0.01;
+        early_stopping_parameters.pressure_error_tolerance = 0.01;
+        early_stopping_parameters.minimum_observation_count = 3;
+
+        control::ObservationPhase early_stopping_phase{
+            "Early Stopping Observation Phase",
+            system_parameters,
+            early_stopping_parameters
+        };
+
+        early_stopping_phase.set_start_time(start_time);
+
+        // Run until the phase completes, counting the Observations it records
+        int recorded_observations = 0;
+        bool complete = false;
+        int last_time_step = start_time;
+
+        for (int time_step : std::views::iota(0, 2 * observation_parameters.observation_interval
+                * observation_parameters.observation_count))
+        {
+            last_time_step = start_time + time_step;
+            early_stopping_phase.evaluate(command_queue, last_time_step, measurement);
+
+            while (!command_queue.empty())
+            {
+                auto& command = command_queue.front();
+                if (std::holds_alternative<control::RecordObservation>(command))
+                {
+                    ++recorded_observations;
+                }
+                if (std::holds_alternative<control::PhaseComplete>(command)) {complete = true;}
+                command_queue.pop();
+            }
+
+            if (complete) {break;}
+        }
+
+        THEN("The phase completes after the minimum number of Observations")
+        {
+            REQUIRE(complete);
+            REQUIRE(early_stopping_parameters.minimum_observation_count == recorded_observations);
+            REQUIRE(
+                start_time + early_stopping_parameters.minimum_observation_count
+                    * early_stopping_parameters.observation_interval == last_time_step
+            );
+        }
     }
 
     WHEN("I measure an average temperature that is outside the desired range")
@@ -176,4 +250,47 @@ SCENARIO("Observation Phase decision-making")
             REQUIRE(std::holds_alternative<control::AbortSimulation>(command_queue.front()));
         }
     }
+
+    WHEN("I sample the pair distribution and then measure a temperature outside the range")
+    {
+        auto pair_distribution = std::make_shared<physics::PairDistributionHistogram>(
+            system_parameters, 2.0, 10
+        );
+
+        auto sampling_parameters = observation_parameters;
+        sampling_parameters.pair_distribution_interval = 10;
+
+        control::ObservationPhase sampling_phase{
+            "Sampling Observation Phase",
+            system_parameters,
+            sampling_parameters,
+            pair_distribution
+        };
+
+        sampling_phase.set_start_time(start_time);
+
+        pair_distribution->add(1.0);
+        pair_distribution->complete_sample();
+
+        state | physics::set_temperature(system_parameters.temperature * 2) | measurement;
+
+        // Two measurements are needed for an Observation
+        for (int offset : {-1, 0})
+        {
+            command_queue = {};
+            sampling_phase.evaluate(
+                command_queue,
+                start_time + observation_parameters.observation_interval + offset,
+                measurement
+            );
+        }
+
+        THEN("The pair distribution is recorded before the simulation is aborted")
+        {
+            REQUIRE(2 == command_queue.size());
+            REQUIRE(std::holds_alternative<control::RecordPairDistribution>(command_queue.front()));
+            command_queue.pop();
+            REQUIRE(std::holds_alternative<control::AbortSimulation>(command_queue.front()));
+        }
+    }
 }
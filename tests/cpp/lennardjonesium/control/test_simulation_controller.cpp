@@ -2,15 +2,20 @@
  * Test the SimulationController class
  */
 
+#include <algorithm>
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
+#include <random>
 #include <sstream>
 #include <utility>
 #include <memory>
+#include <vector>
 
 #include <catch2/catch.hpp>
 #include <Eigen/Dense>
 
+#include <src/cpp/lennardjonesium/physics/lennard_jones_force.hpp>
 #include <src/cpp/lennardjonesium/engine/force_calculation.hpp>
 #include <src/cpp/lennardjonesium/engine/boundary_condition.hpp>
 #include <src/cpp/lennardjonesium/engine/initial_condition.hpp>
@@ -56,15 +61,27 @@ SCENARIO("SimulationController correctly interprets commands")
         
         fs::path observation_log_path = test_dir / "observations.csv";
         std::ofstream observation_log{observation_log_path};
+        
+        fs::path pair_distribution_log_path = test_dir / "pair_distribution.csv";
+        std::ofstream pair_distribution_log{pair_distribution_log_path};
+        
+        fs::path energy_histogram_log_path = test_dir / "energy_histogram.csv";
+        std::ofstream energy_histogram_log{energy_histogram_log_path};
     
         fs::path snapshot_log_path = test_dir / "snapshots.csv";
         std::ofstream snapshot_log{snapshot_log_path};
 
+        fs::path trajectory_log_path = test_dir / "trajectory.bin";
+        std::ofstream trajectory_log{trajectory_log_path, std::ios::binary};
+
         output::Logger::Streams streams = {
             .event_log = event_log,
             .thermodynamic_log = thermodynamic_log,
             .observation_log = observation_log,
-            .snapshot_log = snapshot_log
+            .pair_distribution_log = pair_distribution_log,
+            .energy_histogram_log = energy_histogram_log,
+            .snapshot_log = snapshot_log,
+            .trajectory_log = trajectory_log
         };
 
         // Set up the logger
@@ -93,7 +110,10 @@ SCENARIO("SimulationController correctly interprets commands")
         event_log.close();
         thermodynamic_log.close();
         observation_log.close();
+        pair_distribution_log.close();
+        energy_histogram_log.close();
         snapshot_log.close();
+        trajectory_log.close();
 
         WHEN("I read the events log back in")
         {
@@ -122,3 +142,333 @@ SCENARIO("SimulationController correctly interprets commands")
     // Clean up
     fs::remove_all(test_dir);
 }
+
+SCENARIO("SimulationController restarts the trajectory after an accepted exchange")
+{
+    // A phase which counts how often its trajectory was restarted
+    class RestartCountingPhase : public mock::SuccessPhase
+    {
+        public:
+            virtual void restart_trajectory() override {++*restarts_;}
+
+            RestartCountingPhase(std::shared_ptr<int> restarts)
+                : mock::SuccessPhase{"RestartCountingPhase"}, restarts_{restarts}
+            {}
+
+        private:
+            std::shared_ptr<int> restarts_;
+    };
+
+    tools::SystemParameters system_parameters{
+        .temperature {1.5},
+        .density {1.0},
+        .particle_count {4}
+    };
+
+    engine::InitialCondition initial_condition(system_parameters);
+
+    std::ostringstream event_log;
+    std::ostringstream thermodynamic_log;
+    std::ostringstream observation_log;
+    std::ostringstream pair_distribution_log;
+    std::ostringstream energy_histogram_log;
+    std::ostringstream snapshot_log;
+    std::ostringstream trajectory_log;
+
+    output::Logger logger{output::Logger::Streams{
+        .event_log = event_log,
+        .thermodynamic_log = thermodynamic_log,
+        .observation_log = observation_log,
+        .pair_distribution_log = pair_distribution_log,
+        .energy_histogram_log = energy_histogram_log,
+        .snapshot_log = snapshot_log,
+        .trajectory_log = trajectory_log
+    }};
+
+    GIVEN("An exchange which accepts every other attempt")
+    {
+        auto restarts = std::make_shared<int>(0);
+
+        control::SimulationController::Schedule schedule;
+        schedule.push(std::make_unique<RestartCountingPhase>(restarts));
+
+        control::SimulationController simulation(
+            engine::Integrator::Builder{0.25}.bounding_box(initial_condition.bounding_box())
+                .build(),
+            std::move(schedule), logger
+        );
+
+        int attempts = 0;
+
+        simulation.set_exchange({
+            .exchange = [&attempts](physics::SystemState&)
+                -> control::SimulationController::Exchange::event_type
+            {
+                ++attempts;
+                return output::ReplicaExchangeEvent{
+                    .partner_temperature = 1.5,
+                    .acceptance_probability = 0.5,
+                    .accepted = (attempts % 2 == 0),
+                    .accepted_count = attempts / 2,
+                    .attempted_count = attempts
+                };
+            },
+            .interval = 1
+        });
+
+        WHEN("I run the simulation")
+        {
+            physics::SystemState state = initial_condition.system_state();
+            state | simulation;
+
+            THEN("The phase restarts its trajectory after each accepted exchange")
+            {
+                REQUIRE(attempts > 1);
+                REQUIRE(*restarts == attempts / 2);
+            }
+        }
+    }
+
+    logger.close();
+}
+
+SCENARIO("SimulationController resumes from checkpoints")
+{
+    namespace fs = std::filesystem;
+
+    fs::path test_dir{"test_simulation_controller_checkpoint"};
+    fs::create_directory(test_dir);
+
+    fs::path checkpoint_path = test_dir / "checkpoint.bin";
+
+    tools::SystemParameters system_parameters{
+        .temperature {0.8},
+        .density {0.8},
+        .particle_count {108}
+    };
+
+    engine::InitialCondition initial_condition(system_parameters);
+    physics::LennardJonesForce force({2.5});
+
+    // Everything is recreated for each run, as if the program had been started again
+    auto make_integrator = [&]()
+    {
+        return engine::Integrator::Builder{0.005}
+            .bounding_box(initial_condition.bounding_box())
+            .short_range_force(force)
+            .build();
+    };
+
+    auto make_schedule = [&]()
+    {
+        control::SimulationController::Schedule schedule;
+
+        schedule.push(std::make_unique<control::EquilibrationPhase>(
+            "Equilibration", system_parameters, control::EquilibrationPhase::Parameters{
+                .tolerance = 0.05,
+                .sample_size = 20,
+                .adjustment_interval = 50,
+                .steady_state_time = 200,
+                .timeout = 2000
+            }
+        ));
+
+        schedule.push(std::make_unique<control::ObservationPhase>(
+            "Observation", system_parameters, control::ObservationPhase::Parameters{
+                .tolerance = 0.5,
+                .sample_size = 20,
+                .observation_interval = 50,
+                .observation_count = 4
+            }
+        ));
+
+        return schedule;
+    };
+
+    // The contents of the logs do not matter here
+    std::ostringstream event_log;
+    std::ostringstream thermodynamic_log;
+    std::ostringstream observation_log;
+    std::ostringstream pair_distribution_log;
+    std::ostringstream energy_histogram_log;
+    std::ostringstream snapshot_log;
+    std::ostringstream trajectory_log;
+
+    output::Logger logger{output::Logger::Streams{
+        .event_log = event_log,
+        .thermodynamic_log = thermodynamic_log,
+        .observation_log = observation_log,
+        .pair_distribution_log = pair_distribution_log,
+        .energy_histogram_log = energy_histogram_log,
+        .snapshot_log = snapshot_log,
+        .trajectory_log = trajectory_log
+    }};
+
+    GIVEN("A simulation which wrote checkpoints as it ran")
+    {
+        control::SimulationController simulation(
+            make_integrator(), make_schedule(), logger,
+            control::SimulationController::Checkpointing{.path = checkpoint_path, .interval = 75}
+        );
+
+        physics::SystemState final_state = initial_condition.system_state();
+        final_state | simulation;
+
+        REQUIRE(fs::exists(checkpoint_path));
+
+        WHEN("I resume a new simulation from the last checkpoint")
+        {
+            control::SimulationController resumed_simulation(
+                make_integrator(), make_schedule(), logger
+            );
+
+            physics::SystemState state = initial_condition.system_state();
+
+            std::ifstream checkpoint{checkpoint_path, std::ios::binary};
+            bool restored = resumed_simulation.restore(checkpoint, state);
+
+            THEN("It finishes in exactly the same state")
+            {
+                REQUIRE(restored);
+                REQUIRE(state.time < final_state.time);
+
+                state | resumed_simulation;
+
+                REQUIRE(state.time == final_state.time);
+                REQUIRE(state.positions == final_state.positions);
+                REQUIRE(state.velocities == final_state.velocities);
+            }
+        }
+
+        WHEN("I try to restore a checkpoint into a state of a different size")
+        {
+            control::SimulationController resumed_simulation(
+                make_integrator(), make_schedule(), logger
+            );
+
+            physics::SystemState state{27};
+
+            std::ifstream checkpoint{checkpoint_path, std::ios::binary};
+
+            THEN("The checkpoint is rejected and the state is left alone")
+            {
+                REQUIRE_FALSE(resumed_simulation.restore(checkpoint, state));
+                REQUIRE(state.particle_count() == 27);
+            }
+        }
+
+        WHEN("I try to restore a checkpoint into a simulation with different parameters")
+        {
+            control::SimulationController resumed_simulation(
+                make_integrator(), make_schedule(), logger,
+                control::SimulationController::Checkpointing{
+                    .path = checkpoint_path, .interval = 75, .parameter_hash = 1
+                }
+            );
+
+            physics::SystemState state = initial_condition.system_state();
+            auto initial_time = state.time;
+
+            std::ifstream checkpoint{checkpoint_path, std::ios::binary};
+
+            THEN("The checkpoint is rejected and the state is left alone")
+            {
+                REQUIRE_FALSE(resumed_simulation.restore(checkpoint, state));
+                REQUIRE(state.time == initial_time);
+            }
+        }
+    }
+
+    GIVEN("A simulation which draws random numbers for its exchanges")
+    {
+        // A mock exchange which records its draws, and saves its generator in the checkpoints
+        auto make_exchange = [](std::mt19937& engine, std::vector<std::uint32_t>& draws)
+        {
+            return control::SimulationController::Exchange{
+                .exchange = [&engine, &draws](physics::SystemState&)
+                    -> control::SimulationController::Exchange::event_type
+                {
+                    draws.push_back(engine());
+                    return {};
+                },
+                .leave = {},
+                .save = [&engine](std::ostream& out) {out << engine;},
+                .restore = [&engine](std::istream& in) {return static_cast<bool>(in >> engine);},
+                .interval = 75
+            };
+        };
+
+        std::mt19937 engine{1};
+        std::vector<std::uint32_t> draws;
+
+        control::SimulationController simulation(
+            make_integrator(), make_schedule(), logger,
+            control::SimulationController::Checkpointing{.path = checkpoint_path, .interval = 75}
+        );
+        simulation.set_exchange(make_exchange(engine, draws));
+
+        physics::SystemState final_state = initial_condition.system_state();
+        final_state | simulation;
+
+        WHEN("I resume a new simulation from the last checkpoint")
+        {
+            std::mt19937 resumed_engine{2};
+            std::vector<std::uint32_t> resumed_draws;
+
+            control::SimulationController resumed_simulation(
+                make_integrator(), make_schedule(), logger
+            );
+            resumed_simulation.set_exchange(make_exchange(resumed_engine, resumed_draws));
+
+            physics::SystemState state = initial_condition.system_state();
+
+            std::ifstream checkpoint{checkpoint_path, std::ios::binary};
+            bool restored = resumed_simulation.restore(checkpoint, state);
+
+            THEN("It continues the same sequence of random numbers")
+            {
+                REQUIRE(restored);
+
+                state | resumed_simulation;
+
+                REQUIRE_FALSE(resumed_draws.empty());
+                REQUIRE(resumed_draws.size() < draws.size());
+                REQUIRE(std::equal(
+                    resumed_draws.begin(), resumed_draws.end(),
+                    draws.end() - static_cast<std::ptrdiff_t>(resumed_draws.size())
+                ));
+            }
+        }
+    }
+
+    GIVEN("A simulation whose checkpoints cannot be written")
+    {
+        control::SimulationController simulation(
+            make_integrator(), make_schedule(), logger,
+            control::SimulationController::Checkpointing{
+                .path = test_dir / "missing" / "checkpoint.bin", .interval = 75
+            }
+        );
+
+        physics::SystemState state = initial_condition.system_state();
+        state | simulation;
+
+        WHEN("I look at the events")
+        {
+            logger.close();
+
+            THEN("The failures were reported, and nothing was left behind")
+            {
+                auto events = event_log.str();
+                REQUIRE(events.find("Checkpoint failed: cannot write") != std::string::npos);
+                REQUIRE_FALSE(fs::exists(test_dir / "missing"));
+                REQUIRE(simulation.completed());
+            }
+        }
+    }
+
+    logger.close();
+
+    // Clean up
+    fs::remove_all(test_dir);
+}
@@ -2,6 +2,7 @@
  * Test the InitialCondition class
  */
 
+#include <cmath>
 #include <random>
 
 #include <catch2/catch.hpp>
@@ -56,3 +57,78 @@ SCENARIO("Creating initial conditions with specified properties")
         }
     }
 }
+
+SCENARIO("Warm-starting initial conditions from a reference state")
+{
+    tools::SystemParameters reference_parameters{
+        .temperature{0.5},
+        .density{1.0},
+        .particle_count{108}
+    };
+
+    engine::InitialCondition reference{reference_parameters, 42};
+    physics::SystemState reference_state = reference.system_state();
+
+    WHEN("I warm-start at a lower density and a higher temperature")
+    {
+        tools::SystemParameters system_parameters{
+            .temperature{0.9},
+            .density{0.8},
+            .particle_count{108}
+        };
+
+        engine::InitialCondition initial_condition{
+            system_parameters, reference_state, reference_parameters.density
+        };
+
+        tools::BoundingBox bounding_box = initial_condition.bounding_box();
+        physics::SystemState system_state = initial_condition.system_state();
+
+        THEN("The bounding box has the new density")
+        {
+            REQUIRE(Approx(system_parameters.density) ==
+                static_cast<double>(system_parameters.particle_count) / bounding_box.volume()
+            );
+        }
+
+        THEN("The positions are rescaled into the new bounding box")
+        {
+            double scale_factor = std::cbrt(1.25);
+
+            REQUIRE(system_state.positions.isApprox(scale_factor * reference_state.positions));
+
+            Eigen::Array4d extent = bounding_box.array();
+            for (int i = 0; i < system_state.particle_count(); ++i)
+            {
+                Eigen::Array4d position = system_state.positions.col(i).array();
+                REQUIRE((position >= 0).all());
+                REQUIRE((position.head<3>() < extent.head<3>()).all());
+            }
+        }
+
+        THEN("The velocities have the new temperature and no net momentum")
+        {
+            REQUIRE(Approx(system_parameters.temperature) == physics::temperature(system_state));
+            REQUIRE(Approx(1.0) == 1.0 + physics::total_momentum(system_state).squaredNorm());
+            REQUIRE(system_state.velocities.bottomRows<1>().isZero());
+        }
+    }
+
+    WHEN("I warm-start at the same state point, but redraw the velocities")
+    {
+        engine::InitialCondition initial_condition{
+            reference_parameters, reference_state, reference_parameters.density, 7, true
+        };
+
+        physics::SystemState system_state = initial_condition.system_state();
+
+        THEN("The positions are kept, but the velocities are new")
+        {
+            REQUIRE(system_state.positions.isApprox(reference_state.positions));
+            REQUIRE_FALSE(system_state.velocities.isApprox(reference_state.velocities));
+            REQUIRE(
+                Approx(reference_parameters.temperature) == physics::temperature(system_state)
+            );
+        }
+    }
+}
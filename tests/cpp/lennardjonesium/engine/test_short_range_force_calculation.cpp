@@ -161,6 +161,34 @@ SCENARIO("Computing forces between particles")
                 REQUIRE(Approx(expected_potential) == state.potential_energy);
                 REQUIRE(Approx(expected_virial) == state.virial);
             }
+
+            THEN("The virial tensor is left alone unless it is asked for")
+            {
+                state | force_calculation;
+
+                REQUIRE(state.virial_tensor.isZero());
+            }
+
+            THEN("The virial tensor is diagonal, with trace equal to the virial")
+            {
+                engine::ShortRangeForceCalculation tensor_force_calculation(
+                    short_range_force,
+                    std::make_unique<engine::CellListParticlePairFilter>(
+                        bounding_box, cutoff_distance
+                    ),
+                    nullptr,
+                    true
+                );
+
+                state | tensor_force_calculation;
+
+                Eigen::Matrix4d expected_virial_tensor = Eigen::Matrix4d::Zero();
+                expected_virial_tensor(0, 0) = expected_virial / 2;
+                expected_virial_tensor(1, 1) = expected_virial / 2;
+
+                REQUIRE(expected_virial_tensor.isApprox(state.virial_tensor));
+                REQUIRE(Approx(state.virial) == state.virial_tensor.trace());
+            }
         }
     }
 }
@@ -0,0 +1,77 @@
+/**
+ * Test that compressed logs can be read back transparently
+ */
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <boost/iostreams/device/file.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <src/cpp/lennardjonesium/output/compression.hpp>
+
+SCENARIO("Compressing and decompressing logs")
+{
+    namespace fs = std::filesystem;
+
+    fs::path test_dir{"test_compression"};
+    fs::create_directory(test_dir);
+
+    std::string contents;
+    for (int line = 0; line < 1000; ++line)
+    {
+        contents += std::to_string(line) + ",0.5,1.25,-3.75\n";
+    }
+
+    auto write_file = [&](const fs::path& path, output::Compression compression)
+    {
+        boost::iostreams::filtering_ostream stream;
+        output::push_compressor(stream, compression);
+        stream.push(boost::iostreams::file_sink{path.string(), std::ios::binary});
+
+        stream << contents;
+        stream.reset();
+    };
+
+    auto read_file = [](const fs::path& path)
+    {
+        auto source = output::open_input(path);
+        return std::string{std::istreambuf_iterator<char>{*source}, {}};
+    };
+
+    auto compression = GENERATE(
+        output::Compression::none, output::Compression::gzip, output::Compression::zstd
+    );
+
+    GIVEN("A log written with a given compression")
+    {
+        fs::path path = test_dir / "log.csv";
+        write_file(path, compression);
+
+        THEN("open_input() reads back the original contents")
+        {
+            REQUIRE(read_file(path) == contents);
+        }
+
+        THEN("The compression can be recognized, and the log is smaller if it is compressed")
+        {
+            std::ifstream fin{path, std::ios::binary};
+            std::string data{std::istreambuf_iterator<char>{fin}, {}};
+
+            REQUIRE(output::detect_compression(data.data(), data.size()) == compression);
+            REQUIRE(output::decompress(data) == contents);
+
+            if (compression != output::Compression::none)
+            {
+                REQUIRE(data.size() < contents.size() / 4);
+            }
+        }
+    }
+
+    // Clean up
+    fs::remove_all(test_dir);
+}
@@ -2,15 +2,18 @@
  * Test the Dispatcher to verify it sends to the appropriate destinations
  */
 
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
+#include <string>
 
 #include <catch2/catch.hpp>
 #include <Eigen/Dense>
 
 #include <src/cpp/lennardjonesium/physics/measurements.hpp>
 #include <src/cpp/lennardjonesium/physics/observation.hpp>
+#include <src/cpp/lennardjonesium/physics/pair_distribution.hpp>
 #include <src/cpp/lennardjonesium/output/log_message.hpp>
 #include <src/cpp/lennardjonesium/output/sinks.hpp>
 #include <src/cpp/lennardjonesium/output/dispatcher.hpp>
@@ -36,17 +39,40 @@ SCENARIO("Dispatcher sends to correct files")
     std::ofstream observation_log{observation_log_path};
     output::ObservationSink observation_sink{observation_log};
     
+    fs::path pair_distribution_log_path = test_dir / "pair_distribution.csv";
+    std::ofstream pair_distribution_log{pair_distribution_log_path};
+    output::PairDistributionSink pair_distribution_sink{pair_distribution_log};
+    
+    fs::path energy_histogram_log_path = test_dir / "energy_histogram.csv";
+    std::ofstream energy_histogram_log{energy_histogram_log_path};
+    output::EnergyHistogramSink energy_histogram_sink{energy_histogram_log};
+    
     fs::path snapshot_log_path = test_dir / "snapshots.csv";
     std::ofstream snapshot_log{snapshot_log_path};
     output::SystemSnapshotSink snapshot_sink{snapshot_log};
 
+    fs::path trajectory_log_path = test_dir / "trajectory.bin";
+    std::ofstream trajectory_log{trajectory_log_path, std::ios::binary};
+    output::TrajectorySink trajectory_sink{trajectory_log};
+
     event_sink.write_header();
     thermodynamic_sink.write_header();
     observation_sink.write_header();
+    pair_distribution_sink.write_header();
+    energy_histogram_sink.write_header();
     snapshot_sink.write_header();
+    trajectory_sink.write_header();
 
     // Set up the dispatcher
-    output::Dispatcher dispatcher{event_sink, thermodynamic_sink, observation_sink, snapshot_sink};
+    output::Dispatcher dispatcher{
+        event_sink,
+        thermodynamic_sink,
+        observation_sink,
+        pair_distribution_sink,
+        energy_histogram_sink,
+        snapshot_sink,
+        trajectory_sink
+    };
 
     GIVEN("The dispatcher has been sent a number of messages")
     {
@@ -71,10 +97,32 @@ SCENARIO("Dispatcher sends to correct files")
             .total_energy = 7.5,
             .pressure = 3.25,
             .specific_heat = 2.5,
-            .diffusion_coefficient = 5.25
+            .diffusion_coefficient = 5.25,
+            .temperature_error = 0.125,
+            .total_energy_error = 0.25,
+            .pressure_error = 0.5,
+            .specific_heat_error = 0.75,
+            .green_kubo_diffusion_coefficient = 5.5,
+            .shear_viscosity = 1.25,
+            .order_parameter = 0.875
+        };
+
+        physics::PairDistributionHistogram::Result pair_distribution{
+            .radii = {0.5, 1.5},
+            .pair_distribution = {0.25, 1.75},
+            .sample_count = 4
+        };
+
+        physics::EnergyHistogram energy_histogram{
+            .temperature = 0.5,
+            .density = 0.75,
+            .particle_count = 2,
+            .potential_energies = {-1.5, -0.5},
+            .virials = {2.25, 1.25},
+            .counts = {3, 1}
         };
 
-        output::SystemSnapshot snapshot{
+        output::SystemSnapshot::Data snapshot{
             .positions = Eigen::MatrixX4d{
                 {0, 1, 2, 0}, {3, 4, 5, 0}, {6, 7, 8, 0}
             }.transpose(),
@@ -98,7 +146,15 @@ SCENARIO("Dispatcher sends to correct files")
         dispatcher.send(6, output::RecordObservationEvent{});
         dispatcher.send(7, output::ThermodynamicData{thermodynamic_result});
         dispatcher.send(8, output::AbortSimulationEvent{abort_reason});
-        dispatcher.send(9, snapshot);
+        dispatcher.send(8, output::PairDistributionData{pair_distribution});
+        dispatcher.send(8, output::EnergyHistogramData{energy_histogram});
+        dispatcher.send(9, output::SystemSnapshot{snapshot});
+        dispatcher.send(9, output::TrajectoryFrame{{
+            .time = 4.5,
+            .box = Eigen::Array4d{10.0, 10.0, 10.0, 1.0},
+            .positions = snapshot.positions,
+            .velocities = snapshot.velocities
+        }});
 
         dispatcher.flush_all();
 
@@ -106,7 +162,10 @@ SCENARIO("Dispatcher sends to correct files")
         event_log.close();
         thermodynamic_log.close();
         observation_log.close();
+        pair_distribution_log.close();
+        energy_histogram_log.close();
         snapshot_log.close();
+        trajectory_log.close();
         
         WHEN("I read the events log back in")
         {
@@ -157,8 +216,46 @@ SCENARIO("Dispatcher sends to correct files")
             {
                 std::string expected = 
                     "TimeStep,Temperature,Density,TotalEnergy,Pressure,"
-                    "SpecificHeat,DiffusionCoefficient\n"
-                    "3,0.5,0.75,7.5,3.25,2.5,5.25\n";
+                    "SpecificHeat,DiffusionCoefficient,"
+                    "TemperatureError,TotalEnergyError,PressureError,SpecificHeatError,"
+                    "GreenKuboDiffusionCoefficient,ShearViscosity,OrderParameter\n"
+                    "3,0.5,0.75,7.5,3.25,2.5,5.25,0.125,0.25,0.5,0.75,5.5,1.25,0.875\n";
+                
+                REQUIRE(expected == contents.view());
+            }
+        }
+
+        WHEN("I read the pair distribution log back in")
+        {
+            std::ifstream fin{pair_distribution_log_path};
+            std::ostringstream contents;
+
+            contents << fin.rdbuf();
+
+            THEN("I get the expected file contents")
+            {
+                std::string expected = 
+                    "TimeStep,Radius,PairDistribution\n"
+                    "8,0.5,0.25\n"
+                    "8,1.5,1.75\n";
+                
+                REQUIRE(expected == contents.view());
+            }
+        }
+
+        WHEN("I read the energy histogram log back in")
+        {
+            std::ifstream fin{energy_histogram_log_path};
+            std::ostringstream contents;
+
+            contents << fin.rdbuf();
+
+            THEN("I get the expected file contents")
+            {
+                std::string expected = 
+                    "TimeStep,Temperature,Density,ParticleCount,PotentialEnergy,Virial,Count\n"
+                    "8,0.5,0.75,2,-1.5,2.25,3\n"
+                    "8,0.5,0.75,2,-0.5,1.25,1\n";
                 
                 REQUIRE(expected == contents.view());
             }
@@ -184,8 +281,87 @@ SCENARIO("Dispatcher sends to correct files")
                 REQUIRE(expected == contents.view());
             }
         }
+
+        WHEN("I check the size of the trajectory log")
+        {
+            auto size = fs::file_size(trajectory_log_path);
+
+            THEN("It holds the header and one frame with velocities")
+            {
+                // Header, then frame size, time step, time, box, positions (padded to a
+                // multiple of 4 bytes), velocities
+                REQUIRE(size == 24 + (4 + 4 + 8 + 24 + 3 * 3 * 2 + 2 + 3 * 3 * 4));
+            }
+        }
     }
 
     // Clean up
     fs::remove_all(test_dir);
 }
+
+SCENARIO("Dispatcher closes blocks of aggregated measurements at events")
+{
+    std::ostringstream event_log;
+    std::ostringstream thermodynamic_log;
+    std::ostringstream other_log;
+
+    output::EventSink event_sink{event_log};
+    output::ThermodynamicSink thermodynamic_sink{
+        thermodynamic_log,
+        output::ThermodynamicSink::Format::csv,
+        {.mode = output::ThermodynamicReduction::Mode::aggregate, .interval = 4}
+    };
+    output::ObservationSink observation_sink{other_log};
+    output::PairDistributionSink pair_distribution_sink{other_log};
+    output::EnergyHistogramSink energy_histogram_sink{other_log};
+    output::SystemSnapshotSink snapshot_sink{other_log};
+    output::TrajectorySink trajectory_sink{other_log};
+
+    output::Dispatcher dispatcher{
+        event_sink,
+        thermodynamic_sink,
+        observation_sink,
+        pair_distribution_sink,
+        energy_histogram_sink,
+        snapshot_sink,
+        trajectory_sink
+    };
+
+    auto send_measurement = [&dispatcher](int time_step)
+    {
+        physics::ThermodynamicMeasurement::Result thermodynamic_result{.time = 0.5 * time_step};
+        dispatcher.send(time_step, output::ThermodynamicData{thermodynamic_result});
+    };
+
+    GIVEN("Measurements interrupted by a temperature adjustment and the start of a phase")
+    {
+        // Blocks of 4 measurements, cut short after time steps 2 and 5
+        send_measurement(1);
+        send_measurement(2);
+        dispatcher.send(2, output::AdjustTemperatureEvent{
+            .measured_temperature = 0.25,
+            .target_temperature = 0.5
+        });
+        for (int time_step = 3; time_step <= 5; ++time_step) {send_measurement(time_step);}
+        dispatcher.send(5, output::PhaseStartEvent{"Next Phase"});
+        for (int time_step = 6; time_step <= 9; ++time_step) {send_measurement(time_step);}
+
+        dispatcher.flush_all();
+
+        WHEN("I read the thermodynamic log back in")
+        {
+            std::vector<std::string> rows;
+            std::istringstream contents{thermodynamic_log.str()};
+            for (std::string line; std::getline(contents, line);) {rows.push_back(line);}
+
+            THEN("Each block ends at an event, or after a full interval")
+            {
+                // TimeStep, Time, and SampleCount begin each row
+                REQUIRE(3 == rows.size());
+                REQUIRE(rows[0].starts_with("2,1,2,"));
+                REQUIRE(rows[1].starts_with("5,2.5,3,"));
+                REQUIRE(rows[2].starts_with("9,4.5,4,"));
+            }
+        }
+    }
+}
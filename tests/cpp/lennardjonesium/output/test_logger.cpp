@@ -2,19 +2,96 @@
  * Test the Logger and verify it sends everything to the appropriate files
  */
 
+#include <algorithm>
+#include <atomic>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <catch2/catch.hpp>
 #include <Eigen/Dense>
 
 #include <src/cpp/lennardjonesium/physics/measurements.hpp>
 #include <src/cpp/lennardjonesium/physics/observation.hpp>
+#include <src/cpp/lennardjonesium/physics/pair_distribution.hpp>
 #include <src/cpp/lennardjonesium/output/log_message.hpp>
 #include <src/cpp/lennardjonesium/output/logger.hpp>
 
+namespace
+{
+    // A stream buffer which holds up the Logger thread while it is closed, so that the queue
+    // fills up
+    class GatedBuffer : public std::stringbuf
+    {
+        public:
+            void close() {open_ = false;}
+            void open() {open_ = true; open_.notify_all();}
+
+        protected:
+            std::streamsize xsputn(const char* s, std::streamsize n) override
+            {
+                open_.wait(false);
+                return std::stringbuf::xsputn(s, n);
+            }
+
+            int_type overflow(int_type c) override
+            {
+                open_.wait(false);
+                return std::stringbuf::overflow(c);
+            }
+
+        private:
+            std::atomic<bool> open_{true};
+    };
+
+    // Log ThermodynamicData for time steps 1 to 20 while the Logger is held up, then an event at
+    // time step 21.  Returns the events log, and the time steps in the thermodynamic log.
+    std::pair<std::string, std::vector<int>> log_with_full_queue(output::LogQueue queue)
+    {
+        std::ostringstream event_log, observation_log, pair_distribution_log,
+            energy_histogram_log, snapshot_log, trajectory_log;
+
+        GatedBuffer thermodynamic_buffer;
+        std::ostream thermodynamic_log{&thermodynamic_buffer};
+
+        output::Logger logger{{
+            .event_log = event_log,
+            .thermodynamic_log = thermodynamic_log,
+            .observation_log = observation_log,
+            .pair_distribution_log = pair_distribution_log,
+            .energy_histogram_log = energy_histogram_log,
+            .snapshot_log = snapshot_log,
+            .trajectory_log = trajectory_log
+        }, output::ThermodynamicSink::Format::csv, queue};
+
+        thermodynamic_buffer.close();
+
+        for (int time_step = 1; time_step <= 20; ++time_step)
+        {
+            logger.log(time_step, output::ThermodynamicData{{.time = 0.5 * time_step}});
+        }
+
+        thermodynamic_buffer.open();
+        logger.log(21, output::PhaseCompleteEvent{"Test Phase"});
+        logger.close();
+
+        std::istringstream thermodynamic_rows{thermodynamic_buffer.str()};
+        std::string row;
+        std::vector<int> time_steps;
+
+        std::getline(thermodynamic_rows, row);
+        while (std::getline(thermodynamic_rows, row))
+        {
+            time_steps.push_back(std::stoi(row.substr(0, row.find(','))));
+        }
+
+        return {event_log.str(), time_steps};
+    }
+} // namespace
+
 SCENARIO("Size of a LogMessage")
 {
     REQUIRE(64 == sizeof(output::LogMessage));
@@ -38,14 +115,26 @@ SCENARIO("Logger sends to correct files")
     fs::path observation_log_path = test_dir / "observations.csv";
     std::ofstream observation_log{observation_log_path};
     
+    fs::path pair_distribution_log_path = test_dir / "pair_distribution.csv";
+    std::ofstream pair_distribution_log{pair_distribution_log_path};
+    
+    fs::path energy_histogram_log_path = test_dir / "energy_histogram.csv";
+    std::ofstream energy_histogram_log{energy_histogram_log_path};
+    
     fs::path snapshot_log_path = test_dir / "snapshots.csv";
     std::ofstream snapshot_log{snapshot_log_path};
 
+    fs::path trajectory_log_path = test_dir / "trajectory.bin";
+    std::ofstream trajectory_log{trajectory_log_path, std::ios::binary};
+
     output::Logger::Streams streams = {
         .event_log = event_log,
         .thermodynamic_log = thermodynamic_log,
         .observation_log = observation_log,
-        .snapshot_log = snapshot_log
+        .pair_distribution_log = pair_distribution_log,
+        .energy_histogram_log = energy_histogram_log,
+        .snapshot_log = snapshot_log,
+        .trajectory_log = trajectory_log
     };
 
     GIVEN("The logger has been sent a number of messages")
@@ -75,10 +164,32 @@ SCENARIO("Logger sends to correct files")
             .total_energy = 7.5,
             .pressure = 3.25,
             .specific_heat = 2.5,
-            .diffusion_coefficient = 5.25
+            .diffusion_coefficient = 5.25,
+            .temperature_error = 0.125,
+            .total_energy_error = 0.25,
+            .pressure_error = 0.5,
+            .specific_heat_error = 0.75,
+            .green_kubo_diffusion_coefficient = 5.5,
+            .shear_viscosity = 1.25,
+            .order_parameter = 0.875
         };
 
-        output::SystemSnapshot snapshot{
+        physics::PairDistributionHistogram::Result pair_distribution{
+            .radii = {0.5, 1.5},
+            .pair_distribution = {0.25, 1.75},
+            .sample_count = 4
+        };
+
+        physics::EnergyHistogram energy_histogram{
+            .temperature = 0.5,
+            .density = 0.75,
+            .particle_count = 2,
+            .potential_energies = {-1.5, -0.5},
+            .virials = {2.25, 1.25},
+            .counts = {3, 1}
+        };
+
+        output::SystemSnapshot::Data snapshot{
             .positions = Eigen::MatrixX4d{
                 {0, 1, 2, 0}, {3, 4, 5, 0}, {6, 7, 8, 0}
             }.transpose(),
@@ -103,7 +214,9 @@ SCENARIO("Logger sends to correct files")
         logger.log(6, output::RecordObservationEvent{});
         logger.log(7, output::ThermodynamicData{thermodynamic_result});
         logger.log(8, output::AbortSimulationEvent{abort_reason});
-        logger.log(9, snapshot);
+        logger.log(8, output::PairDistributionData{pair_distribution});
+        logger.log(8, output::EnergyHistogramData{energy_histogram});
+        logger.log(9, output::SystemSnapshot{snapshot});
 
         // Close the logger
         logger.close();
@@ -112,7 +225,10 @@ SCENARIO("Logger sends to correct files")
         event_log.close();
         thermodynamic_log.close();
         observation_log.close();
+        pair_distribution_log.close();
+        energy_histogram_log.close();
         snapshot_log.close();
+        trajectory_log.close();
         
         WHEN("I read the events log back in")
         {
@@ -163,8 +279,46 @@ SCENARIO("Logger sends to correct files")
             {
                 std::string expected = 
                     "TimeStep,Temperature,Density,TotalEnergy,Pressure,"
-                    "SpecificHeat,DiffusionCoefficient\n"
-                    "3,0.5,0.75,7.5,3.25,2.5,5.25\n";
+                    "SpecificHeat,DiffusionCoefficient,"
+                    "TemperatureError,TotalEnergyError,PressureError,SpecificHeatError,"
+                    "GreenKuboDiffusionCoefficient,ShearViscosity,OrderParameter\n"
+                    "3,0.5,0.75,7.5,3.25,2.5,5.25,0.125,0.25,0.5,0.75,5.5,1.25,0.875\n";
+                
+                REQUIRE(expected == contents.view());
+            }
+        }
+
+        WHEN("I read the pair distribution log back in")
+        {
+            std::ifstream fin{pair_distribution_log_path};
+            std::ostringstream contents;
+
+            contents << fin.rdbuf();
+
+            THEN("I get the expected file contents")
+            {
+                std::string expected = 
+                    "TimeStep,Radius,PairDistribution\n"
+                    "8,0.5,0.25\n"
+                    "8,1.5,1.75\n";
+                
+                REQUIRE(expected == contents.view());
+            }
+        }
+
+        WHEN("I read the energy histogram log back in")
+        {
+            std::ifstream fin{energy_histogram_log_path};
+            std::ostringstream contents;
+
+            contents << fin.rdbuf();
+
+            THEN("I get the expected file contents")
+            {
+                std::string expected = 
+                    "TimeStep,Temperature,Density,ParticleCount,PotentialEnergy,Virial,Count\n"
+                    "8,0.5,0.75,2,-1.5,2.25,3\n"
+                    "8,0.5,0.75,2,-0.5,1.25,1\n";
                 
                 REQUIRE(expected == contents.view());
             }
@@ -195,3 +349,95 @@ SCENARIO("Logger sends to correct files")
     // Clean up
     fs::remove_all(test_dir);
 }
+
+SCENARIO("Logger syncs its streams")
+{
+    std::ostringstream event_log, thermodynamic_log, observation_log, pair_distribution_log,
+        energy_histogram_log, snapshot_log, trajectory_log;
+
+    // Continuing earlier logs, so there are no headers
+    output::Logger logger{{
+        .event_log = event_log,
+        .thermodynamic_log = thermodynamic_log,
+        .observation_log = observation_log,
+        .pair_distribution_log = pair_distribution_log,
+        .energy_histogram_log = energy_histogram_log,
+        .snapshot_log = snapshot_log,
+        .trajectory_log = trajectory_log
+    }, output::ThermodynamicSink::Format::csv, {}, nullptr, {}, true};
+
+    for (int time_step = 1; time_step <= 5; ++time_step)
+    {
+        logger.log(time_step, output::ThermodynamicData{{.time = 0.5 * time_step}});
+    }
+
+    logger.log(5, output::PhaseCompleteEvent{"Test Phase"});
+
+    WHEN("I sync the Logger")
+    {
+        logger.sync();
+
+        THEN("Everything logged so far has been written")
+        {
+            auto thermodynamics = thermodynamic_log.str();
+            REQUIRE(5 == std::count(thermodynamics.begin(), thermodynamics.end(), '\n'));
+            REQUIRE(thermodynamics.starts_with("1,"));
+            REQUIRE(event_log.str() == "5: Phase complete: Test Phase\n");
+        }
+    }
+
+    logger.close();
+}
+
+SCENARIO("Logger with a full queue")
+{
+    // The Logger thread is held up after taking the first batch, so only 4 messages fit
+
+    WHEN("The policy is to drop measurements")
+    {
+        auto [events, time_steps] = log_with_full_queue({
+            .capacity = 4, .policy = output::LogQueue::Policy::drop
+        });
+
+        THEN("The measurements which did not fit are dropped and reported")
+        {
+            REQUIRE(time_steps == std::vector<int>{1, 2, 3, 4});
+            REQUIRE(events ==
+                "20: Logger dropped 16 thermodynamic measurements since time step 5\n"
+                "21: Phase complete: Test Phase\n"
+            );
+        }
+    }
+
+    WHEN("The policy is to decimate measurements")
+    {
+        auto [events, time_steps] = log_with_full_queue({
+            .capacity = 8, .policy = output::LogQueue::Policy::decimate, .decimation_interval = 5
+        });
+
+        THEN("Once the queue is half full, only every 5th measurement is kept")
+        {
+            REQUIRE(time_steps == std::vector<int>{1, 2, 3, 4, 5, 10, 15, 20});
+            REQUIRE(events ==
+                "19: Logger dropped 12 thermodynamic measurements since time step 6\n"
+                "21: Phase complete: Test Phase\n"
+            );
+        }
+    }
+
+    WHEN("The policy is to coalesce measurements")
+    {
+        auto [events, time_steps] = log_with_full_queue({
+            .capacity = 4, .policy = output::LogQueue::Policy::coalesce
+        });
+
+        THEN("The most recent measurement is kept, and sent once there is space")
+        {
+            REQUIRE(time_steps == std::vector<int>{1, 2, 3, 4, 20});
+            REQUIRE(events ==
+                "19: Logger dropped 15 thermodynamic measurements since time step 5\n"
+                "21: Phase complete: Test Phase\n"
+            );
+        }
+    }
+}
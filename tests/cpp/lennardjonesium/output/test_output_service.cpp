@@ -0,0 +1,103 @@
+/**
+ * Test that several Loggers can share the threads of an OutputService
+ */
+
+#include <array>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <src/cpp/lennardjonesium/physics/measurements.hpp>
+#include <src/cpp/lennardjonesium/output/log_message.hpp>
+#include <src/cpp/lennardjonesium/output/output_service.hpp>
+#include <src/cpp/lennardjonesium/output/logger.hpp>
+
+namespace
+{
+    struct LoggerStreams
+    {
+        std::ostringstream event_log, thermodynamic_log, observation_log, pair_distribution_log,
+            energy_histogram_log, snapshot_log, trajectory_log;
+
+        output::Logger::Streams streams()
+        {
+            return {
+                .event_log = event_log,
+                .thermodynamic_log = thermodynamic_log,
+                .observation_log = observation_log,
+                .pair_distribution_log = pair_distribution_log,
+                .energy_histogram_log = energy_histogram_log,
+                .snapshot_log = snapshot_log,
+                .trajectory_log = trajectory_log
+            };
+        }
+    };
+
+    // Log an event and some measurements from a separate thread, as a simulation would
+    void run_logger(LoggerStreams& streams, output::OutputService& service, int id)
+    {
+        output::Logger logger{
+            streams.streams(), output::ThermodynamicSink::Format::csv, {}, &service
+        };
+
+        logger.log(0, output::PhaseStartEvent{"Phase " + std::to_string(id)});
+
+        for (int time_step = 1; time_step <= 100; ++time_step)
+        {
+            logger.log(time_step, output::ThermodynamicData{{.time = 0.5 * time_step}});
+
+            // Let the service thread go to sleep now and again
+            if (time_step % 25 == 0) {std::this_thread::sleep_for(std::chrono::milliseconds(5));}
+        }
+
+        logger.log(100, output::PhaseCompleteEvent{"Phase " + std::to_string(id)});
+        logger.close();
+    }
+} // namespace
+
+SCENARIO("Loggers sharing an OutputService")
+{
+    output::OutputService service{1, std::chrono::microseconds(100)};
+
+    std::array<LoggerStreams, 4> streams;
+
+    WHEN("Several Loggers run at once, and are all served by one thread")
+    {
+        std::vector<std::thread> producers;
+
+        for (int id = 0; id < static_cast<int>(streams.size()); ++id)
+        {
+            producers.emplace_back(run_logger, std::ref(streams[id]), std::ref(service), id);
+        }
+
+        for (auto& producer : producers) {producer.join();}
+
+        THEN("Every Logger has written all of its messages by the time it is closed")
+        {
+            for (int id = 0; id < static_cast<int>(streams.size()); ++id)
+            {
+                std::string name = "Phase " + std::to_string(id);
+
+                REQUIRE(streams[id].event_log.str()
+                    == "0: Phase started: " + name + "\n100: Phase complete: " + name + "\n");
+
+                std::istringstream rows{streams[id].thermodynamic_log.str()};
+                std::string row;
+                int row_count = 0;
+
+                std::getline(rows, row);
+                while (std::getline(rows, row))
+                {
+                    ++row_count;
+                    REQUIRE(row.starts_with(std::to_string(row_count) + ","));
+                }
+
+                REQUIRE(row_count == 100);
+            }
+        }
+    }
+}
@@ -5,14 +5,23 @@
 #include <filesystem>
 #include <fstream>
 #include <sstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <array>
 
 #include <catch2/catch.hpp>
 #include <Eigen/Dense>
 
+#include <src/cpp/lennardjonesium/tools/binary_stream.hpp>
 #include <src/cpp/lennardjonesium/physics/measurements.hpp>
 #include <src/cpp/lennardjonesium/physics/observation.hpp>
+#include <src/cpp/lennardjonesium/physics/pair_distribution.hpp>
+#include <src/cpp/lennardjonesium/physics/energy_histogram.hpp>
 #include <src/cpp/lennardjonesium/output/log_message.hpp>
 #include <src/cpp/lennardjonesium/output/sinks.hpp>
+#include <src/cpp/lennardjonesium/output/snapshot_reader.hpp>
 
 SCENARIO("Testing Sink concept")
 {
@@ -24,7 +33,9 @@ SCENARIO("Testing Sink concept")
         AdjustTemperatureEvent,
         RecordObservationEvent,
         PhaseCompleteEvent,
-        AbortSimulationEvent
+        AbortSimulationEvent,
+        ReplicaExchangeEvent,
+        DroppedMessagesEvent
     >;
 
     constexpr bool thermodynamic_sink_check = Sink<
@@ -37,9 +48,27 @@ SCENARIO("Testing Sink concept")
         ObservationData
     >;
 
+    constexpr bool pair_distribution_sink_check = Sink<
+        PairDistributionSink,
+        PairDistributionData
+    >;
+
+    constexpr bool energy_histogram_sink_check = Sink<
+        EnergyHistogramSink,
+        EnergyHistogramData
+    >;
+
+    constexpr bool trajectory_sink_check = Sink<
+        TrajectorySink,
+        TrajectoryFrame
+    >;
+
     REQUIRE(event_sink_check);
     REQUIRE(thermodynamic_sink_check);
     REQUIRE(observation_sink_check);
+    REQUIRE(pair_distribution_sink_check);
+    REQUIRE(energy_histogram_sink_check);
+    REQUIRE(trajectory_sink_check);
 }
 
 SCENARIO("Sinks write correct output to files")
@@ -74,6 +103,16 @@ SCENARIO("Sinks write correct output to files")
         event_sink.write(5, output::PhaseCompleteEvent{phase_name});
         event_sink.write(6, output::RecordObservationEvent{});
         event_sink.write(8, output::AbortSimulationEvent{abort_reason});
+        event_sink.write(9, output::ReplicaExchangeEvent{
+            .partner_temperature = 0.75,
+            .acceptance_probability = 0.125,
+            .accepted = true,
+            .accepted_count = 2,
+            .attempted_count = 3
+        });
+        event_sink.write(12, output::DroppedMessagesEvent{.count = 2, .first_time_step = 10});
+        event_sink.write(15, output::CheckpointFailedEvent{"Disk full"});
+        event_sink.write(0, output::WarmStartFailedEvent{"No snapshot in final.csv"});
 
         event_log.close();
 
@@ -91,18 +130,25 @@ SCENARIO("Sinks write correct output to files")
                     "3: Temperature measured at: 0.25, adjusted to: 0.5\n"
                     "5: Phase complete: Test Phase\n"
                     "6: Observation recorded\n"
-                    "8: Simulation aborted: Could not reverse the polarity\n";
+                    "8: Simulation aborted: Could not reverse the polarity\n"
+                    "9: Replica exchange with temperature 0.75 accepted (probability 0.125), "
+                    "2 of 3 accepted\n"
+                    "12: Logger dropped 2 thermodynamic measurements since time step 10\n"
+                    "15: Checkpoint failed: Disk full\n"
+                    "0: Warm start failed: No snapshot in final.csv; starting from the lattice\n";
                 
                 REQUIRE(expected == contents.view());
             }
         }
     }
 
-    GIVEN("A ThermodynamicSink has written a file")
+    GIVEN("A ThermodynamicSink with the pressure tensor has written a file")
     {
         fs::path thermodynamic_log_path = test_dir / "thermodynamics.csv";
         std::ofstream thermodynamic_log{thermodynamic_log_path};
-        output::ThermodynamicSink thermodynamic_sink{thermodynamic_log};
+        output::ThermodynamicSink thermodynamic_sink{
+            thermodynamic_log, output::ThermodynamicSink::Format::csv, {}, true
+        };
 
         physics::ThermodynamicMeasurement::Result thermodynamic_result{
             .time = 3.5,
@@ -114,6 +160,16 @@ SCENARIO("Sinks write correct output to files")
             .mean_square_displacement = 7.25
         };
 
+        thermodynamic_result.virial_tensor <<
+            1.5, 0.25, 0.0,
+            0.25, 2.0, 0.0,
+            0.0, 0.0, 2.0;
+
+        thermodynamic_result.kinetic_tensor <<
+            1.0, 0.5, 0.0,
+            0.5, 1.25, 0.0,
+            0.0, 0.0, 0.75;
+
         thermodynamic_sink.write_header();
         thermodynamic_sink.write(7, output::ThermodynamicData{thermodynamic_result});
 
@@ -127,6 +183,49 @@ SCENARIO("Sinks write correct output to files")
             contents << fin.rdbuf();
 
             THEN("I get the expected file contents")
+            {
+                std::string expected = 
+                    "TimeStep,Time,KineticEnergy,PotentialEnergy,TotalEnergy,"
+                    "Virial,Temperature,MeanSquareDisplacement,"
+                    "VirialXX,VirialYY,VirialZZ,VirialXY,VirialXZ,VirialYZ,"
+                    "KineticXX,KineticYY,KineticZZ,KineticXY,KineticXZ,KineticYZ\n"
+                    "7,3.5,2.25,4.25,6.5,5.5,0.5,7.25,"
+                    "1.5,2,2,0.25,0,0,1,1.25,0.75,0.5,0,0\n";
+                
+                REQUIRE(expected == contents.view());
+            }
+        }
+    }
+
+    GIVEN("A ThermodynamicSink without the pressure tensor has written a file")
+    {
+        fs::path thermodynamic_log_path = test_dir / "thermodynamics.csv";
+        std::ofstream thermodynamic_log{thermodynamic_log_path};
+        output::ThermodynamicSink thermodynamic_sink{thermodynamic_log};
+
+        physics::ThermodynamicMeasurement::Result thermodynamic_result{
+            .time = 3.5,
+            .kinetic_energy = 2.25,
+            .potential_energy = 4.25,
+            .total_energy = 6.5,
+            .virial = 5.5,
+            .temperature = 0.5,
+            .mean_square_displacement = 7.25
+        };
+
+        thermodynamic_sink.write_header();
+        thermodynamic_sink.write(7, output::ThermodynamicData{thermodynamic_result});
+
+        thermodynamic_log.close();
+
+        WHEN("I read the file back in")
+        {
+            std::ifstream fin{thermodynamic_log_path};
+            std::ostringstream contents;
+
+            contents << fin.rdbuf();
+
+            THEN("The tensor columns are left out")
             {
                 std::string expected = 
                     "TimeStep,Time,KineticEnergy,PotentialEnergy,TotalEnergy,"
@@ -138,6 +237,192 @@ SCENARIO("Sinks write correct output to files")
         }
     }
 
+    GIVEN("A ThermodynamicSink with the pressure tensor has written a binary file")
+    {
+        fs::path thermodynamic_log_path = test_dir / "thermodynamics.bin";
+        std::ofstream thermodynamic_log{thermodynamic_log_path, std::ios::binary};
+        output::ThermodynamicSink thermodynamic_sink{
+            thermodynamic_log, output::ThermodynamicSink::Format::binary, {}, true
+        };
+
+        physics::ThermodynamicMeasurement::Result thermodynamic_result{
+            .time = 3.5,
+            .kinetic_energy = 2.25,
+            .potential_energy = 4.25,
+            .total_energy = 6.5,
+            .virial = 5.5,
+            .temperature = 0.5,
+            .mean_square_displacement = 7.25
+        };
+
+        thermodynamic_result.virial_tensor <<
+            1.5, 0.25, 0.0,
+            0.25, 2.0, 0.0,
+            0.0, 0.0, 2.0;
+
+        thermodynamic_result.kinetic_tensor <<
+            1.0, 0.5, 0.0,
+            0.5, 1.25, 0.0,
+            0.0, 0.0, 0.75;
+
+        thermodynamic_sink.write_header();
+        thermodynamic_sink.write(7, output::ThermodynamicData{thermodynamic_result});
+        thermodynamic_sink.write(8, output::ThermodynamicData{thermodynamic_result});
+
+        thermodynamic_log.close();
+
+        WHEN("I read the header back in")
+        {
+            std::ifstream fin{thermodynamic_log_path, std::ios::binary};
+
+            std::string magic(8, '\0');
+            fin.read(magic.data(), 8);
+
+            std::uint32_t version, byte_order_mark, column_count, data_offset;
+            tools::read_binary(fin, version);
+            tools::read_binary(fin, byte_order_mark);
+            tools::read_binary(fin, column_count);
+            tools::read_binary(fin, data_offset);
+
+            std::vector<std::string> columns;
+            for (std::uint32_t i = 0; i < column_count; ++i)
+            {
+                std::uint32_t length;
+                tools::read_binary(fin, length);
+                std::string column(length, '\0');
+                fin.read(column.data(), length);
+                columns.push_back(column);
+            }
+
+            THEN("It describes the columns of the CSV file")
+            {
+                REQUIRE(magic == "LJCOLUMN");
+                REQUIRE(version == 1);
+                REQUIRE(byte_order_mark == 0x01020304);
+                REQUIRE(column_count == 20);
+                REQUIRE(data_offset % 8 == 0);
+                REQUIRE(columns.front() == "TimeStep");
+                REQUIRE(columns[7] == "MeanSquareDisplacement");
+                REQUIRE(columns.back() == "KineticYZ");
+            }
+
+            THEN("It is followed by one record of doubles per time step")
+            {
+                REQUIRE(
+                    fs::file_size(thermodynamic_log_path)
+                    == data_offset + 2 * column_count * sizeof(double)
+                );
+
+                std::vector<double> records(2 * column_count);
+                fin.seekg(data_offset);
+                fin.read(
+                    reinterpret_cast<char*>(records.data()),
+                    static_cast<std::streamsize>(records.size() * sizeof(double))
+                );
+
+                std::vector<double> expected{
+                    7, 3.5, 2.25, 4.25, 6.5, 5.5, 0.5, 7.25,
+                    1.5, 2, 2, 0.25, 0, 0, 1, 1.25, 0.75, 0.5, 0, 0
+                };
+
+                REQUIRE(std::equal(expected.begin(), expected.end(), records.begin()));
+                REQUIRE(records[column_count] == 8);
+                REQUIRE(records[column_count + 2] == 2.25);
+            }
+        }
+    }
+
+    GIVEN("A ThermodynamicSink which reduces its measurements")
+    {
+        auto mode = GENERATE(
+            output::ThermodynamicReduction::Mode::decimate,
+            output::ThermodynamicReduction::Mode::aggregate
+        );
+
+        std::ostringstream thermodynamic_log;
+        output::ThermodynamicSink thermodynamic_sink{
+            thermodynamic_log,
+            output::ThermodynamicSink::Format::csv,
+            {.mode = mode, .interval = 2}
+        };
+
+        thermodynamic_sink.write_header();
+
+        // Time steps 1 to 5, with temperatures 0.5, 1.5, 1.0, 2.0, 3.0
+        std::vector<double> temperatures{0.5, 1.5, 1.0, 2.0, 3.0};
+        for (int time_step = 1; time_step <= 5; ++time_step)
+        {
+            physics::ThermodynamicMeasurement::Result thermodynamic_result{
+                .time = 0.5 * time_step,
+                .temperature = temperatures[time_step - 1]
+            };
+
+            thermodynamic_sink.write(time_step, output::ThermodynamicData{thermodynamic_result});
+        }
+
+        thermodynamic_sink.write_partial_block();
+
+        WHEN("I read the rows back in")
+        {
+            std::vector<std::vector<std::string>> rows;
+            std::istringstream contents{thermodynamic_log.str()};
+
+            for (std::string line; std::getline(contents, line);)
+            {
+                std::vector<std::string> row;
+                std::istringstream fields{line};
+                for (std::string field; std::getline(fields, field, ',');) {row.push_back(field);}
+                rows.push_back(row);
+            }
+
+            const auto& header = rows.front();
+            auto column = [&header](const std::string& name)
+                {return std::find(header.begin(), header.end(), name) - header.begin();};
+
+            if (mode == output::ThermodynamicReduction::Mode::decimate)
+            {
+                THEN("Only the time steps which are multiples of the interval are written")
+                {
+                    REQUIRE(header.size() == 8);
+                    REQUIRE(rows.size() == 3);
+                    REQUIRE(rows[1][0] == "2");
+                    REQUIRE(rows[1][column("Temperature")] == "1.5");
+                    REQUIRE(rows[2][0] == "4");
+                    REQUIRE(rows[2][column("Temperature")] == "2");
+                }
+            }
+            else
+            {
+                THEN("Each block of measurements is written as one row of statistics")
+                {
+                    REQUIRE(header.size() == 3 + 4 * 6);
+                    REQUIRE(header[2] == "SampleCount");
+                    REQUIRE(rows.size() == 4);
+
+                    REQUIRE(rows[1][0] == "2");
+                    REQUIRE(rows[1][column("Time")] == "1");
+                    REQUIRE(rows[1][column("SampleCount")] == "2");
+                    REQUIRE(rows[1][column("Temperature")] == "1");
+                    REQUIRE(rows[1][column("TemperatureMin")] == "0.5");
+                    REQUIRE(rows[1][column("TemperatureMax")] == "1.5");
+                    REQUIRE(rows[1][column("TemperatureVariance")] == "0.5");
+
+                    REQUIRE(rows[2][0] == "4");
+                    REQUIRE(rows[2][column("Temperature")] == "1.5");
+                    REQUIRE(rows[2][column("TemperatureVariance")] == "0.5");
+                }
+
+                THEN("The last, incomplete block is written at the end")
+                {
+                    REQUIRE(rows[3][0] == "5");
+                    REQUIRE(rows[3][column("SampleCount")] == "1");
+                    REQUIRE(rows[3][column("Temperature")] == "3");
+                    REQUIRE(rows[3][column("TemperatureVariance")] == "0");
+                }
+            }
+        }
+    }
+
     GIVEN("An ObservationSink has written a file")
     {
         fs::path observation_log_path = test_dir / "observations.csv";
@@ -150,7 +435,14 @@ SCENARIO("Sinks write correct output to files")
             .total_energy = 7.5,
             .pressure = 3.25,
             .specific_heat = 2.5,
-            .diffusion_coefficient = 5.25
+            .diffusion_coefficient = 5.25,
+            .temperature_error = 0.125,
+            .total_energy_error = 0.25,
+            .pressure_error = 0.5,
+            .specific_heat_error = 0.75,
+            .green_kubo_diffusion_coefficient = 5.5,
+            .shear_viscosity = 1.25,
+            .order_parameter = 0.875
         };
 
         observation_sink.write_header();
@@ -169,21 +461,126 @@ SCENARIO("Sinks write correct output to files")
             {
                 std::string expected = 
                     "TimeStep,Temperature,Density,TotalEnergy,Pressure,"
-                    "SpecificHeat,DiffusionCoefficient\n"
-                    "3,0.5,0.75,7.5,3.25,2.5,5.25\n";
+                    "SpecificHeat,DiffusionCoefficient,"
+                    "TemperatureError,TotalEnergyError,PressureError,SpecificHeatError,"
+                    "GreenKuboDiffusionCoefficient,ShearViscosity,OrderParameter\n"
+                    "3,0.5,0.75,7.5,3.25,2.5,5.25,0.125,0.25,0.5,0.75,5.5,1.25,0.875\n";
+                
+                REQUIRE(expected == contents.view());
+            }
+        }
+    }
+
+    GIVEN("A PairDistributionSink has written a file")
+    {
+        fs::path pair_distribution_log_path = test_dir / "pair_distribution.csv";
+        std::ofstream pair_distribution_log{pair_distribution_log_path};
+        output::PairDistributionSink pair_distribution_sink{pair_distribution_log};
+
+        physics::PairDistributionHistogram::Result pair_distribution{
+            .radii = {0.5, 1.5},
+            .pair_distribution = {0.25, 1.75},
+            .sample_count = 4
+        };
+
+        pair_distribution_sink.write_header();
+        pair_distribution_sink.write(8, output::PairDistributionData{pair_distribution});
+
+        pair_distribution_log.close();
+
+        WHEN("I read the file back in")
+        {
+            std::ifstream fin{pair_distribution_log_path};
+            std::ostringstream contents;
+
+            contents << fin.rdbuf();
+
+            THEN("I get the expected file contents")
+            {
+                std::string expected = 
+                    "TimeStep,Radius,PairDistribution\n"
+                    "8,0.5,0.25\n"
+                    "8,1.5,1.75\n";
                 
                 REQUIRE(expected == contents.view());
             }
         }
     }
 
+    GIVEN("An EnergyHistogramSink has written two histograms to a file")
+    {
+        fs::path energy_histogram_log_path = test_dir / "energy_histogram.csv";
+        std::ofstream energy_histogram_log{energy_histogram_log_path};
+        output::EnergyHistogramSink energy_histogram_sink{energy_histogram_log};
+
+        physics::EnergyHistogram first_histogram{
+            .temperature = 0.75,
+            .density = 0.5,
+            .particle_count = 2,
+            .potential_energies = {-2.5},
+            .virials = {1.5},
+            .counts = {7}
+        };
+
+        physics::EnergyHistogram energy_histogram{
+            .temperature = 0.5,
+            .density = 0.75,
+            .particle_count = 2,
+            .potential_energies = {-1.5, -0.5},
+            .virials = {2.25, 1.25},
+            .counts = {3, 1}
+        };
+
+        energy_histogram_sink.write_header();
+        energy_histogram_sink.write(4, output::EnergyHistogramData{first_histogram});
+        energy_histogram_sink.write(8, output::EnergyHistogramData{energy_histogram});
+
+        energy_histogram_log.close();
+
+        WHEN("I read the file back in")
+        {
+            std::ifstream fin{energy_histogram_log_path};
+            std::ostringstream contents;
+
+            contents << fin.rdbuf();
+
+            THEN("I get the expected file contents")
+            {
+                std::string expected = 
+                    "TimeStep,Temperature,Density,ParticleCount,PotentialEnergy,Virial,Count\n"
+                    "4,0.75,0.5,2,-2.5,1.5,7\n"
+                    "8,0.5,0.75,2,-1.5,2.25,3\n"
+                    "8,0.5,0.75,2,-0.5,1.25,1\n";
+                
+                REQUIRE(expected == contents.view());
+            }
+        }
+
+        WHEN("I read the histogram back in with read_energy_histogram()")
+        {
+            std::ifstream fin{energy_histogram_log_path};
+            auto restored = output::read_energy_histogram(fin);
+
+            THEN("I get the last histogram written")
+            {
+                REQUIRE(restored.has_value());
+                REQUIRE(energy_histogram.temperature == restored->temperature);
+                REQUIRE(energy_histogram.density == restored->density);
+                REQUIRE(energy_histogram.particle_count == restored->particle_count);
+                REQUIRE(energy_histogram.potential_energies == restored->potential_energies);
+                REQUIRE(energy_histogram.virials == restored->virials);
+                REQUIRE(energy_histogram.counts == restored->counts);
+            }
+        }
+    }
+
     GIVEN("A SystemSnapshotSink has written a file")
     {
         fs::path snapshot_log_path = test_dir / "snapshots.csv";
         std::ofstream snapshot_log{snapshot_log_path};
         output::SystemSnapshotSink snapshot_sink{snapshot_log};
 
-        output::SystemSnapshot snapshot{
+        output::SystemSnapshot::Data snapshot{
             .positions = Eigen::MatrixX4d{
                 {0, 1, 2, 0}, {3, 4, 5, 0}, {6, 7, 8, 0}
             }.transpose(),
@@ -198,7 +595,7 @@ SCENARIO("Sinks write correct output to files")
         };
 
         snapshot_sink.write_header();
-        snapshot_sink.write(9, snapshot);
+        snapshot_sink.write(9, output::SystemSnapshot{snapshot});
 
         snapshot_log.close();
 
@@ -222,6 +619,153 @@ SCENARIO("Sinks write correct output to files")
                 REQUIRE(expected == contents.view());
             }
         }
+
+        WHEN("I read the snapshot back in with read_snapshot()")
+        {
+            std::ifstream fin{snapshot_log_path};
+            auto restored = output::read_snapshot(fin);
+
+            THEN("I get the original snapshot")
+            {
+                REQUIRE(restored.has_value());
+                REQUIRE(snapshot.positions == restored->data->positions);
+                REQUIRE(snapshot.velocities == restored->data->velocities);
+                REQUIRE(snapshot.forces == restored->data->forces);
+            }
+        }
+    }
+
+    GIVEN("A TrajectorySink has written two frames of an odd number of particles to a file")
+    {
+        fs::path trajectory_log_path = test_dir / "trajectory.bin";
+        std::ofstream trajectory_log{trajectory_log_path, std::ios::binary};
+        output::TrajectorySink trajectory_sink{trajectory_log};
+
+        Eigen::Array4d box{4.0, 8.0, 2.0, 1.0};
+
+        Eigen::Matrix4Xd positions = Eigen::MatrixX4d{
+            {0.0, 1.0, 2.0, 0.0}, {3.0, 7.5, 0.5, 0.0}, {1.5, 0.25, 1.75, 0.0}
+        }.transpose();
+
+        Eigen::Matrix4Xd velocities = Eigen::MatrixX4d{
+            {0.5, -1.5, 2.25, 0.0}, {-0.25, 0.75, 1.0, 0.0}, {1.25, -0.5, 0.125, 0.0}
+        }.transpose();
+
+        trajectory_sink.write_header();
+        trajectory_sink.write(10, output::TrajectoryFrame{{
+            .time = 0.05, .box = box, .positions = positions, .velocities = velocities
+        }});
+        trajectory_sink.write(20, output::TrajectoryFrame{{
+            .time = 0.1, .box = box, .positions = positions, .velocities = velocities
+        }});
+
+        trajectory_log.close();
+
+        WHEN("I read the header and the second frame back in")
+        {
+            std::ifstream fin{trajectory_log_path, std::ios::binary};
+
+            std::string magic(8, '\0');
+            fin.read(magic.data(), 8);
+
+            std::uint32_t version, byte_order_mark, particle_count, has_velocities;
+            tools::read_binary(fin, version);
+            tools::read_binary(fin, byte_order_mark);
+            tools::read_binary(fin, particle_count);
+            tools::read_binary(fin, has_velocities);
+
+            std::uint32_t frame_size;
+            tools::read_binary(fin, frame_size);
+
+            // Seek directly to the second frame
+            fin.seekg(24 + frame_size);
+
+            std::uint32_t second_frame_size;
+            std::int32_t time_step;
+            double time;
+            std::array<double, 3> frame_box;
+            std::array<std::uint16_t, 9> quantized_positions;
+            std::uint16_t padding;
+            std::array<float, 9> frame_velocities;
+
+            tools::read_binary(fin, second_frame_size);
+            tools::read_binary(fin, time_step);
+            tools::read_binary(fin, time);
+            for (auto& side : frame_box) {tools::read_binary(fin, side);}
+            for (auto& q : quantized_positions) {tools::read_binary(fin, q);}
+            tools::read_binary(fin, padding);
+            for (auto& v : frame_velocities) {tools::read_binary(fin, v);}
+
+            THEN("I get the frame that was written")
+            {
+                REQUIRE(magic == "LJTRAJEC");
+                REQUIRE(version == 2);
+                REQUIRE(byte_order_mark == 0x01020304);
+                REQUIRE(particle_count == 3);
+                REQUIRE(has_velocities == 1);
+
+                // The positions are padded so that the velocities start on a multiple of 4
+                // bytes, and the frame happens to end on a multiple of 8 bytes already
+                REQUIRE(frame_size == 4 + 4 + 8 + 24 + 3 * 3 * 2 + 2 + 3 * 3 * 4);
+                REQUIRE(frame_size % 8 == 0);
+                REQUIRE(padding == 0);
+                REQUIRE(second_frame_size == frame_size);
+                REQUIRE(fs::file_size(trajectory_log_path) == 24 + 2 * frame_size);
+
+                REQUIRE(time_step == 20);
+                REQUIRE(time == 0.1);
+                REQUIRE(frame_box == std::array<double, 3>{4.0, 8.0, 2.0});
+
+                for (int j = 0; j < 3; ++j)
+                {
+                    for (int i = 0; i < 3; ++i)
+                    {
+                        double decoded = (quantized_positions[3 * j + i] + 0.5) / 65536 * box(i);
+                        REQUIRE(decoded == Approx(positions(i, j)).margin(box(i) / 65536));
+                        REQUIRE(frame_velocities[3 * j + i] == velocities(i, j));
+                    }
+                }
+            }
+        }
+    }
+
+    GIVEN("A TrajectorySink continues a file without writing its header")
+    {
+        fs::path trajectory_log_path = test_dir / "continued_trajectory.bin";
+        std::ofstream trajectory_log{trajectory_log_path, std::ios::binary};
+        output::TrajectorySink trajectory_sink{trajectory_log};
+
+        // Two particles, without velocities
+        Eigen::Matrix4Xd positions = Eigen::Matrix4Xd::Constant(4, 2, 0.5);
+
+        trajectory_sink.write(10, output::TrajectoryFrame{{
+            .time = 0.05,
+            .box = Eigen::Array4d{1.0, 1.0, 1.0, 1.0},
+            .positions = positions,
+            .velocities = Eigen::Matrix4Xd{}
+        }});
+
+        trajectory_log.close();
+
+        THEN("Only the frame is written, padded to a multiple of 8 bytes")
+        {
+            std::ifstream fin{trajectory_log_path, std::ios::binary};
+            std::uint32_t frame_size;
+            tools::read_binary(fin, frame_size);
+
+            REQUIRE(frame_size == 4 + 4 + 8 + 24 + 2 * 3 * 2 + 4);
+            REQUIRE(fs::file_size(trajectory_log_path) == frame_size);
+        }
+    }
+
+    GIVEN("A file which is not a snapshot file")
+    {
+        std::istringstream fin{"TimeStep,Time,KineticEnergy\n7,3.5,2.25\n"};
+
+        THEN("read_snapshot() finds no snapshot")
+        {
+            REQUIRE_FALSE(output::read_snapshot(fin).has_value());
+        }
     }
 
     // Clean up
@@ -0,0 +1,116 @@
+/**
+ * Test that the SweepStore keeps the logs of many runs in one file
+ */
+
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/iostreams/stream.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <src/cpp/lennardjonesium/output/sweep_store.hpp>
+
+SCENARIO("Writing the logs of several runs to a SweepStore")
+{
+    namespace fs = std::filesystem;
+
+    fs::path test_dir{"test_sweep_store"};
+    fs::remove_all(test_dir);
+    fs::create_directory(test_dir);
+
+    fs::path store_path = test_dir / "store.bin";
+
+    // Each run writes many lines, with a small chunk size so that the chunks interleave
+    auto run_contents = [](int run)
+    {
+        std::string contents;
+        for (int line = 0; line < 500; ++line)
+        {
+            contents += "run " + std::to_string(run) + ", line " + std::to_string(line) + "\n";
+        }
+        return contents;
+    };
+
+    GIVEN("Four runs writing to the same store at once")
+    {
+        {
+            auto store = output::SweepStore::open(store_path);
+            std::vector<std::jthread> threads;
+
+            for (int run = 0; run < 4; ++run)
+            {
+                threads.emplace_back([&, run]()
+                {
+                    boost::iostreams::stream<output::SweepStore::Segment> events{
+                        store->segment("run_" + std::to_string(run), "event_log", 256)
+                    };
+
+                    events << run_contents(run);
+                    events.close();
+                });
+            }
+        }
+
+        THEN("Each run can be read back whole")
+        {
+            auto store = output::SweepStore::open(store_path);
+
+            for (int run = 0; run < 4; ++run)
+            {
+                auto contents = store->read("run_" + std::to_string(run), "event_log");
+                REQUIRE(contents.has_value());
+                REQUIRE(*contents == run_contents(run));
+            }
+
+            REQUIRE_FALSE(store->read("run_4", "event_log").has_value());
+            REQUIRE_FALSE(store->read("run_0", "observation_log").has_value());
+        }
+
+        WHEN("The store is reopened and a run is written again")
+        {
+            {
+                auto store = output::SweepStore::open(store_path);
+                store->append("run_1", "event_log", "rewritten\n");
+
+                // An empty segment is recorded as well
+                boost::iostreams::stream<output::SweepStore::Segment> empty{
+                    store->segment("run_2", "event_log")
+                };
+            }
+
+            THEN("Only the newest segment is read")
+            {
+                auto store = output::SweepStore::open(store_path);
+
+                REQUIRE(store->read("run_0", "event_log") == run_contents(0));
+                REQUIRE(store->read("run_1", "event_log") == "rewritten\n");
+                REQUIRE(store->read("run_2", "event_log") == "");
+            }
+        }
+
+        WHEN("A run is killed while its log is written again")
+        {
+            {
+                auto store = output::SweepStore::open(store_path);
+
+                // Some chunks reach the store, but the segment is never closed
+                auto segment = store->segment("run_3", "event_log", 16);
+                std::string partial = "partial contents of a rewritten log\n";
+                segment.write(partial.data(), static_cast<std::streamsize>(partial.size()));
+            }
+
+            THEN("The complete older segment is still read")
+            {
+                auto store = output::SweepStore::open(store_path);
+
+                REQUIRE(store->read("run_3", "event_log") == run_contents(3));
+            }
+        }
+    }
+
+    // Clean up
+    fs::remove_all(test_dir);
+}
@@ -0,0 +1,138 @@
+/**
+ * Test that UringFileSink writes files correctly
+ */
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <boost/iostreams/stream.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <src/cpp/lennardjonesium/output/uring_file_sink.hpp>
+
+namespace
+{
+    // Some data which is not a whole number of pages, and does not repeat with a period of one
+    std::string make_data(std::size_t size)
+    {
+        std::string data(size, '\0');
+        for (std::size_t i = 0; i < size; ++i) {data[i] = static_cast<char>((i * 7919) % 251);}
+        return data;
+    }
+
+    std::string read_file(const std::filesystem::path& path)
+    {
+        std::ifstream fin{path, std::ios::binary};
+        return {std::istreambuf_iterator<char>{fin}, std::istreambuf_iterator<char>{}};
+    }
+} // namespace
+
+SCENARIO("Writing files through io_uring")
+{
+    namespace fs = std::filesystem;
+
+    fs::path test_dir{"test_uring_file_sink"};
+    fs::create_directory(test_dir);
+
+    // Small buffers and a short queue, so that the writer has to wait for buffers to come back
+    std::string data = make_data(3 * 1024 * 1024 + 1234);
+    std::size_t chunk_size = 1000;
+
+    // Write the data from the given start onwards
+    auto write_file = [&](
+        const fs::path& path, output::UringFileSink::Options options, std::size_t start = 0
+    )
+    {
+        boost::iostreams::stream<output::UringFileSink> stream{
+            output::UringFileSink{path, options}
+        };
+
+        for (std::size_t i = start; i < data.size(); i += chunk_size)
+        {
+            stream.write(data.data() + i, std::min(chunk_size, data.size() - i));
+
+            // Flushing part way through should be harmless
+            if (i % (256 * chunk_size) == 0) {stream.flush();}
+        }
+
+        stream.close();
+        return stream.good();
+    };
+
+    GIVEN("A UringFileSink using the page cache")
+    {
+        fs::path path = test_dir / "buffered.bin";
+        bool good = write_file(path, {.direct = false, .buffer_size = 64 * 1024, .queue_depth = 4});
+
+        THEN("The file contains exactly the data written")
+        {
+            REQUIRE(good);
+            REQUIRE(fs::file_size(path) == data.size());
+            REQUIRE(read_file(path) == data);
+        }
+    }
+
+    GIVEN("A UringFileSink using O_DIRECT")
+    {
+        fs::path path = test_dir / "direct.bin";
+        bool good = write_file(path, {.direct = true, .buffer_size = 64 * 1024, .queue_depth = 4});
+
+        THEN("The padding of the last block is removed")
+        {
+            REQUIRE(good);
+            REQUIRE(fs::file_size(path) == data.size());
+            REQUIRE(read_file(path) == data);
+        }
+    }
+
+    GIVEN("A file which was partly written already")
+    {
+        bool direct = GENERATE(false, true);
+
+        // Not a whole number of blocks, so that O_DIRECT has to read back the last one
+        std::size_t start = 10 * 4096 + 1234;
+
+        fs::path path = test_dir / "appended.bin";
+        {
+            std::ofstream fout{path, std::ios::binary};
+            fout.write(data.data(), static_cast<std::streamsize>(start));
+        }
+
+        WHEN("A UringFileSink appends the rest")
+        {
+            bool good = write_file(
+                path,
+                {.direct = direct, .buffer_size = 64 * 1024, .queue_depth = 4, .append = true},
+                start
+            );
+
+            THEN("The file contains all of the data")
+            {
+                REQUIRE(good);
+                REQUIRE(fs::file_size(path) == data.size());
+                REQUIRE(read_file(path) == data);
+            }
+        }
+    }
+
+    GIVEN("An empty file")
+    {
+        fs::path path = test_dir / "empty.bin";
+
+        {
+            boost::iostreams::stream<output::UringFileSink> stream{output::UringFileSink{path}};
+        }
+
+        THEN("The file is created with no contents")
+        {
+            REQUIRE(fs::exists(path));
+            REQUIRE(fs::file_size(path) == 0);
+        }
+    }
+
+    // Clean up
+    fs::remove_all(test_dir);
+}
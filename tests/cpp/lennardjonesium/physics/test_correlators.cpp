@@ -0,0 +1,76 @@
+/**
+ * Test the TransportCorrelator
+ */
+
+#include <catch2/catch.hpp>
+#include <Eigen/Dense>
+
+#include <src/cpp/lennardjonesium/tools/system_parameters.hpp>
+#include <src/cpp/lennardjonesium/physics/system_state.hpp>
+#include <src/cpp/lennardjonesium/physics/correlators.hpp>
+
+SCENARIO("Green-Kubo integrals of time correlation functions")
+{
+    // Two particles in a volume V = N / density = 4
+    tools::SystemParameters system_parameters{
+        .temperature = 1.0,
+        .density = 0.5,
+        .particle_count = 2
+    };
+
+    physics::TransportCorrelator correlator{
+        system_parameters,
+        physics::TransportCorrelator::Parameters{
+            .block_length = 4,
+            .averaging_length = 2,
+            .level_count = 3
+        }
+    };
+
+    GIVEN("A sequence of states with constant velocities and virial tensor")
+    {
+        physics::SystemState state{system_parameters.particle_count};
+
+        state.velocities = Eigen::MatrixX4d{
+            {1, 1, 0, 0}, {2, 2, 0, 0}
+        }.transpose();
+
+        state.virial_tensor(0, 2) = 3;
+
+        // Collect 64 states separated by 0.5 time units
+        for (int i = 0; i < 64; ++i)
+        {
+            state.time = 0.5 * i;
+            state | correlator;
+        }
+
+        auto result = correlator.result();
+
+        THEN("The correlation functions are constant")
+        {
+            // Z(t) = (1/N) sum_i v_i . v_i = (2 + 8) / 2
+            for (double value : result.velocity_autocorrelation) {REQUIRE(Approx(5.0) == value);}
+
+            // P_xy = 1 + 4, P_xz = 3, P_yz = 0
+            for (double value : result.stress_autocorrelation)
+            {
+                REQUIRE(Approx(34.0 / 3.0) == value);
+            }
+        }
+
+        THEN("The correlation times extend to the longest lag")
+        {
+            REQUIRE(Approx(0.0) == result.times.front());
+            REQUIRE(Approx(6.0) == result.times.back());
+        }
+
+        THEN("The transport coefficients are the integrals up to the longest lag")
+        {
+            // D = (1/3) * 5 * 6
+            REQUIRE(Approx(10.0) == result.diffusion_coefficient);
+
+            // eta = (34/3) * 6 / (V T), with T = 5/3
+            REQUIRE(Approx(68.0 / (4.0 * 5.0 / 3.0)) == result.shear_viscosity);
+        }
+    }
+}
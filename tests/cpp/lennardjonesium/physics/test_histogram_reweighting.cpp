@@ -0,0 +1,285 @@
+/**
+ * Test reweighting potential energy histograms to other temperatures
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <src/cpp/lennardjonesium/tools/system_parameters.hpp>
+#include <src/cpp/lennardjonesium/physics/system_state.hpp>
+#include <src/cpp/lennardjonesium/physics/lennard_jones_force.hpp>
+#include <src/cpp/lennardjonesium/physics/measurements.hpp>
+#include <src/cpp/lennardjonesium/physics/analyzers.hpp>
+#include <src/cpp/lennardjonesium/physics/energy_histogram.hpp>
+#include <src/cpp/lennardjonesium/physics/histogram_reweighting.hpp>
+#include <src/cpp/lennardjonesium/engine/initial_condition.hpp>
+#include <src/cpp/lennardjonesium/engine/integrator_builder.hpp>
+
+/**
+ * For a model density of states g(U) ~ exp(-U^2 / (2 s^2)), the canonical distribution of the
+ * potential energy at inverse temperature b is a Gaussian with mean -b s^2 and variance s^2, so
+ * the canonical specific heat is 3/2 + s^2 / (N T^2).  Molecular dynamics samples it instead at
+ * fixed total energy E, with the weight g(U) (E - U)^(3N/2 - 1), which is a narrower
+ * distribution.  We build the exact (rounded) microcanonical histograms of this model, with the
+ * virial proportional to the potential energy, choosing E so that the temperature is close to
+ * the given one.
+ */
+namespace
+{
+    constexpr double energy_scale = 10.0;
+    constexpr double virial_ratio = -2.0;
+    constexpr int particle_count = 100;
+    constexpr double kinetic_exponent = 1.5 * particle_count - 1.0;
+    constexpr double bin_width = 0.25;
+
+    double model_total_energy(double temperature)
+    {
+        return 1.5 * particle_count * temperature - energy_scale * energy_scale / temperature;
+    }
+
+    // ln of the microcanonical weight of potential energy U at total energy E
+    double model_log_weight(double potential_energy, double total_energy)
+    {
+        return -0.5 * potential_energy * potential_energy / (energy_scale * energy_scale)
+            + kinetic_exponent * std::log(total_energy - potential_energy);
+    }
+
+    physics::EnergyHistogram model_histogram(double temperature)
+    {
+        double total_energy = model_total_energy(temperature);
+        double mean = -energy_scale * energy_scale / temperature;
+        // Enough samples that rounding does not cut off the tails which reweighting draws on
+        double total_count = 1.0e11;
+
+        std::vector<double> energies;
+        std::vector<double> log_weights;
+        for (double energy = mean - 8 * energy_scale; energy < mean + 8 * energy_scale;
+            energy += bin_width)
+        {
+            energies.push_back(energy);
+            log_weights.push_back(model_log_weight(energy, total_energy));
+        }
+
+        double maximum = *std::max_element(log_weights.begin(), log_weights.end());
+        double normalization = 0;
+        for (double log_weight : log_weights) {normalization += std::exp(log_weight - maximum);}
+
+        physics::EnergyHistogram histogram{
+            .density = 0.8,
+            .particle_count = particle_count
+        };
+
+        // The temperature is the mean measured one, as in the EnergyHistogramAnalyzer
+        double kinetic_energy_sum = 0;
+
+        for (size_t i = 0; i < energies.size(); ++i)
+        {
+            auto count = std::lround(
+                total_count * std::exp(log_weights[i] - maximum) / normalization
+            );
+
+            if (count == 0) {continue;}
+
+            histogram.potential_energies.push_back(energies[i]);
+            histogram.virials.push_back(virial_ratio * energies[i]);
+            histogram.counts.push_back(count);
+
+            kinetic_energy_sum += static_cast<double>(count) * (total_energy - energies[i]);
+        }
+
+        histogram.temperature = kinetic_energy_sum
+            / (1.5 * particle_count * static_cast<double>(histogram.sample_count()));
+
+        return histogram;
+    }
+
+    // The dimensionless free energy -ln sum_U g(U) (E - U)^(3N/2 - 1) of a microcanonical run
+    double model_free_energy(double temperature)
+    {
+        double total_energy = model_total_energy(temperature);
+        double mean = -energy_scale * energy_scale / temperature;
+
+        std::vector<double> log_weights;
+        for (double energy = mean - 8 * energy_scale; energy < mean + 8 * energy_scale;
+            energy += bin_width / 10)
+        {
+            log_weights.push_back(model_log_weight(energy, total_energy));
+        }
+
+        double maximum = *std::max_element(log_weights.begin(), log_weights.end());
+        double sum = 0;
+        for (double log_weight : log_weights) {sum += std::exp(log_weight - maximum);}
+
+        return -(maximum + std::log(sum));
+    }
+} // namespace
+
+SCENARIO("Reweighting a single histogram")
+{
+    double temperature = 1.0;
+    physics::HistogramReweighting reweighting{{model_histogram(temperature)}};
+
+    REQUIRE(reweighting.converged());
+
+    WHEN("I reweight to the temperature at which the histogram was taken")
+    {
+        auto result = reweighting.reweight(temperature);
+        double potential_energy = -energy_scale * energy_scale / temperature;
+
+        THEN("I recover the averages of the histogram itself")
+        {
+            REQUIRE(Approx(1.5 * particle_count * temperature + potential_energy).epsilon(1.0e-4)
+                == result.total_energy);
+            REQUIRE(
+                Approx(0.8 * (temperature + virial_ratio * potential_energy / (3 * particle_count)))
+                    .epsilon(1.0e-4)
+                == result.pressure
+            );
+            REQUIRE(
+                Approx(1.5 + energy_scale * energy_scale / (particle_count * temperature
+                    * temperature)).epsilon(1.0e-3)
+                == result.specific_heat
+            );
+        }
+
+        THEN("Most samples contribute")
+        {
+            // The canonical distribution is wider, so the tails of the histogram count for more
+            auto sample_count = static_cast<double>(model_histogram(temperature).sample_count());
+            REQUIRE(result.effective_sample_size < sample_count);
+            REQUIRE(result.effective_sample_size > 0.5 * sample_count);
+        }
+    }
+
+    WHEN("I reweight to a nearby temperature")
+    {
+        double new_temperature = 1.1;
+        auto result = reweighting.reweight(new_temperature);
+        double potential_energy = -energy_scale * energy_scale / new_temperature;
+
+        THEN("I predict the averages at that temperature")
+        {
+            REQUIRE(Approx(new_temperature) == result.temperature);
+            REQUIRE(
+                Approx(1.5 * particle_count * new_temperature + potential_energy).epsilon(1.0e-4)
+                    == result.total_energy
+            );
+            REQUIRE(
+                Approx(1.5 + energy_scale * energy_scale / (particle_count * new_temperature
+                    * new_temperature)).epsilon(1.0e-3)
+                == result.specific_heat
+            );
+        }
+
+        THEN("Fewer samples contribute")
+        {
+            auto sample_count = static_cast<double>(model_histogram(temperature).sample_count());
+            REQUIRE(result.effective_sample_size < sample_count);
+        }
+    }
+}
+
+SCENARIO("Combining histograms at several temperatures")
+{
+    std::vector<double> temperatures{0.8, 1.0, 1.25};
+    std::vector<physics::EnergyHistogram> histograms;
+
+    for (double temperature : temperatures)
+    {
+        histograms.push_back(model_histogram(temperature));
+    }
+
+    physics::HistogramReweighting reweighting{histograms};
+
+    THEN("The free energies converge to those of the model")
+    {
+        REQUIRE(reweighting.converged());
+        REQUIRE(3 == reweighting.free_energies().size());
+
+        for (size_t k = 0; k < temperatures.size(); ++k)
+        {
+            REQUIRE(
+                Approx(model_free_energy(temperatures[k]) - model_free_energy(temperatures[0]))
+                    .margin(1.0e-3)
+                == reweighting.free_energies()[k]
+            );
+        }
+    }
+
+    WHEN("I reweight to temperatures between the runs")
+    {
+        for (double temperature : {0.9, 1.1})
+        {
+            auto result = reweighting.reweight(temperature);
+            double potential_energy = -energy_scale * energy_scale / temperature;
+
+            REQUIRE(
+                Approx(1.5 * particle_count * temperature + potential_energy).epsilon(1.0e-4)
+                    == result.total_energy
+            );
+            REQUIRE(
+                Approx(1.5 + energy_scale * energy_scale / (particle_count * temperature
+                    * temperature)).epsilon(1.0e-3)
+                == result.specific_heat
+            );
+        }
+    }
+}
+
+SCENARIO("Reweighting a molecular dynamics run to its own temperature")
+{
+    // Half of the kinetic energy goes into melting the lattice, leaving a liquid at about 0.8
+    tools::SystemParameters system_parameters{
+        .temperature {1.6},
+        .density {0.8},
+        .particle_count {100}
+    };
+
+    // This always uses the default random seed, so the test is repeatable
+    engine::InitialCondition initial_condition(system_parameters);
+    physics::LennardJonesForce short_range_force({2.0});
+
+    auto integrator = engine::Integrator::Builder{0.005}
+        .bounding_box(initial_condition.bounding_box())
+        .short_range_force(short_range_force)
+        .build();
+
+    // Melt the lattice before taking any samples
+    physics::SystemState state = initial_condition.system_state();
+    state | (*integrator)(1000);
+
+    int sample_count = 5000;
+    physics::ThermodynamicMeasurement measurement;
+    physics::ThermodynamicAnalyzer thermodynamic_analyzer{system_parameters, sample_count};
+    physics::EnergyHistogramAnalyzer energy_histogram_analyzer{system_parameters, 0.005};
+
+    for (int i = 0; i < sample_count; ++i)
+    {
+        state | (*integrator)(1) | measurement;
+        thermodynamic_analyzer.collect(measurement);
+        energy_histogram_analyzer.collect(measurement);
+    }
+
+    auto observation = thermodynamic_analyzer.result();
+    auto histogram = energy_histogram_analyzer.result();
+
+    WHEN("I reweight its energy histogram to the temperature of the run")
+    {
+        physics::HistogramReweighting reweighting{{histogram}};
+        auto result = reweighting.reweight(histogram.temperature);
+
+        THEN("I recover the Observation of the same samples")
+        {
+            REQUIRE(reweighting.converged());
+            REQUIRE(Approx(observation.total_energy).epsilon(1.0e-3) == result.total_energy);
+            REQUIRE(Approx(observation.pressure).epsilon(1.0e-2) == result.pressure);
+
+            // Taking the microcanonical variance of U as the canonical one would make this
+            // about 15% too small
+            REQUIRE(Approx(observation.specific_heat).epsilon(0.05) == result.specific_heat);
+        }
+    }
+}
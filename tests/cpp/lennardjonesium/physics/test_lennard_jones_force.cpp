@@ -53,6 +53,13 @@ SCENARIO("Lennard-Jones force with cutoff distance")
         {
             REQUIRE(fc.force.z() > 0);
         }
+
+        THEN("The virial is the separation times the force")
+        {
+            Eigen::Vector4d separation = (nominal_zero_loc - displacement) * z_vector;
+
+            REQUIRE(Approx(fc.virial) == separation.dot(fc.force));
+        }
     }
 
     WHEN("I check the values on the near side of the well")
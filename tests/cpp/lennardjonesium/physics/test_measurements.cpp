@@ -106,6 +106,21 @@ SCENARIO("Measurements of bulk properties of the system")
             REQUIRE(Approx(temperature) == thermodynamics.result().temperature);
         }
 
+        THEN("The measured kinetic tensor is correct")
+        {
+            Eigen::Matrix3d kinetic_tensor{
+                { 4, -4,  0},
+                {-4,  4,  0},
+                { 0,  0,  0}
+            };
+
+            REQUIRE(kinetic_tensor.isApprox(
+                physics::kinetic_tensor(state).topLeftCorner<3, 3>()
+            ));
+            REQUIRE(kinetic_tensor.isApprox(thermodynamics.result().kinetic_tensor));
+            REQUIRE(Approx(2 * kinetic_energy) == thermodynamics.result().kinetic_tensor.trace());
+        }
+
         THEN("The measured total momentum is correct")
         {
             REQUIRE(total_momentum.isApprox(physics::total_momentum(state)));
@@ -186,6 +201,39 @@ SCENARIO("Measurements of bulk properties of the system")
             ));
         }
     }
+
+    GIVEN("Some drifting velocities and displacements on the particles")
+    {
+        state.velocities = Eigen::MatrixX4d{
+            { 1,  2,  0,  0}, { 3, -1,  1,  0}, {-1,  0,  2,  0}, { 0,  1, -2,  0}
+        }.transpose();
+
+        state.displacements = Eigen::MatrixX4d{
+            { 1,  0,  0,  0}, { 0,  2,  0,  0}, { 1,  1,  1,  0}, { 0,  0,  3,  0}
+        }.transpose();
+
+        state | thermodynamics;
+
+        THEN("The fused kinetic moments agree with the separate properties")
+        {
+            auto moments = physics::kinetic_moments(state);
+
+            REQUIRE(Approx(physics::kinetic_energy(state)) == moments.kinetic_energy);
+            REQUIRE(Approx(physics::mean_square_displacement(state))
+                == moments.mean_square_displacement);
+            REQUIRE(physics::kinetic_tensor(state).isApprox(moments.kinetic_tensor));
+            REQUIRE(physics::total_momentum(state).isApprox(moments.total_momentum));
+        }
+
+        THEN("The thermodynamic measurement records the kinetic moments")
+        {
+            Eigen::Vector3d total_momentum{3, 2, 1};
+
+            REQUIRE(Approx(13.0) == thermodynamics.result().kinetic_energy);
+            REQUIRE(Approx(4.25) == thermodynamics.result().mean_square_displacement);
+            REQUIRE(total_momentum.isApprox(thermodynamics.result().total_momentum));
+        }
+    }
 }
 
 SCENARIO("Transformations of bulk properties of a small system")
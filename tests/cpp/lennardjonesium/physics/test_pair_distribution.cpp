@@ -0,0 +1,140 @@
+/**
+ * Test the PairDistributionHistogram
+ */
+
+#include <memory>
+#include <numbers>
+
+#include <catch2/catch.hpp>
+#include <Eigen/Dense>
+
+#include <src/cpp/lennardjonesium/tools/system_parameters.hpp>
+#include <src/cpp/lennardjonesium/tools/bounding_box.hpp>
+#include <src/cpp/lennardjonesium/physics/system_state.hpp>
+#include <src/cpp/lennardjonesium/physics/pair_distribution.hpp>
+#include <src/cpp/lennardjonesium/engine/particle_pair_filter.hpp>
+#include <src/cpp/lennardjonesium/engine/force_calculation.hpp>
+
+#include <tests/cpp/mock/constant_short_range_force.hpp>
+
+SCENARIO("Normalizing the pair distribution histogram")
+{
+    // Two particles in a volume V = N / density = 4
+    tools::SystemParameters system_parameters{
+        .temperature = 1.0,
+        .density = 0.5,
+        .particle_count = 2
+    };
+
+    // Two bins of unit width
+    physics::PairDistributionHistogram histogram{system_parameters, 2.0, 2};
+
+    GIVEN("A single sample with one pair in each bin, and one pair out of range")
+    {
+        histogram.request_sample();
+        histogram.add(0.25);
+        histogram.add(2.25);
+        histogram.add(9.0);
+        histogram.complete_sample();
+
+        auto result = histogram.result();
+
+        THEN("The bins are centered at the expected radii")
+        {
+            REQUIRE(2 == result.radii.size());
+            REQUIRE(Approx(0.5) == result.radii[0]);
+            REQUIRE(Approx(1.5) == result.radii[1]);
+        }
+
+        THEN("Each bin is normalized by the ideal gas pair count in its shell")
+        {
+            // Expected pairs per unit volume is N * density / 2 = 0.5
+            double inner_shell_volume = (4.0 / 3.0) * std::numbers::pi;
+            double outer_shell_volume = 7.0 * inner_shell_volume;
+
+            REQUIRE(1 == result.sample_count);
+            REQUIRE(Approx(1.0 / (0.5 * inner_shell_volume)) == result.pair_distribution[0]);
+            REQUIRE(Approx(1.0 / (0.5 * outer_shell_volume)) == result.pair_distribution[1]);
+        }
+
+        WHEN("I clear the histogram")
+        {
+            histogram.clear();
+
+            THEN("No samples remain")
+            {
+                REQUIRE(0 == histogram.sample_count());
+                REQUIRE_FALSE(histogram.sample_requested());
+            }
+        }
+    }
+}
+
+SCENARIO("Sampling the pair distribution from the force calculation")
+{
+    tools::SystemParameters system_parameters{
+        .temperature = 1.0,
+        .density = 0.5,
+        .particle_count = 2
+    };
+
+    double box_size{3.0};
+    double cutoff_distance{1.0};
+
+    tools::BoundingBox bounding_box{box_size};
+
+    mock::ConstantShortRangeForce short_range_force({-10.0, cutoff_distance});
+
+    auto histogram = std::make_shared<physics::PairDistributionHistogram>(
+        system_parameters, cutoff_distance, 10
+    );
+
+    engine::ShortRangeForceCalculation force_calculation(
+        short_range_force,
+        std::make_unique<engine::CellListParticlePairFilter>(bounding_box, cutoff_distance),
+        histogram
+    );
+
+    GIVEN("Two particles at a distance of 0.45")
+    {
+        physics::SystemState state(2);
+
+        state.positions = Eigen::Matrix4Xd{
+            {0.2, 0.2},
+            {0.2, 0.2},
+            {0.2, 0.65},
+            {  0,   0}
+        };
+
+        WHEN("I compute the forces without requesting a sample")
+        {
+            state | force_calculation;
+
+            THEN("The histogram is not sampled")
+            {
+                REQUIRE(0 == histogram->sample_count());
+            }
+        }
+
+        WHEN("I request a sample and compute the forces twice")
+        {
+            histogram->request_sample();
+            state | force_calculation;
+            state | force_calculation;
+
+            THEN("Exactly one sample is taken, in the bin containing the pair")
+            {
+                REQUIRE(1 == histogram->sample_count());
+                REQUIRE_FALSE(histogram->sample_requested());
+
+                auto result = histogram->result();
+
+                for (int bin = 0; bin < 10; ++bin)
+                {
+                    if (bin == 4) {REQUIRE(result.pair_distribution[bin] > 0);}
+                    else {REQUIRE(0 == result.pair_distribution[bin]);}
+                }
+            }
+        }
+    }
+}
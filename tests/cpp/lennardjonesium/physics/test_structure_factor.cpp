@@ -0,0 +1,131 @@
+/**
+ * Test the StructureFactorMeasurement
+ */
+
+#include <cmath>
+#include <numbers>
+
+#include <catch2/catch.hpp>
+#include <Eigen/Dense>
+
+#include <src/cpp/lennardjonesium/tools/system_parameters.hpp>
+#include <src/cpp/lennardjonesium/tools/bounding_box.hpp>
+#include <src/cpp/lennardjonesium/tools/cubic_lattice.hpp>
+#include <src/cpp/lennardjonesium/physics/system_state.hpp>
+#include <src/cpp/lennardjonesium/physics/structure_factor.hpp>
+
+SCENARIO("Structure factor of a perfect lattice")
+{
+    // 32 particles fill a 2x2x2 face-centered lattice exactly
+    tools::SystemParameters system_parameters{
+        .temperature = 1.0,
+        .density = 0.8,
+        .particle_count = 32
+    };
+
+    tools::CubicLattice lattice{system_parameters};
+
+    physics::SystemState state{system_parameters.particle_count};
+    for (int index = 0; auto position : lattice()) {state.positions.col(index++) = position;}
+
+    GIVEN("A measurement at the first Bragg peak")
+    {
+        physics::StructureFactorMeasurement measurement{
+            lattice.bounding_box(),
+            physics::StructureFactorMeasurement::Parameters{
+                .wavenumbers = lattice.bragg_wavenumbers()
+            }
+        };
+
+        state | measurement;
+        auto result = measurement.result();
+
+        THEN("Every wavevector gives S(k) = N, and the order parameter is 1")
+        {
+            for (double value : result.structure_factor) {REQUIRE(Approx(32.0) == value);}
+            REQUIRE(Approx(1.0) == result.order_parameter);
+        }
+    }
+
+    GIVEN("A measurement at a wavevector where the unit cell interferes destructively")
+    {
+        physics::StructureFactorMeasurement measurement{
+            lattice.bounding_box(),
+            physics::StructureFactorMeasurement::Parameters{
+                .wavenumbers = {Eigen::Vector4i{2, 0, 0, 0}, Eigen::Vector4i{0, -2, 0, 0}}
+            }
+        };
+
+        state | measurement;
+        auto result = measurement.result();
+
+        THEN("S(k) vanishes")
+        {
+            for (double value : result.structure_factor)
+            {
+                REQUIRE(Approx(0.0).margin(1.0e-9) == value);
+            }
+
+            REQUIRE(Approx(0.0).margin(1.0e-9) == result.order_parameter);
+        }
+    }
+}
+
+SCENARIO("Structure factor agrees with direct evaluation")
+{
+    tools::BoundingBox bounding_box{2.0, 3.0, 4.0};
+
+    physics::SystemState state{3};
+    state.positions = Eigen::MatrixX4d{
+        {0.3, 1.1, 2.5, 0}, {1.7, 0.2, 0.9, 0}, {0.8, 2.6, 3.3, 0}
+    }.transpose();
+
+    Eigen::Vector4i n{3, -2, 1, 0};
+
+    physics::StructureFactorMeasurement measurement{
+        bounding_box,
+        physics::StructureFactorMeasurement::Parameters{.wavenumbers = {n}, .stride = 2}
+    };
+
+    WHEN("I give the measurement the same state three times")
+    {
+        state | measurement;
+        state | measurement;
+        state | measurement;
+
+        THEN("Only every second state is measured")
+        {
+            REQUIRE(2 == measurement.sample_count());
+        }
+
+        THEN("The result matches the sum of cosines and sines")
+        {
+            Eigen::Vector4d k = (
+                2 * std::numbers::pi * n.cast<double>().array() / bounding_box.array()
+            ).matrix();
+
+            double cosine_sum = 0;
+            double sine_sum = 0;
+
+            for (int j = 0; j < 3; ++j)
+            {
+                cosine_sum += std::cos(k.dot(state.positions.col(j)));
+                sine_sum += std::sin(k.dot(state.positions.col(j)));
+            }
+
+            double expected = (cosine_sum * cosine_sum + sine_sum * sine_sum) / 3.0;
+
+            REQUIRE(Approx(expected) == measurement.result().structure_factor[0]);
+        }
+
+        AND_WHEN("I clear the measurement")
+        {
+            measurement.clear();
+
+            THEN("No samples remain")
+            {
+                REQUIRE(0 == measurement.sample_count());
+            }
+        }
+    }
+}
@@ -30,8 +30,10 @@ SCENARIO("Size of a system state")
 
         THEN("Their sizes are the same")
         {
-            REQUIRE(88 == sizeof(small));
-            REQUIRE(88 == sizeof(large));
+            REQUIRE(sizeof(small) == sizeof(large));
+
+            // 88 bytes of matrix handles and scalars, plus the (aligned) virial tensor
+            REQUIRE(sizeof(small) <= 88 + sizeof(Eigen::Matrix4d) + 2 * alignof(Eigen::Matrix4d));
         }
     }
 }
@@ -0,0 +1,88 @@
+/**
+ * Test BlockAverage
+ */
+
+#include <cmath>
+
+#include <catch2/catch.hpp>
+#include <Eigen/Dense>
+
+#include <src/cpp/lennardjonesium/tools/block_average.hpp>
+
+SCENARIO("Estimating standard errors by block averaging")
+{
+    GIVEN("A BlockAverage of doubles")
+    {
+        tools::BlockAverage<double> numbers;
+
+        WHEN("I enter a few values")
+        {
+            numbers.push_back(2);
+            numbers.push_back(3);
+            numbers.push_back(8);
+            numbers.push_back(1);
+
+            THEN("I get the correct mean and variance")
+            {
+                auto s = numbers.statistics();
+                REQUIRE(4 == numbers.size());
+                REQUIRE(Approx(3.5) == s.mean);
+                REQUIRE(Approx(29.0 / 3.0) == s.variance);
+            }
+
+            THEN("Too few blocks are available, so I get the naive standard error")
+            {
+                REQUIRE(Approx(std::sqrt(29.0 / 12.0)) == numbers.standard_error());
+            }
+        }
+
+        WHEN("I enter a series which is correlated over blocks of 8 samples")
+        {
+            // Blocks of 8 identical values, alternating between +1 and -1
+            for (int i = 0; i < 512; ++i)
+            {
+                numbers.push_back(((i / 8) % 2 == 0) ? 1.0 : -1.0);
+            }
+
+            THEN("The standard error is the one computed from the 64 independent blocks")
+            {
+                REQUIRE(Approx(0.0).margin(1.0e-12) == numbers.statistics().mean);
+                REQUIRE(Approx(std::sqrt(1.0 / 63.0)) == numbers.standard_error());
+            }
+
+            THEN("The standard error is larger than the naive estimate")
+            {
+                double naive_error = std::sqrt(numbers.statistics().variance / numbers.size());
+                REQUIRE(numbers.standard_error() > 2.5 * naive_error);
+            }
+
+            THEN("Clearing the BlockAverage empties it")
+            {
+                numbers.clear();
+                REQUIRE(numbers.empty());
+            }
+        }
+    }
+
+    GIVEN("A BlockAverage of vectors whose components are equal")
+    {
+        tools::BlockAverage<Eigen::Vector2d> vectors;
+
+        for (int i = 0; i < 512; ++i)
+        {
+            double value = ((i / 8) % 2 == 0) ? 1.0 : -1.0;
+            vectors.push_back({value, value});
+        }
+
+        THEN("The standard error of their difference vanishes")
+        {
+            REQUIRE(Approx(0.0).margin(1.0e-12) == vectors.standard_error({1.0, -1.0}));
+        }
+
+        THEN("The standard error of their sum is twice that of either component")
+        {
+            REQUIRE(Approx(2.0 * std::sqrt(1.0 / 63.0)) == vectors.standard_error({1.0, 1.0}));
+            REQUIRE(Approx(std::sqrt(1.0 / 63.0)) == vectors.standard_error({1.0, 0.0}));
+        }
+    }
+}
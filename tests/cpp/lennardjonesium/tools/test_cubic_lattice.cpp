@@ -163,3 +163,63 @@ SCENARIO("Producing particle lattices with the correct lattice sites")
         }
     }
 }
+
+SCENARIO("Finding the first Bragg peak of a lattice")
+{
+    // 32 particles fill a 2x2x2 face-centered lattice exactly
+    tools::SystemParameters system_parameters{
+        .temperature{0.5},
+        .density{1.0},
+        .particle_count{32}
+    };
+
+    WHEN("I ask for the Bragg wavenumbers of a face-centered cubic lattice")
+    {
+        tools::CubicLattice lattice(system_parameters, tools::CubicLattice::FaceCentered());
+        auto wavenumbers = lattice.bragg_wavenumbers();
+
+        THEN("I get the four (111) directions, scaled by the number of cells per side")
+        {
+            REQUIRE(2 == lattice.cells_per_side());
+            REQUIRE(4 == wavenumbers.size());
+
+            for (const auto& n : wavenumbers)
+            {
+                REQUIRE(Eigen::Vector4i{2, 2, 2, 0} == n.cwiseAbs());
+            }
+        }
+    }
+
+    WHEN("I ask for the Bragg wavenumbers of a body-centered cubic lattice")
+    {
+        tools::CubicLattice lattice(system_parameters, tools::CubicLattice::BodyCentered());
+        auto wavenumbers = lattice.bragg_wavenumbers();
+
+        THEN("I get the six (110) directions")
+        {
+            REQUIRE(6 == wavenumbers.size());
+
+            for (const auto& n : wavenumbers)
+            {
+                REQUIRE(2 * lattice.cells_per_side() * lattice.cells_per_side()
+                    == n.squaredNorm());
+            }
+        }
+    }
+
+    WHEN("I ask for the Bragg wavenumbers of a simple cubic lattice")
+    {
+        tools::CubicLattice lattice(system_parameters, tools::CubicLattice::Simple());
+        auto wavenumbers = lattice.bragg_wavenumbers();
+
+        THEN("I get the three (100) directions")
+        {
+            REQUIRE(3 == wavenumbers.size());
+
+            for (const auto& n : wavenumbers)
+            {
+                REQUIRE(lattice.cells_per_side() * lattice.cells_per_side() == n.squaredNorm());
+            }
+        }
+    }
+}
@@ -0,0 +1,100 @@
+/**
+ * Test DriftTest
+ */
+
+#include <cmath>
+#include <random>
+
+#include <catch2/catch.hpp>
+
+#include <src/cpp/lennardjonesium/tools/drift_test.hpp>
+
+SCENARIO("Testing time series for drift")
+{
+    GIVEN("A DriftTest with blocks of 4 samples")
+    {
+        tools::DriftTest drift_test{4};
+
+        WHEN("I enter fewer samples than a block")
+        {
+            REQUIRE_FALSE(drift_test.push_back(1.0));
+            REQUIRE_FALSE(drift_test.push_back(2.0));
+            REQUIRE_FALSE(drift_test.push_back(3.0));
+
+            THEN("No blocks have been fitted")
+            {
+                REQUIRE(0 == drift_test.block_count());
+                REQUIRE_FALSE(drift_test.stationary(2.0, 0));
+            }
+
+            THEN("The next sample completes a block")
+            {
+                REQUIRE(drift_test.push_back(4.0));
+                REQUIRE(1 == drift_test.block_count());
+            }
+        }
+
+        WHEN("I enter a series that rises linearly")
+        {
+            for (int i = 0; i < 40; ++i) {drift_test.push_back(0.5 * i);}
+
+            THEN("The slope per block is found exactly, and the series is not stationary")
+            {
+                REQUIRE(10 == drift_test.block_count());
+                REQUIRE(Approx(2.0) == drift_test.slope());
+                REQUIRE(drift_test.t_statistic() > 1.0e6);
+                REQUIRE_FALSE(drift_test.stationary(2.0, 5));
+            }
+        }
+
+        WHEN("I enter a constant series")
+        {
+            for (int i = 0; i < 40; ++i) {drift_test.push_back(3.0);}
+
+            THEN("The series is stationary")
+            {
+                REQUIRE(0.0 == drift_test.t_statistic());
+                REQUIRE(drift_test.stationary(2.0, 5));
+                REQUIRE_FALSE(drift_test.stationary(2.0, 20));
+            }
+
+            THEN("Clearing the DriftTest starts over")
+            {
+                drift_test.clear();
+                REQUIRE(0 == drift_test.block_count());
+            }
+        }
+    }
+
+    GIVEN("A DriftTest with blocks of 50 samples")
+    {
+        tools::DriftTest drift_test{50};
+        std::mt19937 gen{2022};
+        std::normal_distribution<> noise{0.0, 1.0};
+
+        WHEN("I enter noise around a constant")
+        {
+            for (int i = 0; i < 2000; ++i) {drift_test.push_back(1.0 + noise(gen));}
+
+            THEN("No significant drift is found")
+            {
+                REQUIRE(40 == drift_test.block_count());
+                REQUIRE(drift_test.stationary(3.0, 10));
+            }
+        }
+
+        WHEN("I enter noise around a slowly decaying transient")
+        {
+            for (int i = 0; i < 2000; ++i)
+            {
+                drift_test.push_back(1.0 + 2.0 * std::exp(-i / 1000.0) + noise(gen));
+            }
+
+            THEN("The drift is detected")
+            {
+                REQUIRE(drift_test.t_statistic() < -3.0);
+                REQUIRE_FALSE(drift_test.stationary(3.0, 10));
+            }
+        }
+    }
+}
@@ -0,0 +1,128 @@
+/**
+ * Test the FramePool of recycled frames.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch.hpp>
+#include <Eigen/Dense>
+
+#include <src/cpp/lennardjonesium/tools/ring_buffer.hpp>
+#include <src/cpp/lennardjonesium/tools/frame_pool.hpp>
+
+SCENARIO("Frame pool in single-threaded environment")
+{
+    tools::FramePool<Eigen::Matrix4Xd> frame_pool{2, Eigen::Matrix4Xd::Zero(4, 100)};
+
+    THEN("The frames are preallocated from the prototype")
+    {
+        REQUIRE(frame_pool.size() == 2);
+        REQUIRE(frame_pool.acquire()->cols() == 100);
+    }
+
+    WHEN("I hold on to the frames I acquire")
+    {
+        auto first = frame_pool.acquire();
+        auto second = frame_pool.acquire();
+
+        THEN("They are different frames")
+        {
+            REQUIRE(first != second);
+            REQUIRE(first->data() != second->data());
+        }
+
+        AND_WHEN("I release one of them")
+        {
+            auto* storage = first->data();
+            first.reset();
+
+            auto third = frame_pool.acquire();
+
+            THEN("It is acquired again, along with its storage")
+            {
+                REQUIRE(third->data() == storage);
+            }
+        }
+    }
+
+    WHEN("I overwrite a released frame with a matrix of the same size")
+    {
+        auto frame = frame_pool.acquire();
+        std::set<const double*> storage{frame->data()};
+        frame.reset();
+
+        Eigen::Matrix4Xd source = Eigen::Matrix4Xd::Random(4, 100);
+
+        for (int i = 0; i < 10; ++i)
+        {
+            auto next = frame_pool.acquire();
+            *next = source;
+            storage.insert(next->data());
+        }
+
+        THEN("No new storage is allocated")
+        {
+            REQUIRE(storage.size() == 2);
+        }
+    }
+}
+
+SCENARIO("Frame pool destroyed while its frames are in use")
+{
+    std::shared_ptr<Eigen::Matrix4Xd> frame;
+
+    {
+        tools::FramePool<Eigen::Matrix4Xd> frame_pool{2, Eigen::Matrix4Xd::Zero(4, 100)};
+        frame = frame_pool.acquire();
+        frame->setConstant(1.5);
+    }
+
+    THEN("The frame outlives the pool")
+    {
+        REQUIRE(frame->cols() == 100);
+        REQUIRE((frame->array() == 1.5).all());
+    }
+}
+
+SCENARIO("Frame pool with a consumer thread")
+{
+    using frame_type = std::vector<int>;
+
+    tools::FramePool<frame_type> frame_pool{3, frame_type(1000)};
+    tools::RingBuffer<std::shared_ptr<const frame_type>> ring_buffer{16};
+
+    WHEN("More frames are sent than there are in the pool")
+    {
+        std::vector<int> sums;
+
+        std::thread consumer{[&ring_buffer, &sums]()
+        {
+            // Each frame is released as soon as its message has been processed
+            while (ring_buffer.get_batch(
+                [&sums](std::shared_ptr<const frame_type> frame)
+                    {sums.push_back(frame->front() + frame->back());}
+            ) > 0);
+        }};
+
+        for (int i = 0; i < 100; ++i)
+        {
+            auto frame = frame_pool.acquire();
+            std::fill(frame->begin(), frame->end(), i);
+            ring_buffer.put(std::move(frame));
+        }
+
+        ring_buffer.close();
+        consumer.join();
+
+        THEN("Every frame arrives intact")
+        {
+            REQUIRE(sums.size() == 100);
+            for (int i = 0; i < 100; ++i) {REQUIRE(sums[i] == 2 * i);}
+        }
+    }
+}
@@ -2,6 +2,8 @@
  * Test MovingAverage
  */
 
+#include <sstream>
+
 #include <catch2/catch.hpp>
 #include <Eigen/Dense>
 
@@ -132,3 +134,43 @@ SCENARIO("Computing statistics from moving samples")
         }
     }
 }
+
+SCENARIO("Saving and restoring moving samples")
+{
+    GIVEN("A MovingSample of vectors which has overflowed")
+    {
+        tools::MovingSample<Eigen::Vector2d> vectors(3);
+
+        vectors.push_back({9, 9});
+        vectors.push_back({1, 2});
+        vectors.push_back({3, 1});
+        vectors.push_back({2, 6});
+
+        WHEN("I save it and restore it into a new MovingSample")
+        {
+            std::stringstream stream;
+            vectors.save(stream);
+
+            tools::MovingSample<Eigen::Vector2d> restored(3);
+            restored.restore(stream);
+
+            THEN("The restored sample has the same values and statistics")
+            {
+                REQUIRE(stream.good());
+                REQUIRE(restored.full());
+                REQUIRE(vectors.statistics().mean.isApprox(restored.statistics().mean));
+                REQUIRE(vectors.statistics().covariance.isApprox(
+                    restored.statistics().covariance
+                ));
+            }
+
+            THEN("Both samples continue in the same way")
+            {
+                vectors.push_back({4, 0});
+                restored.push_back({4, 0});
+
+                REQUIRE(vectors.statistics().mean.isApprox(restored.statistics().mean));
+            }
+        }
+    }
+}
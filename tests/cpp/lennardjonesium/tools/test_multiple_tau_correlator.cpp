@@ -0,0 +1,75 @@
+/**
+ * Test MultipleTauCorrelator
+ */
+
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <src/cpp/lennardjonesium/tools/multiple_tau_correlator.hpp>
+
+SCENARIO("Computing time correlation functions with the multiple-tau scheme")
+{
+    // Blocks of 4 values, averaged in pairs, with 3 levels
+    tools::MultipleTauCorrelator<double> correlator{
+        [](const double& a, const double& b) {return a * b;}, 4, 2, 3
+    };
+
+    WHEN("I enter a constant series")
+    {
+        for (int i = 0; i < 64; ++i) {correlator.push_back(1.0);}
+
+        auto correlation = correlator.correlation();
+
+        THEN("The lags are spaced exponentially across the levels")
+        {
+            std::vector<long> expected_lags{0, 1, 2, 3, 4, 6, 8, 12};
+            REQUIRE(expected_lags == correlation.lags);
+            REQUIRE(64 == correlator.size());
+        }
+
+        THEN("The correlation is constant")
+        {
+            for (double value : correlation.values) {REQUIRE(Approx(1.0) == value);}
+        }
+    }
+
+    WHEN("I enter an alternating series")
+    {
+        for (int i = 0; i < 64; ++i) {correlator.push_back((i % 2 == 0) ? 1.0 : -1.0);}
+
+        auto correlation = correlator.correlation();
+
+        THEN("The finest level resolves the alternation")
+        {
+            REQUIRE(Approx(1.0) == correlation.values[0]);
+            REQUIRE(Approx(-1.0) == correlation.values[1]);
+            REQUIRE(Approx(1.0) == correlation.values[2]);
+            REQUIRE(Approx(-1.0) == correlation.values[3]);
+        }
+
+        THEN("The coarser levels average it away")
+        {
+            for (size_t k = 4; k < correlation.values.size(); ++k)
+            {
+                REQUIRE(Approx(0.0).margin(1.0e-12) == correlation.values[k]);
+            }
+        }
+    }
+
+    WHEN("I enter only a few values")
+    {
+        correlator.push_back(2.0);
+        correlator.push_back(3.0);
+
+        THEN("Only the lags for which there is data are reported")
+        {
+            auto correlation = correlator.correlation();
+
+            std::vector<long> expected_lags{0, 1};
+            REQUIRE(expected_lags == correlation.lags);
+            REQUIRE(Approx((4.0 + 9.0) / 2.0) == correlation.values[0]);
+            REQUIRE(Approx(6.0) == correlation.values[1]);
+        }
+    }
+}
@@ -0,0 +1,148 @@
+/**
+ * Test the lock-free single-producer, single-consumer RingBuffer.
+ */
+
+#include <thread>
+#include <chrono>
+#include <optional>
+#include <numeric>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <src/cpp/lennardjonesium/tools/ring_buffer.hpp>
+
+SCENARIO("Ring buffer in single-threaded environment")
+{
+    tools::RingBuffer<int> ring_buffer{5};
+
+    THEN("The capacity is rounded up to a power of 2")
+    {
+        REQUIRE(ring_buffer.capacity() == 8);
+    }
+
+    WHEN("I push some values to the buffer")
+    {
+        ring_buffer.put(1);
+        ring_buffer.put(2);
+        ring_buffer.put(3);
+
+        THEN("I read back the same values")
+        {
+            REQUIRE(1 == ring_buffer.get());
+            REQUIRE(2 == ring_buffer.get());
+            REQUIRE(3 == ring_buffer.get());
+        }
+    }
+
+    WHEN("I read the values back in a batch")
+    {
+        ring_buffer.put(1);
+        ring_buffer.put(2);
+        ring_buffer.put(3);
+
+        std::vector<int> output;
+        auto count = ring_buffer.get_batch([&output](int i) {output.push_back(i);});
+
+        THEN("The batch contains all of the values")
+        {
+            REQUIRE(count == 3);
+            REQUIRE(output == std::vector<int>{1, 2, 3});
+        }
+    }
+
+    WHEN("I fill the buffer more than once over")
+    {
+        std::vector<int> output;
+
+        for (int i = 0; i < 20; ++i)
+        {
+            ring_buffer.put(i);
+            output.push_back(ring_buffer.get().value());
+        }
+
+        THEN("The indices wrap around correctly")
+        {
+            std::vector<int> input(20);
+            std::iota(input.begin(), input.end(), 0);
+            REQUIRE(input == output);
+        }
+    }
+
+    WHEN("I send the close() signal")
+    {
+        ring_buffer.put(1);
+        ring_buffer.put(2);
+        ring_buffer.close();
+        ring_buffer.put(3);
+
+        THEN("I read back the values put before closing, and then std::nullopt")
+        {
+            REQUIRE(1 == ring_buffer.get());
+            REQUIRE(2 == ring_buffer.get());
+            REQUIRE(std::nullopt == ring_buffer.get());
+            REQUIRE(ring_buffer.get_batch([](int) {}) == 0);
+        }
+    }
+}
+
+SCENARIO("Ring buffer with producer and consumer threads")
+{
+    // A small buffer, so that the producer frequently has to wait for space
+    tools::RingBuffer<int> ring_buffer{16};
+
+    std::vector<int> input(100000);
+    std::iota(input.begin(), input.end(), 0);
+
+    std::vector<int> output;
+
+    WHEN("I create producer and consumer threads and join them")
+    {
+        std::thread producer(
+            [&ring_buffer, &input]()
+            {
+                for (auto i : input) {ring_buffer.put(i);}
+            }
+        );
+
+        std::thread consumer(
+            [&ring_buffer, &output]()
+            {
+                while (ring_buffer.get_batch([&output](int i) {output.push_back(i);}) > 0);
+            }
+        );
+
+        producer.join();
+        ring_buffer.close();
+        consumer.join();
+
+        THEN("The output vector now has the same contents as the input")
+        {
+            REQUIRE(input == output);
+        }
+    }
+
+    WHEN("The consumer is asleep when the producer sends a message")
+    {
+        std::thread consumer(
+            [&ring_buffer, &output]()
+            {
+                while (auto o = ring_buffer.get()) {output.push_back(o.value());}
+            }
+        );
+
+        // Give the consumer time to exhaust its spin loop and go to sleep
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        ring_buffer.put(7);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        ring_buffer.put(11);
+
+        ring_buffer.close();
+        consumer.join();
+
+        THEN("The consumer is woken up and receives the messages")
+        {
+            REQUIRE(output == std::vector<int>{7, 11});
+        }
+    }
+}
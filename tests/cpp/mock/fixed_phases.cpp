@@ -65,7 +65,14 @@ namespace mock
             .total_energy = 7.5,
             .pressure = 3.25,
             .specific_heat = 2.5,
-            .diffusion_coefficient = 5.25
+            .diffusion_coefficient = 5.25,
+            .temperature_error = 0.125,
+            .total_energy_error = 0.25,
+            .pressure_error = 0.5,
+            .specific_heat_error = 0.75,
+            .green_kubo_diffusion_coefficient = 5.5,
+            .shear_viscosity = 1.25,
+            .order_parameter = 0.875
         };
 
         switch (time_step - start_time_)
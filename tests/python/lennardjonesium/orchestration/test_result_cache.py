@@ -0,0 +1,31 @@
+"""
+Test the keys of the ResultCache
+"""
+
+import unittest
+
+from lennardjonesium.simulation import Configuration
+from lennardjonesium.orchestration.result_cache import ResultCache
+
+
+class TestResultCacheKey(unittest.TestCase):
+    def test_output_paths_do_not_change_key(self):
+        source_conf = Configuration()
+        moved_conf = Configuration()
+        moved_conf.filepaths.thermodynamic_log = 'elsewhere/thermodynamics.csv'
+        moved_conf.filepaths.store = 'store.ljs'
+        moved_conf.filepaths.store_run = 'T_0.800000/d_0.700000'
+
+        self.assertEqual(ResultCache.key(source_conf), ResultCache.key(moved_conf))
+    
+    def test_output_options_change_key(self):
+        source_conf = Configuration()
+
+        reduced_conf = Configuration()
+        reduced_conf.filepaths.thermodynamic_log_reduction = 'aggregate'
+
+        dropping_conf = Configuration()
+        dropping_conf.filepaths.log_queue_policy = 'drop'
+
+        self.assertNotEqual(ResultCache.key(source_conf), ResultCache.key(reduced_conf))
+        self.assertNotEqual(ResultCache.key(source_conf), ResultCache.key(dropping_conf))
@@ -23,17 +23,23 @@ class TestSimulation(unittest.TestCase):
         event_log = test_dir / cfg.filepaths.event_log
         thermodynamic_log = test_dir / cfg.filepaths.thermodynamic_log
         observation_log = test_dir / cfg.filepaths.observation_log
+        pair_distribution_log = test_dir / cfg.filepaths.pair_distribution_log
+        energy_histogram_log = test_dir / cfg.filepaths.energy_histogram_log
         snapshot_log = test_dir / cfg.filepaths.snapshot_log
 
         cfg.filepaths.event_log = str(event_log)
         cfg.filepaths.thermodynamic_log = str(thermodynamic_log)
         cfg.filepaths.observation_log = str(observation_log)
+        cfg.filepaths.pair_distribution_log = str(pair_distribution_log)
+        cfg.filepaths.energy_histogram_log = str(energy_histogram_log)
         cfg.filepaths.snapshot_log = str(snapshot_log)
 
         # Make sure all directories exist
         event_log.parent.mkdir(parents=True, exist_ok=True)
         thermodynamic_log.parent.mkdir(parents=True, exist_ok=True)
         observation_log.parent.mkdir(parents=True, exist_ok=True)
+        pair_distribution_log.parent.mkdir(parents=True, exist_ok=True)
+        energy_histogram_log.parent.mkdir(parents=True, exist_ok=True)
         snapshot_log.parent.mkdir(parents=True, exist_ok=True)
 
         # Create and run the simulation
@@ -46,3 +52,10 @@ class TestSimulation(unittest.TestCase):
 
         # Clean up
         shutil.rmtree(test_dir)
+
+    def test_unknown_option(self):
+        cfg = Configuration()
+        cfg.filepaths.log_queue_policy = 'dorp'
+
+        with self.assertRaises(ValueError):
+            Simulation(cfg)